@@ -94,6 +94,7 @@
 #include <86box/sound.h>
 #include <86box/midi.h>
 #include <86box/snd_speaker.h>
+#include <86box/snd_tone.h>
 #include <86box/video.h>
 #include <86box/ui.h>
 #include <86box/path.h>
@@ -103,6 +104,7 @@
 #include <86box/machine_status.h>
 #include <86box/apm.h>
 #include <86box/acpi.h>
+#include <86box/snapshot.h>
 
 // Disable c99-designator to avoid the warnings about int ng
 #ifdef __clang__
@@ -133,6 +135,7 @@ int force_debug = 0; /* (O) force debug output */
 int video_fps = RENDER_FPS; /* (O) render speed in fps */
 #endif
 int settings_only     = 0; /* (O) show only the settings dialog */
+int run_headless      = 0; /* (O) no window, sound or speed limit */
 int confirm_exit_cmdl = 1; /* (O) do not ask for confirmation on quit if set to 0 */
 #ifdef _WIN32
 uint64_t unique_id   = 0;
@@ -190,6 +193,9 @@ uint32_t mem_size                               = 0;              /* (C) memory
                                                                          system board)*/
 uint32_t isa_mem_size                           = 0;              /* (C) memory size (ISA Memory Cards) */
 int      cpu_use_dynarec                        = 0;              /* (C) cpu uses/needs Dyna */
+int      cpu_dynarec_cache                      = 0;              /* (C) keep dynarec block profile */
+int      cpu_dynarec_async                      = 0;              /* (C) compile dynarec blocks in background */
+int      mem_tlb_size                           = 1024;           /* (C) soft TLB entries */
 int      cpu                                    = 0;              /* (C) cpu type */
 int      fpu_type                               = 0;              /* (C) fpu type */
 int      fpu_softfloat                          = 0;              /* (C) fpu uses softfloat */
@@ -200,6 +206,8 @@ int      confirm_save                           = 1;              /* (C) enable
 int      enable_discord                         = 0;              /* (C) enable Discord integration */
 int      pit_mode                               = -1;             /* (C) force setting PIT mode */
 int      fm_driver                              = 0;              /* (C) select FM sound driver */
+int      fm_async                               = 0;              /* (C) render FM synthesis on the sound
+                                                                         render thread */
 int      open_dir_usr_path                      = 0;              /* (C) default file open dialog directory
                                                                          of usr_path */
 int      video_fullscreen_scale_maximized       = 0;              /* (C) Whether fullscreen scaling settings
@@ -531,6 +539,7 @@ usage:
             printf("\nUsage: 86box [options] [cfg-file]\n\n");
             printf("Valid options are:\n\n");
             printf("-? or --help            - show this information\n");
+            printf("-B or --snapshot path   - start from the snapshot in 'path'\n");
             printf("-C or --config path     - set 'path' to be config file\n");
 #ifdef _WIN32
             printf("-D or --debug           - force debug output logging\n");
@@ -552,6 +561,9 @@ usage:
             printf("-M or --missing         - dump missing machines and video cards\n");
             printf("-N or --noconfirm       - do not ask for confirmation on quit\n");
             printf("-P or --vmpath path     - set 'path' to be root for vm\n");
+#ifdef USE_SDL_UI
+            printf("-Q or --headless        - run without a window, sound or speed limit\n");
+#endif
             printf("-R or --rompath path    - set 'path' to be ROM path\n");
 #ifndef USE_SDL_UI
             printf("-S or --settings        - show only the settings dialog\n");
@@ -587,12 +599,21 @@ usage:
                 goto usage;
 
             ppath = argv[++c];
+#ifdef USE_SDL_UI
+        } else if (!strcasecmp(argv[c], "--headless") || !strcasecmp(argv[c], "-Q")) {
+            run_headless = 1;
+#endif
         } else if (!strcasecmp(argv[c], "--rompath") || !strcasecmp(argv[c], "-R")) {
             if ((c + 1) == argc)
                 goto usage;
 
             rpath = argv[++c];
             rom_add_path(rpath);
+        } else if (!strcasecmp(argv[c], "--snapshot") || !strcasecmp(argv[c], "-B")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            snapshot_request_load(argv[++c]);
         } else if (!strcasecmp(argv[c], "--config") || !strcasecmp(argv[c], "-C")) {
             if ((c + 1) == argc || plat_dir_check(argv[c + 1]))
                 goto usage;
@@ -676,6 +697,8 @@ usage:
             //  selected language.
         } else if (!strcasecmp(argv[c], "--test") || !strcasecmp(argv[c], "-T")) {
             /* some (undocumented) test function here.. */
+            timer_benchmark();
+            tone_benchmark();
 
             /* .. and then exit. */
             return 0;
@@ -1082,6 +1105,11 @@ pc_reset_hard_close(void)
 {
     ui_sb_set_ready(0);
 
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    /* Save the dynarec block profile while guest memory is still mapped. */
+    codegen_cache_save();
+#endif
+
     /* Close all the memory mappings. */
     mem_close();
 
@@ -1275,6 +1303,9 @@ pc_reset_hard_init(void)
 #ifdef USE_DYNAREC
     cycles_main = 0;
 #endif
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    codegen_cache_load();
+#endif
 
     update_mouse_msg();
 
@@ -1342,6 +1373,12 @@ pc_close(UNUSED(thread_t *ptr))
 
     plat_mouse_capture(0);
 
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    codegen_async_close();
+    codegen_cache_save();
+    codegen_cache_close();
+#endif
+
     /* Close all the memory mappings. */
     mem_close();
 
@@ -1372,6 +1409,8 @@ pc_close(UNUSED(thread_t *ptr))
 
     sound_cd_thread_end();
 
+    sound_render_thread_end();
+
     cdrom_close();
 
     zip_close();
@@ -1414,6 +1453,12 @@ pc_run(void)
         pc_reset_hard_init();
     }
 
+    /* Save or load a snapshot if one has been asked for. */
+    snapshot_process();
+
+    /* Commit or discard hard disk overlays if asked to. */
+    hdd_image_overlay_process();
+
     /* Run a block of code. */
     startblit();
     cpu_exec((int32_t) cpu_s->rspeed / 100);
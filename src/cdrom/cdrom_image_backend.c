@@ -38,6 +38,7 @@
 #include <86box/86box.h>
 #include <86box/path.h>
 #include <86box/plat.h>
+#include <86box/thread.h>
 #include <86box/cdrom_image_backend.h>
 
 #define CDROM_BCD(x)        (((x) % 10) | (((x) / 10) << 4))
@@ -46,6 +47,50 @@
 #define MAX_FILENAME_LENGTH 256
 #define CROSS_LEN           512
 
+/* Read-ahead of image files: chunk size, number of chunks cached per file,
+   how many chunks to stay ahead of a sequential stream, and how many
+   consecutive reads it takes to consider a stream sequential. */
+#define PREFETCH_CHUNK      65536
+#define PREFETCH_SLOTS      16
+#define PREFETCH_WINDOW     8
+#define PREFETCH_STREAMS    2
+#define PREFETCH_TRIGGER    2
+#define PREFETCH_GAP        4096
+
+enum {
+    PREFETCH_FREE = 0,
+    PREFETCH_QUEUED,
+    PREFETCH_LOADING,
+    PREFETCH_VALID
+};
+
+typedef struct prefetch_slot_t {
+    int      state;
+    uint32_t last_use;
+    uint64_t chunk;
+    size_t   len;
+    uint8_t *data;
+} prefetch_slot_t;
+
+typedef struct prefetch_stream_t {
+    uint64_t next;
+    uint32_t hits;
+    uint32_t last_use;
+} prefetch_stream_t;
+
+typedef struct prefetch_t {
+    thread_t *thread;
+    mutex_t  *mutex;
+    event_t  *wake_event;
+    event_t  *done_event;
+    FILE     *fp;
+    int       quit;
+    uint32_t  clock;
+
+    prefetch_slot_t   slots[PREFETCH_SLOTS];
+    prefetch_stream_t streams[PREFETCH_STREAMS];
+} prefetch_t;
+
 static char temp_keyword[1024];
 
 #ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
@@ -66,18 +111,222 @@ cdrom_image_backend_log(const char *fmt, ...)
 #    define cdrom_image_backend_log(fmt, ...)
 #endif
 
-/* Binary file functions. */
-static int
-bin_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
+/* Read-ahead functions.
+
+   Both the emulated drive and the CD audio thread read image files in
+   long sequential runs. Each file gets a small cache of chunks, which a
+   worker thread fills ahead of every stream of sequential reads, so the
+   reading thread rarely has to wait for the host. */
+static prefetch_slot_t *
+prefetch_find(prefetch_t *pf, uint64_t chunk)
 {
-    track_file_t *tf;
+    for (int i = 0; i < PREFETCH_SLOTS; i++) {
+        if ((pf->slots[i].state != PREFETCH_FREE) && (pf->slots[i].chunk == chunk))
+            return &pf->slots[i];
+    }
 
-    cdrom_image_backend_log("CDROM: binary_read(%08lx, pos=%" PRIu64 " count=%lu\n",
-                            tf->fp, seek, count);
+    return NULL;
+}
+
+static void
+prefetch_thread(void *priv)
+{
+    prefetch_t      *pf = (prefetch_t *) priv;
+    prefetch_slot_t *slot;
+
+    thread_wait_mutex(pf->mutex);
+    while (1) {
+        /* Load queued chunks in the order they were requested. */
+        slot = NULL;
+        for (int i = 0; i < PREFETCH_SLOTS; i++) {
+            if ((pf->slots[i].state == PREFETCH_QUEUED) &&
+                ((slot == NULL) || ((int32_t) (pf->slots[i].last_use - slot->last_use) < 0)))
+                slot = &pf->slots[i];
+        }
 
-    if ((tf = (track_file_t *) priv)->fp == NULL)
+        if (slot == NULL) {
+            if (pf->quit)
+                break;
+            thread_reset_event(pf->wake_event);
+            thread_release_mutex(pf->mutex);
+            thread_wait_event(pf->wake_event, -1);
+            thread_wait_mutex(pf->mutex);
+            continue;
+        }
+
+        slot->state = PREFETCH_LOADING;
+        thread_release_mutex(pf->mutex);
+
+        size_t len = 0;
+        if (fseeko64(pf->fp, slot->chunk * PREFETCH_CHUNK, SEEK_SET) != -1)
+            len = fread(slot->data, 1, PREFETCH_CHUNK, pf->fp);
+
+        thread_wait_mutex(pf->mutex);
+        slot->len   = len;
+        slot->state = PREFETCH_VALID;
+        thread_set_event(pf->done_event);
+    }
+    thread_release_mutex(pf->mutex);
+}
+
+static int
+prefetch_start(prefetch_t *pf, const char *fn)
+{
+    pf->fp = plat_fopen64(fn, "rb");
+    if (pf->fp == NULL)
         return 0;
 
+    for (int i = 0; i < PREFETCH_SLOTS; i++) {
+        pf->slots[i].data = (uint8_t *) malloc(PREFETCH_CHUNK);
+        if (pf->slots[i].data == NULL) {
+            while (i--) {
+                free(pf->slots[i].data);
+                pf->slots[i].data = NULL;
+            }
+            fclose(pf->fp);
+            pf->fp = NULL;
+            return 0;
+        }
+    }
+
+    pf->wake_event = thread_create_event();
+    pf->done_event = thread_create_event();
+    pf->thread     = thread_create(prefetch_thread, pf);
+
+    cdrom_image_backend_log("CDROM: started read-ahead for %s\n", fn);
+
+    return 1;
+}
+
+static void
+prefetch_close(prefetch_t *pf)
+{
+    if (pf->thread != NULL) {
+        thread_wait_mutex(pf->mutex);
+        pf->quit = 1;
+        thread_release_mutex(pf->mutex);
+        thread_set_event(pf->wake_event);
+        thread_wait(pf->thread);
+
+        thread_destroy_event(pf->wake_event);
+        thread_destroy_event(pf->done_event);
+        fclose(pf->fp);
+
+        for (int i = 0; i < PREFETCH_SLOTS; i++)
+            free(pf->slots[i].data);
+    }
+
+    thread_close_mutex(pf->mutex);
+    free(pf);
+}
+
+/* Copy a range out of the cached chunks, waiting for chunks which are
+   being loaded at the moment. Must be called with the lock held. */
+static int
+prefetch_read(prefetch_t *pf, uint8_t *buffer, uint64_t seek, size_t count)
+{
+    prefetch_slot_t *slot;
+    uint64_t         first = seek / PREFETCH_CHUNK;
+    uint64_t         last  = (seek + count - 1) / PREFETCH_CHUNK;
+
+    for (uint64_t c = first; c <= last; c++) {
+        /* Another reader may reuse the slot while we wait, so look it up again. */
+        while (((slot = prefetch_find(pf, c)) != NULL) && (slot->state == PREFETCH_LOADING)) {
+            thread_reset_event(pf->done_event);
+            thread_release_mutex(pf->mutex);
+            thread_wait_event(pf->done_event, -1);
+            thread_wait_mutex(pf->mutex);
+        }
+        if ((slot == NULL) || (slot->state != PREFETCH_VALID))
+            return 0;
+    }
+
+    for (uint64_t c = first; c <= last; c++) {
+        slot = prefetch_find(pf, c);
+        if ((slot == NULL) || (slot->state != PREFETCH_VALID))
+            return 0;
+
+        const uint64_t start = (c == first) ? (seek % PREFETCH_CHUNK) : 0;
+        const uint64_t end   = (c == last) ? (((seek + count - 1) % PREFETCH_CHUNK) + 1) : PREFETCH_CHUNK;
+        if (end > slot->len)
+            return 0;
+
+        memcpy(buffer, slot->data + start, end - start);
+        buffer += end - start;
+        slot->last_use = ++pf->clock;
+    }
+
+    return 1;
+}
+
+/* Track the streams of sequential reads, and queue the chunks ahead of
+   them for loading. Must be called with the lock held. */
+static void
+prefetch_update(track_file_t *tf, prefetch_t *pf, uint64_t seek, size_t count)
+{
+    prefetch_stream_t *stream = NULL;
+    prefetch_slot_t   *slot;
+    int                queued = 0;
+
+    for (int i = 0; i < PREFETCH_STREAMS; i++) {
+        if ((seek + PREFETCH_GAP >= pf->streams[i].next) && (seek <= (pf->streams[i].next + PREFETCH_GAP))) {
+            stream = &pf->streams[i];
+            stream->hits++;
+            break;
+        }
+    }
+
+    if (stream == NULL) {
+        stream = &pf->streams[0];
+        for (int i = 1; i < PREFETCH_STREAMS; i++) {
+            if ((int32_t) (pf->streams[i].last_use - stream->last_use) < 0)
+                stream = &pf->streams[i];
+        }
+        stream->hits = 0;
+    }
+
+    stream->next     = seek + count;
+    stream->last_use = ++pf->clock;
+
+    if (stream->hits < PREFETCH_TRIGGER)
+        return;
+
+    if ((pf->thread == NULL) && !prefetch_start(pf, tf->fn)) {
+        /* Do not try again for this stream. */
+        stream->hits = 0;
+        return;
+    }
+
+    for (uint64_t c = stream->next / PREFETCH_CHUNK; c < ((stream->next / PREFETCH_CHUNK) + PREFETCH_WINDOW); c++) {
+        if (prefetch_find(pf, c) != NULL)
+            continue;
+
+        /* Reuse the least recently used chunk which is not being loaded. */
+        slot = NULL;
+        for (int i = 0; i < PREFETCH_SLOTS; i++) {
+            if ((pf->slots[i].state != PREFETCH_LOADING) &&
+                ((slot == NULL) || (pf->slots[i].state == PREFETCH_FREE) ||
+                 ((slot->state != PREFETCH_FREE) && ((int32_t) (pf->slots[i].last_use - slot->last_use) < 0))))
+                slot = &pf->slots[i];
+        }
+        if (slot == NULL)
+            break;
+
+        slot->state    = PREFETCH_QUEUED;
+        slot->chunk    = c;
+        slot->len      = 0;
+        slot->last_use = ++pf->clock;
+        queued++;
+    }
+
+    if (queued)
+        thread_set_event(pf->wake_event);
+}
+
+/* Binary file functions. */
+static int
+bin_read_file(track_file_t *tf, uint8_t *buffer, uint64_t seek, size_t count)
+{
     if (fseeko64(tf->fp, seek, SEEK_SET) == -1) {
 #ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
         cdrom_image_backend_log("CDROM: binary_read failed during seek!\n");
@@ -95,14 +344,41 @@ bin_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
     return 1;
 }
 
+static int
+bin_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
+{
+    track_file_t *tf = (track_file_t *) priv;
+    prefetch_t   *pf = (prefetch_t *) tf->priv;
+    int           ret;
+
+    cdrom_image_backend_log("CDROM: binary_read(%08lx, pos=%" PRIu64 " count=%lu\n",
+                            tf->fp, seek, count);
+
+    if (tf->fp == NULL)
+        return 0;
+
+    if ((pf == NULL) || (count == 0))
+        return bin_read_file(tf, buffer, seek, count);
+
+    /* The drive and the CD audio thread may read the same file. */
+    thread_wait_mutex(pf->mutex);
+    ret = prefetch_read(pf, buffer, seek, count);
+    if (!ret)
+        ret = bin_read_file(tf, buffer, seek, count);
+    prefetch_update(tf, pf, seek, count);
+    thread_release_mutex(pf->mutex);
+
+    return ret;
+}
+
 static uint64_t
 bin_get_length(void *priv)
 {
-    track_file_t *tf;
+    track_file_t *tf = (track_file_t *) priv;
 
     cdrom_image_backend_log("CDROM: binary_length(%08lx)\n", tf->fp);
 
-    if ((tf = (track_file_t *) priv)->fp == NULL)
+    if (tf->fp == NULL)
         return 0;
 
     fseeko64(tf->fp, 0, SEEK_END);
@@ -120,6 +396,11 @@ bin_close(void *priv)
     if (tf == NULL)
         return;
 
+    if (tf->priv != NULL) {
+        prefetch_close((prefetch_t *) tf->priv);
+        tf->priv = NULL;
+    }
+
     if (tf->fp != NULL) {
         fclose(tf->fp);
         tf->fp = NULL;
@@ -143,7 +424,8 @@ bin_init(const char *filename, int *error)
 
     memset(tf->fn, 0x00, sizeof(tf->fn));
     strncpy(tf->fn, filename, sizeof(tf->fn) - 1);
-    tf->fp = plat_fopen64(tf->fn, "rb");
+    tf->priv = NULL;
+    tf->fp   = plat_fopen64(tf->fn, "rb");
     cdrom_image_backend_log("CDROM: binary_open(%s) = %08lx\n", tf->fn, tf->fp);
 
     if (stat(tf->fn, &stats) != 0) {
@@ -157,6 +439,14 @@ bin_init(const char *filename, int *error)
         tf->read       = bin_read;
         tf->get_length = bin_get_length;
         tf->close      = bin_close;
+
+        /* The read-ahead thread itself is only started once a file is
+           being read sequentially. */
+        prefetch_t *pf = (prefetch_t *) calloc(1, sizeof(prefetch_t));
+        if (pf != NULL) {
+            pf->mutex = thread_create_mutex();
+            tf->priv  = pf;
+        }
     } else {
         /* From the check above, error may still be non-zero if opening a directory.
          * The error is set for viso to try and open the directory following this function.
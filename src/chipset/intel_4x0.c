@@ -15,6 +15,7 @@
  *          Copyright 2019-2020 Miran Grca.
  */
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -33,6 +34,8 @@
 #include <86box/spd.h>
 #include <86box/machine.h>
 #include <86box/agpgart.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 
 enum {
     INTEL_420TX,
@@ -1594,6 +1597,30 @@ i4x0_reset(void *priv)
     }
 }
 
+/* The memory and SMRAM state that the registers select is restored by the
+   core, and the AGP aperture by the GART, so only the registers and the
+   port 22h handler are left. */
+static void
+i4x0_save(void *priv, snapshot_t *s)
+{
+    i4x0_t *dev = (i4x0_t *) priv;
+
+    snapshot_write(s, dev, offsetof(i4x0_t, type));
+}
+
+static void
+i4x0_load(void *priv, snapshot_t *s)
+{
+    i4x0_t *dev = (i4x0_t *) priv;
+
+    snapshot_read(s, dev, offsetof(i4x0_t, type));
+
+    io_removehandler(0x0022, 0x01, pm2_cntrl_read, NULL, NULL, pm2_cntrl_write, NULL, NULL, dev);
+    if (((dev->type == INTEL_430TX) && (dev->regs[0x79] & 0x40)) ||
+        (((dev->type == INTEL_440BX) || (dev->type == INTEL_440ZX) || (dev->type == INTEL_440GX)) && (dev->regs[0x7a] & 0x40)))
+        io_sethandler(0x0022, 0x01, pm2_cntrl_read, NULL, NULL, pm2_cntrl_write, NULL, NULL, dev);
+}
+
 static void
 i4x0_close(void *priv)
 {
@@ -1970,7 +1997,9 @@ const device_t i420tx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i420zx_device = {
@@ -1984,7 +2013,9 @@ const device_t i420zx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i430lx_device = {
@@ -1998,7 +2029,9 @@ const device_t i430lx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i430nx_device = {
@@ -2012,7 +2045,9 @@ const device_t i430nx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i430fx_device = {
@@ -2026,7 +2061,9 @@ const device_t i430fx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i430fx_rev02_device = {
@@ -2040,7 +2077,9 @@ const device_t i430fx_rev02_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i430hx_device = {
@@ -2054,7 +2093,9 @@ const device_t i430hx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i430vx_device = {
@@ -2068,7 +2109,9 @@ const device_t i430vx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i430tx_device = {
@@ -2082,7 +2125,9 @@ const device_t i430tx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i440fx_device = {
@@ -2096,7 +2141,9 @@ const device_t i440fx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i440lx_device = {
@@ -2110,7 +2157,9 @@ const device_t i440lx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i440ex_device = {
@@ -2124,7 +2173,9 @@ const device_t i440ex_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i440bx_device = {
@@ -2138,7 +2189,9 @@ const device_t i440bx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i440bx_no_agp_device = {
@@ -2152,7 +2205,9 @@ const device_t i440bx_no_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i440gx_device = {
@@ -2166,7 +2221,9 @@ const device_t i440gx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
 
 const device_t i440zx_device = {
@@ -2180,5 +2237,7 @@ const device_t i440zx_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = i4x0_save,
+    .load          = i4x0_load
 };
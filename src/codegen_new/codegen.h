@@ -38,6 +38,10 @@ typedef struct codeblock_t {
     uint16_t flags;
     uint8_t  ins;
     uint8_t  TOP;
+    /*Execution count since the eviction clock hand last passed this block,
+      saturating at CODEBLOCK_HEAT_MAX. Halved on every pass of the hand;
+      only blocks which have cooled down to 0 are evicted.*/
+    uint8_t  heat;
 
     /*Pointers for codeblock tree, used to search for blocks when hash lookup
       fails.*/
@@ -82,6 +86,8 @@ extern uint8_t *block_write_data;
 /*Code block is not inlining immediate parameters, parameters must be fetched from memory*/
 #define CODEBLOCK_NO_IMMEDIATES 0x80
 
+#define CODEBLOCK_HEAT_MAX      255
+
 #define BLOCK_PC_INVALID        0xffffffff
 
 #define BLOCK_INVALID           0
@@ -292,6 +298,8 @@ codegen_mark_code_present(codeblock_t *block, uint32_t start_pc, int len)
 extern void codegen_init(void);
 extern void codegen_reset(void);
 extern void codegen_block_init(uint32_t phys_addr);
+extern void codegen_block_init_cached(uint32_t phys_addr, uint16_t flags);
+extern int  codegen_cache_lookup(uint32_t phys_addr, uint32_t block_cs, uint32_t block_pc, uint16_t *flags);
 extern void codegen_block_remove(void);
 extern void codegen_block_start_recompile(codeblock_t *block);
 extern void codegen_block_end_recompile(codeblock_t *block);
@@ -307,10 +315,23 @@ x86seg     *codegen_generate_ea(struct ir_data_t *ir, x86seg *op_ea_seg, uint32_
 extern void codegen_check_seg_read(codeblock_t *block, struct ir_data_t *ir, x86seg *seg);
 extern void codegen_check_seg_write(codeblock_t *block, struct ir_data_t *ir, x86seg *seg);
 
+/*Background compilation, see codegen_async.c*/
+extern int          codegen_async_submit(struct ir_data_t *ir, codeblock_t *block);
+extern int          codegen_async_busy(void);
+extern codeblock_t *codegen_async_block(void);
+extern void         codegen_async_poll(void);
+extern void         codegen_async_finish(void);
+
 extern int codegen_purge_purgable_list(void);
-/*Delete a random code block to free memory. This is obviously quite expensive, and
+/*Delete the least used code block to free memory, using a CLOCK sweep over the
+  code blocks weighted by their heat. This is obviously quite expensive, and
   will only be called when the allocator is out of memory*/
-extern void codegen_delete_random_block(int required_mem_block);
+extern void codegen_evict_block(int required_mem_block);
+
+/*Code cache statistics, for sizing the cache*/
+extern uint64_t codegen_stat_compiles;           /*Blocks compiled*/
+extern uint64_t codegen_stat_evictions;          /*Blocks evicted to free memory*/
+extern uint64_t codegen_stat_evicted_recompiles; /*Evicted blocks which were needed again*/
 
 extern int      cpu_block_end;
 extern uint32_t codegen_endpc;
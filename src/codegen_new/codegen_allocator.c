@@ -28,6 +28,14 @@ static mem_block_t mem_blocks[MEM_BLOCK_NR];
 static uint32_t    mem_block_free_list;
 static uint8_t    *mem_block_alloc = NULL;
 
+/*Blocks set aside for the background compile thread. The last mem_block_t is
+  never put on the free list; it is the scratch block handed out once the
+  reserve runs dry*/
+#define MEM_BLOCK_SCRATCH (MEM_BLOCK_NR - 1)
+static int      mem_block_reserve_active;
+static uint32_t mem_block_reserve;
+static int      mem_block_reserve_overflow;
+
 int codegen_allocator_usage = 0;
 
 void
@@ -46,7 +54,7 @@ codegen_allocator_init(void)
     for (uint32_t c = 0; c < MEM_BLOCK_NR; c++) {
         mem_blocks[c].offset     = c * MEM_BLOCK_SIZE;
         mem_blocks[c].code_block = BLOCK_INVALID;
-        if (c < MEM_BLOCK_NR - 1)
+        if (c < MEM_BLOCK_SCRATCH - 1)
             mem_blocks[c].next = c + 2;
         else
             mem_blocks[c].next = 0;
@@ -60,20 +68,30 @@ codegen_allocator_allocate(mem_block_t *parent, int code_block)
     mem_block_t *block;
     uint32_t     block_nr;
 
-    while (!mem_block_free_list) {
-        /*Pick a random memory block and free the owning code block*/
-        block_nr = rand() & MEM_BLOCK_MASK;
-        block    = &mem_blocks[block_nr];
+    if (mem_block_reserve_active) {
+        if (!mem_block_reserve) {
+            mem_block_reserve_overflow = 1;
+            return &mem_blocks[MEM_BLOCK_SCRATCH];
+        }
+        block_nr          = mem_block_reserve;
+        block             = &mem_blocks[block_nr - 1];
+        mem_block_reserve = block->next;
+        goto got_block;
+    }
 
-        if (block->code_block && block->code_block != code_block)
-            codegen_delete_block(&codeblock[block->code_block]);
+    while (!mem_block_free_list) {
+        /*Free the memory blocks of the least used code block. code_block is
+          the block being compiled, which is never picked*/
+        codegen_evict_block(1);
     }
 
     /*Remove from free list*/
     block_nr            = mem_block_free_list;
     block               = &mem_blocks[block_nr - 1];
     mem_block_free_list = block->next;
+    codegen_allocator_usage++;
 
+got_block:
     block->code_block = code_block;
     if (parent) {
         /*Add to parent list*/
@@ -82,9 +100,36 @@ codegen_allocator_allocate(mem_block_t *parent, int code_block)
     } else
         block->next = 0;
 
-    codegen_allocator_usage++;
     return block;
 }
+
+void
+codegen_allocator_reserve(int count)
+{
+    mem_block_reserve          = 0;
+    mem_block_reserve_overflow = 0;
+
+    while (count--) {
+        mem_block_t *block = codegen_allocator_allocate(NULL, BLOCK_INVALID);
+
+        block->next       = mem_block_reserve;
+        mem_block_reserve = (((uintptr_t) block - (uintptr_t) mem_blocks) / sizeof(mem_block_t)) + 1;
+    }
+
+    mem_block_reserve_active = 1;
+}
+
+int
+codegen_allocator_release_reserve(void)
+{
+    mem_block_reserve_active = 0;
+
+    if (mem_block_reserve)
+        codegen_allocator_free(&mem_blocks[mem_block_reserve - 1]);
+    mem_block_reserve = 0;
+
+    return mem_block_reserve_overflow;
+}
 void
 codegen_allocator_free(mem_block_t *block)
 {
@@ -34,6 +34,16 @@ uint8_t *codeblock_allocator_get_ptr(struct mem_block_t *block);
 /*Cache clean memory block list*/
 void codegen_allocator_clean_blocks(struct mem_block_t *block);
 
+/*Set aside count blocks for a compile running on the background thread. While
+  a reserve is set up, codegen_allocator_allocate() only hands out blocks from
+  it, and never evicts. If the reserve runs dry, a scratch block is returned
+  instead and the compile must be discarded*/
+#define MEM_BLOCK_RESERVE 64
+void codegen_allocator_reserve(int count);
+/*Return unused reserved blocks to the free list. Returns non-zero if the
+  reserve ran dry and the scratch block was handed out*/
+int codegen_allocator_release_reserve(void);
+
 extern int codegen_allocator_usage;
 
 #endif
@@ -0,0 +1,173 @@
+/*Background compilation.
+
+  The first pass of recompiling a block (codegen_block_start_recompile() to
+  codegen_block_end_recompile()) interprets each instruction while generating
+  its IR, and so has to run on the emulation thread. The second pass, register
+  allocation and host code generation in codegen_ir_compile(), only works on
+  the IR and can be moved to a worker thread.
+
+  With background compilation enabled, a finished IR block is handed to the
+  worker and the block is left without CODEBLOCK_WAS_RECOMPILED. Any block
+  that would be compiled while the worker is busy, including the one being
+  compiled, is interpreted instead. Once the worker is done, the block is
+  installed by setting CODEBLOCK_WAS_RECOMPILED; it is already on its page
+  lists, in the tree and in the hash table, so the usual dirty mask checks
+  apply before it is first run.
+
+  Only one block is compiled at a time, so the IR, register allocator and
+  code emitter state is owned by the worker while it runs. The emulation
+  thread does not touch the block being compiled: invalidating or deleting it
+  waits for the worker to finish first, and it is never picked for eviction.
+  Memory for the host code is set aside up front, as the worker must never
+  evict blocks itself.*/
+#if defined(__APPLE__) && defined(__aarch64__)
+#    include <pthread.h>
+#endif
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+#include <86box/plat_unused.h>
+#include <86box/thread.h>
+
+#include "codegen.h"
+#include "codegen_allocator.h"
+#include "codegen_backend.h"
+#include "codegen_ir.h"
+
+static thread_t   *async_thread;
+static event_t    *async_wake;
+static event_t    *async_done;
+static atomic_int  async_busy;
+static atomic_int  async_quit;
+static ir_data_t  *async_ir;
+static codeblock_t *async_job;
+
+/*Physical address of the last block whose host code did not fit in the
+  reserve. It is compiled on the emulation thread the next time round.*/
+static uint32_t async_sync_phys = -1;
+
+static void
+codegen_async_thread(UNUSED(void *param))
+{
+#if defined(__APPLE__) && defined(__aarch64__)
+    if (__builtin_available(macOS 11.0, *)) {
+        pthread_jit_write_protect_np(0);
+    }
+#endif
+
+    while (1) {
+        thread_wait_event(async_wake, -1);
+        thread_reset_event(async_wake);
+
+        if (atomic_load(&async_quit))
+            break;
+
+        if (atomic_load(&async_busy)) {
+            codegen_ir_compile(async_ir, async_job);
+
+            atomic_store(&async_busy, 0);
+            thread_set_event(async_done);
+        }
+    }
+}
+
+/*Install the block compiled by the worker. Must only be called once the
+  worker is idle*/
+static void
+codegen_async_retire(void)
+{
+    codeblock_t *block = async_job;
+
+    async_job = NULL;
+
+    if (codegen_allocator_release_reserve()) {
+        /*Host code did not fit in the reserve; throw it away*/
+        async_sync_phys = block->phys;
+        codegen_delete_block(block);
+        return;
+    }
+
+#if defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+    /*The worker has cleaned the new code out to the point of unification;
+      make sure this core does not run stale prefetched instructions*/
+    __asm__ volatile("isb" ::: "memory");
+#endif
+    block->flags |= CODEBLOCK_WAS_RECOMPILED;
+}
+
+int
+codegen_async_submit(ir_data_t *ir, codeblock_t *block)
+{
+    if (!cpu_dynarec_async || (block->phys == async_sync_phys)) {
+        async_sync_phys = -1;
+        return 0;
+    }
+
+    if (!async_thread) {
+        async_wake   = thread_create_event();
+        async_done   = thread_create_event();
+        atomic_store(&async_quit, 0);
+        async_thread = thread_create(codegen_async_thread, NULL);
+    }
+
+    codegen_allocator_reserve(MEM_BLOCK_RESERVE);
+
+    block->flags &= ~CODEBLOCK_WAS_RECOMPILED;
+    async_ir  = ir;
+    async_job = block;
+
+    thread_reset_event(async_done);
+    atomic_store(&async_busy, 1);
+    thread_set_event(async_wake);
+
+    return 1;
+}
+
+int
+codegen_async_busy(void)
+{
+    return async_job != NULL;
+}
+
+codeblock_t *
+codegen_async_block(void)
+{
+    return async_job;
+}
+
+void
+codegen_async_poll(void)
+{
+    if (async_job && !atomic_load(&async_busy))
+        codegen_async_retire();
+}
+
+void
+codegen_async_finish(void)
+{
+    if (!async_job)
+        return;
+
+    while (atomic_load(&async_busy))
+        thread_wait_event(async_done, -1);
+
+    codegen_async_retire();
+}
+
+void
+codegen_async_close(void)
+{
+    codegen_async_finish();
+
+    if (async_thread) {
+        atomic_store(&async_quit, 1);
+        thread_set_event(async_wake);
+        thread_wait(async_thread);
+        thread_destroy_event(async_wake);
+        thread_destroy_event(async_done);
+        async_thread = NULL;
+    }
+}
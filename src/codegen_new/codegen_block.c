@@ -1,7 +1,9 @@
 #include <inttypes.h>
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#define HAVE_STDARG_H
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/mem.h>
@@ -57,6 +59,44 @@ static int      last_ssegs;
 uint32_t instr_counts[256 * 256];
 #endif
 
+uint64_t codegen_stat_compiles;
+uint64_t codegen_stat_evictions;
+uint64_t codegen_stat_evicted_recompiles;
+
+#ifdef ENABLE_CODEGEN_BLOCK_LOG
+int codegen_block_do_log = ENABLE_CODEGEN_BLOCK_LOG;
+
+static void
+codegen_block_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (codegen_block_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define codegen_block_log(fmt, ...)
+#endif
+
+static void
+codegen_log_stats(void)
+{
+    codegen_block_log("Dynarec: %" PRIu64 " blocks compiled, %" PRIu64 " evicted, %" PRIu64 " evicted blocks recompiled\n",
+                      codegen_stat_compiles, codegen_stat_evictions, codegen_stat_evicted_recompiles);
+}
+
+/*Position of the eviction clock hand in the code block array*/
+static int evict_hand;
+
+/*Physical addresses of recently evicted blocks, hashed. Used to count blocks
+  that get recreated soon after eviction, a sign of the cache being too small.*/
+#define EVICT_HISTORY_SIZE 4096
+#define EVICT_HISTORY_MASK (EVICT_HISTORY_SIZE - 1)
+static uint32_t evict_history[EVICT_HISTORY_SIZE];
+
 static uint16_t block_free_list;
 static void     delete_block(codeblock_t *block);
 static void     delete_dirty_block(codeblock_t *block);
@@ -204,7 +244,7 @@ block_free_list_get(void)
         }
         /*Free list is empty - free up a block*/
         if (!codegen_purge_purgable_list())
-            codegen_delete_random_block(0);
+            codegen_evict_block(0);
     }
 
     block           = &codeblock[block_free_list];
@@ -225,6 +265,12 @@ codegen_init(void)
         block_free_list_add(&codeblock[c]);
     block_dirty_list_head = block_dirty_list_tail = 0;
     dirty_list_size                               = 0;
+
+    evict_hand                      = 0;
+    codegen_stat_compiles           = 0;
+    codegen_stat_evictions          = 0;
+    codegen_stat_evicted_recompiles = 0;
+    memset(evict_history, 0xff, sizeof(evict_history));
 #ifdef DEBUG_EXTRA
     memset(instr_counts, 0, sizeof(instr_counts));
 #endif
@@ -235,6 +281,9 @@ codegen_reset(void)
 {
     int c;
 
+    codegen_log_stats();
+    codegen_async_finish();
+
     for (c = 1; c < BLOCK_SIZE; c++) {
         codeblock_t *block = &codeblock[c];
 
@@ -370,6 +419,13 @@ invalidate_block(codeblock_t *block)
 {
     uint32_t old_pc = block->pc;
 
+    if (block == codegen_async_block()) {
+        codegen_async_finish();
+        /*Discarded if the host code did not fit*/
+        if (block->pc == BLOCK_PC_INVALID)
+            return;
+    }
+
 #ifndef RELEASE_BUILD
     if (block->flags & CODEBLOCK_IN_DIRTY_LIST)
         fatal("invalidate_block: already in dirty list\n");
@@ -388,6 +444,13 @@ delete_block(codeblock_t *block)
 {
     uint32_t old_pc = block->pc;
 
+    if (block == codegen_async_block()) {
+        codegen_async_finish();
+        /*Discarded if the host code did not fit*/
+        if (block->pc == BLOCK_PC_INVALID)
+            return;
+    }
+
     if (block == &codeblock[codeblock_hash[HASH(block->phys)]])
         codeblock_hash[HASH(block->phys)] = BLOCK_INVALID;
 
@@ -432,20 +495,29 @@ codegen_delete_block(codeblock_t *block)
 }
 
 void
-codegen_delete_random_block(int required_mem_block)
+codegen_evict_block(int required_mem_block)
 {
-    int block_nr = rand() & BLOCK_MASK;
-
     while (1) {
-        if (block_nr && block_nr != block_current) {
-            codeblock_t *block = &codeblock[block_nr];
+        evict_hand = (evict_hand + 1) & BLOCK_MASK;
+
+        if (evict_hand && evict_hand != block_current && &codeblock[evict_hand] != codegen_async_block()) {
+            codeblock_t *block = &codeblock[evict_hand];
 
             if (block->pc != BLOCK_PC_INVALID && (!required_mem_block || block->head_mem_block)) {
+                /*Give recently executed blocks another chance*/
+                if (block->heat) {
+                    block->heat >>= 1;
+                    continue;
+                }
+
+                evict_history[(block->phys >> 2) & EVICT_HISTORY_MASK] = block->phys;
+                codegen_stat_evictions++;
+                if (!(codegen_stat_evictions & 0xfff))
+                    codegen_log_stats();
                 delete_block(block);
                 return;
             }
         }
-        block_nr = (block_nr + 1) & BLOCK_MASK;
     }
 }
 
@@ -529,11 +601,54 @@ codegen_block_init(uint32_t phys_addr)
     block->page_mask = block->page_mask2 = 0;
     block->flags                         = CODEBLOCK_STATIC_TOP;
     block->status                        = cpu_cur_status;
+    block->heat                          = 0;
+
+    if (evict_history[(phys_addr >> 2) & EVICT_HISTORY_MASK] == phys_addr) {
+        evict_history[(phys_addr >> 2) & EVICT_HISTORY_MASK] = -1;
+        codegen_stat_evicted_recompiles++;
+    }
 
     recomp_page = block->phys & ~0xfff;
     codeblock_tree_add(block);
 }
 
+/*Set up a block found in the persistent block cache, so that it can be
+  recompiled straight away with the flags it ended up with last time, rather
+  than being interpreted and marked first. The first instruction's chunk is
+  marked as present so the block can go on the page's block list; the rest is
+  filled in by the recompilation that immediately follows*/
+void
+codegen_block_init_cached(uint32_t phys_addr, uint16_t flags)
+{
+    codeblock_t *block;
+    page_t      *page = &pages[phys_addr >> 12];
+
+    codegen_block_init(phys_addr);
+    block = &codeblock[block_current];
+
+    if ((flags & CODEBLOCK_BYTE_MASK) && (page->mem != page_ff) && page->byte_code_present_mask)
+        block->flags |= CODEBLOCK_BYTE_MASK;
+    if (flags & CODEBLOCK_NO_IMMEDIATES)
+        block->flags |= CODEBLOCK_NO_IMMEDIATES;
+    if ((flags & CODEBLOCK_HAS_FPU) && !(flags & CODEBLOCK_STATIC_TOP))
+        block->flags &= ~CODEBLOCK_STATIC_TOP;
+
+    if (block->flags & CODEBLOCK_BYTE_MASK) {
+        int offset = (phys_addr >> PAGE_BYTE_MASK_SHIFT) & PAGE_BYTE_MASK_OFFSET_MASK;
+
+        block->page_mask  = (uint64_t) 1 << (phys_addr & PAGE_BYTE_MASK_MASK);
+        block->dirty_mask = &page->byte_dirty_mask[offset];
+        page->byte_code_present_mask[offset] |= block->page_mask;
+    } else {
+        block->page_mask = (uint64_t) 1 << ((phys_addr >> PAGE_MASK_SHIFT) & PAGE_MASK_MASK);
+        page->code_present_mask |= block->page_mask;
+    }
+    block->phys_2 = -1;
+
+    add_to_block_list(block);
+    recomp_page = -1;
+}
+
 static ir_data_t *ir_data;
 
 ir_data_t *
@@ -561,6 +676,8 @@ codegen_block_start_recompile(codeblock_t *block)
     block->head_mem_block = codegen_allocator_allocate(NULL, block_current);
     block->data           = codeblock_allocator_get_ptr(block->head_mem_block);
 
+    codegen_stat_compiles++;
+
     block->status = cpu_cur_status;
 
     block->page_mask = block->page_mask2 = 0;
@@ -775,7 +892,8 @@ codegen_block_end_recompile(codeblock_t *block)
         block->flags &= ~CODEBLOCK_STATIC_TOP;
 
     codegen_accumulate_flush(ir_data);
-    codegen_ir_compile(ir_data, block);
+    if (!codegen_async_submit(ir_data, block))
+        codegen_ir_compile(ir_data, block);
 }
 
 void
@@ -0,0 +1,353 @@
+/*Persistent block profile cache.
+
+  Compiled host code can not be kept across runs, as it embeds host addresses
+  of the emulator's own data and functions, and the encoding picked for many
+  accesses depends on how far away those are. What is kept instead is the list
+  of blocks that were compiled, along with the flags they ended up with (byte
+  masks, no immediates, dynamic FPU top-of-stack). On the next boot of the same
+  machine, a block found in the cache is compiled the first time it is seen,
+  rather than being interpreted once to mark it first, and starts out with the
+  flags it needed last time rather than rediscovering them through
+  self-modifying code invalidations.
+
+  The IR can not be kept either. Many uops carry host pointers: the functions
+  called for instructions and helpers, the addresses of CPU state and of the
+  block itself, and the host addresses of jumps, all of which move between
+  runs with address space randomisation and between builds. Relocating them
+  would mean tagging the pointer operand of every uop type, and would only
+  save the decoding of the guest code, as register allocation and code
+  emission would still have to run for every block.
+
+  Entries are keyed on the physical address, CS base, PC and CPU status of the
+  block. A hash of the guest code bytes covered by the block is stored with
+  each entry, and an entry is only used if memory still holds the same code.
+  The cache file as a whole is only used with the same CPU and FPU. Since the
+  cache only affects when a block gets compiled, a stale entry costs time but
+  can not affect correctness.*/
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+#include <86box/path.h>
+#include <86box/plat.h>
+
+#include "codegen.h"
+#include "codegen_backend.h"
+
+#define CODEGEN_CACHE_MAGIC     "86BXDRC"
+#define CODEGEN_CACHE_VERSION   1
+#define CODEGEN_CACHE_MAX       65536
+#define CODEGEN_CACHE_HASH_SIZE (CODEGEN_CACHE_MAX * 2)
+#define CODEGEN_CACHE_HASH_MASK (CODEGEN_CACHE_HASH_SIZE - 1)
+#define CODEGEN_CACHE_FILE      "dynarec_cache.bin"
+
+enum {
+    ENTRY_UNUSED = 0,
+    ENTRY_USED,
+    ENTRY_STALE
+};
+
+typedef struct codegen_cache_header_t {
+    char     magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t cpu_hash;
+} codegen_cache_header_t;
+
+typedef struct codegen_cache_entry_t {
+    uint32_t phys;
+    uint32_t block_cs;
+    uint32_t block_pc;
+    uint16_t block_status;
+    uint16_t flags;
+    uint16_t len;
+    uint16_t state;
+    uint32_t pad;
+    uint64_t code_hash;
+} codegen_cache_entry_t;
+
+static codegen_cache_entry_t *entries;
+static uint32_t              *entry_hash; /*Entry index + 1, 0 if empty*/
+static uint32_t               entry_count;
+static uint32_t               entry_hits;  /*Blocks compiled on first sight this run*/
+static uint32_t               entry_stale; /*Entries whose code had changed*/
+
+#ifdef ENABLE_CODEGEN_CACHE_LOG
+int codegen_cache_do_log = ENABLE_CODEGEN_CACHE_LOG;
+
+static void
+codegen_cache_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (codegen_cache_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define codegen_cache_log(fmt, ...)
+#endif
+
+static uint64_t
+fnv1a(uint64_t hash, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *) data;
+
+    while (len--)
+        hash = (hash ^ *p++) * 0x100000001b3ULL;
+
+    return hash;
+}
+
+static uint64_t
+cpu_config_hash(void)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    hash = fnv1a(hash, cpu_f->internal_name, strlen(cpu_f->internal_name));
+    hash = fnv1a(hash, &cpu_s->cpu_type, sizeof(cpu_s->cpu_type));
+    hash = fnv1a(hash, &fpu_type, sizeof(fpu_type));
+    hash = fnv1a(hash, &fpu_softfloat, sizeof(fpu_softfloat));
+
+    return hash;
+}
+
+/*Hash the guest code of a block, straight from the RAM backing its page.
+  Returns 0 for pages not backed by RAM, which are never cached*/
+static int
+code_hash(uint32_t phys, int len, uint64_t *hash)
+{
+    const page_t *page = &pages[phys >> 12];
+
+    if ((page->mem == NULL) || (page->mem == page_ff) || (((phys & 0xfff) + len) > 0x1000))
+        return 0;
+
+    *hash = fnv1a(0xcbf29ce484222325ULL, &page->mem[phys & 0xfff], len);
+
+    return 1;
+}
+
+static uint32_t
+key_hash(uint32_t phys, uint32_t block_cs)
+{
+    uint32_t hash = (phys * 0x9e3779b1) ^ (block_cs * 0x85ebca6b);
+
+    return (hash ^ (hash >> 15)) & CODEGEN_CACHE_HASH_MASK;
+}
+
+static codegen_cache_entry_t *
+cache_find(uint32_t phys, uint32_t block_cs, uint32_t block_pc, uint16_t block_status)
+{
+    uint32_t h = key_hash(phys, block_cs);
+
+    while (entry_hash[h]) {
+        codegen_cache_entry_t *entry = &entries[entry_hash[h] - 1];
+
+        if ((entry->phys == phys) && (entry->block_cs == block_cs) && (entry->block_pc == block_pc) && (entry->block_status == block_status))
+            return entry;
+        h = (h + 1) & CODEGEN_CACHE_HASH_MASK;
+    }
+
+    return NULL;
+}
+
+static codegen_cache_entry_t *
+cache_add(uint32_t phys, uint32_t block_cs, uint32_t block_pc, uint16_t block_status)
+{
+    codegen_cache_entry_t *entry;
+    uint32_t               h = key_hash(phys, block_cs);
+
+    if (entry_count >= CODEGEN_CACHE_MAX)
+        return NULL;
+
+    while (entry_hash[h])
+        h = (h + 1) & CODEGEN_CACHE_HASH_MASK;
+
+    entry = &entries[entry_count++];
+    memset(entry, 0, sizeof(codegen_cache_entry_t));
+    entry->phys         = phys;
+    entry->block_cs     = block_cs;
+    entry->block_pc     = block_pc;
+    entry->block_status = block_status;
+    entry_hash[h]       = entry_count;
+
+    return entry;
+}
+
+/*Length of the guest code of a block within its first page*/
+static int
+block_code_len(codeblock_t *block)
+{
+    int      top = 63;
+    uint32_t end;
+
+    if (!block->page_mask)
+        return 0;
+
+    while (!(block->page_mask & ((uint64_t) 1 << top)))
+        top--;
+
+    if (block->flags & CODEBLOCK_BYTE_MASK)
+        end = (block->phys & ~0x3f) + top + 1;
+    else
+        end = (block->phys & ~0xfff) + ((top + 1) << PAGE_MASK_SHIFT);
+
+    return (end > block->phys) ? (end - block->phys) : 0;
+}
+
+void
+codegen_cache_close(void)
+{
+    free(entries);
+    free(entry_hash);
+    entries     = NULL;
+    entry_hash  = NULL;
+    entry_count = 0;
+    entry_hits  = 0;
+    entry_stale = 0;
+}
+
+void
+codegen_cache_load(void)
+{
+    codegen_cache_header_t header;
+    codegen_cache_entry_t  entry;
+    char                   fn[1024];
+    FILE                  *fp;
+
+    codegen_cache_close();
+
+    if (!cpu_dynarec_cache)
+        return;
+
+    entries    = (codegen_cache_entry_t *) calloc(CODEGEN_CACHE_MAX, sizeof(codegen_cache_entry_t));
+    entry_hash = (uint32_t *) calloc(CODEGEN_CACHE_HASH_SIZE, sizeof(uint32_t));
+    if ((entries == NULL) || (entry_hash == NULL)) {
+        codegen_cache_close();
+        return;
+    }
+
+    path_append_filename(fn, usr_path, CODEGEN_CACHE_FILE);
+    fp = plat_fopen(fn, "rb");
+    if (fp == NULL)
+        return;
+
+    if ((fread(&header, sizeof(header), 1, fp) == 1) && !memcmp(header.magic, CODEGEN_CACHE_MAGIC, sizeof(header.magic)) &&
+        (header.version == CODEGEN_CACHE_VERSION) && (header.cpu_hash == cpu_config_hash())) {
+        for (uint32_t c = 0; c < header.count; c++) {
+            codegen_cache_entry_t *new_entry;
+
+            if (fread(&entry, sizeof(entry), 1, fp) != 1)
+                break;
+            new_entry = cache_add(entry.phys, entry.block_cs, entry.block_pc, entry.block_status);
+            if (new_entry == NULL)
+                break;
+            new_entry->flags     = entry.flags;
+            new_entry->len       = entry.len;
+            new_entry->code_hash = entry.code_hash;
+        }
+    }
+    codegen_cache_log("codegen_cache_load: %u blocks\n", entry_count);
+
+    fclose(fp);
+}
+
+void
+codegen_cache_save(void)
+{
+    codegen_cache_header_t header;
+    char                   fn[1024];
+    FILE                  *fp;
+    uint32_t               count = 0;
+
+    if (entries == NULL)
+        return;
+
+    codegen_async_finish();
+
+    /*Merge the blocks compiled during this run into the cache*/
+    for (int c = 1; c < BLOCK_SIZE; c++) {
+        codeblock_t           *block = &codeblock[c];
+        codegen_cache_entry_t *entry;
+        uint64_t               hash;
+        int                    len;
+
+        if ((block->pc == BLOCK_PC_INVALID) || !(block->flags & CODEBLOCK_WAS_RECOMPILED) ||
+            (block->flags & CODEBLOCK_IN_DIRTY_LIST) || (*block->dirty_mask & block->page_mask))
+            continue;
+
+        len = block_code_len(block);
+        if (!len || !code_hash(block->phys, len, &hash))
+            continue;
+
+        entry = cache_find(block->phys, block->_cs, block->pc, block->status);
+        if (entry == NULL)
+            entry = cache_add(block->phys, block->_cs, block->pc, block->status);
+        if (entry == NULL)
+            break;
+
+        entry->flags     = block->flags & (CODEBLOCK_HAS_FPU | CODEBLOCK_STATIC_TOP | CODEBLOCK_BYTE_MASK | CODEBLOCK_NO_IMMEDIATES);
+        entry->len       = len;
+        entry->code_hash = hash;
+        entry->state     = ENTRY_UNUSED;
+    }
+
+    path_append_filename(fn, usr_path, CODEGEN_CACHE_FILE);
+    fp = plat_fopen(fn, "wb");
+    if (fp == NULL)
+        return;
+
+    for (uint32_t c = 0; c < entry_count; c++) {
+        if (entries[c].state != ENTRY_STALE)
+            count++;
+    }
+
+    memcpy(header.magic, CODEGEN_CACHE_MAGIC, sizeof(header.magic));
+    header.version  = CODEGEN_CACHE_VERSION;
+    header.count    = count;
+    header.cpu_hash = cpu_config_hash();
+    fwrite(&header, sizeof(header), 1, fp);
+
+    for (uint32_t c = 0; c < entry_count; c++) {
+        if (entries[c].state != ENTRY_STALE)
+            fwrite(&entries[c], sizeof(codegen_cache_entry_t), 1, fp);
+    }
+    codegen_cache_log("codegen_cache_save: %u blocks, %u used from the cache, %u stale\n", count, entry_hits, entry_stale);
+
+    fclose(fp);
+}
+
+int
+codegen_cache_lookup(uint32_t phys_addr, uint32_t block_cs, uint32_t block_pc, uint16_t *flags)
+{
+    codegen_cache_entry_t *entry;
+    uint64_t               hash;
+
+    if (entries == NULL)
+        return 0;
+
+    entry = cache_find(phys_addr, block_cs, block_pc, cpu_cur_status);
+    if ((entry == NULL) || (entry->state != ENTRY_UNUSED))
+        return 0;
+
+    /*Only ever use an entry once; after that the block is either compiled,
+      or has been evicted and goes through the normal path again*/
+    if (!code_hash(phys_addr, entry->len, &hash) || (hash != entry->code_hash)) {
+        entry->state = ENTRY_STALE;
+        entry_stale++;
+        return 0;
+    }
+
+    entry->state = ENTRY_USED;
+    entry_hits++;
+    *flags       = entry->flags;
+
+    return 1;
+}
@@ -389,6 +389,9 @@ load_machine(void)
         mem_size = machine_get_max_ram(machine);
 
     cpu_use_dynarec = !!ini_section_get_int(cat, "cpu_use_dynarec", 0);
+    cpu_dynarec_cache = !!ini_section_get_int(cat, "cpu_dynarec_cache", 0);
+    cpu_dynarec_async = !!ini_section_get_int(cat, "cpu_dynarec_async", 0);
+    mem_tlb_size = ini_section_get_int(cat, "mem_tlb_size", 1024);
     fpu_softfloat = !!ini_section_get_int(cat, "fpu_softfloat", 0);
     if ((fpu_type != FPU_NONE) && machine_has_flags(machine, MACHINE_SOFTFLOAT_ONLY))
         fpu_softfloat = 1;
@@ -635,6 +638,8 @@ load_sound(void)
     } else {
         fm_driver = FM_DRV_NUKED;
     }
+
+    fm_async = !!ini_section_get_int(cat, "fm_async", 0);
 }
 
 /* Load "Network" section. */
@@ -707,6 +712,8 @@ load_network(void)
                 nc->net_type = NET_TYPE_SLIRP;
             else if (!strcmp(p, "vde") || !strcmp(p, "2"))
                 nc->net_type = NET_TYPE_VDE;
+            else if (!strcmp(p, "switch"))
+                nc->net_type = NET_TYPE_SWITCH;
             else
                 nc->net_type = NET_TYPE_NONE;
         } else
@@ -734,6 +741,9 @@ load_network(void)
                                              (NET_LINK_10_HD | NET_LINK_10_FD |
                                               NET_LINK_100_HD | NET_LINK_100_FD |
                                               NET_LINK_1000_HD | NET_LINK_1000_FD));
+
+        sprintf(temp, "net_%02i_queue_len", c + 1);
+        nc->queue_len = ini_section_get_int(cat, temp, NET_QUEUE_LEN_DEF);
     }
 }
 
@@ -1055,6 +1065,20 @@ load_hard_disks(void)
         p = ini_section_get_string(cat, temp, "");
         strncpy(hdd[c].vhd_parent, p, sizeof(hdd[c].vhd_parent) - 1);
 
+        sprintf(temp, "hdd_%02i_mmap", c + 1);
+        hdd[c].use_mmap = !!ini_section_get_int(cat, temp, 0);
+
+        memset(hdd[c].overlay, 0x00, sizeof(hdd[c].overlay));
+        sprintf(temp, "hdd_%02i_overlay", c + 1);
+        p = ini_section_get_string(cat, temp, "");
+        if (p[0] != 0x00) {
+            if (path_abs(p))
+                strncpy(hdd[c].overlay, p, sizeof(hdd[c].overlay) - 1);
+            else
+                path_append_filename(hdd[c].overlay, usr_path, p);
+            path_normalize(hdd[c].overlay);
+        }
+
         /* If disk is empty or invalid, mark it for deletion. */
         if (!hdd_is_valid(c)) {
             sprintf(temp, "hdd_%02i_parameters", c + 1);
@@ -1128,6 +1152,8 @@ load_floppy_and_cdrom_drives(void)
         ui_writeprot[c] = !!ini_section_get_int(cat, temp, 0);
         sprintf(temp, "fdd_%02i_turbo", c + 1);
         fdd_set_turbo(c, !!ini_section_get_int(cat, temp, 0));
+        sprintf(temp, "fdd_%02i_sector_level", c + 1);
+        fdd_set_sector_level(c, !!ini_section_get_int(cat, temp, 0));
         sprintf(temp, "fdd_%02i_check_bpb", c + 1);
         fdd_set_check_bpb(c, !!ini_section_get_int(cat, temp, 1));
 
@@ -1149,6 +1175,10 @@ load_floppy_and_cdrom_drives(void)
             sprintf(temp, "fdd_%02i_turbo", c + 1);
             ini_section_delete_var(cat, temp);
         }
+        if (fdd_get_sector_level(c) == 0) {
+            sprintf(temp, "fdd_%02i_sector_level", c + 1);
+            ini_section_delete_var(cat, temp);
+        }
         if (fdd_get_check_bpb(c) == 1) {
             sprintf(temp, "fdd_%02i_check_bpb", c + 1);
             ini_section_delete_var(cat, temp);
@@ -1630,6 +1660,7 @@ config_load(void)
                 fdd_set_type(i, 0);
 
             fdd_set_turbo(i, 0);
+            fdd_set_sector_level(i, 0);
             fdd_set_check_bpb(i, 1);
         }
 
@@ -1951,6 +1982,18 @@ save_machine(void)
     ini_section_set_int(cat, "mem_size", mem_size);
 
     ini_section_set_int(cat, "cpu_use_dynarec", cpu_use_dynarec);
+    if (cpu_dynarec_cache)
+        ini_section_set_int(cat, "cpu_dynarec_cache", cpu_dynarec_cache);
+    else
+        ini_section_delete_var(cat, "cpu_dynarec_cache");
+    if (cpu_dynarec_async)
+        ini_section_set_int(cat, "cpu_dynarec_async", cpu_dynarec_async);
+    else
+        ini_section_delete_var(cat, "cpu_dynarec_async");
+    if (mem_tlb_size != 1024)
+        ini_section_set_int(cat, "mem_tlb_size", mem_tlb_size);
+    else
+        ini_section_delete_var(cat, "mem_tlb_size");
     ini_section_set_int(cat, "fpu_softfloat", fpu_softfloat);
 
     if (time_sync & TIME_SYNC_ENABLED)
@@ -2146,6 +2189,11 @@ save_sound(void)
 
     ini_section_set_string(cat, "fm_driver", (fm_driver == FM_DRV_NUKED) ? "nuked" : "ymfm");
 
+    if (fm_async)
+        ini_section_set_int(cat, "fm_async", fm_async);
+    else
+        ini_section_delete_var(cat, "fm_async");
+
     ini_delete_section_if_empty(config, cat);
 }
 
@@ -2184,6 +2232,9 @@ save_network(void)
             case NET_TYPE_VDE:
                 ini_section_set_string(cat, temp, "vde");
                 break;
+            case NET_TYPE_SWITCH:
+                ini_section_set_string(cat, temp, "switch");
+                break;
 
             default:
                 break;
@@ -2205,6 +2256,12 @@ save_network(void)
             ini_section_delete_var(cat, temp);
         else
             ini_section_set_int(cat, temp, nc->link_state);
+
+        sprintf(temp, "net_%02i_queue_len", c + 1);
+        if ((nc->queue_len <= 0) || (nc->queue_len == NET_QUEUE_LEN_DEF))
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, nc->queue_len);
     }
 
     ini_delete_section_if_empty(config, cat);
@@ -2481,6 +2538,22 @@ save_hard_disks(void)
         } else
             ini_section_delete_var(cat, temp);
 
+        sprintf(temp, "hdd_%02i_mmap", c + 1);
+        if (hdd_is_valid(c) && hdd[c].use_mmap)
+            ini_section_set_int(cat, temp, hdd[c].use_mmap);
+        else
+            ini_section_delete_var(cat, temp);
+
+        sprintf(temp, "hdd_%02i_overlay", c + 1);
+        if (hdd_is_valid(c) && hdd[c].overlay[0]) {
+            path_normalize(hdd[c].overlay);
+            if (!strnicmp(hdd[c].overlay, usr_path, strlen(usr_path)))
+                ini_section_set_string(cat, temp, &hdd[c].overlay[strlen(usr_path)]);
+            else
+                ini_section_set_string(cat, temp, hdd[c].overlay);
+        } else
+            ini_section_delete_var(cat, temp);
+
         sprintf(temp, "hdd_%02i_speed", c + 1);
         if (!hdd_is_valid(c) || ((hdd[c].bus != HDD_BUS_ESDI) && (hdd[c].bus != HDD_BUS_IDE) &&
             (hdd[c].bus != HDD_BUS_SCSI) && (hdd[c].bus != HDD_BUS_ATAPI)))
@@ -2537,6 +2610,12 @@ save_floppy_and_cdrom_drives(void)
         else
             ini_section_set_int(cat, temp, fdd_get_turbo(c));
 
+        sprintf(temp, "fdd_%02i_sector_level", c + 1);
+        if (fdd_get_sector_level(c) == 0)
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, fdd_get_sector_level(c));
+
         sprintf(temp, "fdd_%02i_check_bpb", c + 1);
         if (fdd_get_check_bpb(c) == 1)
             ini_section_delete_var(cat, temp);
@@ -16,6 +16,7 @@
 #include "x86seg_common.h"
 #include "x87_sf.h"
 #include "x87.h"
+#include <86box/io.h>
 #include <86box/nmi.h>
 #include <86box/mem.h>
 #include <86box/smram.h>
@@ -1682,6 +1683,65 @@ checkio(uint32_t port, int mask)
     return mask;
 }
 
+/* How many elements of a forward REP INS/OUTS from offset on can be done in
+   one go: they must all lie in the segment limit, in the address size, and in
+   the same page. */
+static uint32_t
+rep_io_block_count(const x86seg *seg, uint32_t offset, uint32_t count, int size, int addr32)
+{
+    uint32_t addr = seg->base + offset;
+    uint32_t n;
+
+    if ((cpu_state.flags & D_FLAG) || trap || (seg->base == 0xffffffff))
+        return 0;
+#ifdef USE_DEBUG_REGS_486
+    if (dr[7] & 0xFF)
+        return 0;
+#endif
+    if ((offset < seg->limit_low) || (offset > seg->limit_high))
+        return 0;
+
+    n = (0x1000 - (addr & 0xfff)) / size;
+    if (!addr32 && (((0x10000 - offset) / size) < n))
+        n = (0x10000 - offset) / size;
+    if ((((uint64_t) seg->limit_high - offset + 1) / size) < n)
+        n = (seg->limit_high - offset + 1) / size;
+    if (count < n)
+        n = count;
+
+    return n;
+}
+
+/* Once the first element of a REP INS has gone the normal way, and so through
+   the I/O permission and segment checks, the elements that follow it on the
+   same page can be read straight into memory by the port's block handler, if
+   the page is plain RAM with a write lookup. Returns how many were done; the
+   caller goes on one element at a time from there. */
+uint32_t
+rep_ins_block(uint16_t port, uint32_t offset, uint32_t count, int size, int addr32)
+{
+    uint32_t n    = rep_io_block_count(&cpu_state.seg_es, offset, count, size, addr32);
+    uint32_t addr = es + offset;
+
+    if (!n || (writelookup2[addr >> 12] == (uintptr_t) LOOKUP_INV))
+        return 0;
+
+    return io_in_block(port, (void *) (writelookup2[addr >> 12] + (uintptr_t) addr), size, n);
+}
+
+/* Same for REP OUTS, from a page with a read lookup. */
+uint32_t
+rep_outs_block(uint16_t port, const x86seg *seg, uint32_t offset, uint32_t count, int size, int addr32)
+{
+    uint32_t n    = rep_io_block_count(seg, offset, count, size, addr32);
+    uint32_t addr = seg->base + offset;
+
+    if (!n || (readlookup2[addr >> 12] == (uintptr_t) LOOKUP_INV))
+        return 0;
+
+    return io_out_block(port, (const void *) (readlookup2[addr >> 12] + (uintptr_t) addr), size, n);
+}
+
 #ifdef OLD_DIVEXCP
 #    define divexcp()                                                                       \
         {                                                                                   \
@@ -1948,7 +2008,7 @@ sysexit(uint32_t fetchdat)
 
     cpu_cur_status &= ~(CPU_STATUS_NOTFLATSS /* | CPU_STATUS_V86*/);
     cpu_cur_status |= (CPU_STATUS_USE32 | CPU_STATUS_STACK32 | CPU_STATUS_PMODE);
-    flushmmucache_nopc();
+    flushmmucache_supervisor();
     set_use32(1);
     set_stack32(1);
 
@@ -2069,7 +2129,7 @@ sysret(uint32_t fetchdat)
 
     cpu_cur_status &= ~(CPU_STATUS_NOTFLATSS /* | CPU_STATUS_V86*/);
     cpu_cur_status |= (CPU_STATUS_USE32 | CPU_STATUS_STACK32 | CPU_STATUS_PMODE);
-    flushmmucache_nopc();
+    flushmmucache_supervisor();
     set_use32(1);
     set_stack32(1);
 
@@ -205,6 +205,9 @@
 
 int checkio(uint32_t port, int mask);
 
+extern uint32_t rep_ins_block(uint16_t port, uint32_t offset, uint32_t count, int size, int addr32);
+extern uint32_t rep_outs_block(uint16_t port, const x86seg *seg, uint32_t offset, uint32_t count, int size, int addr32);
+
 #define check_io_perm(port, size)                                    \
     if (msw & 1 && ((CPL > IOPL) || (cpu_state.eflags & VM_FLAG))) { \
         int tempi = checkio(port, (1 << size) - 1);                  \
@@ -400,6 +400,8 @@ exec386_dynarec_dyn(void)
     int valid_block = 0;
 
 #    ifdef USE_NEW_DYNAREC
+    codegen_async_poll();
+
     if (!cpu_state.abrt)
 #    else
     if (block && !cpu_state.abrt)
@@ -507,6 +509,20 @@ exec386_dynarec_dyn(void)
         }
     }
 
+#    ifdef USE_NEW_DYNAREC
+    if (!valid_block && !cpu_state.abrt && cpu_dynarec_cache && !codegen_async_busy()) {
+        uint16_t flags;
+
+        /* Block was compiled on a previous run, compile it straight away
+           rather than marking it first */
+        if (codegen_cache_lookup(phys_addr, cs, cs + cpu_state.pc, &flags)) {
+            codegen_block_init_cached(phys_addr, flags);
+            block       = &codeblock[block_current];
+            valid_block = 1;
+        }
+    }
+#    endif
+
 #    ifdef USE_NEW_DYNAREC
     if (valid_block && (block->flags & CODEBLOCK_WAS_RECOMPILED))
 #    else
@@ -517,6 +533,9 @@ exec386_dynarec_dyn(void)
 
 #    ifndef USE_NEW_DYNAREC
         codeblock_hash[hash] = block;
+#    else
+        if (block->heat < CODEBLOCK_HEAT_MAX)
+            block->heat++;
 #    endif
         inrecomp = 1;
         code();
@@ -528,6 +547,12 @@ exec386_dynarec_dyn(void)
 #    ifndef USE_NEW_DYNAREC
         if (!use32)
             cpu_state.pc &= 0xffff;
+#    endif
+#    ifdef USE_NEW_DYNAREC
+    } else if (valid_block && !cpu_state.abrt && codegen_async_busy()) {
+        /* Another block is being compiled in the background, interpret
+           this one for now and compile it when it is next seen */
+        exec386_dynarec_int();
 #    endif
     } else if (valid_block && !cpu_state.abrt) {
 #    ifdef USE_NEW_DYNAREC
@@ -52,6 +52,16 @@
 extern void codegen_init(void);
 extern void codegen_flush(void);
 
+#ifdef USE_NEW_DYNAREC
+/*Persistent block profile cache, see codegen_cache.c*/
+extern void codegen_cache_load(void);
+extern void codegen_cache_save(void);
+extern void codegen_cache_close(void);
+
+/*Background compilation, see codegen_async.c*/
+extern void codegen_async_close(void);
+#endif
+
 /*Current physical page of block being recompiled. -1 if no recompilation taking place */
 extern uint32_t recomp_page;
 extern int      codegen_in_recompile;
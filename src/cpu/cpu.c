@@ -40,6 +40,8 @@
 #include <86box/nmi.h>
 #include <86box/pic.h>
 #include <86box/pci.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 #include <86box/gdbstub.h>
 #include <86box/plat_fallthrough.h>
 #include <86box/plat_unused.h>
@@ -4382,3 +4384,118 @@ cpu_update_waitstates(void)
     if (cpu_s->rspeed <= 8000000)
         cpu_rom_prefetch_cycles = cpu_mem_prefetch_cycles;
 }
+
+/* The CPU is saved as a whole, with the host FPU control words, as a
+   snapshot is only ever loaded by the same build it was saved by. */
+void
+cpu_save(snapshot_t *s)
+{
+    uint32_t size = sizeof(cpu_state_t);
+
+    snapshot_write_var(s, size);
+    snapshot_write_var(s, cpu_state);
+    snapshot_write_var(s, fpu_state);
+    snapshot_write_var(s, msr);
+
+    snapshot_write_var(s, cr2);
+    snapshot_write_var(s, cr3);
+    snapshot_write_var(s, cr4);
+    snapshot_write_var(s, dr);
+    snapshot_write_var(s, gdt);
+    snapshot_write_var(s, ldt);
+    snapshot_write_var(s, idt);
+    snapshot_write_var(s, tr);
+
+    snapshot_write_var(s, use32);
+    snapshot_write_var(s, stack32);
+    snapshot_write_var(s, oldcpl);
+    snapshot_write_var(s, cpu_cur_status);
+    snapshot_write_var(s, cs_msr);
+    snapshot_write_var(s, esp_msr);
+    snapshot_write_var(s, eip_msr);
+    snapshot_write_var(s, amd_efer);
+    snapshot_write_var(s, star);
+
+    snapshot_write_var(s, in_sys);
+    snapshot_write_var(s, smi_latched);
+    snapshot_write_var(s, smm_in_hlt);
+    snapshot_write_var(s, smi_block);
+    snapshot_write_var(s, nmi);
+    snapshot_write_var(s, nmi_mask);
+    snapshot_write_var(s, nmi_auto_clear);
+
+    snapshot_write_var(s, cpu_cache_int_enabled);
+    snapshot_write_var(s, cpu_cache_ext_enabled);
+    snapshot_write_var(s, cpu_fast_off_count);
+    snapshot_write_var(s, cpu_fast_off_val);
+    snapshot_write_var(s, cpu_fast_off_flags);
+
+    snapshot_write_var(s, tsc);
+}
+
+void
+cpu_load(snapshot_t *s)
+{
+    uint32_t size;
+    uint64_t new_tsc;
+
+    snapshot_read_var(s, size);
+    if (size != sizeof(cpu_state_t)) {
+        pclog("CPU: snapshot CPU state is %u bytes, expected %u\n", size, (uint32_t) sizeof(cpu_state_t));
+        snapshot_set_error(s);
+        return;
+    }
+
+    snapshot_read_var(s, cpu_state);
+    snapshot_read_var(s, fpu_state);
+    snapshot_read_var(s, msr);
+
+    snapshot_read_var(s, cr2);
+    snapshot_read_var(s, cr3);
+    snapshot_read_var(s, cr4);
+    snapshot_read_var(s, dr);
+    snapshot_read_var(s, gdt);
+    snapshot_read_var(s, ldt);
+    snapshot_read_var(s, idt);
+    snapshot_read_var(s, tr);
+
+    snapshot_read_var(s, use32);
+    snapshot_read_var(s, stack32);
+    snapshot_read_var(s, oldcpl);
+    snapshot_read_var(s, cpu_cur_status);
+    snapshot_read_var(s, cs_msr);
+    snapshot_read_var(s, esp_msr);
+    snapshot_read_var(s, eip_msr);
+    snapshot_read_var(s, amd_efer);
+    snapshot_read_var(s, star);
+
+    snapshot_read_var(s, in_sys);
+    snapshot_read_var(s, smi_latched);
+    snapshot_read_var(s, smm_in_hlt);
+    snapshot_read_var(s, smi_block);
+    snapshot_read_var(s, nmi);
+    snapshot_read_var(s, nmi_mask);
+    snapshot_read_var(s, nmi_auto_clear);
+
+    snapshot_read_var(s, cpu_cache_int_enabled);
+    snapshot_read_var(s, cpu_cache_ext_enabled);
+    snapshot_read_var(s, cpu_fast_off_count);
+    snapshot_read_var(s, cpu_fast_off_val);
+    snapshot_read_var(s, cpu_fast_off_flags);
+
+    /* The timers are armed against the TSC, so move them along with it. */
+    snapshot_read_var(s, new_tsc);
+    timer_shift((new_tsc - tsc) << 32ULL);
+    tsc = new_tsc;
+
+    /* This points into cpu_state itself, which may have moved. */
+    cpu_state.ea_seg = &cpu_state.seg_ds;
+    cpu_state.abrt   = 0;
+    cpl_override     = 0;
+
+    cpu_update_waitstates();
+    flushmmucache();
+#ifdef USE_DYNAREC
+    codegen_reset();
+#endif
+}
@@ -676,6 +676,9 @@ extern int cpu_has_feature(int feature);
 extern char *cpu_current_pc(char *bufp);
 
 extern void cpu_update_waitstates(void);
+struct snapshot_t;
+extern void cpu_save(struct snapshot_t *s);
+extern void cpu_load(struct snapshot_t *s);
 extern void cpu_set(void);
 extern void cpu_close(void);
 extern void cpu_set_isa_speed(int speed);
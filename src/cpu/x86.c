@@ -14,6 +14,7 @@
  *          Copyright 2015-2020 Andrew Jenner.
  *          Copyright 2016-2020 Miran Grca.
  */
+#include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdint.h>
@@ -41,6 +42,9 @@
 #include <86box/timer.h>
 #include <86box/video.h>
 #include <86box/vid_svga.h>
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+#    include "codegen.h"
+#endif
 
 /* The opcode of the instruction currently being executed. */
 uint8_t opcode;
@@ -140,7 +144,11 @@ dumpregs(int force)
         x86_log("AX=%04X BX=%04X CX=%04X DX=%04X DI=%04X SI=%04X BP=%04X SP=%04X\n",
                 AX, BX, CX, DX, DI, SI, BP, SP);
     }
-    x86_log("Entries in readlookup : %i    writelookup : %i\n", readlnum, writelnum);
+    x86_log("Soft TLB : %u fills, %u evictions, %u flushes, %u entries kept\n", tlb_fills, tlb_evictions, tlb_flushes, tlb_kept);
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    x86_log("Dynarec : %" PRIu64 " blocks compiled, %" PRIu64 " evicted, %" PRIu64 " evicted blocks recompiled\n",
+            codegen_stat_compiles, codegen_stat_evictions, codegen_stat_evicted_recompiles);
+#endif
     x87_dumpregs();
     indump = 0;
 }
@@ -29,6 +29,16 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 15;                                                                                   \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_ins_block(DX, DEST_REG, CNT_REG, 1, sizeof(DEST_REG) == 4);                    \
+                DEST_REG += blk;                                                                                  \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 15 * blk;                                                                               \
+                reads += blk;                                                                                     \
+                writes += blk;                                                                                    \
+                total_cycles += 15 * blk;                                                                         \
+            }                                                                                                     \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
@@ -68,6 +78,16 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 15;                                                                                   \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_ins_block(DX, DEST_REG, CNT_REG, 2, sizeof(DEST_REG) == 4);                    \
+                DEST_REG += blk << 1;                                                                             \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 15 * blk;                                                                               \
+                reads += blk;                                                                                     \
+                writes += blk;                                                                                    \
+                total_cycles += 15 * blk;                                                                         \
+            }                                                                                                     \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
@@ -107,6 +127,16 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 15;                                                                                   \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_ins_block(DX, DEST_REG, CNT_REG, 4, sizeof(DEST_REG) == 4);                    \
+                DEST_REG += blk << 2;                                                                             \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 15 * blk;                                                                               \
+                reads += blk;                                                                                     \
+                writes += blk;                                                                                    \
+                total_cycles += 15 * blk;                                                                         \
+            }                                                                                                     \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, 0, reads, 0, writes, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
@@ -139,6 +169,16 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 14;                                                                                   \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_outs_block(DX, cpu_state.ea_seg, SRC_REG, CNT_REG, 1, sizeof(SRC_REG) == 4);   \
+                SRC_REG += blk;                                                                                   \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 14 * blk;                                                                               \
+                reads += blk;                                                                                     \
+                writes += blk;                                                                                    \
+                total_cycles += 14 * blk;                                                                         \
+            }                                                                                                     \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
@@ -170,6 +210,16 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 14;                                                                                   \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_outs_block(DX, cpu_state.ea_seg, SRC_REG, CNT_REG, 2, sizeof(SRC_REG) == 4);   \
+                SRC_REG += blk << 1;                                                                              \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 14 * blk;                                                                               \
+                reads += blk;                                                                                     \
+                writes += blk;                                                                                    \
+                total_cycles += 14 * blk;                                                                         \
+            }                                                                                                     \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
@@ -201,6 +251,16 @@
             reads++;                                                                                              \
             writes++;                                                                                             \
             total_cycles += 14;                                                                                   \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_outs_block(DX, cpu_state.ea_seg, SRC_REG, CNT_REG, 4, sizeof(SRC_REG) == 4);   \
+                SRC_REG += blk << 2;                                                                              \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 14 * blk;                                                                               \
+                reads += blk;                                                                                     \
+                writes += blk;                                                                                    \
+                total_cycles += 14 * blk;                                                                         \
+            }                                                                                                     \
         }                                                                                                         \
         PREFETCH_RUN(total_cycles, 1, -1, 0, reads, 0, writes, 0);                                                \
         if (CNT_REG > 0) {                                                                                        \
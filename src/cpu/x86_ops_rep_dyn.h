@@ -24,6 +24,13 @@
                 DEST_REG++;                                                                                       \
             CNT_REG--;                                                                                            \
             cycles -= 15;                                                                                         \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_ins_block(DX, DEST_REG, CNT_REG, 1, sizeof(DEST_REG) == 4);                    \
+                DEST_REG += blk;                                                                                  \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 15 * blk;                                                                               \
+            }                                                                                                     \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -57,6 +64,13 @@
                 DEST_REG += 2;                                                                                    \
             CNT_REG--;                                                                                            \
             cycles -= 15;                                                                                         \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_ins_block(DX, DEST_REG, CNT_REG, 2, sizeof(DEST_REG) == 4);                    \
+                DEST_REG += blk << 1;                                                                             \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 15 * blk;                                                                               \
+            }                                                                                                     \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -90,6 +104,13 @@
                 DEST_REG += 4;                                                                                    \
             CNT_REG--;                                                                                            \
             cycles -= 15;                                                                                         \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_ins_block(DX, DEST_REG, CNT_REG, 4, sizeof(DEST_REG) == 4);                    \
+                DEST_REG += blk << 2;                                                                             \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 15 * blk;                                                                               \
+            }                                                                                                     \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -116,6 +137,13 @@
                 SRC_REG++;                                                                                        \
             CNT_REG--;                                                                                            \
             cycles -= 14;                                                                                         \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_outs_block(DX, cpu_state.ea_seg, SRC_REG, CNT_REG, 1, sizeof(SRC_REG) == 4);   \
+                SRC_REG += blk;                                                                                   \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 14 * blk;                                                                               \
+            }                                                                                                     \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -141,6 +169,13 @@
                 SRC_REG += 2;                                                                                     \
             CNT_REG--;                                                                                            \
             cycles -= 14;                                                                                         \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_outs_block(DX, cpu_state.ea_seg, SRC_REG, CNT_REG, 2, sizeof(SRC_REG) == 4);   \
+                SRC_REG += blk << 1;                                                                              \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 14 * blk;                                                                               \
+            }                                                                                                     \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
@@ -166,6 +201,13 @@
                 SRC_REG += 4;                                                                                     \
             CNT_REG--;                                                                                            \
             cycles -= 14;                                                                                         \
+                                                                                                                  \
+            if (CNT_REG > 0) {                                                                                    \
+                uint32_t blk = rep_outs_block(DX, cpu_state.ea_seg, SRC_REG, CNT_REG, 4, sizeof(SRC_REG) == 4);   \
+                SRC_REG += blk << 2;                                                                              \
+                CNT_REG -= blk;                                                                                   \
+                cycles -= 14 * blk;                                                                               \
+            }                                                                                                     \
         }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             CPU_BLOCK_END();                                                                                      \
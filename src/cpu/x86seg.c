@@ -533,7 +533,7 @@ loadcs(uint16_t seg)
             do_seg_load(&cpu_state.seg_cs, segdat);
             use32 = (segdat[3] & 0x40) ? 0x300 : 0;
             if ((CPL == 3) && (oldcpl != 3))
-                flushmmucache_nopc();
+                flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
             oldcpl = CPL;
 #endif
@@ -562,7 +562,7 @@ loadcs(uint16_t seg)
         cpu_state.seg_cs.access     = (cpu_state.eflags & VM_FLAG) ? 0xe2 : 0x82;
         cpu_state.seg_cs.ar_high    = 0x10;
         if ((CPL == 3) && (oldcpl != 3))
-            flushmmucache_nopc();
+            flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
         oldcpl = CPL;
 #endif
@@ -632,7 +632,7 @@ loadcsjmp(uint16_t seg, uint32_t old_pc)
 
             do_seg_load(&cpu_state.seg_cs, segdat);
             if ((CPL == 3) && (oldcpl != 3))
-                flushmmucache_nopc();
+                flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
             oldcpl = CPL;
 #endif
@@ -710,7 +710,7 @@ loadcsjmp(uint16_t seg, uint32_t old_pc)
                             CS = seg2;
                             do_seg_load(&cpu_state.seg_cs, segdat);
                             if ((CPL == 3) && (oldcpl != 3))
-                                flushmmucache_nopc();
+                                flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
                             oldcpl = CPL;
 #endif
@@ -753,7 +753,7 @@ loadcsjmp(uint16_t seg, uint32_t old_pc)
         cpu_state.seg_cs.access     = (cpu_state.eflags & VM_FLAG) ? 0xe2 : 0x82;
         cpu_state.seg_cs.ar_high    = 0x10;
         if ((CPL == 3) && (oldcpl != 3))
-            flushmmucache_nopc();
+            flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
         oldcpl = CPL;
 #endif
@@ -934,7 +934,7 @@ loadcscall(uint16_t seg)
             CS = seg;
             do_seg_load(&cpu_state.seg_cs, segdat);
             if ((CPL == 3) && (oldcpl != 3))
-                flushmmucache_nopc();
+                flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
             oldcpl = CPL;
 #endif
@@ -1077,7 +1077,7 @@ loadcscall(uint16_t seg)
                                 CS = seg2;
                                 do_seg_load(&cpu_state.seg_cs, segdat);
                                 if ((CPL == 3) && (oldcpl != 3))
-                                    flushmmucache_nopc();
+                                    flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
                                 oldcpl = CPL;
 #endif
@@ -1159,7 +1159,7 @@ loadcscall(uint16_t seg)
                             CS = seg2;
                             do_seg_load(&cpu_state.seg_cs, segdat);
                             if ((CPL == 3) && (oldcpl != 3))
-                                flushmmucache_nopc();
+                                flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
                             oldcpl = CPL;
 #endif
@@ -1204,7 +1204,7 @@ loadcscall(uint16_t seg)
         cpu_state.seg_cs.access     = (cpu_state.eflags & VM_FLAG) ? 0xe2 : 0x82;
         cpu_state.seg_cs.ar_high    = 0x10;
         if ((CPL == 3) && (oldcpl != 3))
-            flushmmucache_nopc();
+            flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
         oldcpl = CPL;
 #endif
@@ -1319,7 +1319,7 @@ pmoderetf(int is32, uint16_t off)
         do_seg_load(&cpu_state.seg_cs, segdat);
         cpu_state.seg_cs.access = (cpu_state.seg_cs.access & ~(3 << 5)) | ((CS & 3) << 5);
         if ((CPL == 3) && (oldcpl != 3))
-            flushmmucache_nopc();
+            flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
         oldcpl = CPL;
 #endif
@@ -1432,7 +1432,7 @@ pmoderetf(int is32, uint16_t off)
         CS           = seg;
         do_seg_load(&cpu_state.seg_cs, segdat);
         if ((CPL == 3) && (oldcpl != 3))
-            flushmmucache_nopc();
+            flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
         oldcpl = CPL;
 #endif
@@ -1693,7 +1693,7 @@ pmodeint(int num, int soft)
             CS                      = (seg & 0xfffc) | new_cpl;
             cpu_state.seg_cs.access = (cpu_state.seg_cs.access & ~0x60) | (new_cpl << 5);
             if ((CPL == 3) && (oldcpl != 3))
-                flushmmucache_nopc();
+                flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
             oldcpl = CPL;
 #endif
@@ -1870,7 +1870,7 @@ pmodeiret(int is32)
             cpu_state.seg_cs.access     = 0xe2;
             cpu_state.seg_cs.ar_high    = 0x10;
             if ((CPL == 3) && (oldcpl != 3))
-                flushmmucache_nopc();
+                flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
             oldcpl = CPL;
 #endif
@@ -1955,7 +1955,7 @@ pmodeiret(int is32)
         do_seg_load(&cpu_state.seg_cs, segdat);
         cpu_state.seg_cs.access = (cpu_state.seg_cs.access & ~0x60) | ((CS & 0x0003) << 5);
         if ((CPL == 3) && (oldcpl != 3))
-            flushmmucache_nopc();
+            flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
         oldcpl = CPL;
 #endif
@@ -2044,7 +2044,7 @@ pmodeiret(int is32)
         do_seg_load(&cpu_state.seg_cs, segdat);
         cpu_state.seg_cs.access = (cpu_state.seg_cs.access & ~0x60) | ((CS & 3) << 5);
         if ((CPL == 3) && (oldcpl != 3))
-            flushmmucache_nopc();
+            flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
         oldcpl = CPL;
 #endif
@@ -2199,7 +2199,7 @@ taskswitch286(uint16_t seg, uint16_t *segdat, int is32)
         cr0 |= 8;
 
         cr3 = new_cr3;
-        flushmmucache();
+        flushmmucache_nonglobal();
 
         cpu_state.pc     = new_pc;
         cpu_state.flags  = new_flags;
@@ -2263,7 +2263,7 @@ taskswitch286(uint16_t seg, uint16_t *segdat, int is32)
             CS = new_cs;
             do_seg_load(&cpu_state.seg_cs, segdat2);
             if ((CPL == 3) && (oldcpl != 3))
-                flushmmucache_nopc();
+                flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
             oldcpl = CPL;
 #endif
@@ -2444,7 +2444,7 @@ taskswitch286(uint16_t seg, uint16_t *segdat, int is32)
         CS = new_cs;
         do_seg_load(&cpu_state.seg_cs, segdat2);
         if ((CPL == 3) && (oldcpl != 3))
-            flushmmucache_nopc();
+            flushmmucache_supervisor();
 #ifdef USE_NEW_DYNAREC
         oldcpl = CPL;
 #endif
@@ -54,6 +54,8 @@
 #include <86box/mem.h>
 #include <86box/rom.h>
 #include <86box/sound.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 
 #define DEVICE_MAX 256 /* max # of devices */
 
@@ -318,6 +320,58 @@ device_reset_all(uint32_t match_flags)
 #endif
 }
 
+static const char *
+device_snapshot_name(const device_t *dev)
+{
+    return dev->internal_name ? dev->internal_name : dev->name;
+}
+
+/* A device without save and load callbacks would come back from a snapshot
+   in its post-reset state, under a guest that expects otherwise, so such
+   devices are named and counted here, and the save is refused. */
+int
+device_snapshot_check(void)
+{
+    int missing = 0;
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] != NULL) && ((devices[c]->save == NULL) || (devices[c]->load == NULL))) {
+            pclog("DEVICE: device '%s' has no snapshot support\n", device_snapshot_name(devices[c]));
+            missing++;
+        }
+    }
+
+    return missing;
+}
+
+/* Devices are saved by their slot, which is the same on a load, as the
+   machine is built from the same configuration in the same order. */
+void
+device_save_all(snapshot_t *s)
+{
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] == NULL) || (devices[c]->save == NULL))
+            continue;
+
+        snapshot_section_begin(s, SNAPSHOT_SECTION_DEVICE, device_snapshot_name(devices[c]), c, 0);
+        devices[c]->save(device_priv[c], s);
+        snapshot_section_end(s);
+    }
+}
+
+void
+device_load(snapshot_t *s, uint32_t index, const char *name)
+{
+    if ((index >= DEVICE_MAX) || (devices[index] == NULL) ||
+        strcmp(device_snapshot_name(devices[index]), name) || (devices[index]->load == NULL)) {
+        pclog("DEVICE: snapshot device %u ('%s') does not match this machine\n", index, name);
+        snapshot_set_error(s);
+        return;
+    }
+
+    devices[index]->load(device_priv[index], s);
+}
+
 void *
 device_find_first_priv(uint32_t match_flags)
 {
@@ -16,6 +16,7 @@
  *          Copyright 2023 Miran Grca.
  *          Copyright 2023 EngiNerd.
  */
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -46,6 +47,7 @@
 
 #include <86box/dma.h>
 #include <86box/pci.h>
+#include <86box/snapshot.h>
 
 #define STAT_PARITY        0x80
 #define STAT_RTIMEOUT      0x40
@@ -2204,6 +2206,60 @@ kbc_at_reset(void *priv)
     dev->status = (dev->status & 0x0f) | (dev->p1 & 0xf0);
 }
 
+/* The vendor hooks and the port pointers are set up at init, so the state
+   ends at the flags. The devices behind the ports save their own state. */
+static void
+kbc_at_save(void *priv, snapshot_t *s)
+{
+    atkbc_t *dev = (atkbc_t *) priv;
+
+    snapshot_write(s, dev, offsetof(atkbc_t, flags));
+    snapshot_write_timer(s, &dev->kbc_poll_timer);
+    snapshot_write_timer(s, &dev->kbc_dev_poll_timer);
+    snapshot_write_timer(s, &dev->pulse_cb);
+
+    for (int i = 0; i < 2; i++) {
+        if (dev->ports[i] != NULL) {
+            snapshot_write_var(s, dev->ports[i]->wantcmd);
+            snapshot_write_var(s, dev->ports[i]->dat);
+            snapshot_write_var(s, dev->ports[i]->out_new);
+        }
+    }
+
+    snapshot_write_var(s, kbc_handler_set);
+    snapshot_write_var(s, fast_reset);
+}
+
+static void
+kbc_at_load(void *priv, snapshot_t *s)
+{
+    atkbc_t *dev = (atkbc_t *) priv;
+    uint8_t  handler_set;
+
+    snapshot_read(s, dev, offsetof(atkbc_t, flags));
+    snapshot_read_timer(s, &dev->kbc_poll_timer);
+    snapshot_read_timer(s, &dev->kbc_dev_poll_timer);
+    snapshot_read_timer(s, &dev->pulse_cb);
+
+    for (int i = 0; i < 2; i++) {
+        if (dev->ports[i] != NULL) {
+            snapshot_read_var(s, dev->ports[i]->wantcmd);
+            snapshot_read_var(s, dev->ports[i]->dat);
+            snapshot_read_var(s, dev->ports[i]->out_new);
+        }
+    }
+
+    snapshot_read_var(s, handler_set);
+    snapshot_read_var(s, fast_reset);
+
+    kbc_at_handler(handler_set, dev);
+
+    if (dev->misc_flags & FLAG_PS2)
+        kbc_at_do_poll = kbc_at_poll_ps2;
+    else
+        kbc_at_do_poll = kbc_at_poll_at;
+}
+
 static void
 kbc_at_close(void *priv)
 {
@@ -2380,7 +2436,9 @@ const device_t keyboard_at_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_at_siemens_device = {
@@ -2394,7 +2452,9 @@ const device_t keyboard_at_siemens_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_at_ami_device = {
@@ -2408,7 +2468,9 @@ const device_t keyboard_at_ami_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_at_tg_ami_device = {
@@ -2422,7 +2484,9 @@ const device_t keyboard_at_tg_ami_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_at_toshiba_device = {
@@ -2436,7 +2500,9 @@ const device_t keyboard_at_toshiba_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_at_olivetti_device = {
@@ -2450,7 +2516,9 @@ const device_t keyboard_at_olivetti_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_at_ncr_device = {
@@ -2464,7 +2532,9 @@ const device_t keyboard_at_ncr_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_at_compaq_device = {
@@ -2478,7 +2548,9 @@ const device_t keyboard_at_compaq_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_device = {
@@ -2492,7 +2564,9 @@ const device_t keyboard_ps2_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_ps1_device = {
@@ -2506,7 +2580,9 @@ const device_t keyboard_ps2_ps1_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_ps1_pci_device = {
@@ -2520,7 +2596,9 @@ const device_t keyboard_ps2_ps1_pci_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_xi8088_device = {
@@ -2534,7 +2612,9 @@ const device_t keyboard_ps2_xi8088_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_ami_device = {
@@ -2548,7 +2628,9 @@ const device_t keyboard_ps2_ami_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_holtek_device = {
@@ -2562,7 +2644,9 @@ const device_t keyboard_ps2_holtek_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_phoenix_device = {
@@ -2576,7 +2660,9 @@ const device_t keyboard_ps2_phoenix_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_tg_ami_device = {
@@ -2590,7 +2676,9 @@ const device_t keyboard_ps2_tg_ami_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_mca_1_device = {
@@ -2604,7 +2692,9 @@ const device_t keyboard_ps2_mca_1_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_mca_2_device = {
@@ -2618,7 +2708,9 @@ const device_t keyboard_ps2_mca_2_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_quadtel_device = {
@@ -2632,7 +2724,9 @@ const device_t keyboard_ps2_quadtel_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_pci_device = {
@@ -2646,7 +2740,9 @@ const device_t keyboard_ps2_pci_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_ami_pci_device = {
@@ -2660,7 +2756,9 @@ const device_t keyboard_ps2_ami_pci_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_ali_pci_device = {
@@ -2674,7 +2772,9 @@ const device_t keyboard_ps2_ali_pci_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_intel_ami_pci_device = {
@@ -2688,7 +2788,9 @@ const device_t keyboard_ps2_intel_ami_pci_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_tg_ami_pci_device = {
@@ -2702,7 +2804,9 @@ const device_t keyboard_ps2_tg_ami_pci_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
 
 const device_t keyboard_ps2_acer_pci_device = {
@@ -2716,5 +2820,7 @@ const device_t keyboard_ps2_acer_pci_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = kbc_at_save,
+    .load          = kbc_at_load
 };
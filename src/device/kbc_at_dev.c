@@ -14,6 +14,7 @@
  *
  *          Copyright 2023 Miran Grca.
  */
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -38,6 +39,7 @@
 #include <86box/snd_speaker.h>
 #include <86box/video.h>
 #include <86box/keyboard.h>
+#include <86box/snapshot.h>
 #include <86box/plat_fallthrough.h>
 
 #ifdef ENABLE_KBC_AT_DEV_LOG
@@ -195,6 +197,26 @@ kbc_at_dev_reset(atkbc_dev_t *dev, int do_fa)
         dev->state = DEV_STATE_EXECUTE_BAT;
 }
 
+/* Everything from the type to the mouse state; the callbacks are set at init,
+   and the port is saved by the KBC. */
+void
+kbc_at_dev_save(void *priv, snapshot_t *s)
+{
+    atkbc_dev_t *dev = (atkbc_dev_t *) priv;
+
+    snapshot_write(s, &dev->type, offsetof(atkbc_dev_t, scan) - offsetof(atkbc_dev_t, type));
+    snapshot_write(s, dev->scan, sizeof(int));
+}
+
+void
+kbc_at_dev_load(void *priv, snapshot_t *s)
+{
+    atkbc_dev_t *dev = (atkbc_dev_t *) priv;
+
+    snapshot_read(s, &dev->type, offsetof(atkbc_dev_t, scan) - offsetof(atkbc_dev_t, type));
+    snapshot_read(s, dev->scan, sizeof(int));
+}
+
 atkbc_dev_t *
 kbc_at_dev_init(uint8_t inst)
 {
@@ -25,6 +25,8 @@
 #include <86box/device.h>
 #include <86box/keyboard.h>
 #include <86box/mouse.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 
 #define FLAG_PS2       0x08  /* dev is AT or PS/2 */
 #define FLAG_AT        0x00  /* dev is AT or PS/2 */
@@ -1006,6 +1008,32 @@ keyboard_at_init(const device_t *info)
     return dev;
 }
 
+static void
+keyboard_at_save(void *priv, snapshot_t *s)
+{
+    kbc_at_dev_save(priv, s);
+
+    snapshot_write_var(s, keyboard_mode);
+    snapshot_write_var(s, keyboard_set3_flags);
+    snapshot_write_var(s, keyboard_set3_all_repeat);
+    snapshot_write_var(s, keyboard_set3_all_break);
+    snapshot_write_var(s, bat_counter);
+}
+
+static void
+keyboard_at_load(void *priv, snapshot_t *s)
+{
+    kbc_at_dev_load(priv, s);
+
+    snapshot_read_var(s, keyboard_mode);
+    snapshot_read_var(s, keyboard_set3_flags);
+    snapshot_read_var(s, keyboard_set3_all_repeat);
+    snapshot_read_var(s, keyboard_set3_all_break);
+    snapshot_read_var(s, bat_counter);
+
+    keyboard_at_set_scancode_set();
+}
+
 static void
 keyboard_at_close(void *priv)
 {
@@ -1061,5 +1089,7 @@ const device_t keyboard_at_generic_device = {
     { .poll = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = keyboard_at_config
+    .config        = keyboard_at_config,
+    .save          = keyboard_at_save,
+    .load          = keyboard_at_load
 };
@@ -399,5 +399,7 @@ const device_t mouse_ps2_device = {
     { .poll = ps2_poll },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = ps2_config
+    .config        = ps2_config,
+    .save          = kbc_at_dev_save,
+    .load          = kbc_at_dev_load
 };
@@ -30,6 +30,8 @@
 #include <86box/mem.h>
 #include <86box/device.h>
 #include <86box/pci.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 
 #define PCI_BRIDGE_DEC_21150   0x10110022
 #define AGP_BRIDGE_ALI_M5243   0x10b95243
@@ -483,6 +485,25 @@ pci_bridge_reset(void *priv)
     }
 }
 
+/* The bus number mapping is restored along with the rest of the PCI state. */
+static void
+pci_bridge_save(void *priv, snapshot_t *s)
+{
+    pci_bridge_t *dev = (pci_bridge_t *) priv;
+
+    snapshot_write_var(s, dev->ctl);
+    snapshot_write_var(s, dev->regs);
+}
+
+static void
+pci_bridge_load(void *priv, snapshot_t *s)
+{
+    pci_bridge_t *dev = (pci_bridge_t *) priv;
+
+    snapshot_read_var(s, dev->ctl);
+    snapshot_read_var(s, dev->regs);
+}
+
 static void *
 pci_bridge_init(const device_t *info)
 {
@@ -545,7 +566,9 @@ const device_t dec21150_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
 
 /* AGP bridges */
@@ -560,7 +583,9 @@ const device_t ali5243_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
 
 /* AGP bridges */
@@ -575,7 +600,9 @@ const device_t ali5247_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
 
 const device_t i440lx_agp_device = {
@@ -589,7 +616,9 @@ const device_t i440lx_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
 
 const device_t i440bx_agp_device = {
@@ -603,7 +632,9 @@ const device_t i440bx_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
 
 const device_t i440gx_agp_device = {
@@ -617,7 +648,9 @@ const device_t i440gx_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
 
 const device_t via_vp3_agp_device = {
@@ -631,7 +664,9 @@ const device_t via_vp3_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
 
 const device_t via_mvp3_agp_device = {
@@ -645,7 +680,9 @@ const device_t via_mvp3_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
 
 const device_t via_apro_agp_device = {
@@ -659,7 +696,9 @@ const device_t via_apro_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
 
 const device_t via_vt8601_agp_device = {
@@ -673,7 +712,9 @@ const device_t via_vt8601_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
 
 const device_t sis_5xxx_agp_device = {
@@ -687,5 +728,7 @@ const device_t sis_5xxx_agp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pci_bridge_save,
+    .load          = pci_bridge_load
 };
@@ -379,7 +379,9 @@ esdi_write(uint16_t port, uint8_t val, void *priv)
 
                         case 0xa0:
                             esdi->status = STAT_BUSY;
-                            get_sector(esdi, &addr);
+                            if (!get_sector(esdi, &addr) && (esdi->command == CMD_READ) &&
+                                esdi->drives[esdi->drive_sel].present)
+                                hdd_image_read_submit(esdi->drives[esdi->drive_sel].hdd_num, addr, 1);
                             seek_time = hdd_timing_read(&hdd[esdi->drives[esdi->drive_sel].hdd_num], addr, 1);
                             xfer_time = esdi_get_xfer_time(esdi, 1);
                             esdi_set_callback(esdi, seek_time + xfer_time);
@@ -489,7 +491,8 @@ esdi_readw(uint16_t port, void *priv)
                 if (esdi->secount) {
                     next_sector(esdi);
                     esdi->status = STAT_BUSY;
-                    get_sector(esdi, &addr);
+                    if (!get_sector(esdi, &addr) && (esdi->command == CMD_READ))
+                        hdd_image_read_submit(esdi->drives[esdi->drive_sel].hdd_num, addr, 1);
                     double seek_time = hdd_timing_read(&hdd[esdi->drives[esdi->drive_sel].hdd_num], addr, 1);
                     double xfer_time = esdi_get_xfer_time(esdi, 1);
                     /* 390.625 us per sector at 10 Mbit/s = 1280 kB/s. */
@@ -611,7 +614,7 @@ esdi_callback(void *priv)
                     break;
                 }
 
-                hdd_image_read(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer);
+                hdd_image_read_complete(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer);
                 esdi->pos    = 0;
                 esdi->status = STAT_DRQ | STAT_READY | STAT_DSC;
                 irq_raise(esdi);
@@ -19,6 +19,7 @@
  */
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -48,6 +49,7 @@
 #include <86box/hdd.h>
 #include <86box/zip.h>
 #include <86box/version.h>
+#include <86box/snapshot.h>
 
 /* Bits of 'atastat' */
 #define ERR_STAT     0x01 /* Error */
@@ -1669,6 +1671,10 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
                             double xfer_time = ide_get_xfer_time(ide, 512 * sec_count);
                             wait_time        = seek_time + xfer_time;
                         }
+                        /* Let the host read overlap with the emulated seek and transfer time. */
+                        if ((val != WIN_READ_MULTIPLE) || (ide->blocksize > 0))
+                            hdd_image_read_submit(ide->hdd_num, ide_get_sector(ide),
+                                                  ide->tf->secount ? ide->tf->secount : 256);
                         ide_set_callback(ide, wait_time);
                     } else
                         ide_set_callback(ide, 200.0 * IDE_TIME);
@@ -2071,6 +2077,64 @@ ide_readl(uint16_t addr, void *priv)
     return ret;
 }
 
+/* Number of accesses of size bytes, out of count, that a string transfer on
+   the data port can move straight to or from the sector buffer while DRQ is
+   set. The last word of the sector is always left to ide_read_data() or
+   ide_write_data(), which then handle the end of the sector as usual. */
+static int
+ide_data_block_count(const ide_board_t *dev, const ide_t *ide, int size, int count)
+{
+    int words;
+
+    if ((ide->type == IDE_NONE) || (ide->type & IDE_SHADOW) || (ide->buffer == NULL) ||
+        (ide->command == WIN_PACKETCMD) || !(ide->tf->atastat & DRQ_STAT) || (ide->tf->pos & 1))
+        return 0;
+    if ((size != 2) && ((size != 4) || !dev->bit32))
+        return 0;
+
+    words = ((512 - (int) ide->tf->pos) >> 1) - 1;
+    if (words <= 0)
+        return 0;
+
+    return MIN(count, (words << 1) / size);
+}
+
+static int
+ide_read_data_block(uint16_t addr, void *buf, int size, int count, void *priv)
+{
+    const ide_board_t *dev = (ide_board_t *) priv;
+    ide_t             *ide = ide_drives[dev->cur_dev];
+
+    if (addr & 0x7)
+        return 0;
+
+    count = ide_data_block_count(dev, ide, size, count);
+    if (count > 0) {
+        memcpy(buf, &ide->buffer[ide->tf->pos >> 1], count * size);
+        ide->tf->pos += count * size;
+    }
+
+    return count;
+}
+
+static int
+ide_write_data_block(uint16_t addr, const void *buf, int size, int count, void *priv)
+{
+    const ide_board_t *dev = (ide_board_t *) priv;
+    ide_t             *ide = ide_drives[dev->cur_dev];
+
+    if (addr & 0x7)
+        return 0;
+
+    count = ide_data_block_count(dev, ide, size, count);
+    if (count > 0) {
+        memcpy(&ide->buffer[ide->tf->pos >> 1], buf, count * size);
+        ide->tf->pos += count * size;
+    }
+
+    return count;
+}
+
 static void
 ide_board_callback(void *priv)
 {
@@ -2202,8 +2266,8 @@ ide_callback(void *priv)
                 if (ide->do_initial_read) {
                     ide->do_initial_read = 0;
                     ide->sector_pos      = 0;
-                    hdd_image_read(ide->hdd_num, ide_get_sector(ide),
-                                   ide->tf->secount ? ide->tf->secount : 256, ide->sector_buffer);
+                    hdd_image_read_complete(ide->hdd_num, ide_get_sector(ide),
+                                            ide->tf->secount ? ide->tf->secount : 256, ide->sector_buffer);
                 }
 
                 memcpy(ide->buffer, &ide->sector_buffer[ide->sector_pos * 512], 512);
@@ -2233,7 +2297,7 @@ ide_callback(void *priv)
                     ide->sector_pos = ide->tf->secount;
                 else
                     ide->sector_pos = 256;
-                hdd_image_read(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
+                hdd_image_read_complete(ide->hdd_num, ide_get_sector(ide), ide->sector_pos, ide->sector_buffer);
 
                 ide->tf->pos = 0;
 
@@ -2280,8 +2344,8 @@ ide_callback(void *priv)
                 if (ide->do_initial_read) {
                     ide->do_initial_read = 0;
                     ide->sector_pos      = 0;
-                    hdd_image_read(ide->hdd_num, ide_get_sector(ide),
-                                   ide->tf->secount ? ide->tf->secount : 256, ide->sector_buffer);
+                    hdd_image_read_complete(ide->hdd_num, ide_get_sector(ide),
+                                            ide->tf->secount ? ide->tf->secount : 256, ide->sector_buffer);
                 }
 
                 memcpy(ide->buffer, &ide->sector_buffer[ide->sector_pos * 512], 512);
@@ -2595,6 +2659,10 @@ ide_handlers(uint8_t board, int set)
                        ide_readb, ide_readw, ide_readl,
                        ide_writeb, ide_writew, ide_writel,
                        ide_boards[board]);
+            if (set)
+                io_sethandler_block(ide_boards[board]->base[0],
+                                    ide_read_data_block, ide_write_data_block,
+                                    ide_boards[board]);
         }
 
         if (ide_boards[board]->base[1]) {
@@ -2649,6 +2717,107 @@ ide_board_set_force_ata3(int board, int force_ata3)
         ide_boards[board]->force_ata3 = force_ata3;
 }
 
+/* The drives that are attached, the bus master callbacks and the disk
+   images are set up from the configuration, so only the registers, the
+   timers and the buffers are saved. The state of an ATAPI device is kept by
+   its own driver, whose data buffer is not saved, so a save is refused while
+   an ATAPI command is transferring data. */
+static void
+ide_board_save(int board, snapshot_t *s)
+{
+    const ide_board_t *dev = ide_boards[board];
+
+    snapshot_write(s, dev, offsetof(ide_board_t, inited));
+    snapshot_write_var(s, dev->diag);
+    snapshot_write_var(s, dev->force_ata3);
+    snapshot_write_timer(s, &dev->timer);
+
+    for (uint8_t d = 0; d < 2; d++) {
+        ide_t *ide = dev->ide[d];
+
+        snapshot_write_var(s, ide->type);
+        snapshot_write(s, ide, offsetof(ide_t, buffer));
+        if (!(ide->type & IDE_SHADOW))
+            snapshot_write(s, ide->tf, sizeof(ide_tf_t));
+        snapshot_write_timer(s, &ide->timer);
+        snapshot_write_var(s, ide->interrupt_drq);
+        snapshot_write_var(s, ide->pending_delay);
+
+        if (ide->buffer != NULL)
+            snapshot_write(s, ide->buffer, 65536 * sizeof(uint16_t));
+        if (ide->sector_buffer != NULL)
+            snapshot_write(s, ide->sector_buffer, 256 * 512);
+
+        if ((ide->type == IDE_ATAPI) && (ide->sc != NULL)) {
+            if ((ide->sc->packet_status >= PHASE_COMMAND) && (ide->sc->packet_status <= PHASE_DATA_OUT_DMA)) {
+                pclog("IDE: channel %i is busy with an ATAPI command, not saving\n", ide->channel);
+                snapshot_set_error(s);
+            }
+
+            snapshot_write_var(s, ide->sc->ms_pages_saved);
+            snapshot_write(s, ide->sc->atapi_cdb, offsetof(scsi_common_t, id) - offsetof(scsi_common_t, atapi_cdb));
+            snapshot_write(s, &ide->sc->id, sizeof(scsi_common_t) - offsetof(scsi_common_t, id));
+        }
+    }
+}
+
+static void
+ide_board_load(int board, snapshot_t *s)
+{
+    ide_board_t *dev = ide_boards[board];
+    uint16_t     base[2];
+    int          type;
+
+    base[0] = dev->base[0];
+    base[1] = dev->base[1];
+
+    snapshot_read(s, dev, offsetof(ide_board_t, inited));
+    snapshot_read_var(s, dev->diag);
+    snapshot_read_var(s, dev->force_ata3);
+    snapshot_read_timer(s, &dev->timer);
+
+    /* Plug and Play may have moved the board. */
+    if ((base[0] != dev->base[0]) || (base[1] != dev->base[1])) {
+        uint16_t new_base[2] = { dev->base[0], dev->base[1] };
+
+        dev->base[0] = base[0];
+        dev->base[1] = base[1];
+        ide_remove_handlers(board);
+        dev->base[0] = new_base[0];
+        dev->base[1] = new_base[1];
+        ide_set_handlers(board);
+    }
+
+    for (uint8_t d = 0; d < 2; d++) {
+        ide_t *ide = dev->ide[d];
+
+        snapshot_read_var(s, type);
+        if (type != ide->type) {
+            pclog("IDE: channel %i has a different drive in the snapshot\n", ide->channel);
+            snapshot_set_error(s);
+            return;
+        }
+
+        snapshot_read(s, ide, offsetof(ide_t, buffer));
+        if (!(ide->type & IDE_SHADOW))
+            snapshot_read(s, ide->tf, sizeof(ide_tf_t));
+        snapshot_read_timer(s, &ide->timer);
+        snapshot_read_var(s, ide->interrupt_drq);
+        snapshot_read_var(s, ide->pending_delay);
+
+        if (ide->buffer != NULL)
+            snapshot_read(s, ide->buffer, 65536 * sizeof(uint16_t));
+        if (ide->sector_buffer != NULL)
+            snapshot_read(s, ide->sector_buffer, 256 * 512);
+
+        if ((ide->type == IDE_ATAPI) && (ide->sc != NULL)) {
+            snapshot_read_var(s, ide->sc->ms_pages_saved);
+            snapshot_read(s, ide->sc->atapi_cdb, offsetof(scsi_common_t, id) - offsetof(scsi_common_t, atapi_cdb));
+            snapshot_read(s, &ide->sc->id, sizeof(scsi_common_t) - offsetof(scsi_common_t, id));
+        }
+    }
+}
+
 static void
 ide_board_close(int board)
 {
@@ -2888,6 +3057,20 @@ ide_ter_init(const device_t *info)
     return (ide_boards[2]);
 }
 
+static void
+ide_ter_save(UNUSED(void *priv), snapshot_t *s)
+{
+    if (ide_boards[2] != NULL)
+        ide_board_save(2, s);
+}
+
+static void
+ide_ter_load(UNUSED(void *priv), snapshot_t *s)
+{
+    if (ide_boards[2] != NULL)
+        ide_board_load(2, s);
+}
+
 /* Close a standalone IDE unit. */
 static void
 ide_ter_close(UNUSED(void *priv))
@@ -2919,6 +3102,20 @@ ide_qua_init(const device_t *info)
     return (ide_boards[3]);
 }
 
+static void
+ide_qua_save(UNUSED(void *priv), snapshot_t *s)
+{
+    if (ide_boards[3] != NULL)
+        ide_board_save(3, s);
+}
+
+static void
+ide_qua_load(UNUSED(void *priv), snapshot_t *s)
+{
+    if (ide_boards[3] != NULL)
+        ide_board_load(3, s);
+}
+
 /* Close a standalone IDE unit. */
 static void
 ide_qua_close(UNUSED(void *priv))
@@ -3055,6 +3252,24 @@ ide_reset(UNUSED(void *priv))
     }
 }
 
+static void
+ide_save(UNUSED(void *priv), snapshot_t *s)
+{
+    for (uint8_t i = 0; i < 2; i++) {
+        if (ide_boards[i] != NULL)
+            ide_board_save(i, s);
+    }
+}
+
+static void
+ide_load(UNUSED(void *priv), snapshot_t *s)
+{
+    for (uint8_t i = 0; i < 2; i++) {
+        if (ide_boards[i] != NULL)
+            ide_board_load(i, s);
+    }
+}
+
 /* Close a standalone IDE unit. */
 static void
 ide_close(UNUSED(void *priv))
@@ -3233,7 +3448,9 @@ const device_t ide_isa_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = ide_save,
+    .load          = ide_load
 };
 
 const device_t ide_isa_2ch_device = {
@@ -3247,7 +3464,9 @@ const device_t ide_isa_2ch_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = ide_save,
+    .load          = ide_load
 };
 
 const device_t ide_vlb_device = {
@@ -3261,7 +3480,9 @@ const device_t ide_vlb_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = ide_save,
+    .load          = ide_load
 };
 
 const device_t ide_vlb_2ch_device = {
@@ -3275,7 +3496,9 @@ const device_t ide_vlb_2ch_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = ide_save,
+    .load          = ide_load
 };
 
 const device_t ide_pci_device = {
@@ -3289,7 +3512,9 @@ const device_t ide_pci_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = ide_save,
+    .load          = ide_load
 };
 
 const device_t ide_pci_2ch_device = {
@@ -3303,7 +3528,9 @@ const device_t ide_pci_2ch_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = ide_save,
+    .load          = ide_load
 };
 
 const device_t mcide_device = {
@@ -3386,7 +3613,9 @@ const device_t ide_ter_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = ide_ter_config
+    .config        = ide_ter_config,
+    .save          = ide_ter_save,
+    .load          = ide_ter_load
 };
 
 const device_t ide_ter_pnp_device = {
@@ -3400,7 +3629,9 @@ const device_t ide_ter_pnp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = ide_ter_save,
+    .load          = ide_ter_load
 };
 
 const device_t ide_qua_device = {
@@ -3414,7 +3645,9 @@ const device_t ide_qua_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = ide_qua_config
+    .config        = ide_qua_config,
+    .save          = ide_qua_save,
+    .load          = ide_qua_load
 };
 
 const device_t ide_qua_pnp_device = {
@@ -3428,5 +3661,7 @@ const device_t ide_qua_pnp_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = ide_qua_save,
+    .load          = ide_qua_load
 };
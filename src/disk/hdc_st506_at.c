@@ -115,6 +115,7 @@ typedef struct mfm_t {
 
 static uint8_t mfm_read(uint16_t port, void *priv);
 static void    mfm_write(uint16_t port, uint8_t val, void *priv);
+static void    read_submit(mfm_t *mfm);
 
 #ifdef ENABLE_ST506_AT_LOG
 int st506_at_do_log = ENABLE_ST506_AT_LOG;
@@ -302,6 +303,7 @@ mfm_cmd(mfm_t *mfm, uint8_t val)
                     if (val & 2)
                         fatal("WD1003: READ with ECC\n");
                     mfm->status = STAT_BUSY;
+                    read_submit(mfm);
                     timer_set_delay_u64(&mfm->callback_timer, 200 * MFM_TIME);
                     break;
 
@@ -461,6 +463,7 @@ mfm_readw(uint16_t port, void *priv)
                 if (mfm->secount) {
                     next_sector(mfm);
                     mfm->status = STAT_BUSY | STAT_READY | STAT_DSC;
+                    read_submit(mfm);
                     timer_set_delay_u64(&mfm->callback_timer, SECTOR_TIME);
                 } else
                     ui_sb_update_icon(SB_HDD | HDD_BUS_MFM, 0);
@@ -534,6 +537,22 @@ do_seek(mfm_t *mfm)
         drive->curcyl = drive->tracks - 1;
 }
 
+/* Start fetching the sector the pending READ will transfer, so that the
+   host I/O overlaps the command delay; do_callback() seeks the same way. */
+static void
+read_submit(mfm_t *mfm)
+{
+    const drive_t *drive = &mfm->drives[mfm->drvsel];
+    off64_t        addr;
+
+    if (!drive->present)
+        return;
+
+    do_seek(mfm);
+    if (!get_sector(mfm, &addr))
+        hdd_image_read_submit(drive->hdd_num, addr, 1);
+}
+
 static void
 do_callback(void *priv)
 {
@@ -590,7 +609,7 @@ do_callback(void *priv)
                 break;
             }
 
-            hdd_image_read(drive->hdd_num, addr, 1, (uint8_t *) mfm->buffer);
+            hdd_image_read_complete(drive->hdd_num, addr, 1, (uint8_t *) mfm->buffer);
 
             mfm->pos    = 0;
             mfm->status = STAT_DRQ | STAT_READY | STAT_DSC;
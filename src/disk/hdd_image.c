@@ -26,12 +26,15 @@
 #include <time.h>
 #include <wchar.h>
 #include <errno.h>
+#include <stdatomic.h>
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/path.h>
 #include <86box/plat.h>
 #include <86box/random.h>
+#include <86box/thread.h>
 #include <86box/hdd.h>
+#include <86box/ui.h>
 #include "minivhd/minivhd.h"
 #include "minivhd/internal.h"
 
@@ -40,18 +43,68 @@
 #define HDD_IMAGE_HDX 2
 #define HDD_IMAGE_VHD 3
 
+#define HDD_IO_READ  0
+#define HDD_IO_WRITE 1
+#define HDD_IO_ZERO  2
+
+#define HDD_IO_QUEUE_LEN    64  /* Maximum outstanding requests per image. */
+#define HDD_IO_COALESCE_MAX 256 /* Maximum sectors merged into one host I/O. */
+
+#define HDD_MMAP_SYNC_INTERVAL 5000 /* Milliseconds between flushes of dirty mapped pages. */
+
+typedef struct hdd_io_req_t {
+    uint32_t sector;
+    uint32_t count;
+    uint8_t *buffer; /* Owned copy of the data for writes, NULL otherwise. */
+    uint8_t  op;     /* HDD_IO_READ, HDD_IO_WRITE, or HDD_IO_ZERO */
+} hdd_io_req_t;
+
+/* Per-image I/O worker. Only the worker touches the backing file while
+   requests are queued, the emulation thread only touches it once the
+   queue has been drained, so no lock is needed around the file itself. */
+typedef struct hdd_io_t {
+    thread_t    *thread;
+    mutex_t     *mutex;
+    event_t     *wake_event; /* Set when a request has been queued. */
+    event_t     *done_event; /* Set when a batch of requests has completed. */
+    hdd_io_req_t queue[HDD_IO_QUEUE_LEN];
+    uint32_t     head;
+    uint32_t     count; /* Queued plus in-flight requests. */
+    int          quit;
+
+    uint8_t     *bounce; /* Staging buffer for coalesced writes. */
+    uint32_t     bounce_sectors;
+
+    uint8_t     *read_buf; /* Destination of the submitted read. */
+    uint32_t     read_buf_sectors;
+    uint32_t     read_sector;
+    uint32_t     read_count;
+    uint32_t     read_pos;
+    int          read_valid;
+} hdd_io_t;
+
 typedef struct hdd_image_t {
     FILE     *file; /* Used for HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */
     MVHDMeta *vhd;  /* Used for HDD_IMAGE_VHD. */
+    hdd_io_t *io;
+    hdd_overlay_t *overlay; /* Receives all writes when stacked on a read-only base. */
+    uint8_t  *map; /* Used for memory-mapped HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */
+    uint64_t  map_size;
+    atomic_int map_dirty;
     uint32_t  base;
     uint32_t  pos;
     uint32_t  last_sector;
+    uint8_t   id;
     uint8_t   type; /* HDD_IMAGE_RAW, HDD_IMAGE_HDI, HDD_IMAGE_HDX, or HDD_IMAGE_VHD */
     uint8_t   loaded;
+    atomic_int error; /* Set once error_msg holds an error not yet reported. */
+    char       error_msg[128];
 } hdd_image_t;
 
 hdd_image_t hdd_images[HDD_NUM];
 
+static atomic_int overlay_req[HDD_NUM]; /* HDD_OVERLAY_* asked for by the UI. */
+
 static char  empty_sector[512];
 static char *empty_sector_1mb;
 
@@ -73,6 +126,28 @@ hdd_image_log(const char *fmt, ...)
 #    define hdd_image_log(fmt, ...)
 #endif
 
+/* I/O errors can happen on the worker, which must not stop the emulator
+   behind the emulation thread's back, and after a write-behind has already
+   been reported to the guest as done. They are latched here and reported
+   by the next call made from the emulation thread. */
+static void
+hdd_image_set_error(hdd_image_t *img, const char *msg)
+{
+    pclog("Hard disk image %i: %s\n", img->id, msg);
+
+    if (!atomic_load(&img->error)) {
+        snprintf(img->error_msg, sizeof(img->error_msg), "%s", msg);
+        atomic_store(&img->error, 1);
+    }
+}
+
+static void
+hdd_image_check_error(hdd_image_t *img)
+{
+    if (atomic_load(&img->error))
+        fatal("Hard disk image %i: %s\n", img->id, img->error_msg);
+}
+
 int
 image_is_hdi(const char *s)
 {
@@ -232,8 +307,8 @@ hdd_image_init(void)
         memset(&hdd_images[i], 0, sizeof(hdd_image_t));
 }
 
-int
-hdd_image_load(int id)
+static int
+hdd_image_load_file(int id)
 {
     uint32_t sector_size = 512;
     uint32_t zero        = 0;
@@ -281,7 +356,8 @@ hdd_image_load(int id)
         memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
         return 0;
     }
-    hdd_images[id].file = plat_fopen(fn, "rb+");
+    /* A base image under an overlay is never written to. */
+    hdd_images[id].file = plat_fopen(fn, hdd[id].overlay[0] ? "rb" : "rb+");
     if (hdd_images[id].file == NULL) {
         /* Failed to open existing hard disk image */
         if (errno == ENOENT) {
@@ -327,6 +403,7 @@ hdd_image_load(int id)
                     hdd_images[id].type = HDD_IMAGE_HDX;
                 } else if (is_vhd[0]) {
                     fclose(hdd_images[id].file);
+                    hdd_images[id].file = NULL;
                     MVHDGeom geometry = { 0 };
                     geometry.cyl               = hdd[id].tracks;
                     geometry.heads             = hdd[id].hpc;
@@ -361,7 +438,8 @@ retry_vhd:
                         }
                         fatal("hdd_image_load(): VHD: Could not create VHD : %s\n", mvhd_strerr(vhd_error));
                     }
-                    hdd_images[id].type = HDD_IMAGE_VHD;
+                    hdd_images[id].type   = HDD_IMAGE_VHD;
+                    hdd_images[id].loaded = 1;
 
                     return 1;
                 } else {
@@ -443,7 +521,7 @@ retry_vhd:
         } else if (is_vhd[1]) {
             fclose(hdd_images[id].file);
             hdd_images[id].file = NULL;
-            hdd_images[id].vhd  = mvhd_open(fn, (bool) 0, &vhd_error);
+            hdd_images[id].vhd  = mvhd_open(fn, (bool) !!hdd[id].overlay[0], &vhd_error);
             if (hdd_images[id].vhd == NULL) {
                 if (vhd_error == MVHD_ERR_FILE)
                     fatal("hdd_image_load(): VHD: Error opening VHD file '%s': %s\n", fn, strerror(mvhd_errno));
@@ -487,6 +565,567 @@ retry_vhd:
     return ret;
 }
 
+/* Limit a transfer to the mapped part of the image, like a short fread() would. */
+static uint32_t
+hdd_image_map_clamp(const hdd_image_t *img, uint32_t sector, uint32_t count)
+{
+    uint64_t sectors = (img->map_size - img->base) >> 9;
+
+    if (sector >= sectors)
+        return 0;
+    if ((sectors - sector) < count)
+        return (uint32_t) (sectors - sector);
+
+    return count;
+}
+
+static uint32_t
+hdd_image_base_read(hdd_image_t *img, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    int    non_transferred_sectors;
+    size_t num_read;
+
+    if (img->map != NULL) {
+        num_read = hdd_image_map_clamp(img, sector, count);
+        memcpy(buffer, &img->map[((uint64_t) sector << 9LL) + img->base], num_read << 9);
+        return sector + num_read;
+    }
+
+    if (img->type == HDD_IMAGE_VHD) {
+        non_transferred_sectors = mvhd_read_sectors(img->vhd, sector, count, buffer);
+        return sector + count - non_transferred_sectors - 1;
+    }
+
+    if (fseeko64(img->file, ((uint64_t) (sector) << 9LL) + img->base, SEEK_SET) == -1) {
+        hdd_image_set_error(img, "Read error during seek");
+        return sector;
+    }
+
+    num_read = fread(buffer, 512, count, img->file);
+    return sector + num_read;
+}
+
+static uint32_t
+hdd_image_base_write(hdd_image_t *img, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    int    non_transferred_sectors;
+    size_t num_write;
+
+    if (img->map != NULL) {
+        num_write = hdd_image_map_clamp(img, sector, count);
+        memcpy(&img->map[((uint64_t) sector << 9LL) + img->base], buffer, num_write << 9);
+        atomic_store(&img->map_dirty, 1);
+        return sector + num_write;
+    }
+
+    if (img->type == HDD_IMAGE_VHD) {
+        non_transferred_sectors = mvhd_write_sectors(img->vhd, sector, count, buffer);
+        return sector + count - non_transferred_sectors - 1;
+    }
+
+    if (fseeko64(img->file, ((uint64_t) (sector) << 9LL) + img->base, SEEK_SET) == -1) {
+        hdd_image_set_error(img, "Write error during seek");
+        return sector;
+    }
+
+    num_write = fwrite(buffer, 512, count, img->file);
+    return sector + num_write;
+}
+
+static uint32_t
+hdd_image_base_zero(hdd_image_t *img, uint32_t sector, uint32_t count)
+{
+    uint32_t pos = sector;
+    uint64_t addr;
+
+    if (img->map != NULL) {
+        count = hdd_image_map_clamp(img, sector, count);
+        if (count == 0)
+            return sector;
+
+        /* Deallocate the range where the host supports it, which also zeroes
+           the mapped pages, otherwise clear it in place. */
+        addr = ((uint64_t) sector << 9LL) + img->base;
+        if (plat_file_punch_hole(img->file, addr, (uint64_t) count << 9LL) != 0) {
+            memset(&img->map[addr], 0, (uint64_t) count << 9LL);
+            atomic_store(&img->map_dirty, 1);
+        }
+        return sector + count - 1;
+    }
+
+    if (img->type == HDD_IMAGE_VHD) {
+        int non_transferred_sectors = mvhd_format_sectors(img->vhd, sector, count);
+        return sector + count - non_transferred_sectors - 1;
+    }
+
+    memset(empty_sector, 0, 512);
+
+    if (fseeko64(img->file, ((uint64_t) (sector) << 9LL) + img->base, SEEK_SET) == -1) {
+        hdd_image_set_error(img, "Zero error during seek");
+        return sector;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (feof(img->file))
+            break;
+
+        pos = sector + i;
+        fwrite(empty_sector, 512, 1, img->file);
+    }
+
+    return pos;
+}
+
+/* Mapped images without an overlay are accessed with a plain memcpy(),
+   which is not worth handing over to the worker. */
+static inline int
+hdd_image_is_direct(const hdd_image_t *img)
+{
+    return (img->io == NULL) || ((img->map != NULL) && (img->overlay == NULL));
+}
+
+static void
+hdd_image_overlay_read_base(void *priv, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_base_read((hdd_image_t *) priv, sector, count, buffer);
+}
+
+static int
+hdd_image_overlay_write_base(void *priv, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_t *img = (hdd_image_t *) priv;
+
+    return hdd_image_base_write(img, sector, count, buffer) >= (sector + count - ((img->type == HDD_IMAGE_VHD) ? 1 : 0));
+}
+
+static uint32_t
+hdd_image_do_read(hdd_image_t *img, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if (img->overlay != NULL) {
+        if (!hdd_overlay_read(img->overlay, sector, count, buffer)) {
+            hdd_image_set_error(img, "Overlay read error");
+            return sector;
+        }
+        return sector + count;
+    }
+
+    return hdd_image_base_read(img, sector, count, buffer);
+}
+
+static uint32_t
+hdd_image_do_write(hdd_image_t *img, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if (img->overlay != NULL) {
+        if (!hdd_overlay_write(img->overlay, sector, count, buffer)) {
+            hdd_image_set_error(img, "Overlay write error");
+            return sector;
+        }
+        return sector + count;
+    }
+
+    return hdd_image_base_write(img, sector, count, buffer);
+}
+
+static uint32_t
+hdd_image_do_zero(hdd_image_t *img, uint32_t sector, uint32_t count)
+{
+    if (img->overlay != NULL) {
+        if (!hdd_overlay_zero(img->overlay, sector, count)) {
+            hdd_image_set_error(img, "Overlay write error");
+            return sector;
+        }
+        return sector + count - 1;
+    }
+
+    return hdd_image_base_zero(img, sector, count);
+}
+
+/* Perform a batch of queued requests, already known to be of the same kind
+   and contiguous on the disk, as a single host I/O. */
+static void
+hdd_image_io_process(hdd_image_t *img, uint32_t batch, uint32_t sectors)
+{
+    hdd_io_t     *io  = img->io;
+    hdd_io_req_t *req = &io->queue[io->head];
+    hdd_io_req_t *cur;
+    uint8_t      *p;
+    uint32_t      end;
+
+    switch (req->op) {
+        case HDD_IO_READ:
+            io->read_pos = hdd_image_do_read(img, req->sector, req->count, io->read_buf);
+            break;
+
+        case HDD_IO_WRITE:
+            if (batch == 1)
+                end = hdd_image_do_write(img, req->sector, req->count, req->buffer);
+            else {
+                if (io->bounce_sectors < sectors) {
+                    io->bounce         = (uint8_t *) realloc(io->bounce, sectors << 9);
+                    io->bounce_sectors = sectors;
+                }
+                p = io->bounce;
+                for (uint32_t i = 0; i < batch; i++) {
+                    cur = &io->queue[(io->head + i) % HDD_IO_QUEUE_LEN];
+                    memcpy(p, cur->buffer, cur->count << 9);
+                    p += (cur->count << 9);
+                }
+                end = hdd_image_do_write(img, req->sector, sectors, io->bounce);
+            }
+
+            /* The guest was told these sectors were written, so a short
+               write can only be reported later. */
+            if (end < (req->sector + sectors - ((img->type == HDD_IMAGE_VHD) ? 1 : 0)))
+                hdd_image_set_error(img, "Write error");
+
+            for (uint32_t i = 0; i < batch; i++) {
+                cur = &io->queue[(io->head + i) % HDD_IO_QUEUE_LEN];
+                free(cur->buffer);
+                cur->buffer = NULL;
+            }
+            break;
+
+        case HDD_IO_ZERO:
+            if (hdd_image_do_zero(img, req->sector, sectors) < (req->sector + sectors - 1))
+                hdd_image_set_error(img, "Zero error");
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void
+hdd_image_io_thread(void *priv)
+{
+    hdd_image_t  *img = (hdd_image_t *) priv;
+    hdd_io_t     *io  = img->io;
+    hdd_io_req_t *req;
+    hdd_io_req_t *next;
+    uint32_t      batch;
+    uint32_t      sectors;
+
+    thread_wait_mutex(io->mutex);
+    while (1) {
+        while (!io->count && !io->quit) {
+            thread_reset_event(io->wake_event);
+            thread_release_mutex(io->mutex);
+            thread_wait_event(io->wake_event, img->map ? HDD_MMAP_SYNC_INTERVAL : -1);
+            thread_wait_mutex(io->mutex);
+
+            /* Nothing was queued, so the wait timed out; periodically write
+               back the dirty pages of a mapped image. */
+            if (!io->count && !io->quit && atomic_exchange(&img->map_dirty, 0)) {
+                thread_release_mutex(io->mutex);
+                plat_msync_file(img->map, img->map_size, 0);
+                thread_wait_mutex(io->mutex);
+            }
+        }
+
+        if (!io->count)
+            break;
+
+        /* Coalesce adjacent writes and zero fills into one host I/O. */
+        req     = &io->queue[io->head];
+        batch   = 1;
+        sectors = req->count;
+        while ((req->op != HDD_IO_READ) && (batch < io->count)) {
+            next = &io->queue[(io->head + batch) % HDD_IO_QUEUE_LEN];
+            if ((next->op != req->op) || (next->sector != (req->sector + sectors)) ||
+                ((sectors + next->count) > HDD_IO_COALESCE_MAX))
+                break;
+            sectors += next->count;
+            batch++;
+        }
+
+        /* The submitter only ever appends behind the in-flight requests,
+           so they can be processed without holding the lock. */
+        thread_release_mutex(io->mutex);
+
+        hdd_image_log("Hard disk image %i: %i request(s), %i sector(s) from %i\n",
+                      img->id, batch, sectors, req->sector);
+        hdd_image_io_process(img, batch, sectors);
+
+        thread_wait_mutex(io->mutex);
+
+        /* Write back the VHD sector bitmaps cached by MiniVHD once the
+           queue runs dry, rather than after every single write. The batch
+           is still counted as in flight, so nothing else touches the VHD
+           while the lock is dropped. */
+        if ((img->type == HDD_IMAGE_VHD) && (io->count == batch)) {
+            thread_release_mutex(io->mutex);
+            mvhd_flush(img->vhd);
+            thread_wait_mutex(io->mutex);
+        }
+
+        io->head = (io->head + batch) % HDD_IO_QUEUE_LEN;
+        io->count -= batch;
+        thread_set_event(io->done_event);
+    }
+    thread_release_mutex(io->mutex);
+}
+
+/* Wait until no more than max_count requests are outstanding.
+   Must be called with the queue lock held. */
+static void
+hdd_image_io_wait(hdd_io_t *io, uint32_t max_count)
+{
+    while (io->count > max_count) {
+        thread_reset_event(io->done_event);
+        thread_release_mutex(io->mutex);
+        thread_wait_event(io->done_event, -1);
+        thread_wait_mutex(io->mutex);
+    }
+}
+
+static void
+hdd_image_io_drain(hdd_image_t *img)
+{
+    if (img->io == NULL)
+        return;
+
+    thread_wait_mutex(img->io->mutex);
+    hdd_image_io_wait(img->io, 0);
+    thread_release_mutex(img->io->mutex);
+
+    hdd_image_check_error(img);
+}
+
+static void
+hdd_image_io_submit(hdd_image_t *img, uint8_t op, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_io_t     *io = img->io;
+    hdd_io_req_t *req;
+
+    hdd_image_check_error(img);
+
+    thread_wait_mutex(io->mutex);
+    hdd_image_io_wait(io, HDD_IO_QUEUE_LEN - 1);
+
+    req         = &io->queue[(io->head + io->count) % HDD_IO_QUEUE_LEN];
+    req->op     = op;
+    req->sector = sector;
+    req->count  = count;
+    req->buffer = buffer;
+    io->count++;
+    thread_release_mutex(io->mutex);
+
+    thread_set_event(io->wake_event);
+}
+
+static void
+hdd_image_io_start(hdd_image_t *img)
+{
+    hdd_io_t *io = (hdd_io_t *) calloc(1, sizeof(hdd_io_t));
+
+    io->mutex      = thread_create_mutex();
+    io->wake_event = thread_create_event();
+    io->done_event = thread_create_event();
+
+    img->io    = io;
+    io->thread = thread_create(hdd_image_io_thread, img);
+}
+
+static void
+hdd_image_map(hdd_image_t *img, int writable)
+{
+    if ((img->file == NULL) || (img->type == HDD_IMAGE_VHD))
+        return;
+
+    img->map_size = ((uint64_t) (img->last_sector + 1) << 9LL) + img->base;
+    img->map      = (uint8_t *) plat_mmap_file(img->file, img->map_size, writable);
+    if (img->map == NULL)
+        pclog("Hard disk image %i: Unable to map image, using file I/O\n", img->id);
+    atomic_store(&img->map_dirty, 0);
+}
+
+static void
+hdd_image_unmap(hdd_image_t *img)
+{
+    if (img->map == NULL)
+        return;
+
+    plat_msync_file(img->map, img->map_size, 1);
+    plat_munmap_file(img->map, img->map_size);
+    img->map = NULL;
+}
+
+static void
+hdd_image_io_stop(hdd_image_t *img)
+{
+    hdd_io_t *io = img->io;
+
+    if (io == NULL)
+        return;
+
+    /* The worker drains the queue before exiting. */
+    thread_wait_mutex(io->mutex);
+    io->quit = 1;
+    thread_release_mutex(io->mutex);
+    thread_set_event(io->wake_event);
+    thread_wait(io->thread);
+
+    thread_destroy_event(io->done_event);
+    thread_destroy_event(io->wake_event);
+    thread_close_mutex(io->mutex);
+
+    free(io->bounce);
+    free(io->read_buf);
+    free(io);
+    img->io = NULL;
+}
+
+int
+hdd_image_load(int id)
+{
+    int ret;
+
+    hdd_image_io_stop(&hdd_images[id]);
+    hdd_image_unmap(&hdd_images[id]);
+    hdd_overlay_close(hdd_images[id].overlay);
+    hdd_images[id].overlay = NULL;
+    atomic_store(&hdd_images[id].error, 0);
+
+    ret = hdd_image_load_file(id);
+
+    if (ret) {
+        hdd_images[id].id = id;
+        if (hdd[id].overlay[0]) {
+            /* The base is opened read-only and always mapped, so that the
+               host page cache holds a single copy of it for every
+               instance sharing it. */
+            hdd_image_map(&hdd_images[id], 0);
+            hdd_images[id].overlay = hdd_overlay_open(hdd[id].overlay, hdd_images[id].last_sector + 1,
+                                                      hdd_image_overlay_read_base, &hdd_images[id]);
+            if (hdd_images[id].overlay == NULL)
+                fatal("hdd_image_load(): Could not open overlay '%s'\n", hdd[id].overlay);
+        } else if (hdd[id].use_mmap)
+            hdd_image_map(&hdd_images[id], 1);
+        hdd_image_io_start(&hdd_images[id]);
+    }
+
+    return ret;
+}
+
+/* The new handle is opened before the old one is closed, so that the image
+   stays usable if the base can not be opened in the new mode. */
+static int
+hdd_image_reopen_base(hdd_image_t *img, int writable)
+{
+    MVHDMeta *vhd;
+    FILE     *fp;
+    int       vhd_error = 0;
+
+    if (img->type == HDD_IMAGE_VHD) {
+        vhd = mvhd_open(hdd[img->id].fn, (bool) !writable, &vhd_error);
+        if (vhd == NULL)
+            return 0;
+        mvhd_close(img->vhd);
+        img->vhd = vhd;
+        return 1;
+    }
+
+    fp = plat_fopen(hdd[img->id].fn, writable ? "rb+" : "rb");
+    if (fp == NULL)
+        return 0;
+    fclose(img->file);
+    img->file = fp;
+    return 1;
+}
+
+/* Write everything held by the overlay back into the base image, leaving
+   the overlay empty. The base must be writable by this instance. Returns
+   1 on success; on failure, the overlay is left as it was. */
+int
+hdd_image_overlay_commit(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+    int          ret;
+
+    if (img->overlay == NULL)
+        return 0;
+
+    hdd_image_io_drain(img);
+    hdd_image_unmap(img);
+
+    if (!hdd_image_reopen_base(img, 1)) {
+        pclog("Hard disk image %i: Unable to open base image for writing\n", id);
+        hdd_image_map(img, 0);
+        return 0;
+    }
+
+    ret = hdd_overlay_commit(img->overlay, hdd_image_overlay_write_base, img);
+
+    /* Errors writing to the base are returned rather than latched. */
+    atomic_store(&img->error, 0);
+
+    /* If the base can't go back to read-only, it simply stays writable. */
+    if (!hdd_image_reopen_base(img, 0))
+        pclog("Hard disk image %i: Unable to reopen base image read-only\n", id);
+    hdd_image_map(img, 0);
+
+    return ret;
+}
+
+/* Throw away every write made since the overlay was created. Returns 1 on
+   success. */
+int
+hdd_image_overlay_discard(uint8_t id)
+{
+    hdd_image_t *img = &hdd_images[id];
+
+    if (img->overlay == NULL)
+        return 0;
+
+    hdd_image_io_drain(img);
+
+    return hdd_overlay_discard(img->overlay);
+}
+
+/* Ask the emulation thread to commit or discard an overlay, as the
+   frontends can not touch the images while the machine is running. */
+void
+hdd_image_overlay_request(uint8_t id, int op)
+{
+    if (id >= HDD_NUM)
+        return;
+
+    atomic_store(&overlay_req[id], op);
+}
+
+/* Called by the emulation thread between two blocks of CPU code. */
+void
+hdd_image_overlay_process(void)
+{
+    char msg[256];
+    int  op;
+    int  ret;
+
+    for (uint8_t id = 0; id < HDD_NUM; id++) {
+        op = atomic_exchange(&overlay_req[id], HDD_OVERLAY_NONE);
+        if (op == HDD_OVERLAY_NONE)
+            continue;
+
+        if (hdd_images[id].overlay == NULL) {
+            snprintf(msg, sizeof(msg), "Hard disk %i has no overlay.", id);
+            ret = 0;
+        } else if (op == HDD_OVERLAY_COMMIT) {
+            ret = hdd_image_overlay_commit(id);
+            snprintf(msg, sizeof(msg), "Unable to commit the overlay of hard disk %i to '%s'.", id, hdd[id].fn);
+        } else {
+            ret = hdd_image_overlay_discard(id);
+            snprintf(msg, sizeof(msg), "Unable to discard the overlay '%s' of hard disk %i.", hdd[id].overlay, id);
+        }
+
+        if (ret)
+            pclog("Hard disk image %i: overlay %s\n", id, (op == HDD_OVERLAY_COMMIT) ? "committed" : "discarded");
+        else {
+            pclog("Hard disk image %i: %s\n", id, msg);
+            ui_msgbox(MBX_ERROR | MBX_ANSI, msg);
+        }
+    }
+}
+
 void
 hdd_image_seek(uint8_t id, uint32_t sector)
 {
@@ -495,6 +1134,7 @@ hdd_image_seek(uint8_t id, uint32_t sector)
 
     hdd_images[id].pos = sector;
     if (hdd_images[id].type != HDD_IMAGE_VHD) {
+        hdd_image_io_drain(&hdd_images[id]);
         if (fseeko64(hdd_images[id].file, addr + hdd_images[id].base, SEEK_SET) == -1)
             fatal("hdd_image_seek(): Error seeking\n");
     }
@@ -503,21 +1143,52 @@ hdd_image_seek(uint8_t id, uint32_t sector)
 void
 hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
-    int    non_transferred_sectors;
-    size_t num_read;
+    hdd_image_io_drain(&hdd_images[id]);
 
-    if (hdd_images[id].type == HDD_IMAGE_VHD) {
-        non_transferred_sectors = mvhd_read_sectors(hdd_images[id].vhd, sector, count, buffer);
-        hdd_images[id].pos      = sector + count - non_transferred_sectors - 1;
-    } else {
-        if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-            fatal("Hard disk image %i: Read error during seek\n", id);
-            return;
-        }
+    hdd_images[id].pos = hdd_image_do_read(&hdd_images[id], sector, count, buffer);
+    hdd_image_check_error(&hdd_images[id]);
+}
+
+/* Start reading sectors in the background; the data is picked up by a
+   matching hdd_image_read_complete() once the controller's timing for the
+   transfer has elapsed. Only one such read may be outstanding per image. */
+void
+hdd_image_read_submit(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_image_t *img = &hdd_images[id];
+    hdd_io_t    *io  = img->io;
 
-        num_read           = fread(buffer, 512, count, hdd_images[id].file);
-        hdd_images[id].pos = sector + num_read;
+    if (hdd_image_is_direct(img) || (count == 0))
+        return;
+
+    if (io->read_valid)
+        hdd_image_io_drain(img);
+
+    if (io->read_buf_sectors < count) {
+        io->read_buf         = (uint8_t *) realloc(io->read_buf, count << 9);
+        io->read_buf_sectors = count;
     }
+
+    io->read_sector = sector;
+    io->read_count  = count;
+    io->read_valid  = 1;
+
+    hdd_image_io_submit(img, HDD_IO_READ, sector, count, NULL);
+}
+
+void
+hdd_image_read_complete(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_t *img = &hdd_images[id];
+    hdd_io_t    *io  = img->io;
+
+    if ((io != NULL) && io->read_valid && (io->read_sector == sector) && (io->read_count == count)) {
+        hdd_image_io_drain(img);
+        memcpy(buffer, io->read_buf, count << 9);
+        io->read_valid = 0;
+        img->pos       = io->read_pos;
+    } else
+        hdd_image_read(id, sector, count, buffer);
 }
 
 uint32_t
@@ -551,21 +1222,21 @@ hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 void
 hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
-    int    non_transferred_sectors;
-    size_t num_write;
+    hdd_image_t *img = &hdd_images[id];
+    uint8_t     *data;
 
-    if (hdd_images[id].type == HDD_IMAGE_VHD) {
-        non_transferred_sectors = mvhd_write_sectors(hdd_images[id].vhd, sector, count, buffer);
-        hdd_images[id].pos      = sector + count - non_transferred_sectors - 1;
-    } else {
-        if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-            fatal("Hard disk image %i: Write error during seek\n", id);
-            return;
-        }
-
-        num_write          = fwrite(buffer, 512, count, hdd_images[id].file);
-        hdd_images[id].pos = sector + num_write;
+    if (hdd_image_is_direct(img) || (count == 0)) {
+        img->pos = hdd_image_do_write(img, sector, count, buffer);
+        hdd_image_check_error(img);
+        return;
     }
+
+    /* Write-behind: the caller's buffer is free for reuse on return. */
+    data = (uint8_t *) malloc(count << 9);
+    memcpy(data, buffer, count << 9);
+    hdd_image_io_submit(img, HDD_IO_WRITE, sector, count, data);
+
+    img->pos = sector + count - ((img->type == HDD_IMAGE_VHD) ? 1 : 0);
 }
 
 int
@@ -587,25 +1258,17 @@ hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 void
 hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
 {
-    if (hdd_images[id].type == HDD_IMAGE_VHD) {
-        int non_transferred_sectors = mvhd_format_sectors(hdd_images[id].vhd, sector, count);
-        hdd_images[id].pos          = sector + count - non_transferred_sectors - 1;
-    } else {
-        memset(empty_sector, 0, 512);
+    hdd_image_t *img = &hdd_images[id];
 
-        if (fseeko64(hdd_images[id].file, ((uint64_t) (sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-            fatal("Hard disk image %i: Zero error during seek\n", id);
-            return;
-        }
+    if (hdd_image_is_direct(img) || (count == 0)) {
+        img->pos = hdd_image_do_zero(img, sector, count);
+        hdd_image_check_error(img);
+        return;
+    }
 
-        for (uint32_t i = 0; i < count; i++) {
-            if (feof(hdd_images[id].file))
-                break;
+    hdd_image_io_submit(img, HDD_IO_ZERO, sector, count, NULL);
 
-            hdd_images[id].pos = sector + i;
-            fwrite(empty_sector, 512, 1, hdd_images[id].file);
-        }
-    }
+    img->pos = sector + count - 1;
 }
 
 int
@@ -642,6 +1305,11 @@ hdd_image_unload(uint8_t id, UNUSED(int fn_preserve))
     if (strlen(hdd[id].fn) == 0)
         return;
 
+    hdd_image_io_stop(&hdd_images[id]);
+    hdd_image_unmap(&hdd_images[id]);
+    hdd_overlay_close(hdd_images[id].overlay);
+    hdd_images[id].overlay = NULL;
+
     if (hdd_images[id].loaded) {
         if (hdd_images[id].file != NULL) {
             fclose(hdd_images[id].file);
@@ -663,6 +1331,11 @@ hdd_image_close(uint8_t id)
 {
     hdd_image_log("hdd_image_close(%i)\n", id);
 
+    hdd_image_io_stop(&hdd_images[id]);
+    hdd_image_unmap(&hdd_images[id]);
+    hdd_overlay_close(hdd_images[id].overlay);
+    hdd_images[id].overlay = NULL;
+
     if (!hdd_images[id].loaded)
         return;
 
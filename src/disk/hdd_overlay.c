@@ -0,0 +1,412 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Copy-on-write overlay files for hard disk images.
+ *
+ *          An overlay holds every sector written by the guest, so that
+ *          the base image it is stacked on can stay read-only and be
+ *          shared by any number of emulator instances.
+ *
+ *          The file consists of a 512-byte header, a block allocation
+ *          table with one 32-bit entry per block of the base image, a
+ *          bitmap with one bit per sector telling whether that sector
+ *          is held by the overlay, and the data blocks in the order in
+ *          which they were first written to.
+ *
+ *
+ *
+ * Authors: Miran Grca, <mgrca8@gmail.com>
+ *          Fred N. van Kempen, <decwiz@yahoo.com>
+ *
+ *          Copyright 2016-2024 Miran Grca.
+ *          Copyright 2017-2018 Fred N. van Kempen.
+ */
+#define _GNU_SOURCE
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/plat.h>
+#include <86box/hdd.h>
+
+#define OVERLAY_MAGIC         "86BOXOVL"
+#define OVERLAY_VERSION       1
+#define OVERLAY_BLOCK_SECTORS 64 /* 32 kB per block. */
+#define OVERLAY_BLOCK_FREE    0xffffffff
+
+typedef struct overlay_header_t {
+    char     magic[8];
+    uint32_t version;
+    uint32_t block_sectors;
+    uint32_t sectors;
+    uint32_t blocks;
+    uint32_t bat_offset;
+    uint32_t bitmap_offset;
+    uint32_t data_offset;
+    uint32_t allocated;
+    uint8_t  pad[472];
+} overlay_header_t;
+
+struct hdd_overlay_t {
+    FILE            *fp;
+    char             fn[1024];
+    overlay_header_t hdr;
+    uint32_t        *bat;
+    uint8_t         *bitmap;
+    uint32_t         bitmap_bytes_per_block;
+
+    void (*read_base)(void *priv, uint32_t sector, uint32_t count, uint8_t *buffer);
+    void  *priv;
+};
+
+static uint8_t overlay_zero[OVERLAY_BLOCK_SECTORS << 9];
+
+#ifdef ENABLE_HDD_OVERLAY_LOG
+int hdd_overlay_do_log = ENABLE_HDD_OVERLAY_LOG;
+
+static void
+hdd_overlay_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (hdd_overlay_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define hdd_overlay_log(fmt, ...)
+#endif
+
+static inline int
+overlay_sector_present(const hdd_overlay_t *ovl, uint32_t sector)
+{
+    return !!(ovl->bitmap[sector >> 3] & (1 << (sector & 7)));
+}
+
+static inline uint64_t
+overlay_sector_offset(const hdd_overlay_t *ovl, uint32_t sector)
+{
+    uint32_t block = sector / ovl->hdr.block_sectors;
+
+    return ovl->hdr.data_offset + (((uint64_t) ovl->bat[block] * ovl->hdr.block_sectors) << 9LL) +
+           ((uint64_t) (sector % ovl->hdr.block_sectors) << 9LL);
+}
+
+static void
+overlay_init_header(overlay_header_t *hdr, uint32_t sectors)
+{
+    memset(hdr, 0, sizeof(overlay_header_t));
+    memcpy(hdr->magic, OVERLAY_MAGIC, 8);
+    hdr->version       = OVERLAY_VERSION;
+    hdr->block_sectors = OVERLAY_BLOCK_SECTORS;
+    hdr->sectors       = sectors;
+    hdr->blocks        = (sectors + OVERLAY_BLOCK_SECTORS - 1) / OVERLAY_BLOCK_SECTORS;
+    hdr->bat_offset    = sizeof(overlay_header_t);
+    hdr->bitmap_offset = hdr->bat_offset + (hdr->blocks * sizeof(uint32_t));
+    hdr->data_offset   = hdr->bitmap_offset + (hdr->blocks * (OVERLAY_BLOCK_SECTORS >> 3));
+    /* Align the data to the host page size for efficient I/O. */
+    hdr->data_offset   = (hdr->data_offset + 4095) & ~4095;
+    hdr->allocated     = 0;
+}
+
+static int
+overlay_write_at(hdd_overlay_t *ovl, uint64_t offset, const void *data, size_t len)
+{
+    if (fseeko64(ovl->fp, offset, SEEK_SET) == -1)
+        return 0;
+
+    return fwrite(data, 1, len, ovl->fp) == len;
+}
+
+static int
+overlay_write_metadata(hdd_overlay_t *ovl)
+{
+    if (!overlay_write_at(ovl, 0, &ovl->hdr, sizeof(overlay_header_t)) ||
+        !overlay_write_at(ovl, ovl->hdr.bat_offset, ovl->bat, ovl->hdr.blocks * sizeof(uint32_t)) ||
+        !overlay_write_at(ovl, ovl->hdr.bitmap_offset, ovl->bitmap,
+                          ovl->hdr.blocks * ovl->bitmap_bytes_per_block))
+        return 0;
+
+    fflush(ovl->fp);
+    return 1;
+}
+
+int
+hdd_overlay_create(const char *fn, uint32_t sectors)
+{
+    hdd_overlay_t ovl;
+    int           ret;
+
+    memset(&ovl, 0, sizeof(hdd_overlay_t));
+    overlay_init_header(&ovl.hdr, sectors);
+    ovl.bitmap_bytes_per_block = ovl.hdr.block_sectors >> 3;
+
+    ovl.fp = plat_fopen(fn, "wb+");
+    if (ovl.fp == NULL)
+        return 0;
+
+    ovl.bat    = (uint32_t *) malloc(ovl.hdr.blocks * sizeof(uint32_t));
+    ovl.bitmap = (uint8_t *) calloc(ovl.hdr.blocks, ovl.bitmap_bytes_per_block);
+    memset(ovl.bat, 0xff, ovl.hdr.blocks * sizeof(uint32_t));
+
+    ret = overlay_write_metadata(&ovl);
+
+    free(ovl.bitmap);
+    free(ovl.bat);
+    fclose(ovl.fp);
+
+    return ret;
+}
+
+hdd_overlay_t *
+hdd_overlay_open(const char *fn, uint32_t sectors,
+                 void (*read_base)(void *priv, uint32_t sector, uint32_t count, uint8_t *buffer),
+                 void *priv)
+{
+    hdd_overlay_t   *ovl;
+    overlay_header_t expected;
+    FILE            *fp;
+
+    fp = plat_fopen(fn, "rb+");
+    if (fp == NULL) {
+        hdd_overlay_log("Overlay %s: Creating new overlay\n", fn);
+        if (!hdd_overlay_create(fn, sectors))
+            return NULL;
+        fp = plat_fopen(fn, "rb+");
+        if (fp == NULL)
+            return NULL;
+    }
+
+    ovl     = (hdd_overlay_t *) calloc(1, sizeof(hdd_overlay_t));
+    ovl->fp = fp;
+    strncpy(ovl->fn, fn, sizeof(ovl->fn) - 1);
+    ovl->read_base = read_base;
+    ovl->priv      = priv;
+
+    overlay_init_header(&expected, sectors);
+    if ((fread(&ovl->hdr, 1, sizeof(overlay_header_t), fp) != sizeof(overlay_header_t)) ||
+        memcmp(ovl->hdr.magic, OVERLAY_MAGIC, 8) || (ovl->hdr.version != OVERLAY_VERSION) ||
+        (ovl->hdr.block_sectors != expected.block_sectors) || (ovl->hdr.sectors != expected.sectors) ||
+        (ovl->hdr.blocks != expected.blocks) || (ovl->hdr.bat_offset != expected.bat_offset) ||
+        (ovl->hdr.bitmap_offset != expected.bitmap_offset) || (ovl->hdr.data_offset != expected.data_offset)) {
+        pclog("Overlay %s: Invalid overlay or base image size mismatch\n", fn);
+        fclose(fp);
+        free(ovl);
+        return NULL;
+    }
+
+    ovl->bitmap_bytes_per_block = ovl->hdr.block_sectors >> 3;
+    ovl->bat                    = (uint32_t *) malloc(ovl->hdr.blocks * sizeof(uint32_t));
+    ovl->bitmap                 = (uint8_t *) malloc(ovl->hdr.blocks * ovl->bitmap_bytes_per_block);
+
+    if ((fseeko64(fp, ovl->hdr.bat_offset, SEEK_SET) == -1) ||
+        (fread(ovl->bat, sizeof(uint32_t), ovl->hdr.blocks, fp) != ovl->hdr.blocks) ||
+        (fseeko64(fp, ovl->hdr.bitmap_offset, SEEK_SET) == -1) ||
+        (fread(ovl->bitmap, ovl->bitmap_bytes_per_block, ovl->hdr.blocks, fp) != ovl->hdr.blocks)) {
+        pclog("Overlay %s: Error reading allocation tables\n", fn);
+        hdd_overlay_close(ovl);
+        return NULL;
+    }
+
+    hdd_overlay_log("Overlay %s: %i of %i blocks allocated\n", fn, ovl->hdr.allocated, ovl->hdr.blocks);
+
+    return ovl;
+}
+
+void
+hdd_overlay_close(hdd_overlay_t *ovl)
+{
+    if (ovl == NULL)
+        return;
+
+    if (ovl->fp != NULL)
+        fclose(ovl->fp);
+    free(ovl->bitmap);
+    free(ovl->bat);
+    free(ovl);
+}
+
+/* These return 1 on success, and 0 on a host I/O error. */
+int
+hdd_overlay_read(hdd_overlay_t *ovl, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    uint32_t run;
+    int      present;
+
+    if (ovl->fp == NULL)
+        return 0;
+    if (sector >= ovl->hdr.sectors)
+        return 1;
+    if ((ovl->hdr.sectors - sector) < count)
+        count = ovl->hdr.sectors - sector;
+
+    while (count > 0) {
+        /* Gather a run of sectors that all come from the same place; runs
+           held by the overlay must not cross a block boundary since blocks
+           are not contiguous in the file. */
+        present = overlay_sector_present(ovl, sector);
+        run     = 1;
+        while ((run < count) && (overlay_sector_present(ovl, sector + run) == present) &&
+               (!present || ((sector + run) % ovl->hdr.block_sectors)))
+            run++;
+
+        if (present) {
+            if ((fseeko64(ovl->fp, overlay_sector_offset(ovl, sector), SEEK_SET) == -1) ||
+                (fread(buffer, 512, run, ovl->fp) != run)) {
+                pclog("Overlay %s: Read error\n", ovl->fn);
+                return 0;
+            }
+        } else
+            ovl->read_base(ovl->priv, sector, run, buffer);
+
+        sector += run;
+        count -= run;
+        buffer += (run << 9);
+    }
+
+    return 1;
+}
+
+int
+hdd_overlay_write(hdd_overlay_t *ovl, uint32_t sector, uint32_t count, const uint8_t *buffer)
+{
+    uint32_t block;
+    uint32_t run;
+
+    if (ovl->fp == NULL)
+        return 0;
+    if (sector >= ovl->hdr.sectors)
+        return 1;
+    if ((ovl->hdr.sectors - sector) < count)
+        count = ovl->hdr.sectors - sector;
+
+    while (count > 0) {
+        block = sector / ovl->hdr.block_sectors;
+        run   = ovl->hdr.block_sectors - (sector % ovl->hdr.block_sectors);
+        if (run > count)
+            run = count;
+
+        if (ovl->bat[block] == OVERLAY_BLOCK_FREE) {
+            ovl->bat[block] = ovl->hdr.allocated++;
+            if (!overlay_write_at(ovl, ovl->hdr.bat_offset + (block * sizeof(uint32_t)),
+                                  &ovl->bat[block], sizeof(uint32_t)) ||
+                !overlay_write_at(ovl, 0, &ovl->hdr, sizeof(overlay_header_t))) {
+                pclog("Overlay %s: Error allocating block\n", ovl->fn);
+                return 0;
+            }
+        }
+
+        if (!overlay_write_at(ovl, overlay_sector_offset(ovl, sector), buffer, run << 9)) {
+            pclog("Overlay %s: Write error\n", ovl->fn);
+            return 0;
+        }
+
+        /* Mark the sectors present only once their data is in the file. */
+        for (uint32_t i = sector; i < (sector + run); i++)
+            ovl->bitmap[i >> 3] |= (1 << (i & 7));
+        if (!overlay_write_at(ovl, ovl->hdr.bitmap_offset + (block * ovl->bitmap_bytes_per_block),
+                              &ovl->bitmap[block * ovl->bitmap_bytes_per_block], ovl->bitmap_bytes_per_block)) {
+            pclog("Overlay %s: Error writing sector bitmap\n", ovl->fn);
+            return 0;
+        }
+
+        sector += run;
+        count -= run;
+        buffer += (run << 9);
+    }
+
+    return 1;
+}
+
+int
+hdd_overlay_zero(hdd_overlay_t *ovl, uint32_t sector, uint32_t count)
+{
+    uint32_t run;
+
+    while (count > 0) {
+        run = (count > OVERLAY_BLOCK_SECTORS) ? OVERLAY_BLOCK_SECTORS : count;
+        if (!hdd_overlay_write(ovl, sector, run, overlay_zero))
+            return 0;
+        sector += run;
+        count -= run;
+    }
+
+    return 1;
+}
+
+int
+hdd_overlay_discard(hdd_overlay_t *ovl)
+{
+    fclose(ovl->fp);
+
+    if (!hdd_overlay_create(ovl->fn, ovl->hdr.sectors)) {
+        ovl->fp = NULL;
+        return 0;
+    }
+
+    ovl->fp = plat_fopen(ovl->fn, "rb+");
+    if (ovl->fp == NULL)
+        return 0;
+
+    ovl->hdr.allocated = 0;
+    memset(ovl->bat, 0xff, ovl->hdr.blocks * sizeof(uint32_t));
+    memset(ovl->bitmap, 0x00, ovl->hdr.blocks * ovl->bitmap_bytes_per_block);
+
+    return 1;
+}
+
+int
+hdd_overlay_commit(hdd_overlay_t *ovl,
+                   int (*write_base)(void *priv, uint32_t sector, uint32_t count, uint8_t *buffer),
+                   void *priv)
+{
+    uint8_t  buffer[OVERLAY_BLOCK_SECTORS << 9];
+    uint32_t first;
+    uint32_t last;
+    uint32_t sector;
+    uint32_t run;
+
+    for (uint32_t block = 0; block < ovl->hdr.blocks; block++) {
+        if (ovl->bat[block] == OVERLAY_BLOCK_FREE)
+            continue;
+
+        first = block * ovl->hdr.block_sectors;
+        last  = first + ovl->hdr.block_sectors;
+        if (last > ovl->hdr.sectors)
+            last = ovl->hdr.sectors;
+
+        for (sector = first; sector < last; sector += run) {
+            run = 1;
+            if (!overlay_sector_present(ovl, sector))
+                continue;
+
+            while (((sector + run) < last) && overlay_sector_present(ovl, sector + run))
+                run++;
+
+            if ((fseeko64(ovl->fp, overlay_sector_offset(ovl, sector), SEEK_SET) == -1) ||
+                (fread(buffer, 512, run, ovl->fp) != run)) {
+                pclog("Overlay %s: Read error during commit\n", ovl->fn);
+                return 0;
+            }
+            /* Keep the overlay, so that nothing is lost, if the base could
+               not be written. */
+            if (!write_base(priv, sector, run, buffer)) {
+                pclog("Overlay %s: Write error on the base image during commit\n", ovl->fn);
+                return 0;
+            }
+        }
+    }
+
+    return hdd_overlay_discard(ovl);
+}
@@ -48,6 +48,14 @@
 
 #define MVHD_SPARSE_BLK        0xffffffff
 
+/* Number of block sector bitmaps kept in memory per image */
+#define MVHD_BITMAP_CACHE_SLOTS 1024
+
+/* Data cache geometry: entries of MVHD_CACHE_CHUNK_SECT sectors each */
+#define MVHD_CACHE_CHUNK_SECT  64
+#define MVHD_CACHE_ENTRIES     128
+#define MVHD_CACHE_NONE        0xffffffff
+
 /* For simplicity, we don't handle paths longer than this
  * Note, this is the max path in characters, as that is what
  * Windows uses
@@ -61,12 +69,33 @@
 #define MVHD_START_TS          946684800
 
 
+typedef struct MVHDBitmapSlot {
+    uint8_t* data;
+    uint32_t blk;
+    uint32_t last_use;
+    bool     dirty;
+} MVHDBitmapSlot;
+
 typedef struct MVHDSectorBitmap {
-    uint8_t* curr_bitmap;
-    int      sector_count;
-    int      curr_block;
+    int             sector_count;
+    int32_t*        slot_of;
+    MVHDBitmapSlot* slots;
+    int             slot_count;
+    uint32_t        clock;
 } MVHDSectorBitmap;
 
+typedef struct MVHDCacheEntry {
+    uint8_t* data;
+    uint32_t chunk;
+    uint32_t last_use;
+} MVHDCacheEntry;
+
+typedef struct MVHDDataCache {
+    MVHDCacheEntry* entries;
+    uint32_t        clock;
+    int             last;
+} MVHDDataCache;
+
 typedef struct MVHDFooter {
     uint8_t  cookie[8];
     uint32_t features;
@@ -122,6 +151,7 @@ struct MVHDMeta {
     uint32_t*        block_offset;
     int              sect_per_block;
     MVHDSectorBitmap bitmap;
+    MVHDDataCache    cache;
     int (*read_sectors)(struct MVHDMeta*, uint32_t, int, void*);
     int (*write_sectors)(struct MVHDMeta*, uint32_t, int, void*);
     struct {
@@ -389,6 +419,45 @@ int mvhd_sparse_diff_write(struct MVHDMeta* vhdm, uint32_t offset, int num_secto
  */
 int mvhd_noop_write(struct MVHDMeta* vhdm, uint32_t offset, int num_sectors, void* in_buff);
 
+/**
+ * \brief Write all modified sector bitmaps back to a sparse or differencing VHD image
+ * 
+ * Sector bitmaps are cached in memory, and are only written to file when they are 
+ * evicted from the cache, or when this function is called.
+ * 
+ * \param [in] vhdm MiniVHD data structure
+ */
+void mvhd_write_sect_bitmaps(struct MVHDMeta* vhdm);
+
+/**
+ * \brief Read from a sparse or differencing VHD image through the data cache
+ * 
+ * Small reads are served from a per-image LRU cache of recently read chunks of 
+ * MVHD_CACHE_CHUNK_SECT sectors, which avoids repeatedly walking the sector bitmaps 
+ * and seeking around the file for hot areas of the disk such as the FAT or directories.
+ * Larger reads bypass the cache.
+ * 
+ * \param [in] vhdm MiniVHD data structure
+ * \param [in] offset Sector offset to read from
+ * \param [in] num_sectors The desired number of sectors to read
+ * \param [out] out_buff An output buffer to store read sectors. Must be 
+ * large enough to hold num_sectors worth of sectors.
+ * 
+ * \retval 0 num_sectors were read from file
+ * \retval >0 < num_sectors were read from file
+ */
+int mvhd_cached_read(struct MVHDMeta* vhdm, uint32_t offset, int num_sectors, void* out_buff);
+
+/**
+ * \brief Update any cached chunks overlapping a range of written sectors
+ * 
+ * \param [in] vhdm MiniVHD data structure
+ * \param [in] offset Sector offset that was written to
+ * \param [in] num_sectors The number of sectors that were written
+ * \param [in] in_buff The data that was written
+ */
+void mvhd_cache_update(struct MVHDMeta* vhdm, uint32_t offset, int num_sectors, const void* in_buff);
+
 /**
  * \brief Save the contents of a VHD footer from a buffer to a struct
  * 
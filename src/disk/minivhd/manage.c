@@ -179,12 +179,15 @@ calc_sparse_values(MVHDMeta* vhdm)
 
 
 /**
- * \brief Allocate memory for a sector bitmap.
+ * \brief Allocate memory for the sector bitmap and data caches.
  *
  * Each data block is preceded by a sector bitmap. Each bit indicates whether the corresponding sector
  * is considered 'clean' or 'dirty' (for sparse VHD images), or whether to read from the parent or current
  * image (for differencing images).
  *
+ * Up to MVHD_BITMAP_CACHE_SLOTS sector bitmaps are kept in memory, the storage for all but the first
+ * one is allocated on demand. The data cache entries are allocated on demand as well.
+ *
  * \param [in] vhdm MiniVHD data structure
  * \param [out] err this is populated with MVHD_ERR_MEM if the calloc fails
  *
@@ -194,15 +197,58 @@ calc_sparse_values(MVHDMeta* vhdm)
 static int
 init_sector_bitmap(MVHDMeta* vhdm, MVHDError* err)
 {
-    vhdm->bitmap.curr_bitmap = calloc(vhdm->bitmap.sector_count, MVHD_SECTOR_SIZE);
-    if (vhdm->bitmap.curr_bitmap == NULL) {
-        *err = MVHD_ERR_MEM;
-        return -1;
-    }
+    vhdm->bitmap.slot_of = malloc(vhdm->sparse.max_bat_ent * sizeof *vhdm->bitmap.slot_of);
+    vhdm->bitmap.slots = calloc(MVHD_BITMAP_CACHE_SLOTS, sizeof *vhdm->bitmap.slots);
+    vhdm->cache.entries = calloc(MVHD_CACHE_ENTRIES, sizeof *vhdm->cache.entries);
+    if (vhdm->bitmap.slot_of == NULL || vhdm->bitmap.slots == NULL || vhdm->cache.entries == NULL)
+        goto fail;
 
-    vhdm->bitmap.curr_block = -1;
+    vhdm->bitmap.slots[0].data = calloc(vhdm->bitmap.sector_count, MVHD_SECTOR_SIZE);
+    if (vhdm->bitmap.slots[0].data == NULL)
+        goto fail;
+
+    for (uint32_t i = 0; i < vhdm->sparse.max_bat_ent; i++)
+        vhdm->bitmap.slot_of[i] = -1;
+    for (int i = 0; i < MVHD_CACHE_ENTRIES; i++)
+        vhdm->cache.entries[i].chunk = MVHD_CACHE_NONE;
 
     return 0;
+
+fail:
+    free(vhdm->bitmap.slot_of);
+    vhdm->bitmap.slot_of = NULL;
+    free(vhdm->bitmap.slots);
+    vhdm->bitmap.slots = NULL;
+    free(vhdm->cache.entries);
+    vhdm->cache.entries = NULL;
+    *err = MVHD_ERR_MEM;
+    return -1;
+}
+
+
+/**
+ * \brief Free the sector bitmap and data caches.
+ *
+ * \param [in] vhdm MiniVHD data structure
+ */
+static void
+free_sector_bitmap(MVHDMeta* vhdm)
+{
+    if (vhdm->bitmap.slots != NULL) {
+        for (int i = 0; i < MVHD_BITMAP_CACHE_SLOTS; i++)
+            free(vhdm->bitmap.slots[i].data);
+        free(vhdm->bitmap.slots);
+        vhdm->bitmap.slots = NULL;
+    }
+    free(vhdm->bitmap.slot_of);
+    vhdm->bitmap.slot_of = NULL;
+
+    if (vhdm->cache.entries != NULL) {
+        for (int i = 0; i < MVHD_CACHE_ENTRIES; i++)
+            free(vhdm->cache.entries[i].data);
+        free(vhdm->cache.entries);
+        vhdm->cache.entries = NULL;
+    }
 }
 
 
@@ -595,8 +641,7 @@ cleanup_format_buff:
     vhdm->format_buffer.zero_data = NULL;
 
 cleanup_bitmap:
-    free(vhdm->bitmap.curr_bitmap);
-    vhdm->bitmap.curr_bitmap = NULL;
+    free_sector_bitmap(vhdm);
 
 cleanup_bat:
     free(vhdm->block_offset);
@@ -624,16 +669,14 @@ mvhd_close(MVHDMeta* vhdm)
     if (vhdm->parent != NULL)
         mvhd_close(vhdm->parent);
 
+    mvhd_flush(vhdm);
     fclose(vhdm->f);
 
     if (vhdm->block_offset != NULL) {
         free(vhdm->block_offset);
         vhdm->block_offset = NULL;
     }
-    if (vhdm->bitmap.curr_bitmap != NULL) {
-        free(vhdm->bitmap.curr_bitmap);
-        vhdm->bitmap.curr_bitmap = NULL;
-    }
+    free_sector_bitmap(vhdm);
     if (vhdm->format_buffer.zero_data != NULL) {
         free(vhdm->format_buffer.zero_data);
         vhdm->format_buffer.zero_data = NULL;
@@ -643,6 +686,19 @@ mvhd_close(MVHDMeta* vhdm)
 }
 
 
+MVHDAPI void
+mvhd_flush(MVHDMeta* vhdm)
+{
+    if (vhdm == NULL || vhdm->readonly)
+        return;
+
+    if (vhdm->bitmap.slots != NULL)
+        mvhd_write_sect_bitmaps(vhdm);
+
+    fflush(vhdm->f);
+}
+
+
 MVHDAPI int
 mvhd_diff_update_par_timestamp(MVHDMeta* vhdm, int* err)
 {
@@ -681,6 +737,9 @@ mvhd_diff_update_par_timestamp(MVHDMeta* vhdm, int* err)
 MVHDAPI int
 mvhd_read_sectors(MVHDMeta* vhdm, uint32_t offset, int num_sectors, void* out_buff)
 {
+    if (vhdm->cache.entries != NULL)
+        return mvhd_cached_read(vhdm, offset, num_sectors, out_buff);
+
     return vhdm->read_sectors(vhdm, offset, num_sectors, out_buff);
 }
 
@@ -688,7 +747,12 @@ mvhd_read_sectors(MVHDMeta* vhdm, uint32_t offset, int num_sectors, void* out_bu
 MVHDAPI int
 mvhd_write_sectors(MVHDMeta* vhdm, uint32_t offset, int num_sectors, void* in_buff)
 {
-    return vhdm->write_sectors(vhdm, offset, num_sectors, in_buff);
+    int ret = vhdm->write_sectors(vhdm, offset, num_sectors, in_buff);
+
+    if (!vhdm->readonly)
+        mvhd_cache_update(vhdm, offset, num_sectors - ret, in_buff);
+
+    return ret;
 }
 
 
@@ -699,11 +763,11 @@ mvhd_format_sectors(MVHDMeta* vhdm, uint32_t offset, int num_sectors)
     int remain = num_sectors % vhdm->format_buffer.sector_count;
 
     for (int i = 0; i < num_full; i++) {
-        vhdm->write_sectors(vhdm, offset, vhdm->format_buffer.sector_count, vhdm->format_buffer.zero_data);
+        mvhd_write_sectors(vhdm, offset, vhdm->format_buffer.sector_count, vhdm->format_buffer.zero_data);
         offset += vhdm->format_buffer.sector_count;
     }
 
-    vhdm->write_sectors(vhdm, offset, remain, vhdm->format_buffer.zero_data);
+    mvhd_write_sectors(vhdm, offset, remain, vhdm->format_buffer.zero_data);
 
     return 0;
 }
@@ -259,6 +259,16 @@ MVHDAPI MVHDMeta* mvhd_create_ex(MVHDCreationOptions options, int* err);
  */
 MVHDAPI void mvhd_close(MVHDMeta* vhdm);
 
+/**
+ * \brief Write any cached metadata of a VHD image back to file
+ *
+ * Sector bitmaps of sparse and differencing images are cached in memory and
+ * written back lazily. mvhd_close() does this implicitly.
+ *
+ * \param [in] vhdm MiniVHD data structure to flush
+ */
+MVHDAPI void mvhd_flush(MVHDMeta* vhdm);
+
 /**
  * \brief Calculate hard disk geometry from a provided size
  *
@@ -51,9 +51,9 @@
  *
  * http://www.mathcs.emory.edu/~cheung/Courses/255/Syllabus/1-C-intro/bit-array.html
  */
-#define VHD_SETBIT(A,k)     ( A[(k>>3)] |= (0x80 >> (k&7)) )
-#define VHD_CLEARBIT(A,k)   ( A[(k>>3)] &= ~(0x80 >> (k&7)) )
-#define VHD_TESTBIT(A,k)    ( A[(k>>3)] & (0x80 >> (k&7)) )
+#define VHD_SETBIT(A,k)     ( A[((k)>>3)] |= (0x80 >> ((k)&7)) )
+#define VHD_CLEARBIT(A,k)   ( A[((k)>>3)] &= ~(0x80 >> ((k)&7)) )
+#define VHD_TESTBIT(A,k)    ( A[((k)>>3)] & (0x80 >> ((k)&7)) )
 
 /**
  * \brief Check that we will not be overflowing buffers
@@ -87,38 +87,88 @@ mvhd_write_empty_sectors(FILE *f, int sector_count)
 }
 
 /**
- * \brief Read the sector bitmap for a block.
+ * \brief Write the sector bitmap held in a cache slot to file
+ *
+ * \param [in] vhdm MiniVHD data structure
+ * \param [in] slot The cache slot to write back
+ */
+static void
+write_sect_bitmap(MVHDMeta *vhdm, MVHDBitmapSlot *slot)
+{
+    int64_t abs_offset = (int64_t)vhdm->block_offset[slot->blk] * MVHD_SECTOR_SIZE;
+
+    mvhd_fseeko64(vhdm->f, abs_offset, SEEK_SET);
+    fwrite(slot->data, MVHD_SECTOR_SIZE, vhdm->bitmap.sector_count, vhdm->f);
+    slot->dirty = false;
+}
+
+/**
+ * \brief Get the sector bitmap for a block.
+ *
+ * Sector bitmaps are kept in a cache of MVHD_BITMAP_CACHE_SLOTS entries, so
+ * that reads and writes do not have to go back to the file for every
+ * request. On a miss, the least recently used slot is reused, writing it
+ * back first if it was modified.
  *
  * If the block is sparse, the sector bitmap in memory will be
  * zeroed. Otherwise, the sector bitmap is read from the VHD file.
  *
  * \param [in] vhdm MiniVHD data structure
- * \param [in] blk The block for which to read the sector bitmap from
+ * \param [in] blk The block for which to get the sector bitmap
+ *
+ * \return the cache slot holding the sector bitmap of blk
  */
-static void
-read_sect_bitmap(MVHDMeta *vhdm, int blk)
+static MVHDBitmapSlot*
+get_sect_bitmap(MVHDMeta *vhdm, int blk)
 {
+    MVHDSectorBitmap *bm = &vhdm->bitmap;
+    MVHDBitmapSlot *slot;
+    int bm_size = bm->sector_count * MVHD_SECTOR_SIZE;
+    int i = bm->slot_of[blk];
+
+    if (i >= 0) {
+        slot = &bm->slots[i];
+        slot->last_use = ++bm->clock;
+        return slot;
+    }
+
+    i = bm->slot_count;
+    slot = &bm->slots[i];
+    if ((i < MVHD_BITMAP_CACHE_SLOTS) && ((slot->data != NULL) || ((slot->data = malloc(bm_size)) != NULL)))
+        bm->slot_count++;
+    else {
+        /* Cache full (or out of memory), evict the least recently used bitmap */
+        i = 0;
+        for (int j = 1; j < bm->slot_count; j++) {
+            if ((bm->clock - bm->slots[j].last_use) > (bm->clock - bm->slots[i].last_use))
+                i = j;
+        }
+        slot = &bm->slots[i];
+        if (slot->dirty)
+            write_sect_bitmap(vhdm, slot);
+        bm->slot_of[slot->blk] = -1;
+    }
+
     if (vhdm->block_offset[blk] != MVHD_SPARSE_BLK) {
         mvhd_fseeko64(vhdm->f, (uint64_t)vhdm->block_offset[blk] * MVHD_SECTOR_SIZE, SEEK_SET);
-        (void) !fread(vhdm->bitmap.curr_bitmap, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE, 1, vhdm->f);
+        (void) !fread(slot->data, bm_size, 1, vhdm->f);
     } else
-        memset(vhdm->bitmap.curr_bitmap, 0, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE);
+        memset(slot->data, 0, bm_size);
+
+    slot->blk = blk;
+    slot->dirty = false;
+    slot->last_use = ++bm->clock;
+    bm->slot_of[blk] = i;
 
-    vhdm->bitmap.curr_block = blk;
+    return slot;
 }
 
-/**
- * \brief Write the current sector bitmap in memory to file
- *
- * \param [in] vhdm MiniVHD data structure
- */
-static void
-write_curr_sect_bitmap(MVHDMeta* vhdm)
+void
+mvhd_write_sect_bitmaps(MVHDMeta *vhdm)
 {
-    if (vhdm->bitmap.curr_block >= 0) {
-        int64_t abs_offset = (int64_t)vhdm->block_offset[vhdm->bitmap.curr_block] * MVHD_SECTOR_SIZE;
-        mvhd_fseeko64(vhdm->f, abs_offset, SEEK_SET);
-        fwrite(vhdm->bitmap.curr_bitmap, MVHD_SECTOR_SIZE, vhdm->bitmap.sector_count, vhdm->f);
+    for (int i = 0; i < vhdm->bitmap.slot_count; i++) {
+        if (vhdm->bitmap.slots[i].dirty)
+            write_sect_bitmap(vhdm, &vhdm->bitmap.slots[i]);
     }
 }
 
@@ -223,38 +273,74 @@ mvhd_sparse_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buf
     int64_t addr = 0ULL;
     uint32_t s = 0;
     uint32_t ls = 0;
+    uint8_t* bitmap;
     int blk = 0;
-    int prev_blk = -1;
     int sib = 0;
+    int run = 0;
+    int set = 0;
+    int n = 0;
     ls = offset + transfer_sectors;
 
-    for (s = offset; s < ls; s++) {
+    for (s = offset; s < ls; s += run) {
         blk = s / vhdm->sect_per_block;
         sib = s % vhdm->sect_per_block;
-        if (blk != prev_blk) {
-            prev_blk = blk;
-            if (vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(vhdm, blk);
-                mvhd_fseeko64(vhdm->f, (uint64_t)sib * MVHD_SECTOR_SIZE, SEEK_CUR);
-            } else {
-                addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
-                       MVHD_SECTOR_SIZE;
-                mvhd_fseeko64(vhdm->f, addr, SEEK_SET);
-            }
+        run = vhdm->sect_per_block - sib;
+        if ((uint32_t) run > (ls - s))
+            run = ls - s;
+
+        if (vhdm->block_offset[blk] == MVHD_SPARSE_BLK) {
+            memset(buff, 0, run * MVHD_SECTOR_SIZE);
+            buff += run * MVHD_SECTOR_SIZE;
+            continue;
         }
 
-        if (VHD_TESTBIT(vhdm->bitmap.curr_bitmap, sib))
-            (void) !fread(buff, MVHD_SECTOR_SIZE, 1, vhdm->f);
-        else {
-            memset(buff, 0, MVHD_SECTOR_SIZE);
-            mvhd_fseeko64(vhdm->f, MVHD_SECTOR_SIZE, SEEK_CUR);
+        /* Transfer each run of present or absent sectors in one go */
+        bitmap = get_sect_bitmap(vhdm, blk)->data;
+        for (int i = 0; i < run; i += n) {
+            set = !!VHD_TESTBIT(bitmap, sib + i);
+            for (n = 1; (i + n) < run; n++) {
+                if (!!VHD_TESTBIT(bitmap, sib + i + n) != set)
+                    break;
+            }
+
+            if (set) {
+                addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib + i) *
+                       MVHD_SECTOR_SIZE;
+                mvhd_fseeko64(vhdm->f, addr, SEEK_SET);
+                (void) !fread(buff, n * MVHD_SECTOR_SIZE, 1, vhdm->f);
+            } else
+                memset(buff, 0, n * MVHD_SECTOR_SIZE);
+            buff += n * MVHD_SECTOR_SIZE;
         }
-        buff += MVHD_SECTOR_SIZE;
     }
 
     return truncated_sectors;
 }
 
+/**
+ * \brief Find the image in a differencing chain which holds a sector
+ *
+ * \param [in] vhdm MiniVHD data structure of the child image
+ * \param [in] s The sector to look up
+ *
+ * \return the MiniVHD data structure to read the sector from
+ */
+static MVHDMeta*
+diff_sector_owner(MVHDMeta *vhdm, uint32_t s)
+{
+    while (vhdm->footer.disk_type == MVHD_TYPE_DIFF) {
+        int blk = s / vhdm->sect_per_block;
+        int sib = s % vhdm->sect_per_block;
+
+        if ((vhdm->block_offset[blk] != MVHD_SPARSE_BLK) &&
+            VHD_TESTBIT(get_sect_bitmap(vhdm, blk)->data, sib))
+            break;
+        vhdm = vhdm->parent;
+    }
+
+    return vhdm;
+}
+
 int
 mvhd_diff_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
 {
@@ -265,35 +351,29 @@ mvhd_diff_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
     check_sectors(offset, num_sectors, total_sectors, &transfer_sectors, &truncated_sectors);
 
     uint8_t *buff = (uint8_t*)out_buff;
-    MVHDMeta *curr_vhdm = vhdm;
+    MVHDMeta *curr_vhdm = NULL;
     uint32_t s = 0;
     uint32_t ls = 0;
-    int blk = 0;
-    int sib = 0;
+    uint32_t n = 0;
     ls = offset + transfer_sectors;
 
-    for (s = offset; s < ls; s++) {
-        while (curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) {
-            blk = s / curr_vhdm->sect_per_block;
-            sib = s % curr_vhdm->sect_per_block;
-            if (curr_vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(curr_vhdm, blk);
-            }
-            if (!VHD_TESTBIT(curr_vhdm->bitmap.curr_bitmap, sib)) {
-                curr_vhdm = curr_vhdm->parent;
-            } else { break; }
+    for (s = offset; s < ls; s += n) {
+        /* Gather the run of sectors which live in the same image of the chain */
+        curr_vhdm = diff_sector_owner(vhdm, s);
+        for (n = 1; (s + n) < ls; n++) {
+            if (diff_sector_owner(vhdm, s + n) != curr_vhdm)
+                break;
         }
 
         /* We handle actual sector reading using the fixed or sparse functions,
            as a differencing VHD is also a sparse VHD */
         if ((curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) ||
             (curr_vhdm->footer.disk_type == MVHD_TYPE_DYNAMIC))
-            mvhd_sparse_read(curr_vhdm, s, 1, buff);
+            mvhd_sparse_read(curr_vhdm, s, n, buff);
         else
-            mvhd_fixed_read(curr_vhdm, s, 1, buff);
+            mvhd_fixed_read(curr_vhdm, s, n, buff);
 
-        curr_vhdm = vhdm;
-        buff += MVHD_SECTOR_SIZE;
+        buff += n * MVHD_SECTOR_SIZE;
     }
 
     return truncated_sectors;
@@ -329,46 +409,37 @@ mvhd_sparse_diff_write(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *i
     int64_t addr = 0ULL;
     uint32_t s = 0;
     uint32_t ls = 0;
+    MVHDBitmapSlot* slot;
     int blk = 0;
-    int prev_blk = -1;
     int sib = 0;
+    int run = 0;
     ls = offset + transfer_sectors;
 
-    for (s = offset; s < ls; s++) {
+    for (s = offset; s < ls; s += run) {
         blk = s / vhdm->sect_per_block;
         sib = s % vhdm->sect_per_block;
-        if (vhdm->bitmap.curr_block != blk && prev_blk >= 0) {
-            /* Write the sector bitmap for the previous block, before we replace it. */
-            write_curr_sect_bitmap(vhdm);
-        }
+        run = vhdm->sect_per_block - sib;
+        if ((uint32_t) run > (ls - s))
+            run = ls - s;
 
-        if (vhdm->block_offset[blk] == MVHD_SPARSE_BLK) {
-            /* "read" the sector bitmap first, before creating a new block, as the bitmap will be
-               zero either way */
-            read_sect_bitmap(vhdm, blk);
+        if (vhdm->block_offset[blk] == MVHD_SPARSE_BLK)
             create_block(vhdm, blk);
-        }
 
-        if (blk != prev_blk) {
-            if (vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(vhdm, blk);
-                mvhd_fseeko64(vhdm->f, (uint64_t)sib * MVHD_SECTOR_SIZE, SEEK_CUR);
-            } else {
-                addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
-                       MVHD_SECTOR_SIZE;
-                mvhd_fseeko64(vhdm->f, addr, SEEK_SET);
+        addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) * MVHD_SECTOR_SIZE;
+        mvhd_fseeko64(vhdm->f, addr, SEEK_SET);
+        fwrite(buff, run * MVHD_SECTOR_SIZE, 1, vhdm->f);
+        buff += run * MVHD_SECTOR_SIZE;
+
+        /* The sector bitmap is only written back when it gets evicted, or on flush */
+        slot = get_sect_bitmap(vhdm, blk);
+        for (int i = sib; i < (sib + run); i++) {
+            if (!VHD_TESTBIT(slot->data, i)) {
+                VHD_SETBIT(slot->data, i);
+                slot->dirty = true;
             }
-            prev_blk = blk;
         }
-
-        fwrite(buff, MVHD_SECTOR_SIZE, 1, vhdm->f);
-        VHD_SETBIT(vhdm->bitmap.curr_bitmap, sib);
-        buff += MVHD_SECTOR_SIZE;
     }
 
-    /* And write the sector bitmap for the last block we visited to disk */
-    write_curr_sect_bitmap(vhdm);
-
     return truncated_sectors;
 }
 
@@ -382,3 +453,120 @@ mvhd_noop_write(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *in_buff)
 
     return 0;
 }
+
+/**
+ * \brief Find a chunk in the data cache
+ *
+ * \param [in] cache The data cache
+ * \param [in] chunk The chunk number to look for
+ *
+ * \return the cache entry holding chunk, or NULL on a miss
+ */
+static MVHDCacheEntry*
+cache_lookup(MVHDDataCache *cache, uint32_t chunk)
+{
+    if (cache->entries[cache->last].chunk == chunk)
+        return &cache->entries[cache->last];
+
+    for (int i = 0; i < MVHD_CACHE_ENTRIES; i++) {
+        if (cache->entries[i].chunk == chunk) {
+            cache->last = i;
+            return &cache->entries[i];
+        }
+    }
+
+    return NULL;
+}
+
+int
+mvhd_cached_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
+{
+    int transfer_sectors = 0;
+    int truncated_sectors = 0;
+    uint32_t total_sectors = (uint32_t)(vhdm->footer.curr_sz / MVHD_SECTOR_SIZE);
+
+    if (num_sectors >= MVHD_CACHE_CHUNK_SECT)
+        return vhdm->read_sectors(vhdm, offset, num_sectors, out_buff);
+
+    check_sectors(offset, num_sectors, total_sectors, &transfer_sectors, &truncated_sectors);
+
+    MVHDDataCache *cache = &vhdm->cache;
+    MVHDCacheEntry *entry;
+    uint8_t *buff = (uint8_t*)out_buff;
+    uint32_t s = 0;
+    uint32_t ls = 0;
+    uint32_t chunk = 0;
+    uint32_t start = 0;
+    int cis = 0;
+    int n = 0;
+    ls = offset + transfer_sectors;
+
+    for (s = offset; s < ls; s += n) {
+        chunk = s / MVHD_CACHE_CHUNK_SECT;
+        cis = s % MVHD_CACHE_CHUNK_SECT;
+        n = MVHD_CACHE_CHUNK_SECT - cis;
+        if ((uint32_t) n > (ls - s))
+            n = ls - s;
+
+        entry = cache_lookup(cache, chunk);
+        if (entry == NULL) {
+            /* Miss, replace the least recently used chunk */
+            int victim = 0;
+            for (int i = 1; i < MVHD_CACHE_ENTRIES; i++) {
+                if ((cache->clock - cache->entries[i].last_use) > (cache->clock - cache->entries[victim].last_use))
+                    victim = i;
+            }
+            entry = &cache->entries[victim];
+            if (entry->data == NULL)
+                entry->data = malloc(MVHD_CACHE_CHUNK_SECT * MVHD_SECTOR_SIZE);
+            if (entry->data == NULL) {
+                vhdm->read_sectors(vhdm, s, n, buff);
+                buff += n * MVHD_SECTOR_SIZE;
+                continue;
+            }
+
+            start = chunk * MVHD_CACHE_CHUNK_SECT;
+            entry->chunk = MVHD_CACHE_NONE;
+            vhdm->read_sectors(vhdm, start, MVHD_CACHE_CHUNK_SECT, entry->data);
+            entry->chunk = chunk;
+            cache->last = victim;
+        }
+
+        entry->last_use = ++cache->clock;
+        memcpy(buff, entry->data + (cis * MVHD_SECTOR_SIZE), n * MVHD_SECTOR_SIZE);
+        buff += n * MVHD_SECTOR_SIZE;
+    }
+
+    return truncated_sectors;
+}
+
+void
+mvhd_cache_update(MVHDMeta *vhdm, uint32_t offset, int num_sectors, const void *in_buff)
+{
+    MVHDDataCache *cache = &vhdm->cache;
+    MVHDCacheEntry *entry;
+    const uint8_t *buff = (const uint8_t*)in_buff;
+    uint32_t start;
+    uint32_t end;
+
+    if (cache->entries == NULL || num_sectors <= 0)
+        return;
+
+    for (int i = 0; i < MVHD_CACHE_ENTRIES; i++) {
+        entry = &cache->entries[i];
+        if (entry->chunk == MVHD_CACHE_NONE)
+            continue;
+
+        start = entry->chunk * MVHD_CACHE_CHUNK_SECT;
+        end = start + MVHD_CACHE_CHUNK_SECT;
+        if (start < offset)
+            start = offset;
+        if (end > (offset + num_sectors))
+            end = offset + num_sectors;
+        if (start >= end)
+            continue;
+
+        memcpy(entry->data + ((start % MVHD_CACHE_CHUNK_SECT) * MVHD_SECTOR_SIZE),
+               buff + ((start - offset) * MVHD_SECTOR_SIZE), (end - start) * MVHD_SECTOR_SIZE);
+    }
+}
@@ -32,6 +32,8 @@
 #include <86box/io.h>
 #include <86box/pic.h>
 #include <86box/dma.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 #include <86box/plat_unused.h>
 
 dma_t   dma[8];
@@ -1194,6 +1196,46 @@ dma_high_page_init(void)
                   dma_high_page_read, NULL, NULL, dma_high_page_write, NULL, NULL, NULL);
 }
 
+void
+dma_save(snapshot_t *s)
+{
+    snapshot_write_var(s, dma);
+    snapshot_write_var(s, dma_e);
+    snapshot_write_var(s, dma_m);
+    snapshot_write_var(s, dmaregs);
+    snapshot_write_var(s, dma_wp);
+    snapshot_write_var(s, dma_stat);
+    snapshot_write_var(s, dma_stat_rq);
+    snapshot_write_var(s, dma_stat_rq_pc);
+    snapshot_write_var(s, dma_stat_adv_pend);
+    snapshot_write_var(s, dma_command);
+    snapshot_write_var(s, dma_req_is_soft);
+    snapshot_write_var(s, dma_advanced);
+    snapshot_write_var(s, dma_ps2.xfr_command);
+    snapshot_write_var(s, dma_ps2.xfr_channel);
+    snapshot_write_var(s, dma_ps2.byte_ptr);
+}
+
+void
+dma_load(snapshot_t *s)
+{
+    snapshot_read_var(s, dma);
+    snapshot_read_var(s, dma_e);
+    snapshot_read_var(s, dma_m);
+    snapshot_read_var(s, dmaregs);
+    snapshot_read_var(s, dma_wp);
+    snapshot_read_var(s, dma_stat);
+    snapshot_read_var(s, dma_stat_rq);
+    snapshot_read_var(s, dma_stat_rq_pc);
+    snapshot_read_var(s, dma_stat_adv_pend);
+    snapshot_read_var(s, dma_command);
+    snapshot_read_var(s, dma_req_is_soft);
+    snapshot_read_var(s, dma_advanced);
+    snapshot_read_var(s, dma_ps2.xfr_command);
+    snapshot_read_var(s, dma_ps2.xfr_channel);
+    snapshot_read_var(s, dma_ps2.byte_ptr);
+}
+
 void
 dma_init(void)
 {
@@ -1852,10 +1894,8 @@ dma_bm_read(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize, int Tra
     n2 = TotalSize - n;
 
     /* Do the divisible block, if there is one. */
-    if (n) {
-        for (uint32_t i = 0; i < n; i += TransferSize)
-            mem_read_phys((void *) &(DataRead[i]), PhysAddress + i, TransferSize);
-    }
+    if (n)
+        mem_read_phys_block((void *) DataRead, PhysAddress, n, TransferSize);
 
     /* Do the non-divisible block, if there is one. */
     if (n2) {
@@ -1874,19 +1914,18 @@ dma_bm_write(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize,
     n  = TotalSize & ~(TransferSize - 1);
     n2 = TotalSize - n;
 
-    /* Do the divisible block, if there is one. */
-    if (n) {
-        for (uint32_t i = 0; i < n; i += TransferSize)
-            mem_write_phys((void *) &(DataWrite[i]), PhysAddress + i, TransferSize);
-    }
+    /* Do the divisible block, if there is one. This invalidates everything
+       it writes. */
+    if (n)
+        mem_write_phys_block((void *) DataWrite, PhysAddress, n, TransferSize);
 
     /* Do the non-divisible block, if there is one. */
     if (n2) {
         mem_read_phys((void *) bytes, PhysAddress + n, TransferSize);
         memcpy(bytes, (void *) &(DataWrite[n]), n2);
         mem_write_phys((void *) bytes, PhysAddress + n, TransferSize);
-    }
 
-    if (dma_at)
-        mem_invalidate_range(PhysAddress, PhysAddress + TotalSize - 1);
+        if (dma_at)
+            mem_invalidate_range(PhysAddress + n, PhysAddress + TotalSize - 1);
+    }
 }
@@ -623,6 +623,51 @@ fdc_bad_command(fdc_t *fdc)
     timer_set_delay_u64(&fdc->timer, 100 * TIMER_USEC);
 }
 
+/* Sector-level mode, for READ DATA and WRITE DATA through DMA on drives that
+   have it enabled: if the drive can hand over the sector as a plain buffer,
+   it is moved in one go, and the FDC goes on to the next sector, the same way
+   as when the drive finishes one, after the time the sector takes to pass
+   under the head. Returns 0 if the sector has to go through the drive as
+   usual, which then also reports any errors. */
+static int
+fdc_sector_fast(fdc_t *fdc)
+{
+    int      drive = real_drive(fdc, fdc->drive);
+    int      write = (fdc->interrupt == 0x05);
+    uint8_t *data;
+    uint32_t len;
+
+    if (((fdc->interrupt != 0x05) && (fdc->interrupt != 0x06)) || (fdc->flags & FDC_FLAG_PCJR) ||
+        !fdc->dma || (fdc->deleted & 2) || fdc->tc || !fdc->params[4] || (write && writeprot[drive]))
+        return 0;
+
+    data = fdd_sector_data(drive, fdc->rw_track, fdc->head, fdc->sector, fdc->params[4]);
+    if (data == NULL)
+        return 0;
+
+    len = 128 << fdc->params[4];
+    fdc_log("Sector-level %s (drive %i) (%i %i %i %i)\n", write ? "write" : "read", drive,
+            fdc->rw_track, fdc->head, fdc->sector, fdc->params[4]);
+
+    if (write) {
+        /* Once TC is hit, the rest of the sector is filled with zeroes. */
+        for (uint32_t i = 0; i < len; i++) {
+            int val = fdc_getdata(fdc, i == (len - 1));
+
+            data[i] = (val == -1) ? 0x00 : (val & 0xff);
+        }
+        fdd_do_writeback(drive);
+    } else {
+        for (uint32_t i = 0; i < len; i++) {
+            if (fdc_data(fdc, data[i], i == (len - 1)) == -1)
+                break;
+        }
+    }
+
+    timer_set_delay_u64(&fdc->timer, fdd_sector_period(drive, len, fdc->gap));
+    return 1;
+}
+
 static void
 fdc_io_command_phase1(fdc_t *fdc, int out)
 {
@@ -1050,7 +1095,8 @@ fdc_write(uint16_t addr, uint8_t val, void *priv)
                                 fdc_noidam(fdc);
                                 return;
                             }
-                            fdd_writesector(real_drive(fdc, fdc->drive), fdc->sector, fdc->params[1], fdc->head, fdc->rate, fdc->params[4]);
+                            if (!fdc_sector_fast(fdc))
+                                fdd_writesector(real_drive(fdc, fdc->drive), fdc->sector, fdc->params[1], fdc->head, fdc->rate, fdc->params[4]);
                             break;
                         case 0x11: /* Scan equal */
                         case 0x19: /* Scan low or equal */
@@ -1080,7 +1126,8 @@ fdc_write(uint16_t addr, uint8_t val, void *priv)
                                 fdc->tc = 1;
                                 fdc->deleted |= 2;
                             }
-                            fdd_readsector(real_drive(fdc, fdc->drive), fdc->sector, fdc->params[1], fdc->head, fdc->rate, fdc->params[4]);
+                            if (!fdc_sector_fast(fdc))
+                                fdd_readsector(real_drive(fdc, fdc->drive), fdc->sector, fdc->params[1], fdc->head, fdc->rate, fdc->params[4]);
                             break;
 
                         case 0x07: /* Recalibrate */
@@ -1681,7 +1728,8 @@ fdc_callback(void *priv)
             switch (fdc->interrupt) {
                 case 5:
                 case 9:
-                    fdd_writesector(real_drive(fdc, fdc->drive), fdc->sector, fdc->rw_track, fdc->head, fdc->rate, fdc->params[4]);
+                    if (!fdc_sector_fast(fdc))
+                        fdd_writesector(real_drive(fdc, fdc->drive), fdc->sector, fdc->rw_track, fdc->head, fdc->rate, fdc->params[4]);
                     if ((fdc->flags & FDC_FLAG_PCJR) || !fdc->dma)
                         fdc->stat = 0xb0;
                     else {
@@ -1692,7 +1740,8 @@ fdc_callback(void *priv)
                 case 6:
                 case 0xC:
                 case 0x16:
-                    fdd_readsector(real_drive(fdc, fdc->drive), fdc->sector, fdc->rw_track, fdc->head, fdc->rate, fdc->params[4]);
+                    if (!fdc_sector_fast(fdc))
+                        fdd_readsector(real_drive(fdc, fdc->drive), fdc->sector, fdc->rw_track, fdc->head, fdc->rate, fdc->params[4]);
                     if ((fdc->flags & FDC_FLAG_PCJR) || !fdc->dma)
                         fdc->stat = 0x70;
                     else {
@@ -71,6 +71,7 @@ typedef struct fdd_t {
     int head;
     int turbo;
     int check_bpb;
+    int sector_level;
 } fdd_t;
 
 fdd_t fdd[FDD_NUM];
@@ -417,6 +418,18 @@ fdd_get_turbo(int drive)
     return fdd[drive].turbo;
 }
 
+void
+fdd_set_sector_level(int drive, int sector_level)
+{
+    fdd[drive].sector_level = sector_level;
+}
+
+int
+fdd_get_sector_level(int drive)
+{
+    return fdd[drive].sector_level;
+}
+
 void
 fdd_set_check_bpb(int drive, int check_bpb)
 {
@@ -499,6 +512,7 @@ fdd_close(int drive)
     drives[drive].format        = NULL;
     drives[drive].byteperiod    = NULL;
     drives[drive].stop          = NULL;
+    drives[drive].sector_data   = NULL;
     d86f_destroy(drive);
     ui_sb_update_icon_state(SB_FLOPPY | drive, 1);
 }
@@ -673,3 +687,25 @@ fdd_do_writeback(int drive)
 {
     d86f_handler[drive].writeback(drive);
 }
+
+/* Sector-level access for the FDC, for drives that have it enabled. Returns
+   the data of sector c/h/r/n under the head, or NULL if the sector has to be
+   looked for in the bit cells as usual, including whenever the motor is off
+   or the FDC could not read the disk at its current data rate. */
+uint8_t *
+fdd_sector_data(int drive, uint8_t c, uint8_t h, uint8_t r, uint8_t n)
+{
+    if (!fdd[drive].sector_level || (drives[drive].sector_data == NULL) || drive_empty[drive] ||
+        !motoron[drive] || !d86f_can_read_address(drive))
+        return NULL;
+
+    return drives[drive].sector_data(drive, fdd_get_head(drive), c, h, r, n);
+}
+
+/* Time the sector slot takes to pass under the head: the ID field, gap 2,
+   the data field and gap 3, at the drive's byte period. */
+uint64_t
+fdd_sector_period(int drive, uint32_t len, uint8_t gap)
+{
+    return (62ULL + len + gap) * fdd_byteperiod(drive);
+}
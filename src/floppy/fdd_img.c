@@ -474,6 +474,22 @@ poll_write_data(int drive, UNUSED(int side), uint16_t pos, uint8_t data)
     dev->track_data[dev->current_sector_pos_side][dev->current_sector_pos + pos] = data;
 }
 
+/* For the FDC's sector-level mode: ordinary images have every sector of the
+   track in the image in order, with the IDs img_seek() gives them. */
+static uint8_t *
+sector_data(int drive, int side, uint8_t c, uint8_t h, uint8_t r, uint8_t n)
+{
+    img_t *dev = img[drive];
+
+    if ((dev->fp == NULL) || (dev->xdf_type && !dev->is_cqm) || (dev->track > dev->tracks))
+        return NULL;
+    if ((side >= dev->sides) || (c != dev->track) || (h != side) || (n != dev->sector_size) ||
+        (r < 1) || (r > dev->sectors))
+        return NULL;
+
+    return &dev->track_data[side][(r - 1) * (128 << ((int) dev->sector_size))];
+}
+
 static int
 format_conditions(int drive)
 {
@@ -1247,6 +1263,7 @@ jump_if_fdf:
     drives[drive].seek = img_seek;
 
     d86f_common_handlers(drive);
+    drives[drive].sector_data = sector_data;
 }
 
 void
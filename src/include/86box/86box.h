@@ -89,6 +89,7 @@ extern int force_debug; /* (O) force debug output */
 extern int video_fps; /* (O) render speed in fps */
 #endif
 extern int settings_only;     /* (O) show only the settings dialog */
+extern int run_headless;      /* (O) no window, sound or speed limit */
 extern int confirm_exit_cmdl; /* (O) do not ask for confirmation on quit if set to 0 */
 #ifdef _WIN32
 extern uint64_t unique_id;
@@ -140,6 +141,9 @@ extern uint32_t mem_size;                   /* (C) memory size (Installed on sys
 extern uint32_t isa_mem_size;               /* (C) memory size (ISA Memory Cards) */
 extern int      cpu;                        /* (C) cpu type */
 extern int      cpu_use_dynarec;            /* (C) cpu uses/needs Dyna */
+extern int      cpu_dynarec_cache;          /* (C) keep dynarec block profile */
+extern int      cpu_dynarec_async;          /* (C) compile dynarec blocks in background */
+extern int      mem_tlb_size;               /* (C) soft TLB entries */
 extern int      fpu_type;                   /* (C) fpu type */
 extern int      fpu_softfloat;              /* (C) fpu uses softfloat */
 extern int      time_sync;                  /* (C) enable time sync */
@@ -163,6 +167,7 @@ extern _Atomic double mouse_y_error;        /* Mouse error accumulator - Y */
 #endif
 extern int    pit_mode;                     /* (C) force setting PIT mode */
 extern int    fm_driver;                    /* (C) select FM sound driver */
+extern int    fm_async;                     /* (C) render FM synthesis on the sound render thread */
 
 /* Keyboard variables for future key combination redefinition. */
 extern uint16_t key_prefix_1_1;
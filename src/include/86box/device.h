@@ -163,6 +163,8 @@ typedef struct _device_config_ {
     const device_config_bios_t      bios[32];
 } device_config_t;
 
+struct snapshot_t;
+
 typedef struct _device_ {
     const char *name;
     const char *internal_name;
@@ -183,6 +185,10 @@ typedef struct _device_ {
     void (*force_redraw)(void *priv);
 
     const device_config_t *config;
+
+    /* Optional snapshot support, see snapshot.h. */
+    void (*save)(void *priv, struct snapshot_t *s);
+    void (*load)(void *priv, struct snapshot_t *s);
 } device_t;
 
 typedef struct device_context_t {
@@ -212,6 +218,9 @@ extern void  device_add_inst_ex_params(const device_t *dev, void *priv, int inst
 extern void *device_get_common_priv(void);
 extern void  device_close_all(void);
 extern void  device_reset_all(uint32_t match_flags);
+extern int   device_snapshot_check(void);
+extern void  device_save_all(struct snapshot_t *s);
+extern void  device_load(struct snapshot_t *s, uint32_t index, const char *name);
 extern void *device_find_first_priv(uint32_t match_flags);
 extern void *device_get_priv(const device_t *dev);
 extern int   device_available(const device_t *dev);
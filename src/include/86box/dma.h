@@ -76,6 +76,8 @@ typedef struct dma_t {
     int      eot;
 } dma_t;
 
+struct snapshot_t;
+
 extern dma_t   dma[8];
 extern uint8_t dma_e;
 extern uint8_t dma_m;
@@ -84,6 +86,8 @@ extern void dma_init(void);
 extern void dma16_init(void);
 extern void ps2_dma_init(void);
 extern void dma_reset(void);
+extern void dma_save(struct snapshot_t *s);
+extern void dma_load(struct snapshot_t *s);
 extern int  dma_mode(int channel);
 
 extern void    readdma0(void);
@@ -51,6 +51,8 @@ extern void fdd_set_turbo(int drive, int turbo);
 extern int  fdd_get_turbo(int drive);
 extern void fdd_set_check_bpb(int drive, int check_bpb);
 extern int  fdd_get_check_bpb(int drive);
+extern void fdd_set_sector_level(int drive, int sector_level);
+extern int  fdd_get_sector_level(int drive);
 
 extern void fdd_set_type(int drive, int type);
 extern int  fdd_get_type(int drive);
@@ -81,6 +83,9 @@ typedef struct DRIVE {
     uint64_t (*byteperiod)(int drive);
     void (*stop)(int drive);
     void (*poll)(int drive);
+    /* Plain sector images only: the data of the given sector on the current
+       track, or NULL if it is not there in the standard layout. */
+    uint8_t *(*sector_data)(int drive, int side, uint8_t c, uint8_t h, uint8_t r, uint8_t n);
 } DRIVE;
 
 extern DRIVE      drives[FDD_NUM];
@@ -112,6 +117,9 @@ extern int  fdd_hole(int drive);
 extern void fdd_stop(int drive);
 extern void fdd_do_writeback(int drive);
 
+extern uint8_t *fdd_sector_data(int drive, uint8_t c, uint8_t h, uint8_t r, uint8_t n);
+extern uint64_t fdd_sector_period(int drive, uint32_t len, uint8_t gap);
+
 extern int      motorspin;
 extern uint64_t motoron[FDD_NUM];
 
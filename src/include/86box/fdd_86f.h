@@ -55,6 +55,7 @@ extern void     d86f_load(int drive, char *fn);
 extern void     d86f_close(int drive);
 extern void     d86f_seek(int drive, int track);
 extern int      d86f_hole(int drive);
+extern int      d86f_can_read_address(int drive);
 extern uint64_t d86f_byteperiod(int drive);
 extern void     d86f_stop(int drive);
 extern void     d86f_poll(int drive);
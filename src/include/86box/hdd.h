@@ -84,6 +84,12 @@ enum {
     HDD_OP_WRITE = 3
 };
 
+enum {
+    HDD_OVERLAY_NONE    = 0,
+    HDD_OVERLAY_COMMIT  = 1,
+    HDD_OVERLAY_DISCARD = 2
+};
+
 #define HDD_MAX_ZONES     16
 #define HDD_MAX_CACHE_SEG 16
 
@@ -151,13 +157,14 @@ typedef struct hard_disk_t {
     uint8_t bus_mode;  /* Bit 0 = PIO suported;
                           Bit 1 = DMA supportd. */
     uint8_t wp; /* Disk has been mounted READ-ONLY */
-    uint8_t pad;
+    uint8_t use_mmap; /* Map raw, HDI and HDX images into memory */
     uint8_t pad0;
 
     void *priv;
 
     char fn[1024];         /* Name of current image file */
     char vhd_parent[1041]; /* Differential VHD parent file */
+    char overlay[1024];    /* Copy-on-write overlay file */
 
     uint32_t seek_pos;
     uint32_t seek_len;
@@ -200,6 +207,8 @@ extern int      hdd_image_load(int id);
 extern void     hdd_image_seek(uint8_t id, uint32_t sector);
 extern void     hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern int      hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern void     hdd_image_read_submit(uint8_t id, uint32_t sector, uint32_t count);
+extern void     hdd_image_read_complete(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern void     hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern int      hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern void     hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count);
@@ -210,6 +219,25 @@ extern uint8_t  hdd_image_get_type(uint8_t id);
 extern void     hdd_image_unload(uint8_t id, int fn_preserve);
 extern void     hdd_image_close(uint8_t id);
 extern void     hdd_image_calc_chs(uint32_t *c, uint32_t *h, uint32_t *s, uint32_t size);
+extern int      hdd_image_overlay_commit(uint8_t id);
+extern int      hdd_image_overlay_discard(uint8_t id);
+extern void     hdd_image_overlay_request(uint8_t id, int op);
+extern void     hdd_image_overlay_process(void);
+
+typedef struct hdd_overlay_t hdd_overlay_t;
+
+extern int            hdd_overlay_create(const char *fn, uint32_t sectors);
+extern hdd_overlay_t *hdd_overlay_open(const char *fn, uint32_t sectors,
+                                       void (*read_base)(void *priv, uint32_t sector, uint32_t count, uint8_t *buffer),
+                                       void *priv);
+extern void           hdd_overlay_close(hdd_overlay_t *ovl);
+extern int            hdd_overlay_read(hdd_overlay_t *ovl, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern int            hdd_overlay_write(hdd_overlay_t *ovl, uint32_t sector, uint32_t count, const uint8_t *buffer);
+extern int            hdd_overlay_zero(hdd_overlay_t *ovl, uint32_t sector, uint32_t count);
+extern int            hdd_overlay_discard(hdd_overlay_t *ovl);
+extern int            hdd_overlay_commit(hdd_overlay_t *ovl,
+                                         int (*write_base)(void *priv, uint32_t sector, uint32_t count, uint8_t *buffer),
+                                         void *priv);
 
 extern int image_is_hdi(const char *s);
 extern int image_is_hdx(const char *s, int check_signature);
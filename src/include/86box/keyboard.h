@@ -287,6 +287,11 @@ extern void         kbc_at_dev_queue_add(atkbc_dev_t *dev, uint8_t val, uint8_t
 extern void         kbc_at_dev_reset(atkbc_dev_t *dev, int do_fa);
 extern atkbc_dev_t *kbc_at_dev_init(uint8_t inst);
 
+struct snapshot_t;
+
+extern void         kbc_at_dev_save(void *priv, struct snapshot_t *s);
+extern void         kbc_at_dev_load(void *priv, struct snapshot_t *s);
+
 #ifdef __cplusplus
 }
 #endif
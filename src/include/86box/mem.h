@@ -263,14 +263,10 @@ extern uint8_t *rom;
 extern uint32_t biosmask;
 extern uint32_t biosaddr;
 
-extern int        readlookup[256];
 extern uintptr_t *readlookup2;
 extern uintptr_t  old_rl2;
 extern uint8_t    uncached;
-extern int        readlnext;
-extern int        writelookup[256];
 extern uintptr_t *writelookup2;
-extern int        writelnext;
 extern uint32_t   ram_mapped_addr[64];
 extern uint8_t    page_ff[4096];
 
@@ -299,7 +295,19 @@ extern int writelnum;
 
 extern int memspeed[11];
 
-extern int     mmu_perm;
+/* Set by the page table walks, for the soft TLB. */
+#define MMU_FLAG_GLOBAL 1 /* Global page, with CR4.PGE set. */
+#define MMU_FLAG_LARGE  2 /* Part of a 2 or 4 MB page. */
+
+extern int      mmu_perm;
+extern int      mmu_flags;
+extern uint32_t mmu_flags_page; /* Virtual page that mmu_flags is for. */
+
+/* Soft TLB statistics. */
+extern uint32_t tlb_fills;
+extern uint32_t tlb_evictions;
+extern uint32_t tlb_flushes;
+extern uint32_t tlb_kept;
 extern uint8_t high_page; /* if a high (> 4 gb) page was detected */
 
 extern uint8_t *_mem_exec[MEM_MAPPINGS_NO];
@@ -412,6 +420,8 @@ extern void     mem_writeb_phys(uint32_t addr, uint8_t val);
 extern void     mem_writew_phys(uint32_t addr, uint16_t val);
 extern void     mem_writel_phys(uint32_t addr, uint32_t val);
 extern void     mem_write_phys(void *src, uint32_t addr, int tranfer_size);
+extern void     mem_read_phys_block(void *dest, uint32_t addr, uint32_t len, int transfer_size);
+extern void     mem_write_phys_block(const void *src, uint32_t addr, uint32_t len, int transfer_size);
 
 extern uint8_t  mem_read_ram(uint32_t addr, void *priv);
 extern uint16_t mem_read_ramw(uint32_t addr, void *priv);
@@ -440,8 +450,17 @@ extern void mem_flush_write_page(uint32_t addr, uint32_t virt);
 
 extern void mem_reset_page_blocks(void);
 
+struct snapshot_t;
+
+extern void mem_save(struct snapshot_t *s);
+extern void mem_load(struct snapshot_t *s);
+extern void mem_load_ram(struct snapshot_t *s, uint32_t index);
+
 extern void flushmmucache(void);
 extern void flushmmucache_nopc(void);
+extern void flushmmucache_nonglobal(void);
+extern void flushmmucache_supervisor(void);
+extern void flushmmucache_page(uint32_t addr);
 
 extern void mem_debug_check_addr(uint32_t addr, int write);
 
@@ -46,17 +46,25 @@
 #ifndef EMU_NETWORK_H
 #define EMU_NETWORK_H
 #include <stdint.h>
+#ifdef __cplusplus
+#    include <atomic>
+using atomic_uint = std::atomic_uint;
+#else
+#    include <stdatomic.h>
+#endif
 
 /* Network provider types. */
 #define NET_TYPE_NONE  0 /* use the null network driver */
 #define NET_TYPE_SLIRP 1 /* use the SLiRP port forwarder */
 #define NET_TYPE_PCAP  2 /* use the (Win)Pcap API */
 #define NET_TYPE_VDE   3 /* use the VDE plug API */
+#define NET_TYPE_SWITCH 4 /* use the local shared memory switch */
 
 #define NET_MAX_FRAME  1518
-/* Queue size must be a power of 2 */
-#define NET_QUEUE_LEN      16
-#define NET_QUEUE_LEN_MASK (NET_QUEUE_LEN - 1)
+/* Queue sizes must be a power of 2 */
+#define NET_QUEUE_LEN      16 /* minimum, and the batch size of the host drivers */
+#define NET_QUEUE_LEN_DEF  64
+#define NET_QUEUE_LEN_MAX  1024
 #define NET_QUEUE_COUNT 3
 #define NET_CARD_MAX       4
 #define NET_HOST_INTF_MAX  64
@@ -94,6 +102,7 @@ typedef struct netcard_conf_t {
     int      net_type;
     char     host_dev_name[128];
     uint32_t link_state;
+    int      queue_len;
 } netcard_conf_t;
 
 extern netcard_conf_t net_cards_conf[NET_CARD_MAX];
@@ -107,12 +116,28 @@ typedef struct netpkt {
     int      len;
 } netpkt_t;
 
+/* Single producer, single consumer ring. Only the producer writes head and
+   only the consumer writes tail, so neither side needs a lock. */
 typedef struct netqueue_t {
-    netpkt_t packets[NET_QUEUE_LEN];
-    int      head;
-    int      tail;
+    netpkt_t   *packets;
+    uint32_t    size;
+    uint32_t    mask;
+    atomic_uint head;
+    atomic_uint tail;
+    uint32_t    dropped; /* written by the producer only */
+    uint32_t    peak;    /* written by the producer only */
 } netqueue_t;
 
+typedef struct netcard_stats_t {
+    uint32_t queue_len;
+    uint32_t rx_queued;
+    uint32_t rx_peak;
+    uint32_t rx_dropped;
+    uint32_t tx_queued;
+    uint32_t tx_peak;
+    uint32_t tx_dropped;
+} netcard_stats_t;
+
 typedef struct _netcard_t netcard_t;
 
 typedef struct netdrv_t {
@@ -126,6 +151,7 @@ extern const netdrv_t net_pcap_drv;
 extern const netdrv_t net_slirp_drv;
 extern const netdrv_t net_vde_drv;
 extern const netdrv_t net_null_drv;
+extern const netdrv_t net_switch_drv;
 
 struct _netcard_t {
     const device_t *device;
@@ -134,15 +160,15 @@ struct _netcard_t {
     NETRXCB         rx;
     NETSETLINKSTATE set_link_state;
     netqueue_t      queues[NET_QUEUE_COUNT];
-    netpkt_t        queued_pkt;
-    mutex_t        *tx_mutex;
-    mutex_t        *rx_mutex;
+    mutex_t        *rx_mutex; /* serializes RX producers, see network_rx_put() */
     pc_timer_t      timer;
     uint16_t        card_num;
     double          byte_period;
     uint32_t        led_timer;
     uint32_t        led_state;
     uint32_t        link_state;
+    uint32_t        stats_timer;   /* us since the drop counters were last checked */
+    uint32_t        stats_dropped; /* drops already reported */
 };
 
 typedef struct {
@@ -154,10 +180,11 @@ typedef struct {
     int has_slirp;
     int has_pcap;
     int has_vde;
+    int has_switch;
 } network_devmap_t;
 
 
-#define HAS_NOSLIRP_NET(x)  (x.has_pcap || x.has_vde)
+#define HAS_NOSLIRP_NET(x)  (x.has_pcap || x.has_vde || x.has_switch)
 
 #ifdef __cplusplus
 extern "C" {
@@ -200,6 +227,7 @@ extern int network_tx_pop(netcard_t *card, netpkt_t *out_pkt);
 extern int network_tx_popv(netcard_t *card, netpkt_t *pkt_vec, int vec_size);
 extern int network_rx_put(netcard_t *card, uint8_t *bufp, int len);
 extern int network_rx_put_pkt(netcard_t *card, netpkt_t *pkt);
+extern int network_get_stats(int id, netcard_stats_t *stats);
 
 #ifdef EMU_DEVICE_H
 /* 3Com Etherlink */
@@ -281,6 +281,11 @@ extern void        pci_register_cards(void);
 
 extern void        pci_init(int flags);
 
+struct snapshot_t;
+
+extern void        pci_save(struct snapshot_t *s);
+extern void        pci_load(struct snapshot_t *s);
+
 /* PCI bridge stuff. */
 extern void        pci_bridge_set_ctl(void *priv, uint8_t ctl);
 
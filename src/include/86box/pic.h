@@ -56,6 +56,8 @@ typedef struct pic {
     struct pic *slaves[8];
 } pic_t;
 
+struct snapshot_t;
+
 extern pic_t pic;
 extern pic_t pic2;
 
@@ -80,6 +82,8 @@ extern void pic_init(void);
 extern void pic_init_pcjr(void);
 extern void pic2_init(void);
 extern void pic_reset(void);
+extern void pic_save(struct snapshot_t *s);
+extern void pic_load(struct snapshot_t *s);
 
 extern uint8_t pic_read_icw(uint8_t pic_id, uint8_t icw);
 extern uint8_t pic_read_ocw(uint8_t pic_id, uint8_t ocw);
@@ -146,6 +146,10 @@ extern int      plat_dir_check(char *path);
 extern int      plat_dir_create(char *path);
 extern void    *plat_mmap(size_t size, uint8_t executable);
 extern void     plat_munmap(void *ptr, size_t size);
+extern void    *plat_mmap_file(FILE *fp, uint64_t size, int writable);
+extern void     plat_munmap_file(void *ptr, uint64_t size);
+extern void     plat_msync_file(void *ptr, uint64_t size, int wait);
+extern int      plat_file_punch_hole(FILE *fp, uint64_t offset, uint64_t size);
 extern uint64_t plat_timer_read(void);
 extern uint32_t plat_get_ticks(void);
 extern void     plat_delay_ms(uint32_t count);
@@ -63,4 +63,10 @@ extern void smram_state_change(smram_t *smr, int smm, int flags);
 /* Enables or disables the use of a separate SMRAM for addresses below A0000. */
 extern void smram_set_separate_smram(uint8_t set);
 
+struct snapshot_t;
+
+/* Save or load the state of all the SMRAM mappings, for a snapshot. */
+extern void smram_save(struct snapshot_t *s);
+extern void smram_load(struct snapshot_t *s);
+
 #endif /*EMU_SMRAM_H*/
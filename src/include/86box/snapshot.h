@@ -0,0 +1,64 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the machine snapshot save/restore code.
+ *
+ *
+ *
+ * Authors: Miran Grca, <mgrca8@gmail.com>
+ *
+ *          Copyright 2024 Miran Grca.
+ */
+#ifndef EMU_SNAPSHOT_H
+#define EMU_SNAPSHOT_H
+
+#define SNAPSHOT_SECTION_CORE   0
+#define SNAPSHOT_SECTION_DEVICE 1
+
+typedef struct snapshot_t snapshot_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Save or load straight away; only safe between two blocks of CPU code,
+   in the emulation thread. Both return 0 on success. */
+extern int  snapshot_save(const char *fn);
+extern int  snapshot_load(const char *fn);
+
+/* Ask the emulation thread to save or load when it next can. */
+extern void snapshot_request_save(const char *fn);
+extern void snapshot_request_load(const char *fn);
+extern void snapshot_process(void);
+
+/* Sections. A size of 0 means the data is buffered, and the length is
+   written at the end of the section; otherwise, the data is streamed out
+   and must come to exactly size bytes. */
+extern void snapshot_section_begin(snapshot_t *s, int type, const char *name,
+                                   uint32_t index, uint32_t size);
+extern void snapshot_section_end(snapshot_t *s);
+
+extern void snapshot_write(snapshot_t *s, const void *data, uint32_t len);
+/* Reads past the end of the section or the file zero the data and mark
+   the whole load as failed, so callers need not check every read. */
+extern void snapshot_read(snapshot_t *s, void *data, uint32_t len);
+extern int  snapshot_error(snapshot_t *s);
+extern void snapshot_set_error(snapshot_t *s);
+
+/* Timers are saved relative to the TSC, and are re-armed on load. */
+extern void snapshot_write_timer(snapshot_t *s, const pc_timer_t *timer);
+extern void snapshot_read_timer(snapshot_t *s, pc_timer_t *timer);
+
+#define snapshot_write_var(s, v) snapshot_write((s), &(v), sizeof(v))
+#define snapshot_read_var(s, v)  snapshot_read((s), &(v), sizeof(v))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SNAPSHOT_H*/
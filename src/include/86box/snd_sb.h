@@ -24,6 +24,7 @@
 #include <86box/snd_mpu401.h>
 #include <86box/snd_opl.h>
 #include <86box/snd_sb_dsp.h>
+#include <86box/snd_tone.h>
 
 enum {
     SADLIB  = 1,     /* No DSP */
@@ -191,6 +192,13 @@ typedef struct sb_t {
 
     void   *opl_mixer;
     void  (*opl_mix)(void*, double*, double*);
+
+    /* CT1745 bass and treble controls, one per output path. */
+    tone_t tone_dsp;
+    tone_t tone_music;
+    tone_t tone_wavetable;
+    tone_t tone_cd;
+    tone_t tone_speaker;
 } sb_t;
 
 extern void    sb_ct1345_mixer_write(uint16_t addr, uint8_t val, void *priv);
@@ -2,6 +2,7 @@
 #define SOUND_SND_SB_DSP_H
 
 #include <86box/fifo.h>
+#include <86box/snd_tone.h>
 
 /*Sound Blaster Clones, for quirks*/
 #define SB_SUBTYPE_DEFAULT             0 /* Handle as a Creative card */
@@ -174,6 +175,11 @@ typedef struct sb_dsp_t {
     uint8_t   espcm_table_index;       /* used for ESPCM_3 */
     uint8_t   espcm_last_value;        /* used for ESPCM_3 */
 
+    /* SB16 and ESS output filters, for the DSP, which follows the sample
+       rate, and for the PC speaker. */
+    fir_t fir;
+    fir_t fir_speaker;
+
     mpu_t *mpu;
 } sb_dsp_t;
 
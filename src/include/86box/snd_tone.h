@@ -0,0 +1,92 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the block based stereo filters, output
+ *          filters and bass/treble controls shared by the sound card
+ *          mixers.
+ *
+ *
+ *
+ * Authors: Sarah Walker, <https://pcem-emulator.co.uk/>
+ *          Miran Grca, <mgrca8@gmail.com>
+ *
+ *          Copyright 2008-2024 Sarah Walker.
+ *          Copyright 2016-2024 Miran Grca.
+ */
+#ifndef SOUND_SND_TONE_H
+#define SOUND_SND_TONE_H
+
+/* A second order IIR section for interleaved stereo samples, in transposed
+   direct form II. Each channel has its own coefficients and state, so that
+   both channels can be run side by side. A zeroed biquad_t passes samples
+   through unchanged. */
+typedef struct biquad_t {
+    float b0[2];
+    float b1[2];
+    float b2[2];
+    float a1[2];
+    float a2[2];
+    float z1[2];
+    float z2[2];
+
+    uint8_t active; /* Bit set for each channel that is being filtered. */
+} biquad_t;
+
+enum {
+    TONE_FLAT = 0,
+    TONE_BOOST,
+    TONE_CUT
+};
+
+/* Bass and treble controls: a 350 Hz shelf followed by a 3.5 kHz one. The
+   boost or cut of each shelf is folded into the coefficients of a single
+   biquad, rather than being mixed in from a separate filter per sample. A
+   zeroed tone_t is flat. */
+typedef struct tone_t {
+    biquad_t bass;
+    biquad_t treble;
+
+    int8_t bass_mode[2];
+    int8_t treble_mode[2];
+    double bass_gain[2];
+    double treble_gain[2];
+} tone_t;
+
+/* Number of taps of the output filters, and that rounded up to a multiple
+   of 8 with zero taps, so that they can be run in whole vectors. */
+#define FIR_TAPS 51
+#define FIR_LEN  56
+
+/* A low pass FIR for interleaved stereo samples. Each tap is stored once
+   for each channel, so that both channels can be run side by side. The
+   input is kept twice over, so that the samples under the taps are always
+   in one piece. */
+typedef struct fir_t {
+    float coef[FIR_LEN][2];
+    float hist[FIR_LEN * 2][2];
+    int   pos; /* Newest sample in hist. */
+} fir_t;
+
+extern void  biquad_set(biquad_t *bq, int channel, const double *b, const double *a);
+extern void  biquad_process(biquad_t *bq, float *buffer, int len);
+extern float biquad_process_sample(biquad_t *bq, int channel, float in);
+
+extern void  tone_set(tone_t *tone, int channel, int bass_mode, double bass_gain,
+                      int treble_mode, double treble_gain);
+extern void  tone_set_4bits(tone_t *tone, int channel, int bass, int treble, int flat,
+                            const double *gains);
+extern void  tone_process(tone_t *tone, float *buffer, int len);
+extern float tone_process_sample(tone_t *tone, int channel, float in);
+
+extern void  fir_set_lowpass(fir_t *fir, double cutoff);
+extern void  fir_process(fir_t *fir, float *buffer, int len);
+extern float fir_process_sample(fir_t *fir, int channel, float in);
+
+extern void tone_benchmark(void);
+
+#endif /*SOUND_SND_TONE_H*/
@@ -101,6 +101,15 @@ extern void sound_card_reset(void);
 extern void sound_cd_thread_end(void);
 extern void sound_cd_thread_reset(void);
 
+/* Work that is run on the sound render thread instead of the emulation thread. */
+typedef struct sound_render_job_t sound_render_job_t;
+
+extern sound_render_job_t *sound_render_job_add(void (*render)(void *priv), void *priv);
+extern void                sound_render_job_submit(sound_render_job_t *job);
+extern void                sound_render_job_wait(sound_render_job_t *job);
+extern void                sound_render_job_close(sound_render_job_t *job);
+extern void                sound_render_thread_end(void);
+
 extern void closeal(void);
 extern void inital(void);
 extern void givealbuffer(const void *buf);
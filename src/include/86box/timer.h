@@ -52,6 +52,7 @@ typedef struct pc_timer_t {
 
     struct pc_timer_t *prev;
     struct pc_timer_t *next;
+    int                heap_pos; /* Position in the timer heap plus one, 0 if not in it. */
 } pc_timer_t;
 
 #ifdef __cplusplus
@@ -70,6 +71,9 @@ extern void timer_disable(pc_timer_t *timer);
 /*Process any pending timers*/
 extern void timer_process(void);
 
+/*Move all enabled timers by delay, in 32:32 format*/
+extern void timer_shift(uint64_t delay);
+
 /*Reset timer system*/
 extern void timer_close(void);
 extern void timer_init(void);
@@ -78,6 +82,9 @@ extern void timer_init(void);
   timestamp - this is useful for permanently enabled timers*/
 extern void timer_add(pc_timer_t *timer, void (*callback)(void *priv), void *priv, int start_timer);
 
+/*Time the timer code at typical timer counts, printing the results*/
+extern void timer_benchmark(void);
+
 /*1us in 32:32 format*/
 extern uint64_t TIMER_USEC;
 
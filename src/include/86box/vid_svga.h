@@ -112,6 +112,12 @@ typedef struct svga_t {
     int lastline;
     int firstline_draw;
     int lastline_draw;
+    int dirty_valid;
+    int dirty_first;
+    int dirty_last;
+    int dirty_y_add;
+    int dirty_scrollcache;
+    uint32_t dirty_border;
     int displine;
     int fullchange;
     int x_add;
@@ -328,6 +334,12 @@ extern int  svga_init(const device_t *info, svga_t *svga, void *priv, int memsiz
                       void (*hwcursor_draw)(struct svga_t *svga, int displine),
                       void (*overlay_draw)(struct svga_t *svga, int displine));
 extern void svga_recalctimings(svga_t *svga);
+
+struct snapshot_t;
+
+extern void svga_save(svga_t *svga, struct snapshot_t *s);
+extern void svga_load(svga_t *svga, struct snapshot_t *s);
+extern uint32_t svga_conv_16to32(struct svga_t *svga, uint16_t color, uint8_t bpp);
 extern void svga_close(svga_t *svga);
 
 uint8_t  svga_read(uint32_t addr, void *priv);
@@ -28,9 +28,11 @@
 
 #define LOD_MAX         8
 
-#define TEX_DIRTY_SHIFT 10
+#define TEX_DIRTY_SHIFT 8
+#define TEX_DIRTY_PAGES (16 << (20 - TEX_DIRTY_SHIFT))
 
-#define TEX_CACHE_MAX   64
+#define TEX_CACHE_MIN   64
+#define TEX_CACHE_MAX   1024
 
 #ifdef __cplusplus
 #    include <atomic>
@@ -100,9 +102,20 @@ enum {
 #define PARAM_MASK       (PARAM_SIZE - 1)
 #define PARAM_ENTRY_SIZE (1 << 31)
 
-#define PARAM_ENTRIES(x) (voodoo->params_write_idx - voodoo->params_read_idx[x])
-#define PARAM_FULL(x)    ((voodoo->params_write_idx - voodoo->params_read_idx[x]) >= PARAM_SIZE)
-#define PARAM_EMPTY(x)   (voodoo->params_read_idx[x] == voodoo->params_write_idx)
+#define PARAM_ENTRIES    (voodoo->params_pending)
+#define PARAM_FULL       (voodoo->params_bins_left[voodoo->params_write_idx & PARAM_MASK] != 0)
+#define PARAM_EMPTY      (!voodoo->params_pending)
+
+#define VOODOO_RENDER_THREADS_MAX 16
+
+/*Queued triangles are sorted into bins, each covering bands of 16 lines of
+  the screen. A render thread claims a bin and draws all of the triangles in
+  it in order, so no two threads ever draw the same pixel*/
+#define VOODOO_BINS      64
+#define VOODOO_BIN_SHIFT 4
+
+#define BIN_EMPTY(x)     (voodoo->bins[x].read_idx == voodoo->bins[x].write_idx)
+#define VOODOO_BIN(voodoo, y) (((y) >> VOODOO_BIN_SHIFT) & ((voodoo)->render_bins - 1))
 
 typedef struct
 {
@@ -234,12 +247,16 @@ typedef struct texture_t {
     uint32_t   base;
     uint32_t   tLOD;
     atomic_int refcount;
-    atomic_int refcount_r[4];
+    atomic_int refcount_r;
     int        is16;
     uint32_t   palette_checksum;
     uint32_t   addr_start[4];
     uint32_t   addr_end[4];
     uint32_t  *data;
+    int        data_size; /*In texels*/
+    int        data_lod;  /*First LOD held in data*/
+    int        hash_next;
+    uint32_t   lru;
 } texture_t;
 
 typedef struct vert_t {
@@ -266,6 +283,18 @@ typedef struct clip_t {
     int y_max;
 } clip_t;
 
+typedef struct voodoo_bin_t {
+    atomic_int read_idx;
+    atomic_int write_idx;
+    atomic_int claimed;
+    uint16_t   params[PARAM_SIZE]; /*Indices into params_buffer*/
+} voodoo_bin_t;
+
+typedef struct voodoo_render_thread_t {
+    struct voodoo_t *voodoo;
+    int              index;
+} voodoo_render_thread_t;
+
 typedef struct voodoo_t {
     mem_mapping_t mapping;
 
@@ -362,25 +391,27 @@ typedef struct voodoo_t {
     int    ncc_dirty[2];
 
     thread_t *fifo_thread;
-    thread_t *render_thread[4];
+    thread_t *render_thread[VOODOO_RENDER_THREADS_MAX];
     event_t  *wake_fifo_thread;
     event_t  *wake_main_thread;
     event_t  *fifo_not_full_event;
-    event_t  *render_not_full_event[4];
-    event_t  *wake_render_thread[4];
+    event_t  *render_not_full_event;
+    event_t  *wake_render_thread[VOODOO_RENDER_THREADS_MAX];
 
-    int voodoo_busy;
-    int render_voodoo_busy[4];
+    int        voodoo_busy;
+    atomic_int render_voodoo_busy[VOODOO_RENDER_THREADS_MAX];
 
     int render_threads;
-    int odd_even_mask;
+    int render_bins;
+
+    voodoo_render_thread_t render_thread_data[VOODOO_RENDER_THREADS_MAX];
 
-    int pixel_count[4];
-    int texel_count[4];
+    int pixel_count[VOODOO_RENDER_THREADS_MAX];
+    int texel_count[VOODOO_RENDER_THREADS_MAX];
     int tri_count;
     int frame_count;
-    int pixel_count_old[4];
-    int texel_count_old[4];
+    int pixel_count_old[VOODOO_RENDER_THREADS_MAX];
+    int texel_count_old[VOODOO_RENDER_THREADS_MAX];
     int wr_count;
     int rd_count;
     int tex_count;
@@ -410,9 +441,12 @@ typedef struct voodoo_t {
     atomic_int   cmd_written_fifo;
 
     voodoo_params_t params_buffer[PARAM_SIZE];
-    atomic_int      params_read_idx[4];
+    atomic_int      params_bins_left[PARAM_SIZE]; /*Bins still to draw each queued triangle*/
+    atomic_int      params_pending;               /*Triangles queued but not yet fully drawn*/
     atomic_int      params_write_idx;
 
+    voodoo_bin_t bins[VOODOO_BINS];
+
     uint32_t   cmdfifo_base;
     uint32_t   cmdfifo_end;
     uint32_t   cmdfifo_size;
@@ -642,15 +676,20 @@ typedef struct voodoo_t {
     uint8_t  thefilterb[256][256];
     uint16_t purpleline[256][3];
 
-    texture_t texture_cache[2][TEX_CACHE_MAX];
-    uint8_t   texture_present[2][16384];
-    int       texture_last_removed;
+    texture_t *texture_cache[2];
+    int       *texture_hash[2];
+    int        texture_cache_size;
+    uint16_t   texture_present[2][TEX_DIRTY_PAGES]; /*Cached textures in each page*/
+    uint32_t   texture_lru;
+    uint32_t   texture_hits;
+    uint32_t   texture_misses;
+    uint32_t   texture_evictions;
 
     uint32_t palette_checksum[2];
     int      palette_dirty[2];
 
     uint64_t time;
-    int      render_time[4];
+    int      render_time[VOODOO_RENDER_THREADS_MAX];
 
     int      force_blit_count;
     int      can_blit;
@@ -662,7 +701,7 @@ typedef struct voodoo_t {
     struct voodoo_set_t *set;
 
     uint8_t fifo_thread_run;
-    uint8_t render_thread_run[4];
+    uint8_t render_thread_run[VOODOO_RENDER_THREADS_MAX];
 
     uint8_t *vram;
     uint8_t *changedvram;
@@ -268,10 +268,8 @@ void voodoo_codegen_close(voodoo_t *voodoo);
         src_b = CLAMP(src_b);                                \
     } while (0)
 
-void voodoo_render_thread_1(void *param);
-void voodoo_render_thread_2(void *param);
-void voodoo_render_thread_3(void *param);
-void voodoo_render_thread_4(void *param);
+void voodoo_render_threads_init(voodoo_t *voodoo);
+void voodoo_render_threads_close(voodoo_t *voodoo);
 void voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params);
 
 extern int voodoo_recomp;
@@ -280,28 +278,21 @@ extern int tris;
 static __inline void
 voodoo_wake_render_thread(voodoo_t *voodoo)
 {
-    thread_set_event(voodoo->wake_render_thread[0]); /*Wake up render thread if moving from idle*/
-    if (voodoo->render_threads >= 2)
-        thread_set_event(voodoo->wake_render_thread[1]); /*Wake up render thread if moving from idle*/
-    if (voodoo->render_threads == 4) {
-        thread_set_event(voodoo->wake_render_thread[2]); /*Wake up render thread if moving from idle*/
-        thread_set_event(voodoo->wake_render_thread[3]); /*Wake up render thread if moving from idle*/
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        if (!voodoo->render_voodoo_busy[c])
+            thread_set_event(voodoo->wake_render_thread[c]); /*Wake up render thread if moving from idle*/
     }
 }
 
 static __inline void
 voodoo_wait_for_render_thread_idle(voodoo_t *voodoo)
 {
-    while (!PARAM_EMPTY(0) || (voodoo->render_threads >= 2 && !PARAM_EMPTY(1)) || (voodoo->render_threads == 4 && (!PARAM_EMPTY(2) || !PARAM_EMPTY(3))) || voodoo->render_voodoo_busy[0] || (voodoo->render_threads >= 2 && voodoo->render_voodoo_busy[1]) || (voodoo->render_threads == 4 && (voodoo->render_voodoo_busy[2] || voodoo->render_voodoo_busy[3]))) {
+    while (!PARAM_EMPTY) {
+        thread_reset_event(voodoo->render_not_full_event);
+        if (PARAM_EMPTY)
+            break;
         voodoo_wake_render_thread(voodoo);
-        if (!PARAM_EMPTY(0) || voodoo->render_voodoo_busy[0])
-            thread_wait_event(voodoo->render_not_full_event[0], 1);
-        if (voodoo->render_threads >= 2 && (!PARAM_EMPTY(1) || voodoo->render_voodoo_busy[1]))
-            thread_wait_event(voodoo->render_not_full_event[1], 1);
-        if (voodoo->render_threads == 4 && (!PARAM_EMPTY(2) || voodoo->render_voodoo_busy[2]))
-            thread_wait_event(voodoo->render_not_full_event[2], 1);
-        if (voodoo->render_threads == 4 && (!PARAM_EMPTY(3) || voodoo->render_voodoo_busy[3]))
-            thread_wait_event(voodoo->render_not_full_event[3], 1);
+        thread_wait_event(voodoo->render_not_full_event, 1);
     }
 }
 
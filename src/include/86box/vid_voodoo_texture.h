@@ -33,6 +33,18 @@ static const uint32_t texture_offset[LOD_MAX + 3] = {
     256 * 256 + 128 * 128 + 64 * 64 + 32 * 32 + 16 * 16 + 8 * 8 + 4 * 4 + 2 * 2 + 1 * 1 + 1
 };
 
+/*Decoded textures only hold the LODs they use, starting at data_lod*/
+static __inline uint32_t *
+voodoo_texture_data(const texture_t *texture, int lod)
+{
+    if (lod < texture->data_lod)
+        lod = texture->data_lod;
+
+    return &texture->data[texture_offset[lod] - texture_offset[texture->data_lod]];
+}
+
+void voodoo_texture_cache_init(voodoo_t *voodoo);
+void voodoo_texture_cache_close(voodoo_t *voodoo);
 void voodoo_recalc_tex12(voodoo_t *voodoo, int tmu);
 void voodoo_recalc_tex3(voodoo_t *voodoo, int tmu);
 void voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu);
@@ -253,6 +253,9 @@ extern void video_blit_memtoscreen_8(int x, int y, int w, int h);
 extern void video_blend_monitor(int x, int y, int monitor_index);
 extern void video_process_8_monitor(int x, int y, int monitor_index);
 extern void video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index);
+extern void video_blit_memtoscreen_dirty_monitor(int x, int y, int w, int h, int dirty_y, int dirty_h, int monitor_index);
+extern void video_blit_dirty_rows_monitor(int *y, int *h, int monitor_index);
+extern void video_blit_set_held_monitor(int held, int monitor_index);
 extern void video_blit_complete_monitor(int monitor_index);
 extern void video_wait_for_blit_monitor(int monitor_index);
 extern void video_wait_for_buffer_monitor(int monitor_index);
@@ -42,6 +42,9 @@ typedef struct _io_ {
     void (*outw)(uint16_t addr, uint16_t val, void *priv);
     void (*outl)(uint16_t addr, uint32_t val, void *priv);
 
+    int (*inblock)(uint16_t addr, void *buf, int size, int count, void *priv);
+    int (*outblock)(uint16_t addr, const void *buf, int size, int count, void *priv);
+
     void *priv;
 
     struct _io_ *prev, *next;
@@ -55,10 +58,31 @@ typedef struct {
     void     *priv;
 } io_trap_t;
 
+/* Dispatch flags, kept per port by io_update_dispatch(). Almost every port
+   has exactly one handler, which can then be called without walking the
+   chain. Word and dword accesses can go straight to that handler's inw/inl
+   or outw/outl if no handler on the following ports would also be called to
+   make up the access from narrower ones. */
+#define IO_SINGLE    0x01 /* Port has exactly one handler. */
+#define IO_FAST_INW  0x02
+#define IO_FAST_INL  0x04
+#define IO_FAST_OUTW 0x08
+#define IO_FAST_OUTL 0x10
+
+/* Handler types found on a port, used to work out the dispatch flags. */
+#define IO_HAS_INB_NOT_W   0x01 /* inb, no inw. */
+#define IO_HAS_INB_NOT_WL  0x02 /* inb, no inw and no inl. */
+#define IO_HAS_INW_NOT_L   0x04 /* inw, no inl. */
+#define IO_HAS_OUTB_NOT_W  0x08 /* Same for writes. */
+#define IO_HAS_OUTB_NOT_WL 0x10
+#define IO_HAS_OUTW_NOT_L  0x20
+
 int   initialized = 0;
 io_t *io[NPORTS];
 io_t *io_last[NPORTS];
 
+static uint8_t io_dispatch[NPORTS];
+
 #ifdef ENABLE_IO_LOG
 int io_do_log = ENABLE_IO_LOG;
 
@@ -77,6 +101,58 @@ io_log(const char *fmt, ...)
 #    define io_log(fmt, ...)
 #endif
 
+static uint8_t
+io_port_types(uint16_t port)
+{
+    uint8_t types = 0;
+
+    for (io_t *p = io[port]; p; p = p->next) {
+        if (p->inb && !p->inw)
+            types |= (p->inl ? 0 : IO_HAS_INB_NOT_WL) | IO_HAS_INB_NOT_W;
+        if (p->inw && !p->inl)
+            types |= IO_HAS_INW_NOT_L;
+        if (p->outb && !p->outw)
+            types |= (p->outl ? 0 : IO_HAS_OUTB_NOT_WL) | IO_HAS_OUTB_NOT_W;
+        if (p->outw && !p->outl)
+            types |= IO_HAS_OUTW_NOT_L;
+    }
+
+    return types;
+}
+
+/* Rebuild the dispatch flags of port and of the three ports below it, whose
+   word and dword accesses also reach port. */
+static void
+io_update_dispatch(uint16_t port)
+{
+    for (int i = 3; i >= 0; i--) {
+        uint16_t base  = port - i;
+        io_t    *p     = io[base];
+        uint8_t  flags = 0;
+        uint8_t  types[4];
+
+        if (p && !p->next) {
+            flags = IO_SINGLE;
+
+            for (uint8_t j = 1; j < 4; j++)
+                types[j] = io_port_types(base + j);
+
+            if (p->inw && !(types[1] & IO_HAS_INB_NOT_W))
+                flags |= IO_FAST_INW;
+            if (p->inl && !(types[2] & IO_HAS_INW_NOT_L) &&
+                !((types[1] | types[2] | types[3]) & IO_HAS_INB_NOT_WL))
+                flags |= IO_FAST_INL;
+            if (p->outw && !(types[1] & IO_HAS_OUTB_NOT_W))
+                flags |= IO_FAST_OUTW;
+            if (p->outl && !(types[2] & IO_HAS_OUTW_NOT_L) &&
+                !((types[1] | types[2] | types[3]) & IO_HAS_OUTB_NOT_WL))
+                flags |= IO_FAST_OUTL;
+        }
+
+        io_dispatch[base] = flags;
+    }
+}
+
 void
 io_init(void)
 {
@@ -105,6 +181,7 @@ io_init(void)
 
         /* io[c] should be NULL. */
         io[c] = io_last[c] = NULL;
+        io_dispatch[c]     = 0;
     }
 }
 
@@ -145,6 +222,8 @@ io_sethandler_common(uint16_t base, int size,
         q->next = NULL;
 
         io_last[base + c] = q;
+
+        io_update_dispatch(base + c);
     }
 }
 
@@ -178,6 +257,7 @@ io_removehandler_common(uint16_t base, int size,
                     io_last[base + c] = p->prev;
                 free(p);
                 p = NULL;
+                io_update_dispatch(base + c);
                 break;
             }
             p = q;
@@ -279,6 +359,89 @@ io_handler_interleaved(int set, uint16_t base, int size,
     io_handler_common(set, base, size, inb, inw, inl, outb, outw, outl, priv, 2);
 }
 
+/* Attach block handlers to the handler on port base that has the given priv,
+   which must have been set up by io_sethandler() beforehand. They go away
+   with it when it is removed. */
+void
+io_sethandler_block(uint16_t base,
+                    int (*inblock)(uint16_t addr, void *buf, int size, int count, void *priv),
+                    int (*outblock)(uint16_t addr, const void *buf, int size, int count, void *priv),
+                    void *priv)
+{
+    for (io_t *p = io[base]; p; p = p->next) {
+        if (p->priv == priv) {
+            p->inblock  = inblock;
+            p->outblock = outblock;
+        }
+    }
+}
+
+/* Can a string of accesses of size bytes to port be handed to its handler's
+   block functions? Only if the handler is the one an access would go to on
+   its own, so that nothing else sees a change. */
+static io_t *
+io_block_handler(uint16_t port, int size, int write)
+{
+    static const uint8_t fast[2][5] = {
+        { 0, IO_SINGLE, IO_FAST_INW, 0, IO_FAST_INL },
+        { 0, IO_SINGLE, IO_FAST_OUTW, 0, IO_FAST_OUTL }
+    };
+
+    if ((size != 1) && (size != 2) && (size != 4))
+        return NULL;
+    if (!(io_dispatch[port] & fast[write][size]))
+        return NULL;
+    if ((pci_flags & FLAG_CONFIG_IO_ON) && (port >= pci_base) && (port < (pci_base + pci_size)))
+        return NULL;
+    if ((pci_flags & FLAG_CONFIG_DEV0_IO_ON) && (port >= 0xc000) && (port < 0xc100))
+        return NULL;
+    if (amstrad_latch & 0x80000000)
+        return NULL;
+#ifdef USE_DEBUG_REGS_486
+    if (dr[7] & 0xFF)
+        return NULL;
+#endif
+
+    return io[port];
+}
+
+/* Read up to count accesses of size bytes from port into buf, for string
+   I/O. Returns how many were done, which may be 0 if the port has no block
+   handler or it cannot do them in one go at the moment; the caller then goes
+   on with inb()/inw()/inl(). */
+int
+io_in_block(uint16_t port, void *buf, int size, int count)
+{
+    const io_t *p = io_block_handler(port, size, 0);
+    int         ret;
+
+    if ((p == NULL) || (p->inblock == NULL))
+        return 0;
+
+    ret = p->inblock(port, buf, size, count, p->priv);
+
+    io_log("[%04X:%08X] (%i) in block(%04X, %i) = %i/%i\n", CS, cpu_state.pc, in_smm, port, size, ret, count);
+
+    return ret;
+}
+
+/* Same for writes. */
+int
+io_out_block(uint16_t port, const void *buf, int size, int count)
+{
+    const io_t *p = io_block_handler(port, size, 1);
+    int         ret;
+
+    if ((p == NULL) || (p->outblock == NULL))
+        return 0;
+
+    ret = p->outblock(port, buf, size, count, p->priv);
+
+    io_log("[%04X:%08X] (%i) out block(%04X, %i) = %i/%i\n", CS, cpu_state.pc, in_smm, port, size, ret, count);
+
+    return ret;
+}
+
 #ifdef USE_DEBUG_REGS_486
 extern int trap;
 /* Set trap for I/O address breakpoints. */
@@ -358,6 +521,15 @@ inb(uint16_t port)
 #ifdef ENABLE_IO_LOG
         qfound = 1;
 #endif
+    } else if (io_dispatch[port] & IO_SINGLE) {
+        p = io[port];
+        if (p->inb) {
+            ret   = p->inb(port, p->priv);
+            found = 1;
+#ifdef ENABLE_IO_LOG
+            qfound = 1;
+#endif
+        }
     } else {
         p = io[port];
         while (p) {
@@ -422,6 +594,15 @@ outb(uint16_t port, uint8_t val)
 #ifdef ENABLE_IO_LOG
         qfound = 1;
 #endif
+    } else if (io_dispatch[port] & IO_SINGLE) {
+        p = io[port];
+        if (p->outb) {
+            p->outb(port, val, p->priv);
+            found = 1;
+#ifdef ENABLE_IO_LOG
+            qfound = 1;
+#endif
+        }
     } else {
         p = io[port];
         while (p) {
@@ -477,6 +658,13 @@ inw(uint16_t port)
         found = 2;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (io_dispatch[port] & IO_FAST_INW) {
+        p     = io[port];
+        ret   = p->inw(port, p->priv);
+        found = 2;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
@@ -553,6 +741,13 @@ outw(uint16_t port, uint16_t val)
         found = 2;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (io_dispatch[port] & IO_FAST_OUTW) {
+        p = io[port];
+        p->outw(port, val, p->priv);
+        found = 2;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
@@ -625,6 +820,13 @@ inl(uint16_t port)
         found = 4;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (io_dispatch[port] & IO_FAST_INL) {
+        p     = io[port];
+        ret   = p->inl(port, p->priv);
+        found = 4;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
@@ -733,6 +935,13 @@ outl(uint16_t port, uint32_t val)
         found = 4;
 #ifdef ENABLE_IO_LOG
         qfound = 1;
+#endif
+    } else if (io_dispatch[port] & IO_FAST_OUTL) {
+        p = io[port];
+        p->outl(port, val, p->priv);
+        found = 4;
+#ifdef ENABLE_IO_LOG
+        qfound = 1;
 #endif
     } else {
         p = io[port];
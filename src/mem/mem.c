@@ -37,6 +37,8 @@
 #include <86box/mem.h>
 #include <86box/plat.h>
 #include <86box/rom.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 #include <86box/gdbstub.h>
 #ifdef USE_DYNAREC
 #    include "codegen_public.h"
@@ -83,13 +85,9 @@ uint32_t biosaddr;
 uint32_t pccache;
 uint8_t *pccache2;
 
-int        readlnext;
-int        readlookup[256];
 uintptr_t *readlookup2;
 uintptr_t  old_rl2;
 uint8_t    uncached = 0;
-int        writelnext;
-int        writelookup[256];
 uintptr_t *writelookup2;
 
 uint32_t mem_logical_addr;
@@ -98,7 +96,7 @@ int shadowbios = 0;
 int shadowbios_write;
 int readlnum  = 0;
 int writelnum = 0;
-int cachesize = 256;
+int cachesize = 0;
 
 uint32_t get_phys_virt;
 uint32_t get_phys_phys;
@@ -107,8 +105,16 @@ int mem_a20_key   = 0;
 int mem_a20_alt   = 0;
 int mem_a20_state = 0;
 
-int mmuflush = 0;
-int mmu_perm = 4;
+int      mmuflush       = 0;
+int      mmu_perm       = 4;
+int      mmu_flags      = 0;
+uint32_t mmu_flags_page = 0xffffffff;
+
+/* Soft TLB statistics. */
+uint32_t tlb_fills     = 0;
+uint32_t tlb_evictions = 0;
+uint32_t tlb_flushes   = 0;
+uint32_t tlb_kept      = 0;
 
 #ifdef USE_NEW_DYNAREC
 uint64_t *byte_dirty_mask;
@@ -125,6 +131,27 @@ mem_mapping_t        *write_mapping[MEM_MAPPINGS_NO];
 
 uint8_t              *_mem_exec[MEM_MAPPINGS_NO];
 
+/* The soft TLB. readlookup2[] and writelookup2[] hold an entry for every
+   virtual page, so a lookup is a single load; the tables below only record
+   which pages have been filled in, so that they can be replaced and flushed.
+   They are set associative: a virtual page can only be held in one of the
+   TLB_WAYS entries of the set picked by its low bits, and the ways of each
+   set are replaced in turn. Entries are tagged with how they may be flushed,
+   so that global pages survive CR3 reloads and pages that were filled in at
+   CPL 3 survive a return to CPL 3. */
+#define TLB_WAYS       4
+#define TLB_INVALID    0xffffffff
+#define TLB_PAGE_MASK  0x000fffff
+#define TLB_GLOBAL     0x80000000 /* Global page, kept across CR3 reloads. */
+#define TLB_SUPERVISOR 0x40000000 /* Filled in at CPL 0-2, flushed on entry to CPL 3. */
+#define TLB_LARGE      0x20000000 /* Part of a 2 or 4 MB page. */
+
+static uint32_t      *readlookup;
+static uint32_t      *writelookup;
+static uint8_t       *readlnext;
+static uint8_t       *writelnext;
+static uint32_t       tlb_set_mask;
+
 /* FIXME: re-do this with a 'mem_ops' struct. */
 static uint8_t       *page_lookupp; /* pagetable mmu_perm lookup */
 static uint8_t       *readlookupp;
@@ -173,17 +200,128 @@ mem_addr_is_ram(uint32_t addr)
            (mapping == &ram_mid_mapping2) || (mapping == &ram_remapped_mapping);
 }
 
+static __inline void
+tlb_invalidate_read(uint32_t page)
+{
+    readlookup2[page] = LOOKUP_INV;
+    readlookupp[page] = 4;
+}
+
+static __inline void
+tlb_invalidate_write(uint32_t page)
+{
+    page_lookup[page]  = NULL;
+    page_lookupp[page] = 4;
+    writelookup2[page] = LOOKUP_INV;
+    writelookupp[page] = 4;
+}
+
+/* Flush the entries for which (entry & mask) == val. */
+static void
+tlb_flush(uint32_t mask, uint32_t val)
+{
+    for (int c = 0; c < cachesize; c++) {
+        if (readlookup[c] != TLB_INVALID) {
+            if ((readlookup[c] & mask) == val) {
+                tlb_invalidate_read(readlookup[c] & TLB_PAGE_MASK);
+                readlookup[c] = TLB_INVALID;
+            } else
+                tlb_kept++;
+        }
+        if (writelookup[c] != TLB_INVALID) {
+            if ((writelookup[c] & mask) == val) {
+                tlb_invalidate_write(writelookup[c] & TLB_PAGE_MASK);
+                writelookup[c] = TLB_INVALID;
+            } else
+                tlb_kept++;
+        }
+    }
+
+    tlb_flushes++;
+    if (!(tlb_flushes & 0xffff))
+        mem_log("Soft TLB: %u fills, %u evictions, %u flushes, %u entries kept\n",
+                tlb_fills, tlb_evictions, tlb_flushes, tlb_kept);
+}
+
+/* Pick the entry to fill in for a page: an empty way of its set if there is
+   one, otherwise the next way in turn. */
+static uint32_t *
+tlb_get_entry(uint32_t *tlb, uint8_t *next, uint32_t page)
+{
+    uint32_t  set   = page & tlb_set_mask;
+    uint32_t *entry = &tlb[set * TLB_WAYS];
+
+    for (int way = 0; way < TLB_WAYS; way++) {
+        if (entry[way] == TLB_INVALID)
+            return &entry[way];
+    }
+
+    entry = &entry[next[set]];
+    next[set] = (next[set] + 1) & (TLB_WAYS - 1);
+    tlb_evictions++;
+
+    return entry;
+}
+
+/* The tag for an entry being filled in. The flags of the last page table walk
+   are only used if it was for this page: the accesses that cross a page walk
+   both pages before filling either of them in. Otherwise the entry is tagged
+   so that every flush that could cover it does. */
+static __inline uint32_t
+tlb_get_tag(uint32_t page)
+{
+    uint32_t tag = page;
+
+    if (!(cr0 >> 31))
+        return tag;
+
+    if (mmu_flags_page != page)
+        tag |= TLB_LARGE;
+    else {
+        if (mmu_flags & MMU_FLAG_GLOBAL)
+            tag |= TLB_GLOBAL;
+        if (mmu_flags & MMU_FLAG_LARGE)
+            tag |= TLB_LARGE;
+    }
+    if ((CPL != 3) || cpl_override)
+        tag |= TLB_SUPERVISOR;
+
+    return tag;
+}
+
 void
 resetreadlookup(void)
 {
+    int size = mem_tlb_size;
+
+    /* The soft TLB size must be a power of two, with at least one set. */
+    if ((size < (TLB_WAYS * 16)) || (size > 16384) || (size & (size - 1))) {
+        mem_log("Invalid soft TLB size %i, using 1024\n", size);
+        size = 1024;
+    }
+
+    if (size != cachesize) {
+        free(readlookup);
+        free(writelookup);
+        free(readlnext);
+        free(writelnext);
+
+        cachesize    = size;
+        tlb_set_mask = (size / TLB_WAYS) - 1;
+        readlookup   = (uint32_t *) malloc(size * sizeof(uint32_t));
+        writelookup  = (uint32_t *) malloc(size * sizeof(uint32_t));
+        readlnext    = (uint8_t *) malloc(size / TLB_WAYS);
+        writelnext   = (uint8_t *) malloc(size / TLB_WAYS);
+    }
+
     /* Initialize the page lookup table. */
     memset(page_lookup, 0x00, (1 << 20) * sizeof(page_t *));
 
-    /* Initialize the tables for lower (<= 1024K) RAM. */
-    for (uint16_t c = 0; c < 256; c++) {
-        readlookup[c]  = 0xffffffff;
-        writelookup[c] = 0xffffffff;
-    }
+    /* Initialize the soft TLB. */
+    memset(readlookup, 0xff, cachesize * sizeof(uint32_t));
+    memset(writelookup, 0xff, cachesize * sizeof(uint32_t));
+    memset(readlnext, 0x00, cachesize / TLB_WAYS);
+    memset(writelnext, 0x00, cachesize / TLB_WAYS);
 
     /* Initialize the tables for high (> 1024K) RAM. */
     memset(readlookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
@@ -192,29 +330,14 @@ resetreadlookup(void)
     memset(writelookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
     memset(writelookupp, 0x04, (1 << 20) * sizeof(uint8_t));
 
-    readlnext  = 0;
-    writelnext = 0;
-    pccache    = 0xffffffff;
-    high_page  = 0;
+    pccache   = 0xffffffff;
+    high_page = 0;
 }
 
 void
 flushmmucache(void)
 {
-    for (uint16_t c = 0; c < 256; c++) {
-        if (readlookup[c] != (int) 0xffffffff) {
-            readlookup2[readlookup[c]] = LOOKUP_INV;
-            readlookupp[readlookup[c]] = 4;
-            readlookup[c]              = 0xffffffff;
-        }
-        if (writelookup[c] != (int) 0xffffffff) {
-            page_lookup[writelookup[c]]  = NULL;
-            page_lookupp[writelookup[c]] = 4;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookupp[writelookup[c]] = 4;
-            writelookup[c]               = 0xffffffff;
-        }
-    }
+    tlb_flush(0, 0);
     mmuflush++;
 
     pccache  = (uint32_t) 0xffffffff;
@@ -228,18 +351,46 @@ flushmmucache(void)
 void
 flushmmucache_nopc(void)
 {
-    for (uint16_t c = 0; c < 256; c++) {
-        if (readlookup[c] != (int) 0xffffffff) {
-            readlookup2[readlookup[c]] = LOOKUP_INV;
-            readlookupp[readlookup[c]] = 4;
-            readlookup[c]              = 0xffffffff;
+    tlb_flush(0, 0);
+}
+
+/* Flush on a CR3 reload: global pages are kept. Code blocks are looked up by
+   physical address, so the recompiler does not need to be told. */
+void
+flushmmucache_nonglobal(void)
+{
+    tlb_flush(TLB_GLOBAL, 0);
+    mmuflush++;
+
+    pccache  = (uint32_t) 0xffffffff;
+    pccache2 = (uint8_t *) 0xffffffff;
+}
+
+/* Flush on entry to CPL 3: only the pages that were filled in at a higher
+   privilege level may have passed checks that CPL 3 would fail. */
+void
+flushmmucache_supervisor(void)
+{
+    tlb_flush(TLB_SUPERVISOR, TLB_SUPERVISOR);
+}
+
+/* INVLPG: flush the entries for a page, along with every entry filled in
+   from a large page that holds it. */
+void
+flushmmucache_page(uint32_t addr)
+{
+    uint32_t page = addr >> 12;
+
+    for (int c = 0; c < cachesize; c++) {
+        if ((readlookup[c] != TLB_INVALID) && (((readlookup[c] & TLB_PAGE_MASK) == page) ||
+            ((readlookup[c] & TLB_LARGE) && !(((readlookup[c] ^ page) & TLB_PAGE_MASK) >> 10)))) {
+            tlb_invalidate_read(readlookup[c] & TLB_PAGE_MASK);
+            readlookup[c] = TLB_INVALID;
         }
-        if (writelookup[c] != (int) 0xffffffff) {
-            page_lookup[writelookup[c]]  = NULL;
-            page_lookupp[writelookup[c]] = 4;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookupp[writelookup[c]] = 4;
-            writelookup[c]               = 0xffffffff;
+        if ((writelookup[c] != TLB_INVALID) && (((writelookup[c] & TLB_PAGE_MASK) == page) ||
+            ((writelookup[c] & TLB_LARGE) && !(((writelookup[c] ^ page) & TLB_PAGE_MASK) >> 10)))) {
+            tlb_invalidate_write(writelookup[c] & TLB_PAGE_MASK);
+            writelookup[c] = TLB_INVALID;
         }
     }
 }
@@ -252,8 +403,9 @@ mem_flush_write_page(uint32_t addr, uint32_t virt)
     uint32_t a;
 #endif
 
-    for (uint16_t c = 0; c < 256; c++) {
-        if (writelookup[c] != (int) 0xffffffff) {
+    for (int c = 0; c < cachesize; c++) {
+        if (writelookup[c] != TLB_INVALID) {
+            uint32_t page = writelookup[c] & TLB_PAGE_MASK;
 #if (defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64)
             uintptr_t target = (uintptr_t) &ram[(uintptr_t) (addr & ~0xfff) - (virt & ~0xfff)];
 #else
@@ -266,10 +418,10 @@ mem_flush_write_page(uint32_t addr, uint32_t virt)
                 target = (uintptr_t) &ram[a];
 #endif
 
-            if (writelookup2[writelookup[c]] == target || page_lookup[writelookup[c]] == page_target) {
-                writelookup2[writelookup[c]] = LOOKUP_INV;
-                page_lookup[writelookup[c]]  = NULL;
-                writelookup[c]               = 0xffffffff;
+            if (writelookup2[page] == target || page_lookup[page] == page_target) {
+                writelookup2[page] = LOOKUP_INV;
+                page_lookup[page]  = NULL;
+                writelookup[c]     = TLB_INVALID;
             }
         }
     }
@@ -320,7 +472,9 @@ mmutranslatereal_normal(uint32_t addr, int rw)
             return 0xffffffffffffffffULL;
         }
 
-        mmu_perm = temp & 4;
+        mmu_perm       = temp & 4;
+        mmu_flags      = MMU_FLAG_LARGE | (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+        mmu_flags_page = addr >> 12;
         rammap(addr2) |= (rw ? 0x60 : 0x20);
 
         return (temp & ~0x3fffff) + (addr & 0x3fffff);
@@ -340,7 +494,9 @@ mmutranslatereal_normal(uint32_t addr, int rw)
         return 0xffffffffffffffffULL;
     }
 
-    mmu_perm = temp & 4;
+    mmu_perm       = temp & 4;
+    mmu_flags      = (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+    mmu_flags_page = addr >> 12;
     rammap(addr2) |= 0x20;
     rammap((temp2 & ~0xfff) + ((addr >> 10) & 0xffc)) |= (rw ? 0x60 : 0x20);
 
@@ -404,7 +560,9 @@ mmutranslatereal_pae(uint32_t addr, int rw)
 
             return 0xffffffffffffffffULL;
         }
-        mmu_perm = temp & 4;
+        mmu_perm       = temp & 4;
+        mmu_flags      = MMU_FLAG_LARGE | (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+        mmu_flags_page = addr >> 12;
         rammap64(addr3) |= (rw ? 0x60 : 0x20);
 
         return ((temp & ~0x1fffffULL) + (addr & 0x1fffffULL)) & 0x000000ffffffffffULL;
@@ -425,7 +583,9 @@ mmutranslatereal_pae(uint32_t addr, int rw)
         return 0xffffffffffffffffULL;
     }
 
-    mmu_perm = temp & 4;
+    mmu_perm       = temp & 4;
+    mmu_flags      = (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+    mmu_flags_page = addr >> 12;
     rammap64(addr3) |= 0x20;
     rammap64(addr4) |= (rw ? 0x60 : 0x20);
 
@@ -478,6 +638,9 @@ mmutranslate_noabrt_normal(uint32_t addr, int rw)
         if (((CPL == 3) && !(temp & 4) && !cpl_override) || (rw && !(temp & 2) && ((CPL == 3) || (cr0 & WP_FLAG))))
             return 0xffffffffffffffffULL;
 
+        mmu_flags      = MMU_FLAG_LARGE | (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+        mmu_flags_page = addr >> 12;
+
         return (temp & ~0x3fffff) + (addr & 0x3fffff);
     }
 
@@ -487,6 +650,9 @@ mmutranslate_noabrt_normal(uint32_t addr, int rw)
     if (!(temp & 1) || ((CPL == 3) && !(temp3 & 4) && !cpl_override) || (rw && !(temp3 & 2) && ((CPL == 3) || (cr0 & WP_FLAG))))
         return 0xffffffffffffffffULL;
 
+    mmu_flags      = (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+    mmu_flags_page = addr >> 12;
+
     return (uint64_t) ((temp & ~0xfff) + (addr & 0xfff));
 }
 
@@ -522,6 +688,9 @@ mmutranslate_noabrt_pae(uint32_t addr, int rw)
         if (((CPL == 3) && !(temp & 4) && !cpl_override) || (rw && !(temp & 2) && ((CPL == 3) || (cr0 & WP_FLAG))))
             return 0xffffffffffffffffULL;
 
+        mmu_flags      = MMU_FLAG_LARGE | (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+        mmu_flags_page = addr >> 12;
+
         return ((temp & ~0x1fffffULL) + (addr & 0x1fffff)) & 0x000000ffffffffffULL;
     }
 
@@ -533,6 +702,9 @@ mmutranslate_noabrt_pae(uint32_t addr, int rw)
     if (!(temp & 1) || ((CPL == 3) && !(temp3 & 4) && !cpl_override) || (rw && !(temp3 & 2) && ((CPL == 3) || (cr0 & WP_FLAG))))
         return 0xffffffffffffffffULL;
 
+    mmu_flags      = (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+    mmu_flags_page = addr >> 12;
+
     return ((temp & ~0xfffULL) + ((uint64_t) (addr & 0xfff))) & 0x000000ffffffffffULL;
 }
 
@@ -571,6 +743,7 @@ mem_addr_translate(uint32_t addr, uint32_t chunk_start, uint32_t len)
 void
 addreadlookup(uint32_t virt, uint32_t phys)
 {
+    uint32_t *entry;
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
     uint32_t a;
 #endif
@@ -581,10 +754,11 @@ addreadlookup(uint32_t virt, uint32_t phys)
     if (readlookup2[virt >> 12] != (uintptr_t) LOOKUP_INV)
         return;
 
-    if (readlookup[readlnext] != (int) 0xffffffff) {
-        if ((readlookup[readlnext] == ((es + DI) >> 12)) || (readlookup[readlnext] == ((es + EDI) >> 12)))
+    entry = tlb_get_entry(readlookup, readlnext, virt >> 12);
+    if (*entry != TLB_INVALID) {
+        if (((*entry & TLB_PAGE_MASK) == ((es + DI) >> 12)) || ((*entry & TLB_PAGE_MASK) == ((es + EDI) >> 12)))
             uncached = 1;
-        readlookup2[readlookup[readlnext]] = LOOKUP_INV;
+        readlookup2[*entry & TLB_PAGE_MASK] = LOOKUP_INV;
     }
 
 #if (defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64)
@@ -599,8 +773,8 @@ addreadlookup(uint32_t virt, uint32_t phys)
 #endif
     readlookupp[virt >> 12] = mmu_perm;
 
-    readlookup[readlnext++] = virt >> 12;
-    readlnext &= (cachesize - 1);
+    *entry = tlb_get_tag(virt >> 12);
+    tlb_fills++;
 
     cycles -= 9;
 }
@@ -608,6 +782,7 @@ addreadlookup(uint32_t virt, uint32_t phys)
 void
 addwritelookup(uint32_t virt, uint32_t phys)
 {
+    uint32_t *entry;
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
     uint32_t a;
 #endif
@@ -618,9 +793,10 @@ addwritelookup(uint32_t virt, uint32_t phys)
     if (page_lookup[virt >> 12])
         return;
 
-    if (writelookup[writelnext] != -1) {
-        page_lookup[writelookup[writelnext]]  = NULL;
-        writelookup2[writelookup[writelnext]] = LOOKUP_INV;
+    entry = tlb_get_entry(writelookup, writelnext, virt >> 12);
+    if (*entry != TLB_INVALID) {
+        page_lookup[*entry & TLB_PAGE_MASK]  = NULL;
+        writelookup2[*entry & TLB_PAGE_MASK] = LOOKUP_INV;
     }
 
 #ifdef USE_NEW_DYNAREC
@@ -652,8 +828,8 @@ addwritelookup(uint32_t virt, uint32_t phys)
     }
     writelookupp[virt >> 12] = mmu_perm;
 
-    writelookup[writelnext++] = virt >> 12;
-    writelnext &= (cachesize - 1);
+    *entry = tlb_get_tag(virt >> 12);
+    tlb_fills++;
 
     cycles -= 9;
 }
@@ -1810,6 +1986,90 @@ mem_write_phys(void *src, uint32_t addr, int transfer_size)
     }
 }
 
+/* Number of bytes from addr, at most len and a multiple of transfer_size, that
+   map straight to the backing memory of map within one granule. Returns 0 if
+   the access has to go through the handlers. */
+static uint32_t
+mem_phys_direct_len(const mem_mapping_t *map, uint32_t addr, uint32_t len, int transfer_size)
+{
+    uint32_t off;
+    uint32_t chunk;
+
+    if (!cpu_use_exec || (map == NULL) || (map->exec == NULL))
+        return 0;
+
+    off   = (addr - map->base) & map->mask;
+    chunk = MEM_GRANULARITY_SIZE - (addr & MEM_GRANULARITY_MASK);
+    if ((map->mask - off) < (chunk - 1))
+        chunk = map->mask - off + 1;
+    if (chunk > len)
+        chunk = len;
+
+    return chunk & ~(transfer_size - 1);
+}
+
+/* Bulk versions of mem_read_phys() and mem_write_phys(), for bus masters. len
+   must be a multiple of transfer_size. Runs of plain memory are copied in one
+   go, anything else is accessed transfer_size bytes at a time through the bus
+   mappings as before. Everything mem_write_phys_block() writes is invalidated
+   for the recompiler, as dma_bm_write() used to do for the whole transfer. */
+void
+mem_read_phys_block(void *dest, uint32_t addr, uint32_t len, int transfer_size)
+{
+    uint8_t       *p = (uint8_t *) dest;
+    mem_mapping_t *map;
+    uint32_t       chunk;
+
+    mem_logical_addr = 0xffffffff;
+
+    while (len) {
+        map   = read_mapping_bus[addr >> MEM_GRANULARITY_BITS];
+        chunk = mem_phys_direct_len(map, addr, len, transfer_size);
+
+        if (chunk)
+            memcpy(p, &map->exec[(addr - map->base) & map->mask], chunk);
+        else {
+            chunk = transfer_size;
+            mem_read_phys(p, addr, transfer_size);
+        }
+
+        p += chunk;
+        addr += chunk;
+        len -= chunk;
+    }
+}
+
+void
+mem_write_phys_block(const void *src, uint32_t addr, uint32_t len, int transfer_size)
+{
+    const uint8_t *p = (const uint8_t *) src;
+    mem_mapping_t *map;
+    uint32_t       chunk;
+
+    mem_logical_addr = 0xffffffff;
+
+    while (len) {
+        map   = write_mapping_bus[addr >> MEM_GRANULARITY_BITS];
+        chunk = mem_phys_direct_len(map, addr, len, transfer_size);
+
+        if (chunk) {
+            memcpy(&map->exec[(addr - map->base) & map->mask], p, chunk);
+            /* The write handlers that would have marked the code as dirty
+               were skipped. */
+            mem_invalidate_range(addr, addr + chunk - 1);
+        } else {
+            chunk = transfer_size;
+            mem_write_phys((void *) p, addr, transfer_size);
+            /* Not every write handler marks the code as dirty either. */
+            mem_invalidate_range(addr, addr + chunk - 1);
+        }
+
+        p += chunk;
+        addr += chunk;
+        len -= chunk;
+    }
+}
+
 uint8_t
 mem_read_ram(uint32_t addr, UNUSED(void *priv))
 {
@@ -3147,3 +3407,94 @@ mem_a20_recalc(void)
 
     mem_a20_state = state;
 }
+
+/* RAM is streamed out in chunks, each in its own section, so that no
+   section gets anywhere near 4 GB, and none of it has to be buffered. */
+#define MEM_SNAPSHOT_CHUNK (64 << 20)
+
+static uint8_t *
+mem_snapshot_chunk(uint32_t index, uint32_t *len)
+{
+    size_t   total = 1024UL * (size_t) mem_size;
+    size_t   addr  = (size_t) index * MEM_SNAPSHOT_CHUNK;
+    uint8_t *p;
+
+    if (addr >= total)
+        return NULL;
+
+#if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
+    if (addr >= ram_size)
+        p = &(ram2[addr - ram_size]);
+    else
+#endif
+        p = &(ram[addr]);
+
+    *len = (uint32_t) MIN(total - addr, (size_t) MEM_SNAPSHOT_CHUNK);
+
+    return p;
+}
+
+void
+mem_save(snapshot_t *s)
+{
+    uint8_t *p;
+    uint32_t len;
+
+    snapshot_section_begin(s, SNAPSHOT_SECTION_CORE, "mem", 0, 0);
+    snapshot_write_var(s, mem_size);
+    snapshot_write_var(s, rammask);
+    snapshot_write_var(s, mem_a20_key);
+    snapshot_write_var(s, mem_a20_alt);
+    snapshot_write_var(s, mem_a20_state);
+    snapshot_write_var(s, _mem_state);
+    snapshot_write_var(s, _mem_wp);
+    snapshot_write_var(s, _mem_wp_bus);
+    snapshot_section_end(s);
+
+    for (uint32_t c = 0; (p = mem_snapshot_chunk(c, &len)) != NULL; c++) {
+        snapshot_section_begin(s, SNAPSHOT_SECTION_CORE, "ram", c, len);
+        snapshot_write(s, p, len);
+        snapshot_section_end(s);
+    }
+}
+
+void
+mem_load(snapshot_t *s)
+{
+    uint32_t size;
+
+    snapshot_read_var(s, size);
+    if (size != mem_size) {
+        pclog("MEM: snapshot has %u kB of RAM, this machine has %u kB\n", size, mem_size);
+        snapshot_set_error(s);
+        return;
+    }
+
+    snapshot_read_var(s, rammask);
+    snapshot_read_var(s, mem_a20_key);
+    snapshot_read_var(s, mem_a20_alt);
+    snapshot_read_var(s, mem_a20_state);
+    snapshot_read_var(s, _mem_state);
+    snapshot_read_var(s, _mem_wp);
+    snapshot_read_var(s, _mem_wp_bus);
+
+    mem_mapping_recalc(0x00000000ULL, 0x100000000ULL);
+    flushmmucache();
+}
+
+void
+mem_load_ram(snapshot_t *s, uint32_t index)
+{
+    uint8_t *p;
+    uint32_t len;
+
+    if ((p = mem_snapshot_chunk(index, &len)) == NULL) {
+        snapshot_set_error(s);
+        return;
+    }
+
+    snapshot_read(s, p, len);
+
+    /* Anything the recompiler had made of the old contents is stale. */
+    mem_reset_page_blocks();
+}
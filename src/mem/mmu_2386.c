@@ -211,7 +211,9 @@ mmutranslatereal_2386(uint32_t addr, int rw)
             return 0xffffffffffffffffULL;
         }
 
-        mmu_perm = temp & 4;
+        mmu_perm       = temp & 4;
+        mmu_flags      = MMU_FLAG_LARGE | (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+        mmu_flags_page = addr >> 12;
         mem_writel_map(addr2, mem_readl_map(addr2) | (rw ? 0x60 : 0x20));
 
         return (temp & ~0x3fffff) + (addr & 0x3fffff);
@@ -231,7 +233,9 @@ mmutranslatereal_2386(uint32_t addr, int rw)
         return 0xffffffffffffffffULL;
     }
 
-    mmu_perm = temp & 4;
+    mmu_perm       = temp & 4;
+    mmu_flags      = (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+    mmu_flags_page = addr >> 12;
     mem_writel_map(addr2, mem_readl_map(addr2) | 0x20);
     mem_writel_map((temp2 & ~0xfff) + ((addr >> 10) & 0xffc),
                    mem_readl_map((temp2 & ~0xfff) + ((addr >> 10) & 0xffc)) | (rw ? 0x60 : 0x20));
@@ -261,6 +265,9 @@ mmutranslate_noabrt_2386(uint32_t addr, int rw)
         if (((CPL == 3) && !(temp & 4) && !cpl_override) || (rw && !(temp & 2) && ((CPL == 3) || (cr0 & WP_FLAG))))
             return 0xffffffffffffffffULL;
 
+        mmu_flags      = MMU_FLAG_LARGE | (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+        mmu_flags_page = addr >> 12;
+
         return (temp & ~0x3fffff) + (addr & 0x3fffff);
     }
 
@@ -270,6 +277,9 @@ mmutranslate_noabrt_2386(uint32_t addr, int rw)
     if (!(temp & 1) || ((CPL == 3) && !(temp3 & 4) && !cpl_override) || (rw && !(temp3 & 2) && ((CPL == 3) || (cr0 & WP_FLAG))))
         return 0xffffffffffffffffULL;
 
+    mmu_flags      = (((cr4 & CR4_PGE) && (temp & 0x100)) ? MMU_FLAG_GLOBAL : 0);
+    mmu_flags_page = addr >> 12;
+
     return (uint64_t) ((temp & ~0xfff) + (addr & 0xfff));
 }
 
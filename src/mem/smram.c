@@ -27,6 +27,8 @@
 #include <86box/config.h>
 #include <86box/io.h>
 #include <86box/mem.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 #include <86box/smram.h>
 
 static smram_t *base_smram;
@@ -330,6 +332,28 @@ smram_disable_all(void)
     }
 }
 
+/* Point the mapping of an enabled SMRAM struct at its host and RAM bases. */
+static void
+smram_set_mapping(smram_t *smr)
+{
+    mem_mapping_set_addr(&(smr->mapping), smr->host_base, smr->size);
+    if (!use_separate_smram || (smr->ram_base >= 0x000a0000)) {
+        if (smr->ram_base < (1 << 30))
+            mem_mapping_set_exec(&(smr->mapping), ram + smr->ram_base);
+        else
+            mem_mapping_set_exec(&(smr->mapping), ram2 + smr->ram_base - (1 << 30));
+    } else {
+        if (smr->ram_base == 0x00030000)
+            mem_mapping_set_exec(&(smr->mapping), smram);
+        else if (smr->ram_base == 0x00040000)
+            mem_mapping_set_exec(&(smr->mapping), smram + 0x10000);
+        else if (smr->ram_base == 0x00060000)
+            mem_mapping_set_exec(&(smr->mapping), smram + 0x20000);
+        else if (smr->ram_base == 0x00070000)
+            mem_mapping_set_exec(&(smr->mapping), smram + 0x30000);
+    }
+}
+
 /* Enable SMRAM mappings according to flags for both normal and SMM modes, separately for bus
    and CPU. */
 void
@@ -346,22 +370,7 @@ smram_enable_ex(smram_t *smr, uint32_t host_base, uint32_t ram_base, uint32_t si
         smr->ram_base  = ram_base;
         smr->size      = size;
 
-        mem_mapping_set_addr(&(smr->mapping), smr->host_base, smr->size);
-        if (!use_separate_smram || (smr->ram_base >= 0x000a0000)) {
-            if (smr->ram_base < (1 << 30))
-                mem_mapping_set_exec(&(smr->mapping), ram + smr->ram_base);
-            else
-                mem_mapping_set_exec(&(smr->mapping), ram2 + smr->ram_base - (1 << 30));
-        } else {
-            if (smr->ram_base == 0x00030000)
-                mem_mapping_set_exec(&(smr->mapping), smram);
-            else if (smr->ram_base == 0x00040000)
-                mem_mapping_set_exec(&(smr->mapping), smram + 0x10000);
-            else if (smr->ram_base == 0x00060000)
-                mem_mapping_set_exec(&(smr->mapping), smram + 0x20000);
-            else if (smr->ram_base == 0x00070000)
-                mem_mapping_set_exec(&(smr->mapping), smram + 0x30000);
-        }
+        smram_set_mapping(smr);
 
         smram_map_ex(0, 0, host_base, size, flags_normal);
         smram_map_ex(1, 0, host_base, size, flags_normal_bus);
@@ -409,3 +418,63 @@ smram_set_separate_smram(uint8_t set)
 {
     use_separate_smram = set;
 }
+
+/* The SMRAM structs are added by the chipset in the same order on every
+   hard reset, so they are saved in list order. Their access flags are part
+   of the memory state, which is loaded first. */
+void
+smram_save(snapshot_t *s)
+{
+    uint32_t count = 0;
+
+    for (smram_t *temp_smram = base_smram; temp_smram != NULL; temp_smram = temp_smram->next)
+        count++;
+
+    snapshot_write_var(s, use_separate_smram);
+    snapshot_write_var(s, smram);
+    snapshot_write_var(s, count);
+
+    for (smram_t *temp_smram = base_smram; temp_smram != NULL; temp_smram = temp_smram->next) {
+        snapshot_write_var(s, temp_smram->host_base);
+        snapshot_write_var(s, temp_smram->ram_base);
+        snapshot_write_var(s, temp_smram->size);
+        snapshot_write_var(s, temp_smram->old_host_base);
+        snapshot_write_var(s, temp_smram->old_size);
+    }
+}
+
+void
+smram_load(snapshot_t *s)
+{
+    uint32_t count = 0;
+    uint32_t saved;
+
+    for (smram_t *temp_smram = base_smram; temp_smram != NULL; temp_smram = temp_smram->next)
+        count++;
+
+    snapshot_read_var(s, use_separate_smram);
+    snapshot_read_var(s, smram);
+    snapshot_read_var(s, saved);
+
+    if (saved != count) {
+        pclog("SMRAM: snapshot has %u SMRAM mappings, this machine has %u\n", saved, count);
+        snapshot_set_error(s);
+        return;
+    }
+
+    for (smram_t *temp_smram = base_smram; temp_smram != NULL; temp_smram = temp_smram->next) {
+        snapshot_read_var(s, temp_smram->host_base);
+        snapshot_read_var(s, temp_smram->ram_base);
+        snapshot_read_var(s, temp_smram->size);
+        snapshot_read_var(s, temp_smram->old_host_base);
+        snapshot_read_var(s, temp_smram->old_size);
+
+        if (temp_smram->size != 0x00000000)
+            smram_set_mapping(temp_smram);
+        else
+            mem_mapping_disable(&(temp_smram->mapping));
+    }
+
+    mem_mapping_recalc(0x00000000ULL, 0x100000000ULL);
+    flushmmucache();
+}
@@ -309,6 +309,78 @@ asic_write(nic_t *dev, uint32_t off, uint32_t val, unsigned len)
     }
 }
 
+/* Number of bytes, a multiple of size and at most count accesses, that a
+   string transfer on the data register can move straight to or from the
+   packet memory. The remote DMA must use the access size, stay within the
+   memory and not reach the ring wrap, and the last access is left to
+   asic_read() or asic_write() so that the completion interrupt is raised as
+   usual. */
+static uint32_t
+asic_block_len(const dp8390_t *dp, int size, int count)
+{
+    uint32_t len = (uint32_t) count * size;
+    uint32_t end = dp->page_stop << 8;
+
+    if ((size != 4) && (size != (dp->DCR.wdsize + 1)))
+        return 0;
+    if ((dp->remote_dma < dp->mem_start) || (dp->remote_dma >= dp->mem_end) ||
+        (dp->remote_bytes <= size) || (dp->mem == NULL))
+        return 0;
+
+    if (len > (dp->remote_bytes - size))
+        len = dp->remote_bytes - size;
+    if (len > (dp->mem_end - dp->remote_dma))
+        len = dp->mem_end - dp->remote_dma;
+    if ((dp->remote_dma < end) && (len > (end - dp->remote_dma)))
+        len = end - dp->remote_dma;
+
+    return len - (len % size);
+}
+
+static int
+nic_read_block(uint16_t addr, void *buf, int size, int count, void *priv)
+{
+    nic_t    *dev = (nic_t *) priv;
+    dp8390_t *dp  = dev->dp8390;
+    uint32_t  len;
+
+    if ((addr - dev->base_address) != 0x10)
+        return 0;
+
+    len = asic_block_len(dp, size, count);
+    if (len > 0) {
+        memcpy(buf, &dp->mem[dp->remote_dma - dp->mem_start], len);
+        dp->remote_dma += len;
+        if (dp->remote_dma == dp->page_stop << 8)
+            dp->remote_dma = dp->page_start << 8;
+        dp->remote_bytes -= len;
+    }
+
+    return len / size;
+}
+
+static int
+nic_write_block(uint16_t addr, const void *buf, int size, int count, void *priv)
+{
+    nic_t    *dev = (nic_t *) priv;
+    dp8390_t *dp  = dev->dp8390;
+    uint32_t  len;
+
+    if (((addr - dev->base_address) != 0x10) || ((size > 1) && (dp->DCR.wdsize == 0)))
+        return 0;
+
+    len = asic_block_len(dp, size, count);
+    if (len > 0) {
+        memcpy(&dp->mem[dp->remote_dma - dp->mem_start], buf, len);
+        dp->remote_dma += len;
+        if (dp->remote_dma == dp->page_stop << 8)
+            dp->remote_dma = dp->page_start << 8;
+        dp->remote_bytes -= len;
+    }
+
+    return len / size;
+}
+
 /* Writes to this page are illegal. */
 static uint32_t
 page3_read(nic_t *dev, uint32_t off, UNUSED(unsigned int len))
@@ -579,6 +651,7 @@ nic_ioset(nic_t *dev, uint16_t addr)
                           nic_writeb, nic_writew, NULL, dev);
         }
     }
+    io_sethandler_block(addr + 16, nic_read_block, nic_write_block, dev);
 }
 
 static void
@@ -107,9 +107,12 @@ net_null_thread(void *priv)
 
             case NET_EVENT_TX:
                 net_event_clear(&net_null->tx_event);
-                int packets = network_tx_popv(net_null->card, net_null->pktv, NULL_PKT_BATCH);
-                for (int i = 0; i < packets; i++) {
-                    net_null_log("Null Network: Ignoring TX packet (%d bytes)\n", net_null->pktv[i].len);
+                /* The queue can hold more than one batch. */
+                int packets;
+                while ((packets = network_tx_popv(net_null->card, net_null->pktv, NULL_PKT_BATCH)) > 0) {
+                    for (int i = 0; i < packets; i++) {
+                        net_null_log("Null Network: Ignoring TX packet (%d bytes)\n", net_null->pktv[i].len);
+                    }
                 }
                 break;
 
@@ -147,9 +150,12 @@ net_null_thread(void *priv)
         if (pfd[NET_EVENT_TX].revents & POLLIN) {
             net_event_clear(&net_null->tx_event);
 
-            int packets = network_tx_popv(net_null->card, net_null->pktv, NULL_PKT_BATCH);
-            for (int i = 0; i < packets; i++) {
-                net_null_log("Null Network: Ignoring TX packet (%d bytes)\n", net_null->pktv[i].len);
+            /* The queue can hold more than one batch. */
+            int packets;
+            while ((packets = network_tx_popv(net_null->card, net_null->pktv, NULL_PKT_BATCH)) > 0) {
+                for (int i = 0; i < packets; i++) {
+                    net_null_log("Null Network: Ignoring TX packet (%d bytes)\n", net_null->pktv[i].len);
+                }
             }
         }
     }
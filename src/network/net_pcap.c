@@ -284,13 +284,16 @@ net_pcap_thread(void *priv)
 
             case NET_EVENT_TX:
                 net_event_clear(&pcap->tx_event);
-                int packets = network_tx_popv(pcap->card, pcap->pktv, PCAP_PKT_BATCH);
-                for (int i = 0; i < packets; i++) {
-                    h.caplen = pcap->pktv[i].len;
-                    f_pcap_sendqueue_queue(pcap->pcap_queue, &h, pcap->pktv[i].data);
+                /* The queue can hold more than one batch. */
+                int packets;
+                while ((packets = network_tx_popv(pcap->card, pcap->pktv, PCAP_PKT_BATCH)) > 0) {
+                    for (int i = 0; i < packets; i++) {
+                        h.caplen = pcap->pktv[i].len;
+                        f_pcap_sendqueue_queue(pcap->pcap_queue, &h, pcap->pktv[i].data);
+                    }
+                    f_pcap_sendqueue_transmit(pcap->pcap, pcap->pcap_queue, 0);
+                    pcap->pcap_queue->len = 0;
                 }
-                f_pcap_sendqueue_transmit(pcap->pcap, pcap->pcap_queue, 0);
-                pcap->pcap_queue->len = 0;
                 break;
 
             case NET_EVENT_RX:
@@ -334,9 +337,12 @@ net_pcap_thread(void *priv)
         if (pfd[NET_EVENT_TX].revents & POLLIN) {
             net_event_clear(&pcap->tx_event);
 
-            int packets = network_tx_popv(pcap->card, pcap->pktv, PCAP_PKT_BATCH);
-            for (int i = 0; i < packets; i++) {
-                net_pcap_in(pcap->pcap, pcap->pktv[i].data, pcap->pktv[i].len);
+            /* The queue can hold more than one batch. */
+            int packets;
+            while ((packets = network_tx_popv(pcap->card, pcap->pktv, PCAP_PKT_BATCH)) > 0) {
+                for (int i = 0; i < packets; i++) {
+                    net_pcap_in(pcap->pcap, pcap->pktv[i].data, pcap->pktv[i].len);
+                }
             }
         }
 
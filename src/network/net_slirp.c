@@ -348,9 +348,12 @@ net_slirp_thread(void *priv)
 
             case NET_EVENT_TX:
                 {
-                    int packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
-                    for (int i = 0; i < packets; i++) {
-                        net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
+                    /* The queue can hold more than one batch. */
+                    int packets;
+                    while ((packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH)) > 0) {
+                        for (int i = 0; i < packets; i++) {
+                            net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
+                        }
                     }
                 }
                 break;
@@ -394,9 +397,12 @@ net_slirp_thread(void *priv)
         if (slirp->pfd[NET_EVENT_TX].revents & POLLIN) {
             net_event_clear(&slirp->tx_event);
 
-            int packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
-            for (int i = 0; i < packets; i++) {
-                net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
+            /* The queue can hold more than one batch. */
+            int packets;
+            while ((packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH)) > 0) {
+                for (int i = 0; i < packets; i++) {
+                    net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
+                }
             }
         }
     }
@@ -0,0 +1,639 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Local virtual switch network driver.
+ *
+ *          Connects the network cards of any number of 86Box processes
+ *          on the same host (up to SWITCH_PORTS) that use the same
+ *          switch name, without needing root, pcap or a VDE switch.
+ *
+ *          The switch lives in a POSIX shared memory object. Every
+ *          card attached to it owns a port, which is a ring of packet
+ *          slots that the other ports write into. Sending a packet is
+ *          a copy into the destination's ring; the destination is only
+ *          woken up through its doorbell socket when it is waiting for
+ *          packets. Doorbells live in XDG_RUNTIME_DIR, or in the VM
+ *          directory if that is not set, and every port publishes the
+ *          path of its own. The shared memory object is removed when
+ *          the last port is closed.
+ *
+ *          The switch learns which port each MAC address is behind
+ *          from the packets that ports send, and floods packets to
+ *          unknown, broadcast and multicast addresses.
+ *
+ *
+ *
+ * Authors: Miran Grca, <mgrca8@gmail.com>
+ *
+ *          Copyright 2024 Miran Grca.
+ */
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/thread.h>
+#include <86box/timer.h>
+#include <86box/network.h>
+#include <86box/net_event.h>
+
+enum {
+    NET_EVENT_STOP = 0,
+    NET_EVENT_TX,
+    NET_EVENT_RX,
+    NET_EVENT_MAX
+};
+
+#define SWITCH_PKT_BATCH NET_QUEUE_LEN
+
+#define SWITCH_MAGIC     0x48435753 /* "SWCH" */
+#define SWITCH_VERSION   2
+#define SWITCH_PORTS     16
+#define SWITCH_RING_LEN  128 /* must be a power of 2 */
+#define SWITCH_RING_MASK (SWITCH_RING_LEN - 1)
+#define SWITCH_MACS      256 /* must be a power of 2 */
+#define SWITCH_NAME_MAX  20  /* keeps the shared memory name within 31 characters */
+#define SWITCH_BELL_MAX  108 /* size of sun_path on Linux */
+
+/* All of the shared state is valid when zeroed, so a new switch only needs to
+   be created at the right size.
+
+   A slot's seq is stored relative to the slot's index in the ring: slot k is
+   free for the sender that claimed ring position pos when seq + k == pos, and
+   holds a packet for the reader at pos when seq + k == pos + 1. */
+typedef struct switch_slot_t {
+    atomic_uint seq;
+    uint32_t    len;
+    uint8_t     data[NET_MAX_FRAME];
+} switch_slot_t;
+
+typedef struct switch_port_t {
+    atomic_int    pid;     /* owning process, 0 if the port is free */
+    atomic_uint   waiting; /* the owner is about to wait on its doorbell */
+    atomic_uint   head;    /* next ring position to be claimed by a sender */
+    atomic_uint   tail;    /* next ring position to be read by the owner */
+    atomic_uint   dropped;
+    char          bell[SWITCH_BELL_MAX]; /* path of the owner's doorbell socket */
+    switch_slot_t slots[SWITCH_RING_LEN];
+} switch_port_t;
+
+typedef struct switch_shm_t {
+    atomic_uint   magic;
+    /* MAC address in the upper 48 bits, port + 1 in the lower 16. */
+    atomic_ullong macs[SWITCH_MACS];
+    switch_port_t ports[SWITCH_PORTS];
+} switch_shm_t;
+
+typedef struct net_switch_t {
+    switch_shm_t *shm;
+    int           port;
+    int           bell_fd;  /* our doorbell, others ring it */
+    int           send_fd;  /* used to ring the other ports' doorbells */
+    char          name[SWITCH_NAME_MAX + 1];
+    netcard_t    *card;
+    thread_t     *poll_tid;
+    net_evt_t     tx_event;
+    net_evt_t     stop_event;
+    netpkt_t      pkt;
+    netpkt_t      pktv[SWITCH_PKT_BATCH];
+    uint8_t       mac_addr[6];
+} net_switch_t;
+
+#ifdef ENABLE_NET_SWITCH_LOG
+int net_switch_do_log = ENABLE_NET_SWITCH_LOG;
+
+static void
+net_switch_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (net_switch_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define net_switch_log(fmt, ...)
+#endif
+
+static void
+net_switch_shm_name(char *buf, size_t size, const char *name)
+{
+    snprintf(buf, size, "/86box-sw-%s", name);
+}
+
+/* Work out where our own doorbell goes. Returns 0 if the path does not fit. */
+static int
+net_switch_bell_path(struct sockaddr_un *addr, const char *name, int port)
+{
+    const char *dir = getenv("XDG_RUNTIME_DIR");
+    int         len;
+
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    if ((dir != NULL) && (dir[0] != '\0'))
+        len = snprintf(addr->sun_path, sizeof(addr->sun_path), "%s/86box-switch-%s.%i", dir, name, port);
+    else
+        len = snprintf(addr->sun_path, sizeof(addr->sun_path), "%s86box-switch-%s.%i", usr_path, name, port);
+
+    return (len > 0) && (len < (int) MIN(sizeof(addr->sun_path), SWITCH_BELL_MAX));
+}
+
+static void
+net_switch_ring_bell(net_switch_t *sw, int port)
+{
+    struct sockaddr_un addr;
+    uint8_t            val = 0;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, sw->shm->ports[port].bell, MIN(sizeof(addr.sun_path), SWITCH_BELL_MAX) - 1);
+
+    /* A full doorbell means that the port has already been woken up. */
+    (void) sendto(sw->send_fd, &val, 1, 0, (struct sockaddr *) &addr, sizeof(addr));
+}
+
+static int
+net_switch_port_alive(switch_port_t *port)
+{
+    int pid = atomic_load(&port->pid);
+
+    return pid && ((kill(pid, 0) == 0) || (errno != ESRCH));
+}
+
+/* Copy a packet into a port's ring. Any number of senders can do this at the
+   same time. */
+static int
+net_switch_ring_put(net_switch_t *sw, int dst, const uint8_t *data, int len)
+{
+    switch_port_t *port = &sw->shm->ports[dst];
+    switch_slot_t *slot;
+    uint32_t       pos = atomic_load_explicit(&port->head, memory_order_relaxed);
+    int32_t        diff;
+
+    while (1) {
+        slot = &port->slots[pos & SWITCH_RING_MASK];
+        diff = (int32_t) (atomic_load_explicit(&slot->seq, memory_order_acquire) + (pos & SWITCH_RING_MASK) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&port->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&port->dropped, 1, memory_order_relaxed);
+            return 0;
+        } else
+            pos = atomic_load_explicit(&port->head, memory_order_relaxed);
+    }
+
+    memcpy(slot->data, data, len);
+    slot->len = len;
+    atomic_store_explicit(&slot->seq, pos + 1 - (pos & SWITCH_RING_MASK), memory_order_release);
+
+    /* Pairs with the fence in net_switch_thread(), so that either the owner
+       sees the packet before going to sleep, or we see it waiting. */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&port->waiting, memory_order_relaxed))
+        net_switch_ring_bell(sw, dst);
+
+    return 1;
+}
+
+/* Returns the slot at the front of our ring, or NULL if it is empty. */
+static switch_slot_t *
+net_switch_ring_peek(net_switch_t *sw)
+{
+    switch_port_t *port = &sw->shm->ports[sw->port];
+    uint32_t       pos  = atomic_load_explicit(&port->tail, memory_order_relaxed);
+    switch_slot_t *slot = &port->slots[pos & SWITCH_RING_MASK];
+
+    if ((atomic_load_explicit(&slot->seq, memory_order_acquire) + (pos & SWITCH_RING_MASK)) != (pos + 1))
+        return NULL;
+
+    return slot;
+}
+
+static void
+net_switch_ring_next(net_switch_t *sw)
+{
+    switch_port_t *port = &sw->shm->ports[sw->port];
+    uint32_t       pos  = atomic_load_explicit(&port->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&port->slots[pos & SWITCH_RING_MASK].seq, pos + SWITCH_RING_LEN - (pos & SWITCH_RING_MASK), memory_order_release);
+    atomic_store_explicit(&port->tail, pos + 1, memory_order_relaxed);
+}
+
+/* Throw away whatever a previous owner of the port left in its ring. A slot
+   that was claimed but never filled in (its sender died half way through) is
+   skipped after a while. */
+static void
+net_switch_ring_drain(net_switch_t *sw)
+{
+    switch_port_t *port = &sw->shm->ports[sw->port];
+    int            wait = 0;
+
+    while (atomic_load(&port->tail) != atomic_load(&port->head)) {
+        if (!net_switch_ring_peek(sw) && (wait++ < 100)) {
+            usleep(1000);
+            continue;
+        }
+        net_switch_ring_next(sw);
+        wait = 0;
+    }
+}
+
+static uint32_t
+net_switch_mac_hash(const uint8_t *mac)
+{
+    return (mac[0] ^ mac[1] ^ mac[2] ^ mac[3] ^ mac[4] ^ (mac[5] * 31)) & (SWITCH_MACS - 1);
+}
+
+static uint64_t
+net_switch_mac_key(const uint8_t *mac)
+{
+    return ((uint64_t) mac[0] << 56) | ((uint64_t) mac[1] << 48) | ((uint64_t) mac[2] << 40) |
+           ((uint64_t) mac[3] << 32) | ((uint64_t) mac[4] << 24) | ((uint64_t) mac[5] << 16);
+}
+
+/* Remember that a MAC address is behind the given port. The table is direct
+   mapped, so an address can push out another one, which is then flooded
+   until it is learned again. */
+static void
+net_switch_mac_learn(net_switch_t *sw, const uint8_t *mac, int port)
+{
+    atomic_ullong *entry = &sw->shm->macs[net_switch_mac_hash(mac)];
+    uint64_t       val   = net_switch_mac_key(mac) | (port + 1);
+
+    if (mac[0] & 0x01)
+        return;
+
+    if (atomic_load_explicit(entry, memory_order_relaxed) != val)
+        atomic_store_explicit(entry, val, memory_order_relaxed);
+}
+
+/* Returns the port a MAC address is behind, or -1 if it is not known. */
+static int
+net_switch_mac_lookup(net_switch_t *sw, const uint8_t *mac)
+{
+    uint64_t val = atomic_load_explicit(&sw->shm->macs[net_switch_mac_hash(mac)], memory_order_relaxed);
+
+    if ((mac[0] & 0x01) || ((val & ~0xffffULL) != net_switch_mac_key(mac)))
+        return -1;
+
+    return (int) (val & 0xffff) - 1;
+}
+
+static void
+net_switch_mac_forget(net_switch_t *sw)
+{
+    for (int i = 0; i < SWITCH_MACS; i++) {
+        uint64_t val = atomic_load(&sw->shm->macs[i]);
+
+        if ((val & 0xffff) == (uint64_t) (sw->port + 1))
+            atomic_compare_exchange_strong(&sw->shm->macs[i], &val, 0);
+    }
+}
+
+static void
+net_switch_tx(net_switch_t *sw, const netpkt_t *pkt)
+{
+    int dst;
+
+    if (pkt->len < 14)
+        return;
+
+    net_switch_mac_learn(sw, &pkt->data[6], sw->port);
+
+    dst = net_switch_mac_lookup(sw, pkt->data);
+    if (dst == sw->port)
+        return;
+
+    if ((dst >= 0) && (dst < SWITCH_PORTS) && atomic_load(&sw->shm->ports[dst].pid)) {
+        net_switch_ring_put(sw, dst, pkt->data, pkt->len);
+        return;
+    }
+
+    /* Flood. */
+    for (int i = 0; i < SWITCH_PORTS; i++) {
+        if ((i != sw->port) && atomic_load(&sw->shm->ports[i].pid))
+            net_switch_ring_put(sw, i, pkt->data, pkt->len);
+    }
+}
+
+static void
+net_switch_thread(void *priv)
+{
+    net_switch_t  *sw   = (net_switch_t *) priv;
+    switch_port_t *port = &sw->shm->ports[sw->port];
+    switch_slot_t *slot;
+    uint8_t        bell[16];
+
+    net_switch_log("Switch Network: polling started.\n");
+
+    struct pollfd pfd[NET_EVENT_MAX];
+    pfd[NET_EVENT_STOP].fd     = net_event_get_fd(&sw->stop_event);
+    pfd[NET_EVENT_STOP].events = POLLIN | POLLPRI;
+
+    pfd[NET_EVENT_TX].fd     = net_event_get_fd(&sw->tx_event);
+    pfd[NET_EVENT_TX].events = POLLIN | POLLPRI;
+
+    pfd[NET_EVENT_RX].fd     = sw->bell_fd;
+    pfd[NET_EVENT_RX].events = POLLIN;
+
+    while (1) {
+        /* Receive everything that is waiting in our ring. */
+        while ((slot = net_switch_ring_peek(sw)) != NULL) {
+            memcpy(sw->pkt.data, slot->data, slot->len);
+            sw->pkt.len = slot->len;
+            net_switch_ring_next(sw);
+            network_rx_put_pkt(sw->card, &sw->pkt);
+        }
+
+        /* Tell the senders to ring the doorbell, then check once more for
+           anything that came in before they could see that. If something
+           did, only look at the events without sleeping, so that a busy
+           ring cannot hold back our own packets or the stop request. */
+        atomic_store(&port->waiting, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (poll(pfd, NET_EVENT_MAX, (net_switch_ring_peek(sw) == NULL) ? -1 : 0) < 0)
+            pfd[NET_EVENT_STOP].revents = pfd[NET_EVENT_TX].revents = pfd[NET_EVENT_RX].revents = 0;
+        atomic_store(&port->waiting, 0);
+
+        if (pfd[NET_EVENT_STOP].revents & POLLIN) {
+            net_event_clear(&sw->stop_event);
+            break;
+        }
+
+        if (pfd[NET_EVENT_TX].revents & POLLIN) {
+            net_event_clear(&sw->tx_event);
+
+            /* The queue can hold more than one batch. */
+            int packets;
+            while ((packets = network_tx_popv(sw->card, sw->pktv, SWITCH_PKT_BATCH)) > 0) {
+                for (int i = 0; i < packets; i++)
+                    net_switch_tx(sw, &sw->pktv[i]);
+            }
+        }
+
+        if (pfd[NET_EVENT_RX].revents & POLLIN) {
+            while (recv(sw->bell_fd, bell, sizeof(bell), 0) > 0)
+                ;
+        }
+    }
+
+    net_switch_log("Switch Network: polling stopped.\n");
+}
+
+static void
+net_switch_error(char *errbuf, const char *fmt, const char *arg)
+{
+    snprintf(errbuf, NET_DRV_ERRBUF_SIZE, fmt, arg, strerror(errno));
+    net_switch_log("Switch Network: %s\n", errbuf);
+}
+
+/* Open the switch with the given name, creating it if needed. */
+static switch_shm_t *
+net_switch_open(const char *name, char *errbuf)
+{
+    char          shm_name[32];
+    struct stat   st;
+    switch_shm_t *shm;
+    uint32_t      magic = 0;
+    int           fd;
+
+    net_switch_shm_name(shm_name, sizeof(shm_name), name);
+    if ((fd = shm_open(shm_name, O_RDWR | O_CREAT, 0600)) < 0) {
+        net_switch_error(errbuf, "Unable to open switch %s (%s)", name);
+        return NULL;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        net_switch_error(errbuf, "Unable to open switch %s (%s)", name);
+        close(fd);
+        return NULL;
+    }
+
+    /* Several processes may get here at the same time for a new switch, but
+       they all set the same size. */
+    if ((st.st_size == 0) && (ftruncate(fd, sizeof(switch_shm_t)) < 0)) {
+        net_switch_error(errbuf, "Unable to create switch %s (%s)", name);
+        close(fd);
+        return NULL;
+    }
+
+    if ((st.st_size != 0) && (st.st_size != sizeof(switch_shm_t))) {
+        errno = EINVAL;
+        net_switch_error(errbuf, "Switch %s was created by an incompatible version (%s)", name);
+        close(fd);
+        return NULL;
+    }
+
+    shm = mmap(NULL, sizeof(switch_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shm == MAP_FAILED) {
+        net_switch_error(errbuf, "Unable to map switch %s (%s)", name);
+        return NULL;
+    }
+
+    if (!atomic_compare_exchange_strong(&shm->magic, &magic, SWITCH_MAGIC + SWITCH_VERSION) &&
+        (magic != (SWITCH_MAGIC + SWITCH_VERSION))) {
+        errno = EINVAL;
+        net_switch_error(errbuf, "Switch %s was created by an incompatible version (%s)", name);
+        munmap(shm, sizeof(switch_shm_t));
+        return NULL;
+    }
+
+    return shm;
+}
+
+/* Take the first free port, or one whose owner is gone. */
+static int
+net_switch_port_claim(net_switch_t *sw)
+{
+    for (int i = 0; i < SWITCH_PORTS; i++) {
+        switch_port_t *port = &sw->shm->ports[i];
+        int            pid  = atomic_load(&port->pid);
+
+        if (net_switch_port_alive(port))
+            continue;
+
+        if (atomic_compare_exchange_strong(&port->pid, &pid, (int) getpid())) {
+            sw->port = i;
+            if (pid)
+                net_switch_mac_forget(sw);
+            net_switch_ring_drain(sw);
+            atomic_store(&port->waiting, 0);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void *
+net_switch_init(const netcard_t *card, const uint8_t *mac_addr, void *priv, char *netdrv_errbuf)
+{
+    const char        *name = (const char *) priv;
+    struct sockaddr_un addr;
+    net_switch_t      *sw;
+
+    if ((name == NULL) || (name[0] == '\0') || !strcmp(name, "none"))
+        name = "default";
+
+    for (const char *p = name; *p; p++) {
+        if ((p - name) >= SWITCH_NAME_MAX || (!((*p >= 'a') && (*p <= 'z')) && !((*p >= 'A') && (*p <= 'Z')) &&
+                                               !((*p >= '0') && (*p <= '9')) && (*p != '-') && (*p != '_'))) {
+            snprintf(netdrv_errbuf, NET_DRV_ERRBUF_SIZE, "Invalid switch name %s: up to %i letters, digits, - and _ are allowed", name, SWITCH_NAME_MAX);
+            net_switch_log("Switch Network: %s\n", netdrv_errbuf);
+            return NULL;
+        }
+    }
+
+    net_switch_log("Switch Network: attaching to switch %s\n", name);
+
+    sw       = calloc(1, sizeof(net_switch_t));
+    sw->card = (netcard_t *) card;
+    strcpy(sw->name, name);
+    memcpy(sw->mac_addr, mac_addr, sizeof(sw->mac_addr));
+
+    if ((sw->shm = net_switch_open(name, netdrv_errbuf)) == NULL) {
+        free(sw);
+        return NULL;
+    }
+
+    if (!net_switch_port_claim(sw)) {
+        snprintf(netdrv_errbuf, NET_DRV_ERRBUF_SIZE, "Switch %s has no free ports (%i in use)", name, SWITCH_PORTS);
+        net_switch_log("Switch Network: %s\n", netdrv_errbuf);
+        munmap(sw->shm, sizeof(switch_shm_t));
+        free(sw);
+        return NULL;
+    }
+
+    /* Our doorbell, plus an unbound socket to ring everyone else's. */
+    if (!net_switch_bell_path(&addr, name, sw->port)) {
+        errno = ENAMETOOLONG;
+        sw->bell_fd = sw->send_fd = -1;
+    } else {
+        unlink(addr.sun_path);
+        sw->bell_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+        sw->send_fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    }
+    if ((sw->bell_fd < 0) || (sw->send_fd < 0) || (bind(sw->bell_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)) {
+        net_switch_error(netdrv_errbuf, "Unable to create the doorbell socket for switch %s (%s)", name);
+        if (sw->bell_fd >= 0)
+            close(sw->bell_fd);
+        if (sw->send_fd >= 0)
+            close(sw->send_fd);
+        atomic_store(&sw->shm->ports[sw->port].pid, 0);
+        munmap(sw->shm, sizeof(switch_shm_t));
+        free(sw);
+        return NULL;
+    }
+    fcntl(sw->bell_fd, F_SETFL, fcntl(sw->bell_fd, F_GETFL) | O_NONBLOCK);
+    fcntl(sw->send_fd, F_SETFL, fcntl(sw->send_fd, F_GETFL) | O_NONBLOCK);
+
+    /* Nobody rings it before our thread starts waiting. */
+    memcpy(sw->shm->ports[sw->port].bell, addr.sun_path, SWITCH_BELL_MAX);
+
+    net_switch_mac_learn(sw, sw->mac_addr, sw->port);
+
+    net_switch_log("Switch Network: using port %i of switch %s\n", sw->port, name);
+
+    for (int i = 0; i < SWITCH_PKT_BATCH; i++) {
+        sw->pktv[i].data = calloc(1, NET_MAX_FRAME);
+    }
+    sw->pkt.data = calloc(1, NET_MAX_FRAME);
+
+    net_event_init(&sw->tx_event);
+    net_event_init(&sw->stop_event);
+    sw->poll_tid = thread_create(net_switch_thread, sw);
+
+    return sw;
+}
+
+void
+net_switch_in_available(void *priv)
+{
+    net_switch_t *sw = (net_switch_t *) priv;
+    net_event_set(&sw->tx_event);
+}
+
+void
+net_switch_close(void *priv)
+{
+    struct sockaddr_un addr;
+    char               shm_name[32];
+    int                last = 1;
+
+    if (!priv)
+        return;
+
+    net_switch_t *sw = (net_switch_t *) priv;
+
+    net_switch_log("Switch Network: closing.\n");
+
+    /* Tell the thread to finish. */
+    net_event_set(&sw->stop_event);
+
+    net_switch_log("Switch Network: waiting for thread to end...\n");
+    thread_wait(sw->poll_tid);
+    net_switch_log("Switch Network: thread ended\n");
+
+    close(sw->bell_fd);
+    close(sw->send_fd);
+    if (net_switch_bell_path(&addr, sw->name, sw->port))
+        unlink(addr.sun_path);
+
+    net_switch_mac_forget(sw);
+    atomic_store(&sw->shm->ports[sw->port].pid, 0);
+
+    /* Remove the switch once nobody is using it any more. A process that is
+       attaching right now keeps the old one until it closes, which only
+       means that it does not see the processes that attach after it. */
+    for (int i = 0; i < SWITCH_PORTS; i++) {
+        if (net_switch_port_alive(&sw->shm->ports[i]))
+            last = 0;
+    }
+    munmap(sw->shm, sizeof(switch_shm_t));
+    if (last) {
+        net_switch_shm_name(shm_name, sizeof(shm_name), sw->name);
+        shm_unlink(shm_name);
+        net_switch_log("Switch Network: removed switch %s\n", sw->name);
+    }
+
+    for (int i = 0; i < SWITCH_PKT_BATCH; i++) {
+        free(sw->pktv[i].data);
+    }
+    free(sw->pkt.data);
+
+    net_event_close(&sw->tx_event);
+    net_event_close(&sw->stop_event);
+
+    free(sw);
+}
+
+const netdrv_t net_switch_drv = {
+    &net_switch_in_available,
+    &net_switch_init,
+    &net_switch_close,
+    NULL
+};
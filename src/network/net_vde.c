@@ -150,11 +150,14 @@ static void net_vde_thread(void *priv) {
         // There are packets queued to transmit
         if (pfd[NET_EVENT_TX].revents & POLLIN) {
             net_event_clear(&vde->tx_event);
-            int packets = network_tx_popv(vde->card, vde->pktv, VDE_PKT_BATCH);
-            for (int i=0; i<packets; i++) {
-                int nc = f_vde_send(vde->vdeconn, vde->pktv[i].data,vde->pktv[i].len, 0 );
-                if (nc == 0) {
-                    vde_log("VDE: Problem, no bytes sent.\n");
+            // The queue can hold more than one batch
+            int packets;
+            while ((packets = network_tx_popv(vde->card, vde->pktv, VDE_PKT_BATCH)) > 0) {
+                for (int i=0; i<packets; i++) {
+                    int nc = f_vde_send(vde->vdeconn, vde->pktv[i].data,vde->pktv[i].len, 0 );
+                    if (nc == 0) {
+                        vde_log("VDE: Problem, no bytes sent.\n");
+                    }
                 }
             }
         }
@@ -149,6 +149,7 @@ int  network_ndev;
 netdev_t network_devs[NET_HOST_INTF_MAX];
 
 /* Local variables. */
+static netcard_t *net_cards_attached[NET_CARD_MAX];
 
 #if defined     ENABLE_NETWORK_LOG && !defined(_WIN32)
 int             network_do_log = ENABLE_NETWORK_LOG;
@@ -251,6 +252,10 @@ network_init(void)
     }
 #endif
 
+#ifdef HAS_NET_SWITCH
+    network_devmap.has_switch = 1;
+#endif
+
 #if defined ENABLE_NETWORK_LOG && !defined(_WIN32)
     /* Start packet dump. */
     network_dump = fopen("network.pcap", "wb");
@@ -272,25 +277,27 @@ network_init(void)
 }
 
 void
-network_queue_init(netqueue_t *queue)
-{
-    queue->head = queue->tail = 0;
-    for (int i = 0; i < NET_QUEUE_LEN; i++) {
+network_queue_init(netqueue_t *queue, uint32_t size)
+{
+    queue->packets = calloc(size, sizeof(netpkt_t));
+    queue->size    = size;
+    queue->mask    = size - 1;
+    queue->dropped = queue->peak = 0;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    for (uint32_t i = 0; i < size; i++) {
         queue->packets[i].data = calloc(1, NET_MAX_FRAME);
         queue->packets[i].len  = 0;
     }
 }
 
-static bool
-network_queue_full(netqueue_t *queue)
+/* Number of packets in the queue. The head and tail only ever increase (and
+   wrap around), so this is correct even when they wrap. One slot is kept free
+   as before, so a queue of size N holds up to N - 1 packets. */
+static inline uint32_t
+network_queue_count(netqueue_t *queue, uint32_t head, uint32_t tail)
 {
-    return ((queue->head + 1) & NET_QUEUE_LEN_MASK) == queue->tail;
-}
-
-static bool
-network_queue_empty(netqueue_t *queue)
-{
-    return (queue->head == queue->tail);
+    return (head - tail) & queue->mask;
 }
 
 static inline void
@@ -301,24 +308,63 @@ network_swap_packet(netpkt_t *pkt1, netpkt_t *pkt2)
     *pkt1        = tmp;
 }
 
+/* Producer side: returns the slot to fill in, or NULL if the queue is full. */
+static netpkt_t *
+network_queue_put_begin(netqueue_t *queue, uint32_t *head)
+{
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    *head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (network_queue_count(queue, *head, tail) >= queue->mask) {
+        queue->dropped++;
+        return NULL;
+    }
+
+    return &queue->packets[*head];
+}
+
+static void
+network_queue_put_end(netqueue_t *queue, uint32_t head)
+{
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint32_t count;
+
+    head = (head + 1) & queue->mask;
+    atomic_store_explicit(&queue->head, head, memory_order_release);
+
+    count = network_queue_count(queue, head, tail);
+    if (count > queue->peak)
+        queue->peak = count;
+}
+
 int
 network_queue_put(netqueue_t *queue, uint8_t *data, int len)
 {
-    if (len == 0 || len > NET_MAX_FRAME || network_queue_full(queue)) {
+    netpkt_t *pkt;
+    uint32_t  head;
+
+    if (len == 0 || len > NET_MAX_FRAME)
+        return 0;
+
+    if ((pkt = network_queue_put_begin(queue, &head)) == NULL)
         return 0;
-    }
 
-    netpkt_t *pkt = &queue->packets[queue->head];
     memcpy(pkt->data, data, len);
-    pkt->len    = len;
-    queue->head = (queue->head + 1) & NET_QUEUE_LEN_MASK;
+    pkt->len = len;
+    network_queue_put_end(queue, head);
     return 1;
 }
 
 int
 network_queue_put_swap(netqueue_t *queue, netpkt_t *src_pkt)
 {
-    if (src_pkt->len == 0 || src_pkt->len > NET_MAX_FRAME || network_queue_full(queue)) {
+    netpkt_t *dst_pkt = NULL;
+    uint32_t  head;
+
+    if (src_pkt->len != 0 && src_pkt->len <= NET_MAX_FRAME)
+        dst_pkt = network_queue_put_begin(queue, &head);
+
+    if (dst_pkt == NULL) {
 #ifdef DEBUG
         if (src_pkt->len == 0) {
             network_log("Discarded zero length packet.\n");
@@ -333,59 +379,88 @@ network_queue_put_swap(netqueue_t *queue, netpkt_t *src_pkt)
         return 0;
     }
 
-    netpkt_t *dst_pkt = &queue->packets[queue->head];
     network_swap_packet(src_pkt, dst_pkt);
-
-    queue->head = (queue->head + 1) & NET_QUEUE_LEN_MASK;
+    network_queue_put_end(queue, head);
     return 1;
 }
 
+/* Consumer side: take up to vec_size packets off the queue in one go, swapping
+   their buffers with the ones in pkt_vec. */
 static int
-network_queue_get_swap(netqueue_t *queue, netpkt_t *dst_pkt)
+network_queue_get_swapv(netqueue_t *queue, netpkt_t *pkt_vec, int vec_size)
 {
-    if (network_queue_empty(queue))
-        return 0;
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint32_t count = network_queue_count(queue, head, tail);
 
-    netpkt_t *src_pkt = &queue->packets[queue->tail];
-    network_swap_packet(src_pkt, dst_pkt);
-    queue->tail = (queue->tail + 1) & NET_QUEUE_LEN_MASK;
-    return 1;
+    if (count > (uint32_t) vec_size)
+        count = vec_size;
+
+    for (uint32_t i = 0; i < count; i++) {
+        network_swap_packet(&queue->packets[tail], &pkt_vec[i]);
+        tail = (tail + 1) & queue->mask;
+    }
+
+    if (count)
+        atomic_store_explicit(&queue->tail, tail, memory_order_release);
+
+    return count;
 }
 
-static int
+/* Move as many packets as will fit from src_q to dst_q. Only used from the
+   emulation thread, which is the consumer of src_q and the producer of dst_q. */
+static uint32_t
 network_queue_move(netqueue_t *dst_q, netqueue_t *src_q)
 {
-    if (network_queue_empty(src_q))
-        return 0;
+    uint32_t src_head = atomic_load_explicit(&src_q->head, memory_order_acquire);
+    uint32_t src_tail = atomic_load_explicit(&src_q->tail, memory_order_relaxed);
+    uint32_t dst_head = atomic_load_explicit(&dst_q->head, memory_order_relaxed);
+    uint32_t dst_tail = atomic_load_explicit(&dst_q->tail, memory_order_acquire);
+    uint32_t count    = network_queue_count(src_q, src_head, src_tail);
+    uint32_t space    = dst_q->mask - network_queue_count(dst_q, dst_head, dst_tail);
+    uint32_t bytes    = 0;
+
+    if (count > space) {
+        count = space;
+        if (count == 0)
+            return 0;
+    }
 
-    if (network_queue_full(dst_q)) {
-        return 0;
+    for (uint32_t i = 0; i < count; i++) {
+        network_swap_packet(&src_q->packets[src_tail], &dst_q->packets[dst_head]);
+        bytes += dst_q->packets[dst_head].len;
+        src_tail = (src_tail + 1) & src_q->mask;
+        dst_head = (dst_head + 1) & dst_q->mask;
     }
 
-    netpkt_t *src_pkt = &src_q->packets[src_q->tail];
-    netpkt_t *dst_pkt = &dst_q->packets[dst_q->head];
+    atomic_store_explicit(&src_q->tail, src_tail, memory_order_release);
+    atomic_store_explicit(&dst_q->head, dst_head, memory_order_release);
 
-    network_swap_packet(src_pkt, dst_pkt);
-    dst_q->head = (dst_q->head + 1) & NET_QUEUE_LEN_MASK;
-    src_q->tail = (src_q->tail + 1) & NET_QUEUE_LEN_MASK;
+    count = network_queue_count(dst_q, dst_head, dst_tail);
+    if (count > dst_q->peak)
+        dst_q->peak = count;
 
-    return dst_pkt->len;
+    return bytes;
 }
 
 void
 network_queue_clear(netqueue_t *queue)
 {
-    for (int i = 0; i < NET_QUEUE_LEN; i++) {
+    for (uint32_t i = 0; i < queue->size; i++) {
         free(queue->packets[i].data);
         queue->packets[i].len = 0;
     }
-    queue->tail = queue->head = 0;
+    free(queue->packets);
+    queue->packets = NULL;
+    atomic_store(&queue->tail, 0);
+    atomic_store(&queue->head, 0);
 }
 
 static void
 network_rx_queue(void *priv)
 {
-    netcard_t *card = (netcard_t *) priv;
+    netcard_t  *card  = (netcard_t *) priv;
+    netqueue_t *queue = &card->queues[NET_QUEUE_RX];
 
     uint32_t new_link_state = net_cards_conf[card->card_num].link_state;
     if (new_link_state != card->link_state) {
@@ -394,34 +469,26 @@ network_rx_queue(void *priv)
         card->link_state = new_link_state;
     }
 
+    /* Hand everything that has arrived so far to the card, straight from the
+       queue, and only release the slots it accepted once done. A packet the
+       card can't take right now stays at the tail of the queue. */
     uint32_t rx_bytes = 0;
-    for (int i = 0; i < NET_QUEUE_LEN; i++) {
-        if (card->queued_pkt.len == 0) {
-            thread_wait_mutex(card->rx_mutex);
-            int res = network_queue_get_swap(&card->queues[NET_QUEUE_RX], &card->queued_pkt);
-            thread_release_mutex(card->rx_mutex);
-            if (!res)
-                break;
-        }
+    uint32_t head     = atomic_load_explicit(&queue->head, memory_order_acquire);
+    uint32_t tail     = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    while (tail != head) {
+        netpkt_t *pkt = &queue->packets[tail];
 
-        network_dump_packet(&card->queued_pkt);
-        int res = card->rx(card->card_drv, card->queued_pkt.data, card->queued_pkt.len);
+        network_dump_packet(pkt);
+        int res = card->rx(card->card_drv, pkt->data, pkt->len);
         if (!res)
             break;
-        rx_bytes += card->queued_pkt.len;
-        card->queued_pkt.len = 0;
+        rx_bytes += pkt->len;
+        tail = (tail + 1) & queue->mask;
     }
+    atomic_store_explicit(&queue->tail, tail, memory_order_release);
 
     /* Transmission. */
-    uint32_t tx_bytes = 0;
-    thread_wait_mutex(card->tx_mutex);
-    for (int i = 0; i < NET_QUEUE_LEN; i++) {
-        uint32_t bytes = network_queue_move(&card->queues[NET_QUEUE_TX_HOST], &card->queues[NET_QUEUE_TX_VM]);
-        if (!bytes)
-            break;
-        tx_bytes += bytes;
-    }
-    thread_release_mutex(card->tx_mutex);
+    uint32_t tx_bytes = network_queue_move(&card->queues[NET_QUEUE_TX_HOST], &card->queues[NET_QUEUE_TX_VM]);
     if (tx_bytes) {
         /* Notify host that a packet is available in the TX queue */
         card->host_drv.notify_in(card->host_drv.priv);
@@ -441,6 +508,20 @@ network_rx_queue(void *priv)
     }
 
     card->led_timer += timer_period;
+
+    /* Report packets dropped for lack of queue space, at most once per
+       second, as a hint to raise the queue length. */
+    card->stats_timer += timer_period;
+    if (card->stats_timer >= 1000000) {
+        netcard_stats_t stats;
+
+        card->stats_timer = 0;
+        if (network_get_stats(card->card_num, &stats) && ((stats.rx_dropped + stats.tx_dropped) != card->stats_dropped)) {
+            pclog("NETWORK: card %i: %u RX and %u TX packets dropped so far, queue length %u, RX peak %u, TX peak %u\n",
+                  card->card_num + 1, stats.rx_dropped, stats.tx_dropped, stats.queue_len, stats.rx_peak, stats.tx_peak);
+            card->stats_dropped = stats.rx_dropped + stats.tx_dropped;
+        }
+    }
 }
 
 /*
@@ -455,11 +536,10 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
 {
     netcard_t *card       = calloc(1, sizeof(netcard_t));
     int net_type          = net_cards_conf[net_card_current].net_type;
-    card->queued_pkt.data = calloc(1, NET_MAX_FRAME);
+    uint32_t queue_len    = NET_QUEUE_LEN;
     card->card_drv        = card_drv;
     card->rx              = rx;
     card->set_link_state  = set_link_state;
-    card->tx_mutex        = thread_create_mutex();
     card->rx_mutex        = thread_create_mutex();
     card->card_num        = net_card_current;
     card->byte_period     = NET_PERIOD_10M;
@@ -467,8 +547,13 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
     char net_drv_error[NET_DRV_ERRBUF_SIZE];
     wchar_t tempmsg[NET_DRV_ERRBUF_SIZE * 2];
 
+    /* Round the configured queue length up to a power of 2. */
+    if (net_cards_conf[net_card_current].queue_len <= 0)
+        net_cards_conf[net_card_current].queue_len = NET_QUEUE_LEN_DEF;
+    while ((queue_len < NET_QUEUE_LEN_MAX) && (queue_len < (uint32_t) net_cards_conf[net_card_current].queue_len))
+        queue_len <<= 1;
     for (int i = 0; i < NET_QUEUE_COUNT; i++) {
-        network_queue_init(&card->queues[i]);
+        network_queue_init(&card->queues[i], queue_len);
     }
 
     if (!strcmp(network_card_get_internal_name(net_cards_conf[net_card_current].device_num), "modem") && net_type >= NET_TYPE_PCAP) {
@@ -491,6 +576,12 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
             card->host_drv      = net_vde_drv;
             card->host_drv.priv = card->host_drv.init(card, mac, net_cards_conf[net_card_current].host_dev_name, net_drv_error);
             break;
+#endif
+#ifdef HAS_NET_SWITCH
+        case NET_TYPE_SWITCH:
+            card->host_drv      = net_switch_drv;
+            card->host_drv.priv = card->host_drv.init(card, mac, net_cards_conf[net_card_current].host_dev_name, net_drv_error);
+            break;
 #endif
         default:
             card->host_drv.priv = NULL;
@@ -519,13 +610,11 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
         // If null fails, something is very wrong
         // Clean up and fatal
         if(!card->host_drv.priv) {
-            thread_close_mutex(card->tx_mutex);
             thread_close_mutex(card->rx_mutex);
             for (int i = 0; i < NET_QUEUE_COUNT; i++) {
                 network_queue_clear(&card->queues[i]);
             }
 
-            free(card->queued_pkt.data);
             free(card);
             // Placeholder - insert the error message
             fatal("Error initializing the network device: Null driver initialization failed");
@@ -537,6 +626,8 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
     timer_add(&card->timer, network_rx_queue, card, 0);
     timer_on_auto(&card->timer, 100);
 
+    net_cards_attached[card->card_num] = card;
+
     return card;
 }
 
@@ -546,13 +637,19 @@ netcard_close(netcard_t *card)
     timer_stop(&card->timer);
     card->host_drv.close(card->host_drv.priv);
 
-    thread_close_mutex(card->tx_mutex);
+    network_log("NETWORK: card %i: queue length %u, RX peak %u dropped %u, TX peak %u dropped %u\n",
+                card->card_num + 1, card->queues[NET_QUEUE_RX].size,
+                card->queues[NET_QUEUE_RX].peak, card->queues[NET_QUEUE_RX].dropped,
+                card->queues[NET_QUEUE_TX_VM].peak, card->queues[NET_QUEUE_TX_VM].dropped);
+
+    if (net_cards_attached[card->card_num] == card)
+        net_cards_attached[card->card_num] = NULL;
+
     thread_close_mutex(card->rx_mutex);
     for (int i = 0; i < NET_QUEUE_COUNT; i++) {
         network_queue_clear(&card->queues[i]);
     }
 
-    free(card->queued_pkt.data);
     free(card);
 }
 
@@ -603,36 +700,24 @@ network_tx(netcard_t *card, uint8_t *bufp, int len)
     network_queue_put(&card->queues[NET_QUEUE_TX_VM], bufp, len);
 }
 
+/* The host driver thread is the only consumer of the TX_HOST queue, so
+   these need no locking. */
 int
 network_tx_pop(netcard_t *card, netpkt_t *out_pkt)
 {
-    int ret = 0;
-
-    thread_wait_mutex(card->tx_mutex);
-    ret = network_queue_get_swap(&card->queues[NET_QUEUE_TX_HOST], out_pkt);
-    thread_release_mutex(card->tx_mutex);
-
-    return ret;
+    return network_queue_get_swapv(&card->queues[NET_QUEUE_TX_HOST], out_pkt, 1);
 }
 
 int
 network_tx_popv(netcard_t *card, netpkt_t *pkt_vec, int vec_size)
 {
-    int pkt_count = 0;
-
-    netqueue_t *queue = &card->queues[NET_QUEUE_TX_HOST];
-    thread_wait_mutex(card->tx_mutex);
-    for (int i = 0; i < vec_size; i++) {
-        if (!network_queue_get_swap(queue, pkt_vec))
-            break;
-        pkt_count++;
-        pkt_vec++;
-    }
-    thread_release_mutex(card->tx_mutex);
-
-    return pkt_count;
+    return network_queue_get_swapv(&card->queues[NET_QUEUE_TX_HOST], pkt_vec, vec_size);
 }
 
+/* The RX queue normally has a single producer, the host driver thread, but
+   cards can also loop packets back to themselves from the emulation thread
+   (see the RTL8139), so the producers still take a mutex. The consumer side
+   in network_rx_queue() does not. */
 int
 network_rx_put(netcard_t *card, uint8_t *bufp, int len)
 {
@@ -657,6 +742,35 @@ network_rx_put_pkt(netcard_t *card, netpkt_t *pkt)
     return ret;
 }
 
+/* Queue length, occupancy and drop counters of an attached card, for
+   diagnostics. */
+int
+network_get_stats(int id, netcard_stats_t *stats)
+{
+    netcard_t  *card;
+    netqueue_t *rx_q;
+    netqueue_t *tx_vm_q;
+    netqueue_t *tx_host_q;
+
+    if ((id < 0) || (id >= NET_CARD_MAX) || ((card = net_cards_attached[id]) == NULL))
+        return 0;
+
+    rx_q      = &card->queues[NET_QUEUE_RX];
+    tx_vm_q   = &card->queues[NET_QUEUE_TX_VM];
+    tx_host_q = &card->queues[NET_QUEUE_TX_HOST];
+
+    stats->queue_len  = rx_q->size;
+    stats->rx_queued  = network_queue_count(rx_q, atomic_load(&rx_q->head), atomic_load(&rx_q->tail));
+    stats->rx_peak    = rx_q->peak;
+    stats->rx_dropped = rx_q->dropped;
+    stats->tx_queued  = network_queue_count(tx_vm_q, atomic_load(&tx_vm_q->head), atomic_load(&tx_vm_q->tail)) +
+                        network_queue_count(tx_host_q, atomic_load(&tx_host_q->head), atomic_load(&tx_host_q->tail));
+    stats->tx_peak    = tx_host_q->peak;
+    stats->tx_dropped = tx_vm_q->dropped;
+
+    return 1;
+}
+
 void
 network_connect(int id, int connect)
 {
@@ -218,6 +218,7 @@
  *   USA.
  */
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <string.h>
@@ -236,6 +237,7 @@
 #include <86box/rom.h>
 #include <86box/device.h>
 #include <86box/nvr.h>
+#include <86box/snapshot.h>
 
 /* RTC registers and bit definitions. */
 #define RTC_SECONDS        0
@@ -1190,6 +1192,40 @@ nvr_at_init(const device_t *info)
     return nvr;
 }
 
+static void
+nvr_at_save(void *priv, snapshot_t *s)
+{
+    nvr_t   *nvr   = (nvr_t *) priv;
+    local_t *local = (local_t *) nvr->data;
+
+    snapshot_write(s, nvr->regs, nvr->size);
+    snapshot_write_var(s, nvr->onesec_cnt);
+    snapshot_write_timer(s, &nvr->onesec_time);
+
+    snapshot_write(s, local, offsetof(local_t, lock));
+    snapshot_write(s, local->lock, nvr->size);
+    snapshot_write(s, &local->count, offsetof(local_t, update_timer) - offsetof(local_t, count));
+    snapshot_write_timer(s, &local->update_timer);
+    snapshot_write_timer(s, &local->rtc_timer);
+}
+
+static void
+nvr_at_load(void *priv, snapshot_t *s)
+{
+    nvr_t   *nvr   = (nvr_t *) priv;
+    local_t *local = (local_t *) nvr->data;
+
+    snapshot_read(s, nvr->regs, nvr->size);
+    snapshot_read_var(s, nvr->onesec_cnt);
+    snapshot_read_timer(s, &nvr->onesec_time);
+
+    snapshot_read(s, local, offsetof(local_t, lock));
+    snapshot_read(s, local->lock, nvr->size);
+    snapshot_read(s, &local->count, offsetof(local_t, update_timer) - offsetof(local_t, count));
+    snapshot_read_timer(s, &local->update_timer);
+    snapshot_read_timer(s, &local->rtc_timer);
+}
+
 static void
 nvr_at_close(void *priv)
 {
@@ -1227,7 +1263,9 @@ const device_t at_nvr_old_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t at_nvr_device = {
@@ -1241,7 +1279,9 @@ const device_t at_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t at_mb_nvr_device = {
@@ -1255,7 +1295,9 @@ const device_t at_mb_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t ps_nvr_device = {
@@ -1269,7 +1311,9 @@ const device_t ps_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t amstrad_nvr_device = {
@@ -1283,7 +1327,9 @@ const device_t amstrad_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t ibmat_nvr_device = {
@@ -1297,7 +1343,9 @@ const device_t ibmat_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t piix4_nvr_device = {
@@ -1311,7 +1359,9 @@ const device_t piix4_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t ps_no_nmi_nvr_device = {
@@ -1325,7 +1375,9 @@ const device_t ps_no_nmi_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t amstrad_no_nmi_nvr_device = {
@@ -1339,7 +1391,9 @@ const device_t amstrad_no_nmi_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t ami_1992_nvr_device = {
@@ -1353,7 +1407,9 @@ const device_t ami_1992_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t ami_1994_nvr_device = {
@@ -1367,7 +1423,9 @@ const device_t ami_1994_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t ami_1995_nvr_device = {
@@ -1381,7 +1439,9 @@ const device_t ami_1995_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t via_nvr_device = {
@@ -1395,7 +1455,9 @@ const device_t via_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t p6rp4_nvr_device = {
@@ -1409,7 +1471,9 @@ const device_t p6rp4_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t amstrad_megapc_nvr_device = {
@@ -1423,7 +1487,9 @@ const device_t amstrad_megapc_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
 
 const device_t elt_nvr_device = {
@@ -1437,5 +1503,7 @@ const device_t elt_nvr_device = {
     { .available = NULL },
     .speed_changed = nvr_at_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = nvr_at_save,
+    .load          = nvr_at_load
 };
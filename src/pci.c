@@ -31,6 +31,8 @@
 #include <86box/dma.h>
 #include <86box/pci.h>
 #include <86box/keyboard.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 #include <86box/plat_unused.h>
 
 #define PCI_ENABLED               0x80000000
@@ -936,6 +938,51 @@ pci_slots_clear(void)
     pci_bus_number_to_index_mapping[0] = 0; /* always map bus 0 to index 0 */
 }
 
+/* The cards and their slots are set up by the machine and the devices, so only
+   the configuration mechanism, the bus numbers and the IRQ routing are saved. */
+void
+pci_save(snapshot_t *s)
+{
+    snapshot_write_var(s, pci_flags);
+    snapshot_write_var(s, pci_pmc);
+    snapshot_write_var(s, pci_index);
+    snapshot_write_var(s, pci_func);
+    snapshot_write_var(s, pci_card);
+    snapshot_write_var(s, pci_bus);
+    snapshot_write_var(s, pci_key);
+    snapshot_write_var(s, pci_trc_reg);
+    snapshot_write_var(s, pci_enable);
+    snapshot_write_var(s, pci_bus_number_to_index_mapping);
+    snapshot_write_var(s, pci_irqs);
+    snapshot_write_var(s, pci_irq_level);
+    snapshot_write_var(s, pci_irq_hold);
+    snapshot_write_var(s, pci_mirqs);
+}
+
+void
+pci_load(snapshot_t *s)
+{
+    /* The mechanism may have been switched, so the ports are set up again. */
+    pci_io_handlers(0);
+
+    snapshot_read_var(s, pci_flags);
+    snapshot_read_var(s, pci_pmc);
+    snapshot_read_var(s, pci_index);
+    snapshot_read_var(s, pci_func);
+    snapshot_read_var(s, pci_card);
+    snapshot_read_var(s, pci_bus);
+    snapshot_read_var(s, pci_key);
+    snapshot_read_var(s, pci_trc_reg);
+    snapshot_read_var(s, pci_enable);
+    snapshot_read_var(s, pci_bus_number_to_index_mapping);
+    snapshot_read_var(s, pci_irqs);
+    snapshot_read_var(s, pci_irq_level);
+    snapshot_read_var(s, pci_irq_hold);
+    snapshot_read_var(s, pci_mirqs);
+
+    pci_io_handlers(1);
+}
+
 void
 pci_init(int flags)
 {
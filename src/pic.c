@@ -18,6 +18,7 @@
  *          Copyright 2016-2020 Miran Grca.
  */
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -32,6 +33,7 @@
 #include <86box/pci.h>
 #include <86box/pic.h>
 #include <86box/timer.h>
+#include <86box/snapshot.h>
 #include <86box/pit.h>
 #include <86box/device.h>
 #include <86box/apm.h>
@@ -279,6 +281,32 @@ pic_reset(void)
     pic_pci = 0;
 }
 
+/* The slave pointers and the ELCR, PCI and shadow settings are made by the
+   machine and chipset, so only the registers and lines are saved. */
+void
+pic_save(snapshot_t *s)
+{
+    snapshot_write(s, &pic, offsetof(pic_t, slaves));
+    snapshot_write(s, &pic2, offsetof(pic_t, slaves));
+    snapshot_write_var(s, smi_irq_mask);
+    snapshot_write_var(s, smi_irq_status);
+    snapshot_write_var(s, latched_irqs);
+    snapshot_write_timer(s, &pic_timer);
+}
+
+void
+pic_load(snapshot_t *s)
+{
+    snapshot_read(s, &pic, offsetof(pic_t, slaves));
+    snapshot_read(s, &pic2, offsetof(pic_t, slaves));
+    snapshot_read_var(s, smi_irq_mask);
+    snapshot_read_var(s, smi_irq_status);
+    snapshot_read_var(s, latched_irqs);
+    snapshot_read_timer(s, &pic_timer);
+
+    update_pending();
+}
+
 void
 pic_set_shadow(int sh)
 {
@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -36,6 +37,7 @@
 #include <86box/timer.h>
 #include <86box/pit.h>
 #include <86box/pit_fast.h>
+#include <86box/snapshot.h>
 #include <86box/ppi.h>
 #include <86box/machine.h>
 #include <86box/sound.h>
@@ -912,6 +914,32 @@ pit_speed_changed(void *priv)
     pit_set_pit_const(priv, PITCONST);
 }
 
+static void
+pit_save(void *priv, snapshot_t *s)
+{
+    pit_t *dev = (pit_t *) priv;
+
+    /* The handlers are set up again by the machine, on the hard reset
+       that comes before a load. */
+    for (uint8_t i = 0; i < 3; i++)
+        snapshot_write(s, &dev->counters[i], offsetof(ctr_t, load_func));
+
+    snapshot_write_var(s, dev->ctrl);
+    snapshot_write_timer(s, &dev->callback_timer);
+}
+
+static void
+pit_load(void *priv, snapshot_t *s)
+{
+    pit_t *dev = (pit_t *) priv;
+
+    for (uint8_t i = 0; i < 3; i++)
+        snapshot_read(s, &dev->counters[i], offsetof(ctr_t, load_func));
+
+    snapshot_read_var(s, dev->ctrl);
+    snapshot_read_timer(s, &dev->callback_timer);
+}
+
 static void
 pit_close(void *priv)
 {
@@ -963,7 +991,9 @@ const device_t i8253_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pit_save,
+    .load          = pit_load
 };
 
 const device_t i8253_ext_io_device = {
@@ -977,7 +1007,9 @@ const device_t i8253_ext_io_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pit_save,
+    .load          = pit_load
 };
 
 const device_t i8254_device = {
@@ -991,7 +1023,9 @@ const device_t i8254_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pit_save,
+    .load          = pit_load
 };
 
 const device_t i8254_sec_device = {
@@ -1005,7 +1039,9 @@ const device_t i8254_sec_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pit_save,
+    .load          = pit_load
 };
 
 const device_t i8254_ext_io_device = {
@@ -1019,7 +1055,9 @@ const device_t i8254_ext_io_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pit_save,
+    .load          = pit_load
 };
 
 const device_t i8254_ps2_device = {
@@ -1033,7 +1071,9 @@ const device_t i8254_ps2_device = {
     { .available = NULL },
     .speed_changed = pit_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pit_save,
+    .load          = pit_load
 };
 
 pit_t *
@@ -18,6 +18,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -36,6 +37,7 @@
 #include <86box/timer.h>
 #include <86box/pit.h>
 #include <86box/pit_fast.h>
+#include <86box/snapshot.h>
 #include <86box/ppi.h>
 #include <86box/machine.h>
 #include <86box/sound.h>
@@ -695,6 +697,32 @@ pitf_speed_changed(void *priv)
     pitf_set_pit_const(priv, PITCONST);
 }
 
+static void
+pitf_save(void *priv, snapshot_t *s)
+{
+    pitf_t *dev = (pitf_t *) priv;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        snapshot_write(s, &dev->counters[i], offsetof(ctrf_t, pit_const));
+        snapshot_write_timer(s, &dev->counters[i].timer);
+    }
+
+    snapshot_write_var(s, dev->ctrl);
+}
+
+static void
+pitf_load(void *priv, snapshot_t *s)
+{
+    pitf_t *dev = (pitf_t *) priv;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        snapshot_read(s, &dev->counters[i], offsetof(ctrf_t, pit_const));
+        snapshot_read_timer(s, &dev->counters[i].timer);
+    }
+
+    snapshot_read_var(s, dev->ctrl);
+}
+
 static void
 pitf_close(void *priv)
 {
@@ -754,7 +782,9 @@ const device_t i8253_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pitf_save,
+    .load          = pitf_load
 };
 
 const device_t i8254_fast_device = {
@@ -768,7 +798,9 @@ const device_t i8254_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pitf_save,
+    .load          = pitf_load
 };
 
 const device_t i8254_sec_fast_device = {
@@ -782,7 +814,9 @@ const device_t i8254_sec_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pitf_save,
+    .load          = pitf_load
 };
 
 const device_t i8254_ext_io_fast_device = {
@@ -796,7 +830,9 @@ const device_t i8254_ext_io_fast_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pitf_save,
+    .load          = pitf_load
 };
 
 const device_t i8254_ps2_fast_device = {
@@ -810,7 +846,9 @@ const device_t i8254_ps2_fast_device = {
     { .available = NULL },
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = pitf_save,
+    .load          = pitf_load
 };
 
 const pit_intf_t pit_fast_intf = {
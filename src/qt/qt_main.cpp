@@ -83,6 +83,8 @@ extern MainWindow   *main_window;
 extern "C" {
 #include <86box/timer.h>
 #include <86box/nvr.h>
+#include <86box/snapshot.h>
+#include <86box/hdd.h>
 extern int qt_nvr_save(void);
 }
 
@@ -348,6 +350,12 @@ main(int argc, char *argv[])
             emit main_window->close();
         });
         QObject::connect(&socket, &UnixManagerSocket::ctrlaltdel, []() { pc_send_cad(); });
+        QObject::connect(&socket, &UnixManagerSocket::snapshot, [](const QString &path) {
+            snapshot_request_save(path.toUtf8().constData());
+        });
+        QObject::connect(&socket, &UnixManagerSocket::hddOverlay, [](int id, int op) {
+            hdd_image_overlay_request(id, op);
+        });
         main_window->installEventFilter(&socket);
         socket.connectToServer(qgetenv("86BOX_MANAGER_SOCKET"));
     }
@@ -955,6 +955,9 @@ MediaMenu::nicUpdateMenu(int i)
         case NET_TYPE_VDE:
             netType = "VDE";
             break;
+        case NET_TYPE_SWITCH:
+            netType = tr("Local Switch");
+            break;
     }
 
     QString devName = DeviceConfig::DeviceName(network_card_getdevice(net_cards_conf[i].device_num), network_card_get_internal_name(net_cards_conf[i].device_num), 1);
@@ -26,6 +26,8 @@ extern "C" {
 
 #include <QStandardItemModel>
 
+#include <memory>
+
 #include "qt_harddiskdialog.hpp"
 #include "qt_harddrive_common.hpp"
 #include "qt_settings_bus_tracking.hpp"
@@ -147,6 +149,10 @@ SettingsHarddisks::~SettingsHarddisks()
 void
 SettingsHarddisks::save()
 {
+    /* Options that are only set in the configuration file follow their image. */
+    auto old_hdd = std::make_unique<hard_disk_t[]>(HDD_NUM);
+    memcpy(old_hdd.get(), hdd, sizeof(hdd));
+
     memset(hdd, 0, sizeof(hdd));
 
     auto *model = ui->tableView->model();
@@ -163,6 +169,14 @@ SettingsHarddisks::save()
         QByteArray fileName = idx.siblingAtColumn(ColumnFilename).data(Qt::UserRole).toString().toUtf8();
         strncpy(hdd[i].fn, fileName.data(), sizeof(hdd[i].fn) - 1);
         hdd[i].priv = nullptr;
+
+        for (int j = 0; j < HDD_NUM; ++j) {
+            if (old_hdd[j].fn[0] && !strcmp(old_hdd[j].fn, hdd[i].fn)) {
+                hdd[i].use_mmap = old_hdd[j].use_mmap;
+                memcpy(hdd[i].overlay, old_hdd[j].overlay, sizeof(hdd[i].overlay));
+                break;
+            }
+        }
     }
 }
 
@@ -19,6 +19,10 @@
 
 #include "qt_unixmanagerfilter.hpp"
 
+extern "C" {
+#include <86box/hdd.h>
+}
+
 UnixManagerSocket::UnixManagerSocket(QObject *obj)
     : QLocalSocket(obj)
 {
@@ -44,6 +48,12 @@ UnixManagerSocket::readyToRead()
                 emit force_shutdown();
             } else if (line == "shutdown") {
                 emit request_shutdown();
+            } else if (line.startsWith("snapshot ")) {
+                emit snapshot(QString::fromUtf8(line.mid(9)));
+            } else if (line.startsWith("hddcommit ")) {
+                emit hddOverlay(line.mid(10).toInt(), HDD_OVERLAY_COMMIT);
+            } else if (line.startsWith("hdddiscard ")) {
+                emit hddOverlay(line.mid(11).toInt(), HDD_OVERLAY_DISCARD);
             }
         }
     }
@@ -40,6 +40,8 @@ signals:
     void request_shutdown();
     void force_shutdown();
     void dialogstatus(bool open);
+    void snapshot(const QString &path);
+    void hddOverlay(int id, int op);
 
 protected:
     bool eventFilter(QObject *obj, QEvent *event) override;
@@ -0,0 +1,534 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Machine snapshot save/restore.
+ *
+ *          A snapshot is a gzip stream holding a header, which names the
+ *          build and the machine it was taken on, and then a list of
+ *          sections, each one made of:
+ *
+ *              uint8_t  type      (core or device)
+ *              uint16_t name length, and the name
+ *              uint32_t index     (device slot, or RAM chunk)
+ *              uint32_t length, and the data
+ *
+ *          The CPU, memory, SMRAM, PCI, PIC and DMA sections are written
+ *          by the core, and there is a section for each device. Every
+ *          device in the machine must have save and load callbacks, or
+ *          the save is refused, naming the devices that lack them; a
+ *          device that is not in a snapshot would be left as the hard
+ *          reset before the load left it. The data in the sections is
+ *          raw emulator state, so a snapshot can only be loaded by the same
+ *          build, on the same machine configuration, that saved it.
+ *
+ *
+ *
+ * Authors: Miran Grca, <mgrca8@gmail.com>
+ *
+ *          Copyright 2024 Miran Grca.
+ */
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <zlib.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/version.h>
+#include "cpu.h"
+#include <86box/device.h>
+#include <86box/machine.h>
+#include <86box/mem.h>
+#include <86box/smram.h>
+#include <86box/dma.h>
+#include <86box/pci.h>
+#include <86box/pic.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
+
+#define SNAPSHOT_MAGIC   "86BXSNAP"
+#define SNAPSHOT_VERSION 1
+
+enum {
+    SNAPSHOT_REQ_NONE = 0,
+    SNAPSHOT_REQ_SAVE,
+    SNAPSHOT_REQ_LOAD
+};
+
+struct snapshot_t {
+    gzFile fp;
+    int    error;
+
+    /* The section being written. */
+    int      type;
+    char     name[256];
+    uint32_t index;
+    uint32_t size;
+    uint32_t written;
+    uint8_t *buf;
+    uint32_t buf_len;
+    uint32_t buf_alloc;
+
+    /* What is left of the section being read. */
+    uint32_t remain;
+};
+
+static char                snapshot_req_path[1024];
+static volatile atomic_int snapshot_req = SNAPSHOT_REQ_NONE;
+
+#ifdef ENABLE_SNAPSHOT_LOG
+int snapshot_do_log = ENABLE_SNAPSHOT_LOG;
+
+static void
+snapshot_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (snapshot_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define snapshot_log(fmt, ...)
+#endif
+
+int
+snapshot_error(snapshot_t *s)
+{
+    return s->error;
+}
+
+void
+snapshot_set_error(snapshot_t *s)
+{
+    s->error = 1;
+}
+
+static void
+snapshot_put(snapshot_t *s, const void *data, uint32_t len)
+{
+    if (s->error || !len)
+        return;
+
+    if (gzwrite(s->fp, data, len) != (int) len)
+        s->error = 1;
+}
+
+static void
+snapshot_get(snapshot_t *s, void *data, uint32_t len)
+{
+    if (s->error || (gzread(s->fp, data, len) != (int) len)) {
+        memset(data, 0x00, len);
+        s->error = 1;
+    }
+}
+
+static void
+snapshot_put_string(snapshot_t *s, const char *str)
+{
+    uint16_t len = (uint16_t) strlen(str);
+
+    snapshot_put(s, &len, sizeof(len));
+    snapshot_put(s, str, len);
+}
+
+static void
+snapshot_get_string(snapshot_t *s, char *str, uint16_t max)
+{
+    uint16_t len;
+
+    snapshot_get(s, &len, sizeof(len));
+    if (len >= max)
+        s->error = 1;
+    if (s->error) {
+        str[0] = 0x00;
+        return;
+    }
+
+    snapshot_get(s, str, len);
+    str[len] = 0x00;
+}
+
+static void
+snapshot_put_section(snapshot_t *s, uint32_t size)
+{
+    uint8_t type = (uint8_t) s->type;
+
+    snapshot_put(s, &type, sizeof(type));
+    snapshot_put_string(s, s->name);
+    snapshot_put(s, &s->index, sizeof(s->index));
+    snapshot_put(s, &size, sizeof(size));
+}
+
+void
+snapshot_section_begin(snapshot_t *s, int type, const char *name, uint32_t index, uint32_t size)
+{
+    s->type    = type;
+    s->index   = index;
+    s->size    = size;
+    s->written = 0;
+    s->buf_len = 0;
+    snprintf(s->name, sizeof(s->name), "%s", name);
+
+    /* Sections of a known size go straight out. */
+    if (size)
+        snapshot_put_section(s, size);
+}
+
+void
+snapshot_section_end(snapshot_t *s)
+{
+    if (s->size) {
+        if (s->written != s->size) {
+            pclog("SNAPSHOT: section '%s' is %u bytes, not %u\n", s->name, s->written, s->size);
+            s->error = 1;
+        }
+    } else {
+        snapshot_put_section(s, s->buf_len);
+        snapshot_put(s, s->buf, s->buf_len);
+    }
+
+    snapshot_log("SNAPSHOT: wrote section '%s' (%u), %u bytes\n", s->name, s->index,
+                 s->size ? s->written : s->buf_len);
+}
+
+void
+snapshot_write(snapshot_t *s, const void *data, uint32_t len)
+{
+    if (s->error)
+        return;
+
+    if (s->size) {
+        s->written += len;
+        snapshot_put(s, data, len);
+        return;
+    }
+
+    if ((s->buf_len + len) > s->buf_alloc) {
+        while ((s->buf_len + len) > s->buf_alloc)
+            s->buf_alloc = s->buf_alloc ? (s->buf_alloc << 1) : 65536;
+        s->buf = (uint8_t *) realloc(s->buf, s->buf_alloc);
+        if (s->buf == NULL)
+            fatal("snapshot_write - out of memory\n");
+    }
+
+    memcpy(&s->buf[s->buf_len], data, len);
+    s->buf_len += len;
+}
+
+void
+snapshot_read(snapshot_t *s, void *data, uint32_t len)
+{
+    if (len > s->remain) {
+        memset(data, 0x00, len);
+        s->error = 1;
+        return;
+    }
+
+    s->remain -= len;
+    snapshot_get(s, data, len);
+}
+
+void
+snapshot_write_timer(snapshot_t *s, const pc_timer_t *timer)
+{
+    uint64_t rel   = timer->ts.ts64 - (tsc << 32ULL);
+    int      flags = timer->flags & (TIMER_ENABLED | TIMER_SPLIT);
+
+    snapshot_write_var(s, rel);
+    snapshot_write_var(s, flags);
+    snapshot_write_var(s, timer->period);
+}
+
+void
+snapshot_read_timer(snapshot_t *s, pc_timer_t *timer)
+{
+    uint64_t rel;
+    int      flags;
+    double   period;
+
+    snapshot_read_var(s, rel);
+    snapshot_read_var(s, flags);
+    snapshot_read_var(s, period);
+
+    if (s->error)
+        return;
+
+    timer_disable(timer);
+
+    timer->ts.ts64 = (tsc << 32ULL) + rel;
+    timer->period  = period;
+    timer->flags   = (timer->flags & ~TIMER_SPLIT) | (flags & TIMER_SPLIT);
+
+    if (flags & TIMER_ENABLED)
+        timer_enable(timer);
+}
+
+static void
+snapshot_close(snapshot_t *s)
+{
+    if (s->fp != NULL)
+        gzclose(s->fp);
+
+    free(s->buf);
+    free(s);
+}
+
+int
+snapshot_save(const char *fn)
+{
+    snapshot_t *s;
+    uint32_t    val;
+    int         ret;
+
+    if ((ret = device_snapshot_check()) != 0) {
+        pclog("SNAPSHOT: not saving '%s', %i device(s) above have no snapshot support\n", fn, ret);
+        return -1;
+    }
+
+    s = (snapshot_t *) calloc(1, sizeof(snapshot_t));
+    if (s == NULL)
+        return -1;
+
+    /* Most of RAM is either zero or code, so the fastest level is enough. */
+    s->fp = gzopen(fn, "wb1");
+    if (s->fp == NULL) {
+        pclog("SNAPSHOT: unable to create '%s'\n", fn);
+        free(s);
+        return -1;
+    }
+
+    snapshot_put(s, SNAPSHOT_MAGIC, 8);
+    val = SNAPSHOT_VERSION;
+    snapshot_put(s, &val, sizeof(val));
+    snapshot_put_string(s, EMU_VERSION_FULL);
+    snapshot_put_string(s, machine_get_internal_name());
+    snapshot_put_string(s, cpu_f->internal_name);
+    val = cpu;
+    snapshot_put(s, &val, sizeof(val));
+    snapshot_put(s, &mem_size, sizeof(mem_size));
+
+    /* The CPU goes first, as the timers in the other sections are saved
+       relative to its TSC. */
+    snapshot_section_begin(s, SNAPSHOT_SECTION_CORE, "cpu", 0, 0);
+    cpu_save(s);
+    snapshot_section_end(s);
+
+    mem_save(s);
+
+    /* After the memory state, which holds the SMRAM access flags. */
+    snapshot_section_begin(s, SNAPSHOT_SECTION_CORE, "smram", 0, 0);
+    smram_save(s);
+    snapshot_section_end(s);
+
+    if (machine_has_bus(machine, MACHINE_BUS_PCI)) {
+        snapshot_section_begin(s, SNAPSHOT_SECTION_CORE, "pci", 0, 0);
+        pci_save(s);
+        snapshot_section_end(s);
+    }
+
+    snapshot_section_begin(s, SNAPSHOT_SECTION_CORE, "pic", 0, 0);
+    pic_save(s);
+    snapshot_section_end(s);
+
+    snapshot_section_begin(s, SNAPSHOT_SECTION_CORE, "dma", 0, 0);
+    dma_save(s);
+    snapshot_section_end(s);
+
+    device_save_all(s);
+
+    snapshot_section_begin(s, SNAPSHOT_SECTION_CORE, "end", 0, 0);
+    snapshot_section_end(s);
+
+    ret = s->error ? -1 : 0;
+    if ((gzclose(s->fp) != Z_OK) || ret) {
+        pclog("SNAPSHOT: error writing '%s'\n", fn);
+        remove(fn);
+        ret = -1;
+    } else
+        pclog("SNAPSHOT: saved to '%s'\n", fn);
+    s->fp = NULL;
+
+    snapshot_close(s);
+
+    return ret;
+}
+
+static int
+snapshot_check_header(snapshot_t *s)
+{
+    char     str[256];
+    uint32_t val;
+
+    snapshot_get(s, str, 8);
+    if (s->error || memcmp(str, SNAPSHOT_MAGIC, 8)) {
+        pclog("SNAPSHOT: not a snapshot\n");
+        return 0;
+    }
+
+    snapshot_get(s, &val, sizeof(val));
+    if (val != SNAPSHOT_VERSION) {
+        pclog("SNAPSHOT: unsupported version %u\n", val);
+        return 0;
+    }
+
+    snapshot_get_string(s, str, sizeof(str));
+    if (strcmp(str, EMU_VERSION_FULL)) {
+        pclog("SNAPSHOT: saved by %s, this is %s\n", str, EMU_VERSION_FULL);
+        return 0;
+    }
+
+    snapshot_get_string(s, str, sizeof(str));
+    if (strcmp(str, machine_get_internal_name())) {
+        pclog("SNAPSHOT: saved on machine '%s', this is '%s'\n", str, machine_get_internal_name());
+        return 0;
+    }
+
+    snapshot_get_string(s, str, sizeof(str));
+    snapshot_get(s, &val, sizeof(val));
+    if (strcmp(str, cpu_f->internal_name) || (val != (uint32_t) cpu)) {
+        pclog("SNAPSHOT: saved with a different CPU\n");
+        return 0;
+    }
+
+    snapshot_get(s, &val, sizeof(val));
+    if (val != mem_size) {
+        pclog("SNAPSHOT: saved with %u kB of RAM, this machine has %u kB\n", val, mem_size);
+        return 0;
+    }
+
+    return !s->error;
+}
+
+/* Expects a machine that has just been hard reset. */
+int
+snapshot_load(const char *fn)
+{
+    snapshot_t *s;
+    uint8_t     type;
+    int         done = 0;
+
+    s = (snapshot_t *) calloc(1, sizeof(snapshot_t));
+    if (s == NULL)
+        return -1;
+
+    s->fp = gzopen(fn, "rb");
+    if (s->fp == NULL) {
+        pclog("SNAPSHOT: unable to open '%s'\n", fn);
+        free(s);
+        return -1;
+    }
+
+    if (!snapshot_check_header(s))
+        s->error = 1;
+
+    while (!s->error && !done) {
+        snapshot_get(s, &type, sizeof(type));
+        snapshot_get_string(s, s->name, sizeof(s->name));
+        snapshot_get(s, &s->index, sizeof(s->index));
+        snapshot_get(s, &s->remain, sizeof(s->remain));
+        if (s->error)
+            break;
+
+        snapshot_log("SNAPSHOT: reading section '%s' (%u), %u bytes\n", s->name, s->index, s->remain);
+
+        if (type == SNAPSHOT_SECTION_DEVICE)
+            device_load(s, s->index, s->name);
+        else if (!strcmp(s->name, "cpu"))
+            cpu_load(s);
+        else if (!strcmp(s->name, "mem"))
+            mem_load(s);
+        else if (!strcmp(s->name, "ram"))
+            mem_load_ram(s, s->index);
+        else if (!strcmp(s->name, "smram"))
+            smram_load(s);
+        else if (!strcmp(s->name, "pci") && machine_has_bus(machine, MACHINE_BUS_PCI))
+            pci_load(s);
+        else if (!strcmp(s->name, "pic"))
+            pic_load(s);
+        else if (!strcmp(s->name, "dma"))
+            dma_load(s);
+        else if (!strcmp(s->name, "end"))
+            done = 1;
+        else {
+            pclog("SNAPSHOT: unknown section '%s'\n", s->name);
+            s->error = 1;
+        }
+
+        if (s->remain) {
+            pclog("SNAPSHOT: %u bytes left over in section '%s'\n", s->remain, s->name);
+            s->error = 1;
+        }
+    }
+
+    if (s->error || !done) {
+        pclog("SNAPSHOT: error loading '%s'\n", fn);
+        snapshot_close(s);
+        return -1;
+    }
+
+    pclog("SNAPSHOT: loaded '%s'\n", fn);
+    snapshot_close(s);
+
+    return 0;
+}
+
+static void
+snapshot_request(int req, const char *fn)
+{
+    if (atomic_load(&snapshot_req) != SNAPSHOT_REQ_NONE) {
+        pclog("SNAPSHOT: a snapshot is already pending, ignoring '%s'\n", fn);
+        return;
+    }
+
+    snprintf(snapshot_req_path, sizeof(snapshot_req_path), "%s", fn);
+    atomic_store(&snapshot_req, req);
+}
+
+void
+snapshot_request_save(const char *fn)
+{
+    snapshot_request(SNAPSHOT_REQ_SAVE, fn);
+}
+
+void
+snapshot_request_load(const char *fn)
+{
+    snapshot_request(SNAPSHOT_REQ_LOAD, fn);
+}
+
+/* Called by the emulation thread between two blocks of CPU code. */
+void
+snapshot_process(void)
+{
+    int req = atomic_load(&snapshot_req);
+
+    if (req == SNAPSHOT_REQ_NONE)
+        return;
+
+    if (req == SNAPSHOT_REQ_SAVE)
+        (void) snapshot_save(snapshot_req_path);
+    else {
+        /* Load on top of a clean machine, so that devices which are not
+           in the snapshot are in a known state; if the load fails half
+           way through, start the machine over. */
+        pc_reset_hard_close();
+        pc_reset_hard_init();
+        if (snapshot_load(snapshot_req_path)) {
+            pc_reset_hard_close();
+            pc_reset_hard_init();
+        }
+    }
+
+    atomic_store(&snapshot_req, SNAPSHOT_REQ_NONE);
+}
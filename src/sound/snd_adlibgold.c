@@ -16,6 +16,7 @@
 #include <86box/pic.h>
 #include <86box/sound.h>
 #include <86box/snd_opl.h>
+#include <86box/snd_tone.h>
 #include <86box/snd_ym7128.h>
 #include <86box/plat_unused.h>
 
@@ -90,6 +91,10 @@ typedef struct adgold_t {
     int gameport_enabled;
 
     int surround_enabled;
+
+    /* Bass and treble controls, for the sample and the FM paths. */
+    biquad_t tone_samp;
+    biquad_t tone_music;
 } adgold_t;
 
 static int attenuation[0x40];
@@ -149,6 +154,13 @@ static int treble_cut[6] = {
     (int) (0.354 * 16384)  /*-3 dB - filter output is at +6 dB*/
 };
 
+/* The bass and treble controls mix these two filters back into the signal. */
+/* fc=150Hz */
+static const double adgold_lowpass_b[3] = { 0.00009159473951071446, 0.00018318947902142891, 0.00009159473951071446 };
+static const double adgold_lowpass_a[3] = { 1.00000000000000000000, -1.97223372919526560000, 0.97261396931306277000 };
+/* fc=150Hz */
+static const double adgold_highpass_b[3] = { 0.98657437157334349000, -1.97314874314668700000, 0.98657437157334349000 };
+
 void adgold_timer_poll(void *priv);
 void adgold_update(adgold_t *adgold);
 
@@ -778,6 +790,73 @@ adgold_timer_poll(void *priv)
     }
 }
 
+/* Each control either adds one filter output to the signal (boost), or
+   replaces the signal with the other filter output plus some of the signal
+   (cut). The result is a sum of the signal and both filter outputs, and as
+   the filters share their poles, that sum is a single biquad. */
+static void
+adgold_tone_update(const adgold_t *adgold, biquad_t *bq)
+{
+    double x  = 1.0; /* Signal */
+    double lp = 0.0; /* Low pass output */
+    double hp = 0.0; /* High pass output */
+    double b[3];
+
+    if ((adgold->bass == 6) && (adgold->treble == 6)) {
+        biquad_set(bq, 0, NULL, NULL);
+        biquad_set(bq, 1, NULL, NULL);
+        return;
+    }
+
+    if (adgold->bass > 6)
+        lp = bass_attenuation[adgold->bass] / 16384.0;
+    else if (adgold->bass < 6) {
+        x  = bass_cut[adgold->bass] / 16384.0;
+        hp = 1.0;
+    }
+
+    if (adgold->treble > 6)
+        hp += treble_attenuation[adgold->treble] / 16384.0;
+    else if (adgold->treble < 6) {
+        const double cut = treble_cut[adgold->treble] / 16384.0;
+
+        x *= cut;
+        lp = 1.0 + (lp * cut);
+        hp *= cut;
+    }
+
+    for (uint8_t i = 0; i < 3; i++)
+        b[i] = (x * adgold_lowpass_a[i]) + (lp * adgold_lowpass_b[i]) + (hp * adgold_highpass_b[i]);
+
+    biquad_set(bq, 0, b, adgold_lowpass_a);
+    biquad_set(bq, 1, b, adgold_lowpass_a);
+}
+
+static void
+adgold_tone_process(const adgold_t *adgold, biquad_t *bq, const int16_t *adgold_buffer, int32_t *buffer, int len)
+{
+    float out[MUSICBUFLEN * 2];
+
+    /*Output is deliberately halved to avoid clipping*/
+    for (int c = 0; c < len * 2; c += 2) {
+        out[c]     = (float) (((int32_t) adgold_buffer[c] * adgold->vol_l) >> 17);
+        out[c + 1] = (float) (((int32_t) adgold_buffer[c + 1] * adgold->vol_r) >> 17);
+    }
+
+    adgold_tone_update(adgold, bq);
+    biquad_process(bq, out, len);
+
+    for (int c = 0; c < len * 2; c++) {
+        int32_t temp = (int32_t) out[c];
+
+        if (temp < -32768)
+            temp = -32768;
+        if (temp > 32767)
+            temp = 32767;
+        buffer[c] += temp;
+    }
+}
+
 static void
 adgold_get_buffer(int32_t *buffer, int len, void *priv)
 {
@@ -847,46 +926,7 @@ adgold_get_buffer(int32_t *buffer, int len, void *priv)
             break;
     }
 
-    for (c = 0; c < len * 2; c += 2) {
-        int32_t temp;
-        int32_t lowpass;
-        int32_t highpass;
-
-        /*Output is deliberately halved to avoid clipping*/
-        temp     = ((int32_t) adgold_buffer[c] * adgold->vol_l) >> 17;
-        lowpass  = adgold_lowpass_iir(0, 0, temp);
-        highpass = adgold_highpass_iir(0, 0, temp);
-        if (adgold->bass > 6)
-            temp += (lowpass * bass_attenuation[adgold->bass]) >> 14;
-        else if (adgold->bass < 6)
-            temp = highpass + ((temp * bass_cut[adgold->bass]) >> 14);
-        if (adgold->treble > 6)
-            temp += (highpass * treble_attenuation[adgold->treble]) >> 14;
-        else if (adgold->treble < 6)
-            temp = lowpass + ((temp * treble_cut[adgold->treble]) >> 14);
-        if (temp < -32768)
-            temp = -32768;
-        if (temp > 32767)
-            temp = 32767;
-        buffer[c] += temp;
-
-        temp     = ((int32_t) adgold_buffer[c + 1] * adgold->vol_r) >> 17;
-        lowpass  = adgold_lowpass_iir(0, 1, temp);
-        highpass = adgold_highpass_iir(0, 1, temp);
-        if (adgold->bass > 6)
-            temp += (lowpass * bass_attenuation[adgold->bass]) >> 14;
-        else if (adgold->bass < 6)
-            temp = highpass + ((temp * bass_cut[adgold->bass]) >> 14);
-        if (adgold->treble > 6)
-            temp += (highpass * treble_attenuation[adgold->treble]) >> 14;
-        else if (adgold->treble < 6)
-            temp = lowpass + ((temp * treble_cut[adgold->treble]) >> 14);
-        if (temp < -32768)
-            temp = -32768;
-        if (temp > 32767)
-            temp = 32767;
-        buffer[c + 1] += temp;
-    }
+    adgold_tone_process(adgold, &adgold->tone_samp, adgold_buffer, buffer, len);
 
     adgold->pos = 0;
 
@@ -963,46 +1003,7 @@ adgold_get_music_buffer(int32_t *buffer, int len, void *priv)
             break;
     }
 
-    for (c = 0; c < len * 2; c += 2) {
-        int32_t temp;
-        int32_t lowpass;
-        int32_t highpass;
-
-        /*Output is deliberately halved to avoid clipping*/
-        temp     = ((int32_t) adgold_buffer[c] * adgold->vol_l) >> 17;
-        lowpass  = adgold_lowpass_iir(1, 0, temp);
-        highpass = adgold_highpass_iir(1, 0, temp);
-        if (adgold->bass > 6)
-            temp += (lowpass * bass_attenuation[adgold->bass]) >> 14;
-        else if (adgold->bass < 6)
-            temp = highpass + ((temp * bass_cut[adgold->bass]) >> 14);
-        if (adgold->treble > 6)
-            temp += (highpass * treble_attenuation[adgold->treble]) >> 14;
-        else if (adgold->treble < 6)
-            temp = lowpass + ((temp * treble_cut[adgold->treble]) >> 14);
-        if (temp < -32768)
-            temp = -32768;
-        if (temp > 32767)
-            temp = 32767;
-        buffer[c] += temp;
-
-        temp     = ((int32_t) adgold_buffer[c + 1] * adgold->vol_r) >> 17;
-        lowpass  = adgold_lowpass_iir(1, 1, temp);
-        highpass = adgold_highpass_iir(1, 1, temp);
-        if (adgold->bass > 6)
-            temp += (lowpass * bass_attenuation[adgold->bass]) >> 14;
-        else if (adgold->bass < 6)
-            temp = highpass + ((temp * bass_cut[adgold->bass]) >> 14);
-        if (adgold->treble > 6)
-            temp += (highpass * treble_attenuation[adgold->treble]) >> 14;
-        else if (adgold->treble < 6)
-            temp = lowpass + ((temp * treble_cut[adgold->treble]) >> 14);
-        if (temp < -32768)
-            temp = -32768;
-        if (temp > 32767)
-            temp = 32767;
-        buffer[c + 1] += temp;
-    }
+    adgold_tone_process(adgold, &adgold->tone_music, adgold_buffer, buffer, len);
 
     adgold->opl.reset_buffer(adgold->opl.priv);
 
@@ -55,6 +55,8 @@
 #define WRBUF_DELAY 1
 #define RSM_FRAC    10
 
+#define WRLIST_SIZE 1024
+
 // #define OPL_FREQ FREQ_48000
 #define OPL_FREQ FREQ_49716
 
@@ -176,6 +178,13 @@ typedef struct chip {
     wrbuf_t  wrbuf[WRBUF_SIZE];
 } nuked_t;
 
+/* A register write, stamped with the music buffer position it was made at. */
+typedef struct wrlist_t {
+    uint16_t pos;
+    uint16_t reg;
+    uint8_t  data;
+} wrlist_t;
+
 typedef struct {
     nuked_t opl;
     int8_t  flags;
@@ -184,6 +193,7 @@ typedef struct {
     uint16_t port;
     uint8_t  status;
     uint8_t  timer_ctrl;
+    uint8_t  newm;
     uint16_t timer_count[2];
     uint16_t timer_cur_count[2];
 
@@ -191,6 +201,17 @@ typedef struct {
 
     int     pos;
     int32_t buffer[MUSICBUFLEN * 2];
+
+    /* When the chip is rendered on the sound render thread, the emulation
+       thread only records the register writes of the current music buffer
+       in one list, while the render thread plays the writes of the previous
+       buffer from the other list into render_buffer. */
+    sound_render_job_t *job;
+    int                 wrlist_cur;
+    int                 wrlist_num[2];
+    int                 wrlist_size[2];
+    wrlist_t           *wrlist[2];
+    int32_t             render_buffer[MUSICBUFLEN * 2];
 } nuked_drv_t;
 
 enum {
@@ -1512,6 +1533,59 @@ nuked_drv_set_do_cycles(void *priv, int8_t do_cycles)
         dev->flags &= ~FLAG_CYCLES;
 }
 
+static void
+nuked_drv_generate(nuked_drv_t *dev, int32_t *buffer, int start, int end)
+{
+    if (start >= end)
+        return;
+
+    nuked_generate_stream(&dev->opl, &buffer[start * 2], end - start);
+
+    for (int c = start * 2; c < end * 2; c++)
+        buffer[c] /= 2;
+}
+
+/* Runs on the sound render thread: plays the register writes recorded during
+   the previous music buffer into the chip at the positions they were made,
+   generating the samples in between. */
+static void
+nuked_drv_render(void *priv)
+{
+    nuked_drv_t    *dev = (nuked_drv_t *) priv;
+    const wrlist_t *wr  = dev->wrlist[dev->wrlist_cur ^ 1];
+    const int       num = dev->wrlist_num[dev->wrlist_cur ^ 1];
+    int             pos = 0;
+
+    for (int i = 0; i < num; i++) {
+        nuked_drv_generate(dev, dev->render_buffer, pos, wr[i].pos);
+        if (wr[i].pos > pos)
+            pos = wr[i].pos;
+
+        nuked_write_reg_buffered(&dev->opl, wr[i].reg, wr[i].data);
+    }
+
+    nuked_drv_generate(dev, dev->render_buffer, pos, MUSICBUFLEN);
+}
+
+static void
+nuked_drv_record_write(nuked_drv_t *dev, uint16_t reg, uint8_t val)
+{
+    const int cur = dev->wrlist_cur;
+    wrlist_t *wr;
+
+    if (dev->wrlist_num[cur] == dev->wrlist_size[cur]) {
+        dev->wrlist_size[cur] <<= 1;
+        dev->wrlist[cur] = (wrlist_t *) realloc(dev->wrlist[cur], dev->wrlist_size[cur] * sizeof(wrlist_t));
+        if (dev->wrlist[cur] == NULL)
+            fatal("nuked_drv_record_write(): out of memory\n");
+    }
+
+    wr       = &dev->wrlist[cur][dev->wrlist_num[cur]++];
+    wr->pos  = music_pos_global;
+    wr->reg  = reg;
+    wr->data = val;
+}
+
 static void *
 nuked_drv_init(const device_t *info)
 {
@@ -1528,6 +1602,16 @@ nuked_drv_init(const device_t *info)
     timer_add(&dev->timers[0], nuked_timer_1, dev, 0);
     timer_add(&dev->timers[1], nuked_timer_2, dev, 0);
 
+    if (fm_async)
+        dev->job = sound_render_job_add(nuked_drv_render, dev);
+
+    if (dev->job != NULL) {
+        for (uint8_t i = 0; i < 2; i++) {
+            dev->wrlist_size[i] = WRLIST_SIZE;
+            dev->wrlist[i]      = (wrlist_t *) malloc(WRLIST_SIZE * sizeof(wrlist_t));
+        }
+    }
+
     return dev;
 }
 
@@ -1535,6 +1619,14 @@ static void
 nuked_drv_close(void *priv)
 {
     nuked_drv_t *dev = (nuked_drv_t *) priv;
+
+    if (dev->job != NULL) {
+        sound_render_job_close(dev->job);
+
+        free(dev->wrlist[0]);
+        free(dev->wrlist[1]);
+    }
+
     free(dev);
 }
 
@@ -1546,15 +1638,29 @@ nuked_drv_update(void *priv)
     if (dev->pos >= music_pos_global)
         return dev->buffer;
 
-    nuked_generate_stream(&dev->opl,
-                          &dev->buffer[dev->pos * 2],
-                          music_pos_global - dev->pos);
+    if (dev->job != NULL) {
+        /* Only the end of the music buffer matters here, the writes made
+           in it are recorded with their positions. Hand them over to the
+           render thread and return the previous buffer, which it has
+           rendered while the emulation ran through this one. */
+        if (music_pos_global < MUSICBUFLEN)
+            return dev->buffer;
+
+        sound_render_job_wait(dev->job);
+        memcpy(dev->buffer, dev->render_buffer, sizeof(dev->buffer));
 
-    for (; dev->pos < music_pos_global; dev->pos++) {
-        dev->buffer[dev->pos * 2] /= 2;
-        dev->buffer[(dev->pos * 2) + 1] /= 2;
+        dev->wrlist_cur ^= 1;
+        dev->wrlist_num[dev->wrlist_cur] = 0;
+        sound_render_job_submit(dev->job);
+
+        dev->pos = music_pos_global;
+
+        return dev->buffer;
     }
 
+    nuked_drv_generate(dev, dev->buffer, dev->pos, music_pos_global);
+    dev->pos = music_pos_global;
+
     return dev->buffer;
 }
 
@@ -1588,7 +1694,10 @@ nuked_drv_write(uint16_t port, uint8_t val, void *priv)
     nuked_drv_update(dev);
 
     if ((port & 0x0001) == 0x0001) {
-        nuked_write_reg_buffered(&dev->opl, dev->port, val);
+        if (dev->job != NULL)
+            nuked_drv_record_write(dev, dev->port, val);
+        else
+            nuked_write_reg_buffered(&dev->opl, dev->port, val);
 
         switch (dev->port) {
             case 0x002: /* Timer 1 */
@@ -1614,14 +1723,19 @@ nuked_drv_write(uint16_t port, uint8_t val, void *priv)
                 break;
 
             case 0x105:
-                dev->opl.newm = val & 0x01;
+                /* The chip itself is only touched by whoever renders it. */
+                dev->newm = val & 0x01;
+                if (dev->job == NULL)
+                    dev->opl.newm = dev->newm;
                 break;
 
             default:
                 break;
         }
     } else {
-        dev->port = nuked_write_addr(&dev->opl, port, val) & 0x01ff;
+        dev->port = val;
+        if ((port & 0x0002) && ((val == 0x05) || dev->newm))
+            dev->port |= 0x0100;
 
         if (!(dev->flags & FLAG_OPL3))
             dev->port &= 0x00ff;
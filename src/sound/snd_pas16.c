@@ -98,7 +98,6 @@
 #include <86box/86box.h>
 #include <86box/device.h>
 #include <86box/dma.h>
-#include <86box/filters.h>
 #include <86box/plat_unused.h>
 #include <86box/io.h>
 #include <86box/mem.h>
@@ -251,6 +250,15 @@ typedef struct pas16_t {
     t128_t * scsi;
 
     pc_timer_t scsi_timer;
+
+    /* PCM output filter. */
+    fir_t fir;
+
+    /* LMC1982 bass and treble controls, one per output path. */
+    tone_t tone_pcm;
+    tone_t tone_music;
+    tone_t tone_cd;
+    tone_t tone_speaker;
 } pas16_t;
 
 static uint8_t pas16_next = 0;
@@ -489,8 +497,6 @@ enum {
 #define MV508_REG_SB_L          (MV508_MIXER | MV508_SB | MV508_LEFT)
 #define MV508_REG_SB_R          (MV508_MIXER | MV508_SB | MV508_RIGHT)
 
-double low_fir_pas16_coef[SB16_NCoef];
-
 /*
    Also used for the MVA508.
  */
@@ -628,39 +634,11 @@ static const double lmc835_att_05dbstep_7bits[128] = {
                  0.0
 };
 
-static __inline double
-sinc(const double x)
-{
-    return sin(M_PI * x) / (M_PI * x);
-}
-
+/* The PCM output filter cuts off at half the given rate. */
 static void
-recalc_pas16_filter(const int playback_freq)
+recalc_pas16_filter(pas16_t *pas16, const int playback_freq)
 {
-    /* Cutoff frequency = playback / 2 */
-    int          n;
-    const double fC = ((double) playback_freq) / (double) FREQ_96000;
-    double       gain = 0.0;
-
-    for (n = 0; n < SB16_NCoef; n++) {
-        /* Blackman window */
-        const double w = 0.42 - (0.5 * cos((2.0 * n * M_PI) / (double) (SB16_NCoef - 1))) +
-                         (0.08 * cos((4.0 * n * M_PI) / (double) (SB16_NCoef - 1)));
-        /* Sinc filter */
-        const double h = sinc(2.0 * fC * ((double) n - ((double) (SB16_NCoef - 1) / 2.0)));
-
-        /* Create windowed-sinc filter */
-        low_fir_pas16_coef[n] = w * h;
-    }
-
-    low_fir_pas16_coef[(SB16_NCoef - 1) / 2] = 1.0;
-
-    for (n = 0; n < SB16_NCoef; n++)
-        gain += low_fir_pas16_coef[n];
-
-    /* Normalise filter, to produce unity gain */
-    for (n = 0; n < SB16_NCoef; n++)
-        low_fir_pas16_coef[n] /= gain;
+    fir_set_lowpass(&pas16->fir, ((double) playback_freq) / (double) FREQ_96000);
 }
 
 #ifdef ENABLE_PAS16_LOG
@@ -1418,22 +1396,22 @@ pas16_out(uint16_t port, uint8_t val, void *priv)
                         pas16->filter = 0;
                         break;
                     case 0x01:
-                        recalc_pas16_filter(17897);
+                        recalc_pas16_filter(pas16, 17897);
                         break;
                     case 0x02:
-                        recalc_pas16_filter(15909);
+                        recalc_pas16_filter(pas16, 15909);
                         break;
                     case 0x04:
-                        recalc_pas16_filter(2982);
+                        recalc_pas16_filter(pas16, 2982);
                         break;
                     case 0x09:
-                        recalc_pas16_filter(11931);
+                        recalc_pas16_filter(pas16, 11931);
                         break;
                     case 0x11:
-                        recalc_pas16_filter(8948);
+                        recalc_pas16_filter(pas16, 8948);
                         break;
                     case 0x19:
-                        recalc_pas16_filter(5965);
+                        recalc_pas16_filter(pas16, 5965);
                         break;
                 }
             } else
@@ -1935,61 +1913,47 @@ pas16_update(pas16_t *pas16)
     }
 }
 
+/* Run the LMC1982 bass and treble controls over a block of mixed samples and
+   add the result to the output. */
+static void
+pas16_tone_process(tone_t *tone, int bass, int treble, float *out, int32_t *buffer, int len)
+{
+    tone_set_4bits(tone, 0, bass, treble, 6, lmc1982_bass_treble_4bits);
+    tone_set_4bits(tone, 1, bass, treble, 6, lmc1982_bass_treble_4bits);
+    tone_process(tone, out, len);
+
+    for (int c = 0; c < len * 2; c++)
+        buffer[c] += (int32_t) out[c];
+}
+
 void
 pasplus_get_buffer(int32_t *buffer, int len, void *priv)
 {
-    pas16_t *          pas16   = (pas16_t *) priv;
-    const nsc_mixer_t *mixer   = &pas16->nsc_mixer;
-    double             bass_treble;
+    pas16_t *          pas16    = (pas16_t *) priv;
+    const nsc_mixer_t *mixer    = &pas16->nsc_mixer;
+    const float        master_l = (float) mixer->master_l;
+    const float        master_r = (float) mixer->master_r;
+    const float        pcm_l    = (float) mixer->pcm_l;
+    const float        pcm_r    = (float) mixer->pcm_r;
+    float              out[SOUNDBUFLEN * 2];
 
     sb_dsp_update(&pas16->dsp);
     pas16_update(pas16);
     for (int c = 0; c < len * 2; c += 2) {
-        double out_l = pas16->dsp.buffer[c];
-        double out_r = pas16->dsp.buffer[c + 1];
-
-        if (pas16->filter) {
-            /* We divide by 3 to get the volume down to normal. */
-            out_l += low_fir_pas16(0, (double) pas16->pcm_buffer[0][c >> 1]) * mixer->pcm_l;
-            out_r += low_fir_pas16(1, (double) pas16->pcm_buffer[1][c >> 1]) * mixer->pcm_r;
-        } else {
-            out_l += ((double) pas16->pcm_buffer[0][c >> 1]) * mixer->pcm_l;
-            out_r += ((double) pas16->pcm_buffer[1][c >> 1]) * mixer->pcm_r;
-        }
-
-        out_l *= mixer->master_l;
-        out_r *= mixer->master_r;
-
-        /* This is not exactly how one does bass/treble controls, but the end result is like it.
-           A better implementation would reduce the CPU usage. */
-        if (mixer->bass != 6) {
-            bass_treble = lmc1982_bass_treble_4bits[mixer->bass];
-
-            if (mixer->bass > 6) {
-                out_l += (low_iir(0, 0, out_l) * bass_treble);
-                out_r += (low_iir(0, 1, out_r) * bass_treble);
-            } else if (mixer->bass < 6) {
-                out_l = (out_l *bass_treble + low_cut_iir(0, 0, out_l) * (1.0 - bass_treble));
-                out_r = (out_r *bass_treble + low_cut_iir(0, 1, out_r) * (1.0 - bass_treble));
-            }
-        }
+        out[c]     = ((float) pas16->pcm_buffer[0][c >> 1]) * pcm_l;
+        out[c + 1] = ((float) pas16->pcm_buffer[1][c >> 1]) * pcm_r;
+    }
 
-        if (mixer->treble != 6) {
-            bass_treble = lmc1982_bass_treble_4bits[mixer->treble];
+    if (pas16->filter)
+        fir_process(&pas16->fir, out, len);
 
-            if (mixer->treble > 6) {
-                out_l += (high_iir(0, 0, out_l) * bass_treble);
-                out_r += (high_iir(0, 1, out_r) * bass_treble);
-            } else if (mixer->treble < 6) {
-                out_l = (out_l *bass_treble + high_cut_iir(0, 0, out_l) * (1.0 - bass_treble));
-                out_r = (out_r *bass_treble + high_cut_iir(0, 1, out_r) * (1.0 - bass_treble));
-            }
-        }
-
-        buffer[c] += (int32_t) out_l;
-        buffer[c + 1] += (int32_t) out_r;
+    for (int c = 0; c < len * 2; c += 2) {
+        out[c]     = (out[c] + (float) pas16->dsp.buffer[c]) * master_l;
+        out[c + 1] = (out[c + 1] + (float) pas16->dsp.buffer[c + 1]) * master_r;
     }
 
+    pas16_tone_process(&pas16->tone_pcm, mixer->bass, mixer->treble, out, buffer, len);
+
     pas16->pos = 0;
     pas16->dsp.pos = 0;
 }
@@ -1997,177 +1961,81 @@ pasplus_get_buffer(int32_t *buffer, int len, void *priv)
 void
 pasplus_get_music_buffer(int32_t *buffer, int len, void *priv)
 {
-    const pas16_t *    pas16   = (const pas16_t *) priv;
+    pas16_t *          pas16   = (pas16_t *) priv;
     const nsc_mixer_t *mixer   = &pas16->nsc_mixer;
     const int32_t *    opl_buf = pas16->opl.update(pas16->opl.priv);
-    double             bass_treble;
+    /* TODO: recording CD, Mic with AGC or line in. Note: mic volume does not affect recording. */
+    const float        gain_l  = (float) (mixer->fm_l * 0.7171630859375 * mixer->master_l);
+    const float        gain_r  = (float) (mixer->fm_r * 0.7171630859375 * mixer->master_r);
+    float              out[MUSICBUFLEN * 2];
 
     for (int c = 0; c < len * 2; c += 2) {
-        double out_l = (((double) opl_buf[c]) * mixer->fm_l) * 0.7171630859375;
-        double out_r = (((double) opl_buf[c + 1]) * mixer->fm_r) * 0.7171630859375;
-
-        /* TODO: recording CD, Mic with AGC or line in. Note: mic volume does not affect recording. */
-        out_l *= mixer->master_l;
-        out_r *= mixer->master_r;
-
-        /* This is not exactly how one does bass/treble controls, but the end result is like it.
-           A better implementation would reduce the CPU usage. */
-        if (mixer->bass != 6) {
-            bass_treble = lmc1982_bass_treble_4bits[mixer->bass];
-
-            if (mixer->bass > 6) {
-                out_l += (low_iir(1, 0, out_l) * bass_treble);
-                out_r += (low_iir(1, 1, out_r) * bass_treble);
-            } else if (mixer->bass < 6) {
-                out_l = (out_l *bass_treble + low_cut_iir(1, 0, out_l) * (1.0 - bass_treble));
-                out_r = (out_r *bass_treble + low_cut_iir(1, 1, out_r) * (1.0 - bass_treble));
-            }
-        }
-
-        if (mixer->treble != 6) {
-            bass_treble = lmc1982_bass_treble_4bits[mixer->treble];
-
-            if (mixer->treble > 6) {
-                out_l += (high_iir(1, 0, out_l) * bass_treble);
-                out_r += (high_iir(1, 1, out_r) * bass_treble);
-            } else if (mixer->treble < 6) {
-                out_l = (out_l *bass_treble + high_cut_iir(1, 0, out_l) * (1.0 - bass_treble));
-                out_r = (out_r *bass_treble + high_cut_iir(1, 1, out_r) * (1.0 - bass_treble));
-            }
-        }
-
-        buffer[c] += (int32_t) out_l;
-        buffer[c + 1] += (int32_t) out_r;
+        out[c]     = ((float) opl_buf[c]) * gain_l;
+        out[c + 1] = ((float) opl_buf[c + 1]) * gain_r;
     }
 
+    pas16_tone_process(&pas16->tone_music, mixer->bass, mixer->treble, out, buffer, len);
+
     pas16->opl.reset_buffer(pas16->opl.priv);
 }
 
 void
 pasplus_filter_cd_audio(int channel, double *buffer, void *priv)
 {
-    const pas16_t *    pas16  = (const pas16_t *) priv;
+    pas16_t *          pas16  = (pas16_t *) priv;
     const nsc_mixer_t *mixer  = &pas16->nsc_mixer;
     const double       cd     = channel ? mixer->cd_r : mixer->cd_l;
     const double       master = channel ? mixer->master_r : mixer->master_l;
-    const int32_t      bass   = mixer->bass;
-    const int32_t      treble = mixer->treble;
-    double             c      = (*buffer) * cd * master;
-    double             bass_treble;
-
-    /* This is not exactly how one does bass/treble controls, but the end result is like it.
-       A better implementation would reduce the CPU usage. */
-    if (bass != 6) {
-        bass_treble = lmc1982_bass_treble_4bits[bass];
-
-        if (bass > 6)
-            c += (low_iir(2, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + low_cut_iir(2, channel, c) * (1.0 - bass_treble));
-    }
+    const double       c      = (*buffer) * cd * master;
 
-    if (treble != 6) {
-        bass_treble = lmc1982_bass_treble_4bits[treble];
-
-        if (treble > 6)
-            c += (high_iir(2, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + high_cut_iir(2, channel, c) * (1.0 - bass_treble));
-    }
-
-    *buffer = c;
+    tone_set_4bits(&pas16->tone_cd, channel, mixer->bass, mixer->treble, 6, lmc1982_bass_treble_4bits);
+    *buffer = tone_process_sample(&pas16->tone_cd, channel, (float) c);
 }
 
 void
 pasplus_filter_pc_speaker(int channel, double *buffer, void *priv)
 {
-    const pas16_t *    pas16  =  (pas16_t *) priv;
+    pas16_t *          pas16  = (pas16_t *) priv;
     const nsc_mixer_t *mixer  = &pas16->nsc_mixer;
     const double       spk    = channel ? mixer->speaker_r : mixer->speaker_l;
     const double       master = channel ? mixer->master_r : mixer->master_l;
-    const int32_t      bass   = mixer->bass;
-    const int32_t      treble = mixer->treble;
-    double             c      = (*buffer) * spk * master;
-    double             bass_treble;
-
-    /* This is not exactly how one does bass/treble controls, but the end result is like it.
-       A better implementation would reduce the CPU usage. */
-    if (bass != 6) {
-        bass_treble = lmc1982_bass_treble_4bits[bass];
-
-        if (bass > 6)
-            c += (low_iir(3, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + low_cut_iir(3, channel, c) * (1.0 - bass_treble));
-    }
-
-    if (treble != 6) {
-        bass_treble = lmc1982_bass_treble_4bits[treble];
+    const double       c      = (*buffer) * spk * master;
 
-        if (treble > 6)
-            c += (high_iir(3, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + high_cut_iir(3, channel, c) * (1.0 - bass_treble));
-    }
-
-    *buffer = c;
+    tone_set_4bits(&pas16->tone_speaker, channel, mixer->bass, mixer->treble, 6, lmc1982_bass_treble_4bits);
+    *buffer = tone_process_sample(&pas16->tone_speaker, channel, (float) c);
 }
 
 void
 pas16_get_buffer(int32_t *buffer, int len, void *priv)
 {
     pas16_t *            pas16 =  (pas16_t *) priv;
-    const mv508_mixer_t *mixer   = &pas16->mv508_mixer;
-    double               bass_treble;
+    const mv508_mixer_t *mixer    = &pas16->mv508_mixer;
+    /* We divide by 3 to get the volume down to normal. */
+    const float          sb_l     = (float) (mixer->sb_l / 3.0);
+    const float          sb_r     = (float) (mixer->sb_r / 3.0);
+    const float          pcm_l    = (float) (mixer->pcm_l / 3.0);
+    const float          pcm_r    = (float) (mixer->pcm_r / 3.0);
+    const float          master_l = (float) mixer->master_l;
+    const float          master_r = (float) mixer->master_r;
+    float                out[SOUNDBUFLEN * 2];
 
     sb_dsp_update(&pas16->dsp);
     pas16_update(pas16);
     for (int c = 0; c < len * 2; c += 2) {
-        double out_l = (pas16->dsp.buffer[c] * mixer->sb_l) / 3.0;
-        double out_r = (pas16->dsp.buffer[c + 1] * mixer->sb_r) / 3.0;
-
-        if (pas16->filter) {
-            /* We divide by 3 to get the volume down to normal. */
-            out_l += (low_fir_pas16(0, (double) pas16->pcm_buffer[0][c >> 1]) * mixer->pcm_l) / 3.0;
-            out_r += (low_fir_pas16(1, (double) pas16->pcm_buffer[1][c >> 1]) * mixer->pcm_r) / 3.0;
-        } else {
-            out_l += (((double) pas16->pcm_buffer[0][c >> 1]) * mixer->pcm_l) / 3.0;
-            out_r += (((double) pas16->pcm_buffer[1][c >> 1]) * mixer->pcm_r) / 3.0;
-        }
-
-        out_l *= mixer->master_l;
-        out_r *= mixer->master_r;
-
-        /* This is not exactly how one does bass/treble controls, but the end result is like it.
-           A better implementation would reduce the CPU usage. */
-        if (mixer->bass != 6) {
-            bass_treble = lmc1982_bass_treble_4bits[mixer->bass];
-
-            if (mixer->bass > 6) {
-                out_l += (low_iir(0, 0, out_l) * bass_treble);
-                out_r += (low_iir(0, 1, out_r) * bass_treble);
-            } else if (mixer->bass < 6) {
-                out_l = (out_l *bass_treble + low_cut_iir(0, 0, out_l) * (1.0 - bass_treble));
-                out_r = (out_r *bass_treble + low_cut_iir(0, 1, out_r) * (1.0 - bass_treble));
-            }
-        }
+        out[c]     = ((float) pas16->pcm_buffer[0][c >> 1]) * pcm_l;
+        out[c + 1] = ((float) pas16->pcm_buffer[1][c >> 1]) * pcm_r;
+    }
 
-        if (mixer->treble != 6) {
-            bass_treble = lmc1982_bass_treble_4bits[mixer->treble];
+    if (pas16->filter)
+        fir_process(&pas16->fir, out, len);
 
-            if (mixer->treble > 6) {
-                out_l += (high_iir(0, 0, out_l) * bass_treble);
-                out_r += (high_iir(0, 1, out_r) * bass_treble);
-            } else if (mixer->treble < 6) {
-                out_l = (out_l *bass_treble + high_cut_iir(0, 0, out_l) * (1.0 - bass_treble));
-                out_r = (out_r *bass_treble + high_cut_iir(0, 1, out_r) * (1.0 - bass_treble));
-            }
-        }
-
-        buffer[c] += (int32_t) out_l;
-        buffer[c + 1] += (int32_t) out_r;
+    for (int c = 0; c < len * 2; c += 2) {
+        out[c]     = (out[c] + (((float) pas16->dsp.buffer[c]) * sb_l)) * master_l;
+        out[c + 1] = (out[c + 1] + (((float) pas16->dsp.buffer[c + 1]) * sb_r)) * master_r;
     }
 
+    pas16_tone_process(&pas16->tone_pcm, mixer->bass, mixer->treble, out, buffer, len);
+
     pas16->pos = 0;
     pas16->dsp.pos = 0;
 }
@@ -2175,120 +2043,48 @@ pas16_get_buffer(int32_t *buffer, int len, void *priv)
 void
 pas16_get_music_buffer(int32_t *buffer, int len, void *priv)
 {
-    const pas16_t *      pas16   = (const pas16_t *) priv;
+    pas16_t *            pas16   = (pas16_t *) priv;
     const mv508_mixer_t *mixer   = &pas16->mv508_mixer;
     const int32_t *      opl_buf = pas16->opl.update(pas16->opl.priv);
-    double               bass_treble;
+    /* TODO: recording CD, Mic with AGC or line in. Note: mic volume does not affect recording. */
+    const float          gain_l  = (float) (mixer->fm_l * 0.7171630859375 * mixer->master_l);
+    const float          gain_r  = (float) (mixer->fm_r * 0.7171630859375 * mixer->master_r);
+    float                out[MUSICBUFLEN * 2];
 
     for (int c = 0; c < len * 2; c += 2) {
-        double out_l = (((double) opl_buf[c]) * mixer->fm_l) * 0.7171630859375;
-        double out_r = (((double) opl_buf[c + 1]) * mixer->fm_r) * 0.7171630859375;
-
-        /* TODO: recording CD, Mic with AGC or line in. Note: mic volume does not affect recording. */
-        out_l *= mixer->master_l;
-        out_r *= mixer->master_r;
-
-        /* This is not exactly how one does bass/treble controls, but the end result is like it.
-           A better implementation would reduce the CPU usage. */
-        if (mixer->bass != 6) {
-            bass_treble = lmc1982_bass_treble_4bits[mixer->bass];
-
-            if (mixer->bass > 6) {
-                out_l += (low_iir(1, 0, out_l) * bass_treble);
-                out_r += (low_iir(1, 1, out_r) * bass_treble);
-            } else if (mixer->bass < 6) {
-                out_l = (out_l *bass_treble + low_cut_iir(1, 0, out_l) * (1.0 - bass_treble));
-                out_r = (out_r *bass_treble + low_cut_iir(1, 1, out_r) * (1.0 - bass_treble));
-            }
-        }
-
-        if (mixer->treble != 6) {
-            bass_treble = lmc1982_bass_treble_4bits[mixer->treble];
-
-            if (mixer->treble > 6) {
-                out_l += (high_iir(1, 0, out_l) * bass_treble);
-                out_r += (high_iir(1, 1, out_r) * bass_treble);
-            } else if (mixer->treble < 6) {
-                out_l = (out_l *bass_treble + high_cut_iir(1, 0, out_l) * (1.0 - bass_treble));
-                out_r = (out_r *bass_treble + high_cut_iir(1, 1, out_r) * (1.0 - bass_treble));
-            }
-        }
-
-        buffer[c] += (int32_t) out_l;
-        buffer[c + 1] += (int32_t) out_r;
+        out[c]     = ((float) opl_buf[c]) * gain_l;
+        out[c + 1] = ((float) opl_buf[c + 1]) * gain_r;
     }
 
+    pas16_tone_process(&pas16->tone_music, mixer->bass, mixer->treble, out, buffer, len);
+
     pas16->opl.reset_buffer(pas16->opl.priv);
 }
 
 void
 pas16_filter_cd_audio(int channel, double *buffer, void *priv)
 {
-    const pas16_t *      pas16  = (const pas16_t *) priv;
+    pas16_t *            pas16  = (pas16_t *) priv;
     const mv508_mixer_t *mixer  = &pas16->mv508_mixer;
     const double         cd     = channel ? mixer->cd_r : mixer->cd_l;
     const double         master = channel ? mixer->master_r : mixer->master_l;
-    const int32_t        bass   = mixer->bass;
-    const int32_t        treble = mixer->treble;
-    double               c      = (((*buffer) * cd) / 3.0) * master;
-    double               bass_treble;
-
-    /* This is not exactly how one does bass/treble controls, but the end result is like it.
-       A better implementation would reduce the CPU usage. */
-    if (bass != 6) {
-        bass_treble = lmc1982_bass_treble_4bits[bass];
-
-        if (bass > 6)
-            c += (low_iir(2, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + low_cut_iir(2, channel, c) * (1.0 - bass_treble));
-    }
+    const double         c      = (((*buffer) * cd) / 3.0) * master;
 
-    if (treble != 6) {
-        bass_treble = lmc1982_bass_treble_4bits[treble];
-
-        if (treble > 6)
-            c += (high_iir(2, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + high_cut_iir(2, channel, c) * (1.0 - bass_treble));
-    }
-
-    *buffer = c;
+    tone_set_4bits(&pas16->tone_cd, channel, mixer->bass, mixer->treble, 6, lmc1982_bass_treble_4bits);
+    *buffer = tone_process_sample(&pas16->tone_cd, channel, (float) c);
 }
 
 void
 pas16_filter_pc_speaker(int channel, double *buffer, void *priv)
 {
-    const pas16_t *      pas16  = (const pas16_t *) priv;
+    pas16_t *            pas16  = (pas16_t *) priv;
     const mv508_mixer_t *mixer  = &pas16->mv508_mixer;
     const double         spk    = channel ? mixer->speaker_r : mixer->speaker_l;
     const double         master = channel ? mixer->master_r : mixer->master_l;
-    const int32_t        bass   = mixer->bass;
-    const int32_t        treble = mixer->treble;
-    double               c      = (((*buffer) * spk) / 3.0) * master;
-    double               bass_treble;
-
-    /* This is not exactly how one does bass/treble controls, but the end result is like it.
-       A better implementation would reduce the CPU usage. */
-    if (bass != 6) {
-        bass_treble = lmc1982_bass_treble_4bits[bass];
-
-        if (bass > 6)
-            c += (low_iir(3, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + low_cut_iir(3, channel, c) * (1.0 - bass_treble));
-    }
-
-    if (treble != 6) {
-        bass_treble = lmc1982_bass_treble_4bits[treble];
-
-        if (treble > 6)
-            c += (high_iir(3, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + high_cut_iir(3, channel, c) * (1.0 - bass_treble));
-    }
+    const double         c      = (((*buffer) * spk) / 3.0) * master;
 
-    *buffer = c;
+    tone_set_4bits(&pas16->tone_speaker, channel, mixer->bass, mixer->treble, 6, lmc1982_bass_treble_4bits);
+    *buffer = tone_process_sample(&pas16->tone_speaker, channel, (float) c);
 }
 
 static void
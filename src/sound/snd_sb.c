@@ -320,72 +320,45 @@ sbpro_filter_cd_audio(int channel, double *buffer, void *priv)
     *buffer = c;
 }
 
+/* Run the CT1745 bass and treble controls over a block of mixed samples and
+   add the result to the output. */
 static void
-sb_get_buffer_sb16_awe32(int32_t *buffer, int len, void *priv)
+sb_ct1745_tone_process(tone_t *tone, const sb_ct1745_mixer_t *mixer, float *out, int32_t *buffer, int len)
 {
-    sb_t                    *sb      = (sb_t *) priv;
-    const sb_ct1745_mixer_t *mixer   = &sb->mixer_sb16;
-    double                   bass_treble;
+    const float gain_l = (float) mixer->output_gain_L;
+    const float gain_r = (float) mixer->output_gain_R;
 
-    sb_dsp_update(&sb->dsp);
+    tone_set_4bits(tone, 0, mixer->bass_l, mixer->treble_l, 8, sb_bass_treble_4bits);
+    tone_set_4bits(tone, 1, mixer->bass_r, mixer->treble_r, 8, sb_bass_treble_4bits);
+    tone_process(tone, out, len);
 
     for (int c = 0; c < len * 2; c += 2) {
-        double out_l = 0.0;
-        double out_r = 0.0;
-
-        if (mixer->output_filter) {
-            /* We divide by 3 to get the volume down to normal. */
-            out_l += (low_fir_sb16(0, 0, (double) sb->dsp.buffer[c]) * mixer->voice_l) / 3.0;
-            out_r += (low_fir_sb16(0, 1, (double) sb->dsp.buffer[c + 1]) * mixer->voice_r) / 3.0;
-        } else {
-            out_l += (((double) sb->dsp.buffer[c]) * mixer->voice_l) / 3.0;
-            out_r += (((double) sb->dsp.buffer[c + 1]) * mixer->voice_r) / 3.0;
-        }
-
-        out_l *= mixer->master_l;
-        out_r *= mixer->master_r;
-
-        /* This is not exactly how one does bass/treble controls, but the end result is like it.
-           A better implementation would reduce the CPU usage. */
-        if (mixer->bass_l != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->bass_l];
-
-            if (mixer->bass_l > 8)
-                out_l += (low_iir(0, 0, out_l) * bass_treble);
-            else
-                out_l = (out_l *bass_treble + low_cut_iir(0, 0, out_l) * (1.0 - bass_treble));
-        }
-
-        if (mixer->bass_r != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->bass_r];
-
-            if (mixer->bass_r > 8)
-                out_r += (low_iir(0, 1, out_r) * bass_treble);
-            else
-                out_r = (out_r *bass_treble + low_cut_iir(0, 1, out_r) * (1.0 - bass_treble));
-        }
+        buffer[c] += (int32_t) (out[c] * gain_l);
+        buffer[c + 1] += (int32_t) (out[c + 1] * gain_r);
+    }
+}
 
-        if (mixer->treble_l != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->treble_l];
+static void
+sb_get_buffer_sb16_awe32(int32_t *buffer, int len, void *priv)
+{
+    sb_t                    *sb     = (sb_t *) priv;
+    const sb_ct1745_mixer_t *mixer  = &sb->mixer_sb16;
+    /* We divide by 3 to get the volume down to normal. */
+    const float              gain_l = (float) ((mixer->voice_l * mixer->master_l) / 3.0);
+    const float              gain_r = (float) ((mixer->voice_r * mixer->master_r) / 3.0);
+    float                    out[SOUNDBUFLEN * 2];
 
-            if (mixer->treble_l > 8)
-                out_l += (high_iir(0, 0, out_l) * bass_treble);
-            else
-                out_l = (out_l *bass_treble + high_cut_iir(0, 0, out_l) * (1.0 - bass_treble));
-        }
+    sb_dsp_update(&sb->dsp);
 
-        if (mixer->treble_r != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->treble_r];
+    for (int c = 0; c < len * 2; c += 2) {
+        out[c]     = ((float) sb->dsp.buffer[c]) * gain_l;
+        out[c + 1] = ((float) sb->dsp.buffer[c + 1]) * gain_r;
+    }
 
-            if (mixer->treble_r > 8)
-                out_r += (high_iir(0, 1, out_r) * bass_treble);
-            else
-                out_r = (out_l *bass_treble + high_cut_iir(0, 1, out_r) * (1.0 - bass_treble));
-        }
+    if (mixer->output_filter)
+        fir_process(&sb->dsp.fir, out, len);
 
-        buffer[c] += (int32_t) (out_l * mixer->output_gain_L);
-        buffer[c + 1] += (int32_t) (out_r * mixer->output_gain_R);
-    }
+    sb_ct1745_tone_process(&sb->tone_dsp, mixer, out, buffer, len);
 
     sb->dsp.pos = 0;
 }
@@ -396,69 +369,32 @@ sb_get_music_buffer_sb16_awe32(int32_t *buffer, const int len, void *priv)
     sb_t                    *sb          = (sb_t *) priv;
     const sb_ct1745_mixer_t *mixer       = &sb->mixer_sb16;
     const int                dsp_rec_pos = sb->dsp.record_pos_write;
-    double                   bass_treble;
+    const float              fm_l        = (float) (mixer->fm_l * 0.7171630859375);
+    const float              fm_r        = (float) (mixer->fm_r * 0.7171630859375);
+    const float              master_l    = (float) mixer->master_l;
+    const float              master_r    = (float) mixer->master_r;
     const int32_t           *opl_buf     = NULL;
+    float                    out[MUSICBUFLEN * 2];
 
     if (sb->opl_enabled)
         opl_buf = sb->opl.update(sb->opl.priv);
 
     for (int c = 0; c < len * 2; c += 2) {
-        double out_l = 0.0;
-        double out_r = 0.0;
+        float out_l = 0.0f;
+        float out_r = 0.0f;
 
         if (sb->opl_enabled) {
-            out_l = ((double) opl_buf[c]) * mixer->fm_l * 0.7171630859375;
-            out_r = ((double) opl_buf[c + 1]) * mixer->fm_r * 0.7171630859375;
-        }
-
-        /* TODO: Multi-recording mic with agc/+20db, CD, and line in with channel inversion */
-        int32_t in_l = (mixer->input_selector_left & INPUT_MIDI_L) ?
-                       ((int32_t) out_l) : 0 + (mixer->input_selector_left & INPUT_MIDI_R) ? ((int32_t) out_r) : 0;
-        int32_t in_r = (mixer->input_selector_right & INPUT_MIDI_L) ?
-                       ((int32_t) out_l) : 0 + (mixer->input_selector_right & INPUT_MIDI_R) ? ((int32_t) out_r) : 0;
-
-        out_l *= mixer->master_l;
-        out_r *= mixer->master_r;
-
-        /* This is not exactly how one does bass/treble controls, but the end result is like it.
-           A better implementation would reduce the CPU usage. */
-        if (mixer->bass_l != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->bass_l];
-
-            if (mixer->bass_l > 8)
-                out_l += (low_iir(1, 0, out_l) * bass_treble);
-            else
-                out_l = (out_l *bass_treble + low_cut_iir(1, 0, out_l) * (1.0 - bass_treble));
-        }
-
-        if (mixer->bass_r != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->bass_r];
-
-            if (mixer->bass_r > 8)
-                out_r += (low_iir(1, 1, out_r) * bass_treble);
-            else
-                out_r = (out_r *bass_treble + low_cut_iir(1, 1, out_r) * (1.0 - bass_treble));
-        }
-
-        if (mixer->treble_l != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->treble_l];
-
-            if (mixer->treble_l > 8)
-                out_l += (high_iir(1, 0, out_l) * bass_treble);
-            else
-                out_l = (out_l *bass_treble + high_cut_iir(1, 0, out_l) * (1.0 - bass_treble));
-        }
-
-        if (mixer->treble_r != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->treble_r];
-
-            if (mixer->treble_r > 8)
-                out_r += (high_iir(1, 1, out_r) * bass_treble);
-            else
-                out_r = (out_l *bass_treble + high_cut_iir(1, 1, out_r) * (1.0 - bass_treble));
+            out_l = ((float) opl_buf[c]) * fm_l;
+            out_r = ((float) opl_buf[c + 1]) * fm_r;
         }
 
         if (sb->dsp.sb_enable_i) {
+            /* TODO: Multi-recording mic with agc/+20db, CD, and line in with channel inversion */
+            int32_t in_l = (mixer->input_selector_left & INPUT_MIDI_L) ?
+                           ((int32_t) out_l) : 0 + (mixer->input_selector_left & INPUT_MIDI_R) ? ((int32_t) out_r) : 0;
+            int32_t in_r = (mixer->input_selector_right & INPUT_MIDI_L) ?
+                           ((int32_t) out_l) : 0 + (mixer->input_selector_right & INPUT_MIDI_R) ? ((int32_t) out_r) : 0;
+
             const int c_record = dsp_rec_pos + ((c * sb->dsp.sb_freq) / MUSIC_FREQ);
 
             in_l <<= mixer->input_gain_L;
@@ -479,10 +415,12 @@ sb_get_music_buffer_sb16_awe32(int32_t *buffer, const int len, void *priv)
             sb->dsp.record_buffer[(c_record + 1) & 0xffff] = (int16_t) in_r;
         }
 
-        buffer[c] += (int32_t) (out_l * mixer->output_gain_L);
-        buffer[c + 1] += (int32_t) (out_r * mixer->output_gain_R);
+        out[c]     = out_l * master_l;
+        out[c + 1] = out_r * master_r;
     }
 
+    sb_ct1745_tone_process(&sb->tone_music, mixer, out, buffer, len);
+
     sb->dsp.record_pos_write += ((len * sb->dsp.sb_freq) / 24000);
     sb->dsp.record_pos_write &= 0xffff;
 
@@ -493,99 +431,38 @@ sb_get_music_buffer_sb16_awe32(int32_t *buffer, const int len, void *priv)
 static void
 sb_get_wavetable_buffer_sb16_awe32(int32_t *buffer, const int len, void *priv)
 {
-    sb_t                    *sb      = (sb_t *) priv;
-    const sb_ct1745_mixer_t *mixer   = &sb->mixer_sb16;
-    double                   bass_treble;
+    sb_t                    *sb     = (sb_t *) priv;
+    const sb_ct1745_mixer_t *mixer  = &sb->mixer_sb16;
+    const float              gain_l = (float) (mixer->fm_l * mixer->master_l);
+    const float              gain_r = (float) (mixer->fm_r * mixer->master_r);
+    float                    out[WTBUFLEN * 2];
 
     emu8k_update(&sb->emu8k);
 
     for (int c = 0; c < len * 2; c += 2) {
-        double out_l = 0.0;
-        double out_r = 0.0;
-
-        out_l += (((double) sb->emu8k.buffer[c]) * mixer->fm_l);
-        out_r += (((double) sb->emu8k.buffer[c + 1]) * mixer->fm_r);
-
-        out_l *= mixer->master_l;
-        out_r *= mixer->master_r;
-
-        /* This is not exactly how one does bass/treble controls, but the end result is like it.
-           A better implementation would reduce the CPU usage. */
-        if (mixer->bass_l != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->bass_l];
-
-            if (mixer->bass_l > 8)
-                out_l += (low_iir(4, 0, out_l) * bass_treble);
-            else
-                out_l = (out_l *bass_treble + low_cut_iir(4, 0, out_l) * (1.0 - bass_treble));
-        }
-
-        if (mixer->bass_r != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->bass_r];
-
-            if (mixer->bass_r > 8)
-                out_r += (low_iir(4, 1, out_r) * bass_treble);
-            else
-                out_r = (out_r *bass_treble + low_cut_iir(4, 1, out_r) * (1.0 - bass_treble));
-        }
-
-        if (mixer->treble_l != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->treble_l];
-
-            if (mixer->treble_l > 8)
-                out_l += (high_iir(4, 0, out_l) * bass_treble);
-            else
-                out_l = (out_l *bass_treble + high_cut_iir(4, 0, out_l) * (1.0 - bass_treble));
-        }
-
-        if (mixer->treble_r != 8) {
-            bass_treble = sb_bass_treble_4bits[mixer->treble_r];
-
-            if (mixer->treble_r > 8)
-                out_r += (high_iir(4, 1, out_r) * bass_treble);
-            else
-                out_r = (out_l *bass_treble + high_cut_iir(4, 1, out_r) * (1.0 - bass_treble));
-        }
-
-        buffer[c] += (int32_t) (out_l * mixer->output_gain_L);
-        buffer[c + 1] += (int32_t) (out_r * mixer->output_gain_R);
+        out[c]     = ((float) sb->emu8k.buffer[c]) * gain_l;
+        out[c + 1] = ((float) sb->emu8k.buffer[c + 1]) * gain_r;
     }
 
+    sb_ct1745_tone_process(&sb->tone_wavetable, mixer, out, buffer, len);
+
     sb->emu8k.pos = 0;
 }
 
 void
 sb16_awe32_filter_cd_audio(int channel, double *buffer, void *priv)
 {
-    const sb_t              *sb          = (sb_t *) priv;
+    sb_t                    *sb          = (sb_t *) priv;
     const sb_ct1745_mixer_t *mixer       = &sb->mixer_sb16;
     const double             cd          = channel ? mixer->cd_r : mixer->cd_l /* / 3.0 */;
     const double             master      = channel ? mixer->master_r : mixer->master_l;
     const int32_t            bass        = channel ? mixer->bass_r : mixer->bass_l;
     const int32_t            treble      = channel ? mixer->treble_r : mixer->treble_l;
     const double             output_gain = (channel ? mixer->output_gain_R : mixer->output_gain_L);
-    double                   bass_treble;
     double                   c           = (((*buffer) * cd) / 3.0) * master;
 
-    /* This is not exactly how one does bass/treble controls, but the end result is like it.
-       A better implementation would reduce the CPU usage. */
-    if (bass != 8) {
-        bass_treble = sb_bass_treble_4bits[bass];
-
-        if (bass > 8)
-            c += (low_iir(2, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + low_cut_iir(2, channel, c) * (1.0 - bass_treble));
-    }
-
-    if (treble != 8) {
-        bass_treble = sb_bass_treble_4bits[treble];
-
-        if (treble > 8)
-            c += (high_iir(2, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + high_cut_iir(2, channel, c) * (1.0 - bass_treble));
-    }
+    tone_set_4bits(&sb->tone_cd, channel, bass, treble, 8, sb_bass_treble_4bits);
+    c = tone_process_sample(&sb->tone_cd, channel, (float) c);
 
     *buffer = c * output_gain;
 }
@@ -593,41 +470,23 @@ sb16_awe32_filter_cd_audio(int channel, double *buffer, void *priv)
 void
 sb16_awe32_filter_pc_speaker(int channel, double *buffer, void *priv)
 {
-    const sb_t              *sb          = (sb_t *) priv;
+    sb_t                    *sb          = (sb_t *) priv;
     const sb_ct1745_mixer_t *mixer       = &sb->mixer_sb16;
     const double             spk         = mixer->speaker;
     const double             master      = channel ? mixer->master_r : mixer->master_l;
     const int32_t            bass        = channel ? mixer->bass_r : mixer->bass_l;
     const int32_t            treble      = channel ? mixer->treble_r : mixer->treble_l;
     const double             output_gain = (channel ? mixer->output_gain_R : mixer->output_gain_L);
-    double                   bass_treble;
     double                   c;
 
     if (mixer->output_filter)
-        c = (low_fir_sb16(3, channel, *buffer) * spk) / 3.0;
+        c = (fir_process_sample(&sb->dsp.fir_speaker, channel, (float) *buffer) * spk) / 3.0;
     else
         c = ((*buffer) * spk) / 3.0;
     c *= master;
 
-    /* This is not exactly how one does bass/treble controls, but the end result is like it.
-       A better implementation would reduce the CPU usage. */
-    if (bass != 8) {
-        bass_treble = sb_bass_treble_4bits[bass];
-
-        if (bass > 8)
-            c += (low_iir(3, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + low_cut_iir(3, channel, c) * (1.0 - bass_treble));
-    }
-
-    if (treble != 8) {
-        bass_treble = sb_bass_treble_4bits[treble];
-
-        if (treble > 8)
-            c += (high_iir(3, channel, c) * bass_treble);
-        else
-            c = (c * bass_treble + high_cut_iir(3, channel, c) * (1.0 - bass_treble));
-    }
+    tone_set_4bits(&sb->tone_speaker, channel, bass, treble, 8, sb_bass_treble_4bits);
+    c = tone_process_sample(&sb->tone_speaker, channel, (float) c);
 
     *buffer = c * output_gain;
 }
@@ -635,31 +494,26 @@ sb16_awe32_filter_pc_speaker(int channel, double *buffer, void *priv)
 void
 sb_get_buffer_ess(int32_t *buffer, int len, void *priv)
 {
-    sb_t              *ess   = (sb_t *) priv;
-    const ess_mixer_t *mixer = &ess->mixer_ess;
+    sb_t              *ess    = (sb_t *) priv;
+    const ess_mixer_t *mixer  = &ess->mixer_ess;
+    /* TODO: recording from the mixer. */
+    const float        gain_l = (float) ((mixer->voice_l * mixer->master_l) / 3.0);
+    const float        gain_r = (float) ((mixer->voice_r * mixer->master_r) / 3.0);
+    float              out[SOUNDBUFLEN * 2];
 
     sb_dsp_update(&ess->dsp);
 
+    /* TODO: Implement the stereo switch on the mixer instead of on the dsp? */
     for (int c = 0; c < len * 2; c += 2) {
-        double out_l = 0.0;
-        double out_r = 0.0;
-
-        /* TODO: Implement the stereo switch on the mixer instead of on the dsp? */
-        if (mixer->output_filter) {
-            out_l += (low_fir_sb16(0, 0, (double) ess->dsp.buffer[c]) * mixer->voice_l) / 3.0;
-            out_r += (low_fir_sb16(0, 1, (double) ess->dsp.buffer[c + 1]) * mixer->voice_r) / 3.0;
-        } else {
-            out_l += (ess->dsp.buffer[c] * mixer->voice_l) / 3.0;
-            out_r += (ess->dsp.buffer[c + 1] * mixer->voice_r) / 3.0;
-        }
+        out[c]     = ((float) ess->dsp.buffer[c]) * gain_l;
+        out[c + 1] = ((float) ess->dsp.buffer[c + 1]) * gain_r;
+    }
 
-        /* TODO: recording from the mixer. */
-        out_l *= mixer->master_l;
-        out_r *= mixer->master_r;
+    if (mixer->output_filter)
+        fir_process(&ess->dsp.fir, out, len);
 
-        buffer[c] += (int32_t) out_l;
-        buffer[c + 1] += (int32_t) out_r;
-    }
+    for (int c = 0; c < len * 2; c++)
+        buffer[c] += (int32_t) out[c];
 
     ess->dsp.pos = 0;
 }
@@ -712,14 +566,14 @@ ess_filter_cd_audio(int channel, double *buffer, void *priv)
 void
 ess_filter_pc_speaker(int channel, double *buffer, void *priv)
 {
-    const sb_t        *ess   = (sb_t *) priv;
+    sb_t              *ess   = (sb_t *) priv;
     const ess_mixer_t *mixer = &ess->mixer_ess;
     double             c;
     double             spk    = mixer->speaker;
     double             master = channel ? mixer->master_r : mixer->master_l;
 
     if (mixer->output_filter)
-        c = (low_fir_sb16(3, channel, *buffer) * spk) / 3.0;
+        c = (fir_process_sample(&ess->dsp.fir_speaker, channel, (float) *buffer) * spk) / 3.0;
     else
         c = ((*buffer) * spk) / 3.0;
     c *= master;
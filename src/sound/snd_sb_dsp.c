@@ -18,7 +18,6 @@
 #include <86box/86box.h>
 #include <86box/device.h>
 #include <86box/dma.h>
-#include <86box/filters.h>
 #include <86box/io.h>
 #include <86box/midi.h>
 #include <86box/pic.h>
@@ -248,8 +247,6 @@ uint16_t espcm3_dpcm_tables[1024] =
 };
 // clang-format on
 
-double low_fir_sb16_coef[5][SB16_NCoef];
-
 #ifdef ENABLE_SB_DSP_LOG
 int sb_dsp_do_log = ENABLE_SB_DSP_LOG;
 
@@ -270,68 +267,11 @@ sb_dsp_log(const char *fmt, ...)
 
 #define ESSreg(reg) (dsp)->ess_regs[reg - 0xA0]
 
-static __inline double
-sinc(double x)
-{
-    return sin(M_PI * x) / (M_PI * x);
-}
-
-static void
-recalc_sb16_filter(const int c, const int playback_freq)
-{
-    /* Cutoff frequency = playback / 2 */
-    int          n;
-    const double fC = ((double) playback_freq) / (double) FREQ_96000;
-
-    for (n = 0; n < SB16_NCoef; n++) {
-        /* Blackman window */
-        const double w = 0.42 - (0.5 * cos((2.0 * n * M_PI) / (double) (SB16_NCoef - 1))) +
-                     (0.08 * cos((4.0 * n * M_PI) / (double) (SB16_NCoef - 1)));
-        /* Sinc filter */
-        const double h = sinc(2.0 * fC * ((double) n - ((double) (SB16_NCoef - 1) / 2.0)));
-
-        /* Create windowed-sinc filter */
-        low_fir_sb16_coef[c][n] = w * h;
-    }
-
-    low_fir_sb16_coef[c][(SB16_NCoef - 1) / 2] = 1.0;
-
-    double gain = 0.0;
-    for (n = 0; n < SB16_NCoef; n++)
-        gain += low_fir_sb16_coef[c][n];
-
-    /* Normalise filter, to produce unity gain */
-    for (n = 0; n < SB16_NCoef; n++)
-        low_fir_sb16_coef[c][n] /= gain;
-}
-
+/* The SB16 and ESS output filter cuts off at half the sample rate. */
 static void
-recalc_opl_filter(const int playback_freq)
+recalc_sb16_filter(sb_dsp_t *dsp, const int playback_freq)
 {
-    /* Cutoff frequency = playback / 2 */
-    int          n;
-    const double fC = ((double) playback_freq) / (double) (FREQ_49716 * 2);
-
-    for (n = 0; n < SB16_NCoef; n++) {
-        /* Blackman window */
-        const double w = 0.42 - (0.5 * cos((2.0 * n * M_PI) / (double) (SB16_NCoef - 1))) +
-                     (0.08 * cos((4.0 * n * M_PI) / (double) (SB16_NCoef - 1)));
-        /* Sinc filter */
-        const double h = sinc(2.0 * fC * ((double) n - ((double) (SB16_NCoef - 1) / 2.0)));
-
-        /* Create windowed-sinc filter */
-        low_fir_sb16_coef[1][n] = w * h;
-    }
-
-    low_fir_sb16_coef[1][(SB16_NCoef - 1) / 2] = 1.0;
-
-    double gain = 0.0;
-    for (n = 0; n < SB16_NCoef; n++)
-        gain += low_fir_sb16_coef[1][n];
-
-    /* Normalise filter, to produce unity gain */
-    for (n = 0; n < SB16_NCoef; n++)
-        low_fir_sb16_coef[1][n] /= gain;
+    fir_set_lowpass(&dsp->fir, ((double) playback_freq) / (double) FREQ_96000);
 }
 
 static void
@@ -935,7 +875,7 @@ sb_ess_update_reg_a2(sb_dsp_t *dsp, const uint8_t val)
     ESSreg(0xA2) = val;
 
     if (dsp->sb_freq != temp)
-        recalc_sb16_filter(0, temp);
+        recalc_sb16_filter(dsp, temp);
     dsp->sb_freq = temp;
 }
 
@@ -1385,7 +1325,7 @@ sb_exec_command(sb_dsp_t *dsp)
             temp                          = 1000000 / temp;
             sb_dsp_log("Sample rate - %ihz (%f)\n", temp, dsp->sblatcho);
             if ((dsp->sb_freq != temp) && (dsp->sb_type >= SB16))
-                recalc_sb16_filter(0, temp);
+                recalc_sb16_filter(dsp, temp);
             dsp->sb_freq = temp;
             if (IS_ESS(dsp)) {
                 sb_ess_update_filter_freq(dsp);
@@ -1402,7 +1342,7 @@ sb_exec_command(sb_dsp_t *dsp)
                 dsp->sblatchi = dsp->sblatcho;
                 dsp->sb_timei = dsp->sb_timeo;
                 if (dsp->sb_freq != temp)
-                    recalc_sb16_filter(0, dsp->sb_freq);
+                    recalc_sb16_filter(dsp, dsp->sb_freq);
                 dsp->sb_8051_ram[0x13] = dsp->sb_freq & 0xff;
                 dsp->sb_8051_ram[0x14] = (dsp->sb_freq >> 8) & 0xff;
             }
@@ -2075,30 +2015,13 @@ sb_dsp_init(sb_dsp_t *dsp, int type, int subtype, void *parent)
     if (IS_ESS(dsp))
         /* Initialize ESS filter to 8 kHz. This will be recalculated when a set frequency command is
            sent. */
-        recalc_sb16_filter(0, 8000 * 2);
+        recalc_sb16_filter(dsp, 8000 * 2);
     else
         /* Initialise SB16 filter to same cutoff as 8-bit SBs (3.2 kHz). This will be recalculated when
            a set frequency command is sent. */
-        recalc_sb16_filter(0, 3200 * 2);
-    if (IS_ESS(dsp) || (dsp->sb_type >= SBPRO2)) {
-        /* OPL3 or dual OPL2 is stereo. */
-        if (dsp->sb_has_real_opl)
-            recalc_opl_filter(FREQ_49716 * 2);
-        else
-            recalc_sb16_filter(1, FREQ_48000 * 2);
-    } else {
-        /* OPL2 is mono. */
-        if (dsp->sb_has_real_opl)
-            recalc_opl_filter(FREQ_49716);
-        else
-            recalc_sb16_filter(1, FREQ_48000);
-    }
-    /* CD Audio is stereo. */
-    recalc_sb16_filter(2, FREQ_44100 * 2);
+        recalc_sb16_filter(dsp, 3200 * 2);
     /* PC speaker is mono. */
-    recalc_sb16_filter(3, 18939);
-    /* E-MU 8000 is stereo. */
-    recalc_sb16_filter(4, FREQ_44100 * 2);
+    fir_set_lowpass(&dsp->fir_speaker, 18939.0 / (double) FREQ_96000);
 
     /* Initialize SB16 8051 RAM and ASP internal RAM */
     memset(dsp->sb_8051_ram, 0x00, sizeof(dsp->sb_8051_ram));
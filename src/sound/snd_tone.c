@@ -0,0 +1,719 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Block based stereo filters, output filters and bass/treble
+ *          controls shared by the sound card mixers.
+ *
+ *          The mixers used to run every sample through a low or high
+ *          pass filter in double precision, and then mix the filter
+ *          output back in with the boost or cut gain. Both steps are
+ *          linear, so they fold into the coefficients of a single
+ *          biquad per shelf, which is run over the whole buffer in
+ *          single precision with both channels side by side. The
+ *          output low pass FIRs are run the same way.
+ *
+ *
+ *
+ * Authors: Sarah Walker, <https://pcem-emulator.co.uk/>
+ *          Miran Grca, <mgrca8@gmail.com>
+ *
+ *          Copyright 2008-2024 Sarah Walker.
+ *          Copyright 2016-2024 Miran Grca.
+ */
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/plat.h>
+#include <86box/snd_tone.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    define TONE_SSE2
+#    include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    define TONE_NEON
+#    include <arm_neon.h>
+#endif
+
+/* fc=350Hz low pass, mixed in to boost bass. */
+static const double low_b[3] = { 0.00049713569693400649, 0.00099427139386801299, 0.00049713569693400649 };
+static const double low_a[3] = { 1.00000000000000000000, -1.93522955470669530000, 0.93726236021404663000 };
+
+/* fc=350Hz high pass, mixed in to cut bass. */
+static const double low_cut_b[3] = { 0.96839970114733542000, -1.93679940229467080000, 0.96839970114733542000 };
+static const double low_cut_a[3] = { 1.00000000000000000000, -1.93522955471202770000, 0.93726236021916731000 };
+
+/* fc=3.5kHz high pass, mixed in to boost treble. */
+static const double high_b[3] = { 0.72248704753064896000, -1.44497409506129790000, 0.72248704753064896000 };
+static const double high_a[3] = { 1.00000000000000000000, -1.36640781670578510000, 0.52352474706139873000 };
+
+/* fc=3.5kHz low pass, mixed in to cut treble. */
+static const double high_cut_b[3] = { 0.03927726802250377400, 0.07855453604500754700, 0.03927726802250377400 };
+static const double high_cut_a[3] = { 1.00000000000000000000, -1.36640781666419950000, 0.52352474703279628000 };
+
+static void
+biquad_set_flat(biquad_t *bq, int channel)
+{
+    bq->b0[channel] = 1.0f;
+    bq->b1[channel] = bq->b2[channel] = 0.0f;
+    bq->a1[channel] = bq->a2[channel] = 0.0f;
+    bq->z1[channel] = bq->z2[channel] = 0.0f;
+
+    bq->active &= ~(1 << channel);
+}
+
+/* Set the coefficients of one channel, a[0] is taken to be 1. NULL makes
+   the channel pass through unchanged. */
+void
+biquad_set(biquad_t *bq, int channel, const double *b, const double *a)
+{
+    if (b == NULL) {
+        biquad_set_flat(bq, channel);
+        return;
+    }
+
+    /* Both channels are run together, so the other one needs pass through
+       coefficients if it has never been set. */
+    if (!(bq->active & (1 << (channel ^ 1))))
+        biquad_set_flat(bq, channel ^ 1);
+
+    bq->b0[channel] = (float) b[0];
+    bq->b1[channel] = (float) b[1];
+    bq->b2[channel] = (float) b[2];
+    bq->a1[channel] = (float) a[1];
+    bq->a2[channel] = (float) a[2];
+
+    bq->active |= (1 << channel);
+}
+
+void
+biquad_process(biquad_t *bq, float *buffer, int len)
+{
+    if (!bq->active)
+        return;
+
+#if defined(TONE_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 b0   = _mm_loadl_pi(zero, (const __m64 *) bq->b0);
+    const __m128 b1   = _mm_loadl_pi(zero, (const __m64 *) bq->b1);
+    const __m128 b2   = _mm_loadl_pi(zero, (const __m64 *) bq->b2);
+    const __m128 a1   = _mm_loadl_pi(zero, (const __m64 *) bq->a1);
+    const __m128 a2   = _mm_loadl_pi(zero, (const __m64 *) bq->a2);
+    __m128       z1   = _mm_loadl_pi(zero, (const __m64 *) bq->z1);
+    __m128       z2   = _mm_loadl_pi(zero, (const __m64 *) bq->z2);
+
+    for (int c = 0; c < len * 2; c += 2) {
+        const __m128 x = _mm_loadl_pi(zero, (const __m64 *) &buffer[c]);
+        const __m128 y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+
+        _mm_storel_pi((__m64 *) &buffer[c], y);
+    }
+
+    _mm_storel_pi((__m64 *) bq->z1, z1);
+    _mm_storel_pi((__m64 *) bq->z2, z2);
+#elif defined(TONE_NEON)
+    const float32x2_t b0 = vld1_f32(bq->b0);
+    const float32x2_t b1 = vld1_f32(bq->b1);
+    const float32x2_t b2 = vld1_f32(bq->b2);
+    const float32x2_t a1 = vld1_f32(bq->a1);
+    const float32x2_t a2 = vld1_f32(bq->a2);
+    float32x2_t       z1 = vld1_f32(bq->z1);
+    float32x2_t       z2 = vld1_f32(bq->z2);
+
+    for (int c = 0; c < len * 2; c += 2) {
+        const float32x2_t x = vld1_f32(&buffer[c]);
+        const float32x2_t y = vmla_f32(z1, b0, x);
+
+        z1 = vadd_f32(vmls_f32(vmul_f32(b1, x), a1, y), z2);
+        z2 = vmls_f32(vmul_f32(b2, x), a2, y);
+
+        vst1_f32(&buffer[c], y);
+    }
+
+    vst1_f32(bq->z1, z1);
+    vst1_f32(bq->z2, z2);
+#else
+    /* Both channels in the same loop, so that their filters overlap. */
+    const float b0_l = bq->b0[0];
+    const float b1_l = bq->b1[0];
+    const float b2_l = bq->b2[0];
+    const float a1_l = bq->a1[0];
+    const float a2_l = bq->a2[0];
+    const float b0_r = bq->b0[1];
+    const float b1_r = bq->b1[1];
+    const float b2_r = bq->b2[1];
+    const float a1_r = bq->a1[1];
+    const float a2_r = bq->a2[1];
+    float       z1_l = bq->z1[0];
+    float       z2_l = bq->z2[0];
+    float       z1_r = bq->z1[1];
+    float       z2_r = bq->z2[1];
+
+    for (int c = 0; c < len * 2; c += 2) {
+        const float x_l = buffer[c];
+        const float x_r = buffer[c + 1];
+        const float y_l = (b0_l * x_l) + z1_l;
+        const float y_r = (b0_r * x_r) + z1_r;
+
+        z1_l = ((b1_l * x_l) - (a1_l * y_l)) + z2_l;
+        z1_r = ((b1_r * x_r) - (a1_r * y_r)) + z2_r;
+        z2_l = (b2_l * x_l) - (a2_l * y_l);
+        z2_r = (b2_r * x_r) - (a2_r * y_r);
+
+        buffer[c]     = y_l;
+        buffer[c + 1] = y_r;
+    }
+
+    bq->z1[0] = z1_l;
+    bq->z2[0] = z2_l;
+    bq->z1[1] = z1_r;
+    bq->z2[1] = z2_r;
+#endif
+}
+
+/* For the filters that are handed one sample at a time. */
+float
+biquad_process_sample(biquad_t *bq, int channel, float in)
+{
+    float out;
+
+    if (!(bq->active & (1 << channel)))
+        return in;
+
+    out = (bq->b0[channel] * in) + bq->z1[channel];
+
+    bq->z1[channel] = ((bq->b1[channel] * in) - (bq->a1[channel] * out)) + bq->z2[channel];
+    bq->z2[channel] = (bq->b2[channel] * in) - (bq->a2[channel] * out);
+
+    return out;
+}
+
+/* Boosting mixes the filter output in on top of the signal:
+       y = x + gain * H(x)
+   cutting crossfades between the signal and the filter output:
+       y = gain * x + (1 - gain) * H(x)
+   With H = b / a, both are a single biquad with the denominator of H. */
+static void
+tone_set_shelf(biquad_t *bq, int channel, int mode, double gain,
+               const double *boost_b, const double *boost_a,
+               const double *cut_b, const double *cut_a)
+{
+    double b[3];
+
+    switch (mode) {
+        case TONE_BOOST:
+            for (uint8_t i = 0; i < 3; i++)
+                b[i] = boost_a[i] + (gain * boost_b[i]);
+            biquad_set(bq, channel, b, boost_a);
+            break;
+
+        case TONE_CUT:
+            for (uint8_t i = 0; i < 3; i++)
+                b[i] = (gain * cut_a[i]) + ((1.0 - gain) * cut_b[i]);
+            biquad_set(bq, channel, b, cut_a);
+            break;
+
+        default:
+            biquad_set(bq, channel, NULL, NULL);
+            break;
+    }
+}
+
+/* Cheap enough to be called every buffer, the coefficients are only
+   recalculated when the settings change. */
+void
+tone_set(tone_t *tone, int channel, int bass_mode, double bass_gain,
+         int treble_mode, double treble_gain)
+{
+    if ((bass_mode != tone->bass_mode[channel]) || (bass_gain != tone->bass_gain[channel])) {
+        tone->bass_mode[channel] = bass_mode;
+        tone->bass_gain[channel] = bass_gain;
+
+        tone_set_shelf(&tone->bass, channel, bass_mode, bass_gain,
+                       low_b, low_a, low_cut_b, low_cut_a);
+    }
+
+    if ((treble_mode != tone->treble_mode[channel]) || (treble_gain != tone->treble_gain[channel])) {
+        tone->treble_mode[channel] = treble_mode;
+        tone->treble_gain[channel] = treble_gain;
+
+        tone_set_shelf(&tone->treble, channel, treble_mode, treble_gain,
+                       high_b, high_a, high_cut_b, high_cut_a);
+    }
+}
+
+/* For mixers with 4-bit bass and treble registers: values above flat
+   boost, values below it cut, with the gain taken from the table. */
+void
+tone_set_4bits(tone_t *tone, int channel, int bass, int treble, int flat,
+               const double *gains)
+{
+    const int bass_mode   = (bass > flat) ? TONE_BOOST : ((bass < flat) ? TONE_CUT : TONE_FLAT);
+    const int treble_mode = (treble > flat) ? TONE_BOOST : ((treble < flat) ? TONE_CUT : TONE_FLAT);
+
+    tone_set(tone, channel, bass_mode, gains[bass], treble_mode, gains[treble]);
+}
+
+#if defined(TONE_SSE2)
+/* Both stages in one vector, bass in the low half and treble in the high
+   half. The treble stage runs one sample behind, on the bass output of the
+   previous iteration, so that the two stages do not wait on each other. */
+static void
+tone_process_sse2(tone_t *tone, float *buffer, int len)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 b0   = _mm_loadh_pi(_mm_loadl_pi(zero, (const __m64 *) tone->bass.b0), (const __m64 *) tone->treble.b0);
+    const __m128 b1   = _mm_loadh_pi(_mm_loadl_pi(zero, (const __m64 *) tone->bass.b1), (const __m64 *) tone->treble.b1);
+    const __m128 b2   = _mm_loadh_pi(_mm_loadl_pi(zero, (const __m64 *) tone->bass.b2), (const __m64 *) tone->treble.b2);
+    const __m128 a1   = _mm_loadh_pi(_mm_loadl_pi(zero, (const __m64 *) tone->bass.a1), (const __m64 *) tone->treble.a1);
+    const __m128 a2   = _mm_loadh_pi(_mm_loadl_pi(zero, (const __m64 *) tone->bass.a2), (const __m64 *) tone->treble.a2);
+    __m128       z1   = _mm_loadh_pi(_mm_loadl_pi(zero, (const __m64 *) tone->bass.z1), (const __m64 *) tone->treble.z1);
+    __m128       z2   = _mm_loadh_pi(_mm_loadl_pi(zero, (const __m64 *) tone->bass.z2), (const __m64 *) tone->treble.z2);
+    __m128       x;
+    __m128       y;
+    __m128       z1_new;
+    __m128       z2_new;
+
+    /* The first sample only goes through the bass stage. */
+    x      = _mm_loadl_pi(zero, (const __m64 *) buffer);
+    y      = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+    z1_new = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+    z2_new = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+    z1     = _mm_shuffle_ps(z1_new, z1, _MM_SHUFFLE(3, 2, 1, 0));
+    z2     = _mm_shuffle_ps(z2_new, z2, _MM_SHUFFLE(3, 2, 1, 0));
+
+    for (int c = 2; c < len * 2; c += 2) {
+        x = _mm_movelh_ps(_mm_loadl_pi(zero, (const __m64 *) &buffer[c]), y);
+        y = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+
+        z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+        z2 = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+
+        _mm_storeh_pi((__m64 *) &buffer[c - 2], y);
+    }
+
+    /* And the last one only has the treble stage left. */
+    x      = _mm_movelh_ps(zero, y);
+    y      = _mm_add_ps(_mm_mul_ps(b0, x), z1);
+    z1_new = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, x), _mm_mul_ps(a1, y)), z2);
+    z2_new = _mm_sub_ps(_mm_mul_ps(b2, x), _mm_mul_ps(a2, y));
+    z1     = _mm_shuffle_ps(z1, z1_new, _MM_SHUFFLE(3, 2, 1, 0));
+    z2     = _mm_shuffle_ps(z2, z2_new, _MM_SHUFFLE(3, 2, 1, 0));
+
+    _mm_storeh_pi((__m64 *) &buffer[(len - 1) * 2], y);
+
+    _mm_storel_pi((__m64 *) tone->bass.z1, z1);
+    _mm_storel_pi((__m64 *) tone->bass.z2, z2);
+    _mm_storeh_pi((__m64 *) tone->treble.z1, z1);
+    _mm_storeh_pi((__m64 *) tone->treble.z2, z2);
+}
+#endif
+
+void
+tone_process(tone_t *tone, float *buffer, int len)
+{
+#if defined(TONE_SSE2)
+    if (tone->bass.active && tone->treble.active && (len > 0)) {
+        tone_process_sse2(tone, buffer, len);
+        return;
+    }
+#endif
+
+    biquad_process(&tone->bass, buffer, len);
+    biquad_process(&tone->treble, buffer, len);
+}
+
+float
+tone_process_sample(tone_t *tone, int channel, float in)
+{
+    return biquad_process_sample(&tone->treble, channel,
+                                 biquad_process_sample(&tone->bass, channel, in));
+}
+
+/* Blackman windowed sinc, normalised to unity gain. The cutoff is given as
+   a fraction of the sample rate. */
+static void
+fir_design(double *coef, double cutoff)
+{
+    const int center = (FIR_TAPS - 1) / 2;
+    double    gain   = 0.0;
+
+    for (int n = 0; n < FIR_TAPS; n++) {
+        const double w = 0.42 - (0.5 * cos((2.0 * n * M_PI) / (double) (FIR_TAPS - 1))) +
+                         (0.08 * cos((4.0 * n * M_PI) / (double) (FIR_TAPS - 1)));
+        const double x = 2.0 * cutoff * (double) (n - center);
+
+        coef[n] = (n == center) ? 1.0 : (w * (sin(M_PI * x) / (M_PI * x)));
+        gain += coef[n];
+    }
+
+    for (int n = 0; n < FIR_TAPS; n++)
+        coef[n] /= gain;
+}
+
+/* The input is left alone, so that the rate can change while playing. */
+void
+fir_set_lowpass(fir_t *fir, double cutoff)
+{
+    double coef[FIR_TAPS];
+
+    fir_design(coef, cutoff);
+
+    for (int n = 0; n < FIR_LEN; n++)
+        fir->coef[n][0] = fir->coef[n][1] = (n < FIR_TAPS) ? (float) coef[n] : 0.0f;
+}
+
+/* The input runs backwards through hist, so that the newest sample is under
+   the first tap. */
+static __inline float *
+fir_push(fir_t *fir)
+{
+    fir->pos = fir->pos ? (fir->pos - 1) : (FIR_LEN - 1);
+
+    return fir->hist[fir->pos];
+}
+
+void
+fir_process(fir_t *fir, float *buffer, int len)
+{
+    const float *coef = fir->coef[0];
+
+    for (int c = 0; c < len * 2; c += 2) {
+        float *x = fir_push(fir);
+
+        x[0] = x[(FIR_LEN * 2) + 0] = buffer[c];
+        x[1] = x[(FIR_LEN * 2) + 1] = buffer[c + 1];
+
+        /* Both channels of two taps at a time, over four sums so that the
+           additions do not wait on each other. */
+#if defined(TONE_SSE2)
+        __m128 sum0 = _mm_setzero_ps();
+        __m128 sum1 = _mm_setzero_ps();
+        __m128 sum2 = _mm_setzero_ps();
+        __m128 sum3 = _mm_setzero_ps();
+
+        for (int n = 0; n < (FIR_LEN * 2); n += 16) {
+            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(&coef[n]), _mm_loadu_ps(&x[n])));
+            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(&coef[n + 4]), _mm_loadu_ps(&x[n + 4])));
+            sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(&coef[n + 8]), _mm_loadu_ps(&x[n + 8])));
+            sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(&coef[n + 12]), _mm_loadu_ps(&x[n + 12])));
+        }
+        sum0 = _mm_add_ps(_mm_add_ps(sum0, sum1), _mm_add_ps(sum2, sum3));
+        sum0 = _mm_add_ps(sum0, _mm_movehl_ps(sum0, sum0));
+        _mm_storel_pi((__m64 *) &buffer[c], sum0);
+#elif defined(TONE_NEON)
+        float32x4_t sum0 = vdupq_n_f32(0.0f);
+        float32x4_t sum1 = vdupq_n_f32(0.0f);
+        float32x4_t sum2 = vdupq_n_f32(0.0f);
+        float32x4_t sum3 = vdupq_n_f32(0.0f);
+
+        for (int n = 0; n < (FIR_LEN * 2); n += 16) {
+            sum0 = vmlaq_f32(sum0, vld1q_f32(&coef[n]), vld1q_f32(&x[n]));
+            sum1 = vmlaq_f32(sum1, vld1q_f32(&coef[n + 4]), vld1q_f32(&x[n + 4]));
+            sum2 = vmlaq_f32(sum2, vld1q_f32(&coef[n + 8]), vld1q_f32(&x[n + 8]));
+            sum3 = vmlaq_f32(sum3, vld1q_f32(&coef[n + 12]), vld1q_f32(&x[n + 12]));
+        }
+        sum0 = vaddq_f32(vaddq_f32(sum0, sum1), vaddq_f32(sum2, sum3));
+        vst1_f32(&buffer[c], vadd_f32(vget_low_f32(sum0), vget_high_f32(sum0)));
+#else
+        float sum_l0 = 0.0f;
+        float sum_r0 = 0.0f;
+        float sum_l1 = 0.0f;
+        float sum_r1 = 0.0f;
+
+        for (int n = 0; n < (FIR_LEN * 2); n += 4) {
+            sum_l0 += coef[n] * x[n];
+            sum_r0 += coef[n + 1] * x[n + 1];
+            sum_l1 += coef[n + 2] * x[n + 2];
+            sum_r1 += coef[n + 3] * x[n + 3];
+        }
+        buffer[c]     = sum_l0 + sum_l1;
+        buffer[c + 1] = sum_r0 + sum_r1;
+#endif
+    }
+}
+
+/* For the filters that are handed one sample at a time, left first. */
+float
+fir_process_sample(fir_t *fir, int channel, float in)
+{
+    float *x;
+    float  sum = 0.0f;
+
+    if (channel)
+        x = fir->hist[fir->pos];
+    else
+        x = fir_push(fir);
+
+    x[channel] = x[(FIR_LEN * 2) + channel] = in;
+
+    for (int n = 0; n < FIR_TAPS; n++)
+        sum += fir->coef[n][channel] * x[(n * 2) + channel];
+
+    return sum;
+}
+
+#define TONE_BENCH_LEN    1024 /* Stereo frames per block, about a sound buffer. */
+#define TONE_BENCH_BLOCKS 2000
+#define TONE_BENCH_CHECK  16   /* Blocks compared against the old filters. */
+
+static uint32_t       tone_bench_seed;
+static volatile float tone_bench_sink; /* Keeps the timed loops from being optimised out. */
+
+/* White noise at full scale. */
+static void
+tone_bench_fill(float *buffer)
+{
+    for (int c = 0; c < TONE_BENCH_LEN * 2; c++) {
+        tone_bench_seed = (tone_bench_seed * 1103515245) + 12345;
+        buffer[c]       = (float) ((int) ((tone_bench_seed >> 16) & 0xffff) - 32768);
+    }
+}
+
+/* The old per sample FIR, in double precision with its state in a ring of
+   one sample more than there are taps. It reads the taps two samples late,
+   which the comparison allows for. */
+typedef struct tone_bench_fir_t {
+    double coef[FIR_TAPS];
+    double x[2][FIR_TAPS + 1];
+    int    pos;
+} tone_bench_fir_t;
+
+static double
+tone_bench_fir_old(tone_bench_fir_t *fir, int i, double in)
+{
+    double out = 0.0;
+    int    n;
+
+    fir->x[i][fir->pos] = in;
+
+    for (n = 0; (n < ((FIR_TAPS + 1) - fir->pos)) && (n < FIR_TAPS); n++)
+        out += fir->coef[n] * fir->x[i][n + fir->pos];
+    for (; n < FIR_TAPS; n++)
+        out += fir->coef[n] * fir->x[i][(n + fir->pos) - (FIR_TAPS + 1)];
+
+    if (i == 1) {
+        fir->pos++;
+        if (fir->pos > FIR_TAPS)
+            fir->pos = 0;
+    }
+
+    return out;
+}
+
+/* The old bass and treble controls: a second order IIR in double precision
+   per shelf, with the output mixed back in with the boost or cut gain. */
+typedef struct tone_bench_iir_t {
+    double x[2][3];
+    double y[2][3];
+} tone_bench_iir_t;
+
+static double
+tone_bench_iir_old(tone_bench_iir_t *iir, int i, const double *b, const double *a, double in)
+{
+    iir->x[i][2] = iir->x[i][1];
+    iir->x[i][1] = iir->x[i][0];
+    iir->y[i][2] = iir->y[i][1];
+    iir->y[i][1] = iir->y[i][0];
+
+    iir->x[i][0] = in;
+    iir->y[i][0] = (b[0] * iir->x[i][0]) + (b[1] * iir->x[i][1]) - (a[1] * iir->y[i][1]) +
+                   (b[2] * iir->x[i][2]) - (a[2] * iir->y[i][2]);
+
+    return iir->y[i][0];
+}
+
+static double
+tone_bench_shelf_old(tone_bench_iir_t *iir, int i, int mode, double gain, double in,
+                     const double *boost_b, const double *boost_a,
+                     const double *cut_b, const double *cut_a)
+{
+    switch (mode) {
+        case TONE_BOOST:
+            return in + (tone_bench_iir_old(iir, i, boost_b, boost_a, in) * gain);
+        case TONE_CUT:
+            return (in * gain) + (tone_bench_iir_old(iir, i, cut_b, cut_a, in) * (1.0 - gain));
+        default:
+            return in;
+    }
+}
+
+static double
+tone_bench_db(double err)
+{
+    return (err > 0.0) ? (20.0 * log10(err / 32768.0)) : -999.0;
+}
+
+static void
+tone_bench_fir(void)
+{
+    float            *buffer = (float *) malloc(TONE_BENCH_LEN * 2 * sizeof(float));
+    float            *out    = (float *) malloc(TONE_BENCH_LEN * 2 * sizeof(float));
+    double           *ref    = (double *) malloc(((TONE_BENCH_LEN * TONE_BENCH_CHECK) + 2) * 2 * sizeof(double));
+    fir_t            *fir    = (fir_t *) calloc(1, sizeof(fir_t));
+    tone_bench_fir_t *old    = (tone_bench_fir_t *) calloc(1, sizeof(tone_bench_fir_t));
+    double            err    = 0.0;
+    uint32_t          start;
+    uint32_t          t_new;
+    uint32_t          t_old;
+
+    if ((buffer == NULL) || (out == NULL) || (ref == NULL) || (fir == NULL) || (old == NULL))
+        fatal("tone_bench_fir - out of memory\n");
+
+    /* The output filter at a 44.1 kHz playback rate. */
+    fir_set_lowpass(fir, 22050.0 / 48000.0);
+    fir_design(old->coef, 22050.0 / 48000.0);
+
+    /* The same noise through both, the old one with two samples more. */
+    tone_bench_seed = 1;
+    for (int b = 0; b < TONE_BENCH_CHECK; b++) {
+        tone_bench_fill(buffer);
+        for (int c = 0; c < TONE_BENCH_LEN * 2; c++)
+            ref[(b * TONE_BENCH_LEN * 2) + c] = tone_bench_fir_old(old, c & 1, buffer[c]);
+    }
+    for (int c = 0; c < 4; c++)
+        ref[(TONE_BENCH_CHECK * TONE_BENCH_LEN * 2) + c] = tone_bench_fir_old(old, c & 1, 0.0);
+
+    tone_bench_seed = 1;
+    for (int b = 0; b < TONE_BENCH_CHECK; b++) {
+        tone_bench_fill(buffer);
+        fir_process(fir, buffer, TONE_BENCH_LEN);
+        for (int c = 0; c < TONE_BENCH_LEN * 2; c++)
+            err = fmax(err, fabs(buffer[c] - ref[(b * TONE_BENCH_LEN * 2) + c + 4]));
+    }
+
+    tone_bench_fill(buffer);
+    start = plat_get_ticks();
+    for (int b = 0; b < TONE_BENCH_BLOCKS; b++) {
+        memcpy(out, buffer, TONE_BENCH_LEN * 2 * sizeof(float));
+        fir_process(fir, out, TONE_BENCH_LEN);
+        tone_bench_sink += out[b & ((TONE_BENCH_LEN * 2) - 1)];
+    }
+    t_new = plat_get_ticks() - start;
+
+    start = plat_get_ticks();
+    for (int b = 0; b < TONE_BENCH_BLOCKS; b++) {
+        for (int c = 0; c < TONE_BENCH_LEN * 2; c++)
+            out[c] = (float) tone_bench_fir_old(old, c & 1, buffer[c]);
+        tone_bench_sink += out[b & ((TONE_BENCH_LEN * 2) - 1)];
+    }
+    t_old = plat_get_ticks() - start;
+
+    printf("fir      %6.1f ns/frame, old %6.1f ns/frame, error %7.1f dB\n",
+           ((double) t_new * 1000000.0) / (double) (TONE_BENCH_BLOCKS * TONE_BENCH_LEN),
+           ((double) t_old * 1000000.0) / (double) (TONE_BENCH_BLOCKS * TONE_BENCH_LEN),
+           tone_bench_db(err));
+
+    free(old);
+    free(fir);
+    free(ref);
+    free(out);
+    free(buffer);
+}
+
+static void
+tone_bench_tone(void)
+{
+    /* The 4-bit gains of the CT1745, flat at 8. */
+    static const double gains[16] = {
+        0.199526231, 0.25, 0.316227766, 0.398107170, 0.5, 0.63095734, 0.794328234, 1,
+        0, 0.25892541, 0.584893192, 1, 1.511886431, 2.16227766, 3, 4.011872336
+    };
+    float            *buffer = (float *) malloc(TONE_BENCH_LEN * 2 * sizeof(float));
+    float            *out    = (float *) malloc(TONE_BENCH_LEN * 2 * sizeof(float));
+    tone_t           *tone   = (tone_t *) calloc(1, sizeof(tone_t));
+    tone_bench_iir_t *bass   = (tone_bench_iir_t *) calloc(1, sizeof(tone_bench_iir_t));
+    tone_bench_iir_t *treble = (tone_bench_iir_t *) calloc(1, sizeof(tone_bench_iir_t));
+    double            err    = 0.0;
+    uint32_t          start;
+    uint32_t          t_new;
+    uint32_t          t_old;
+
+    if ((buffer == NULL) || (out == NULL) || (tone == NULL) || (bass == NULL) || (treble == NULL))
+        fatal("tone_bench_tone - out of memory\n");
+
+    /* Every setting of both controls, from a flat start each time. */
+    tone_bench_seed = 1;
+    tone_bench_fill(buffer);
+    for (int s = 0; s < 256; s++) {
+        const int b_mode = ((s >> 4) > 8) ? TONE_BOOST : (((s >> 4) < 8) ? TONE_CUT : TONE_FLAT);
+        const int t_mode = ((s & 15) > 8) ? TONE_BOOST : (((s & 15) < 8) ? TONE_CUT : TONE_FLAT);
+
+        memset(tone, 0, sizeof(tone_t));
+        memset(bass, 0, sizeof(tone_bench_iir_t));
+        memset(treble, 0, sizeof(tone_bench_iir_t));
+        tone_set_4bits(tone, 0, s >> 4, s & 15, 8, gains);
+        tone_set_4bits(tone, 1, s >> 4, s & 15, 8, gains);
+
+        memcpy(out, buffer, TONE_BENCH_LEN * 2 * sizeof(float));
+        tone_process(tone, out, TONE_BENCH_LEN);
+
+        for (int c = 0; c < TONE_BENCH_LEN * 2; c++) {
+            double ref = tone_bench_shelf_old(bass, c & 1, b_mode, gains[s >> 4], buffer[c],
+                                              low_b, low_a, low_cut_b, low_cut_a);
+
+            ref = tone_bench_shelf_old(treble, c & 1, t_mode, gains[s & 15], ref,
+                                       high_b, high_a, high_cut_b, high_cut_a);
+            err = fmax(err, fabs(out[c] - ref));
+        }
+    }
+
+    /* Timed with both controls at full boost. */
+    memset(tone, 0, sizeof(tone_t));
+    tone_set_4bits(tone, 0, 15, 15, 8, gains);
+    tone_set_4bits(tone, 1, 15, 15, 8, gains);
+
+    start = plat_get_ticks();
+    for (int b = 0; b < TONE_BENCH_BLOCKS; b++) {
+        memcpy(out, buffer, TONE_BENCH_LEN * 2 * sizeof(float));
+        tone_process(tone, out, TONE_BENCH_LEN);
+        tone_bench_sink += out[b & ((TONE_BENCH_LEN * 2) - 1)];
+    }
+    t_new = plat_get_ticks() - start;
+
+    start = plat_get_ticks();
+    for (int b = 0; b < TONE_BENCH_BLOCKS; b++) {
+        for (int c = 0; c < TONE_BENCH_LEN * 2; c++) {
+            const double ref = tone_bench_shelf_old(bass, c & 1, TONE_BOOST, gains[15], buffer[c],
+                                                    low_b, low_a, low_cut_b, low_cut_a);
+
+            out[c] = (float) tone_bench_shelf_old(treble, c & 1, TONE_BOOST, gains[15], ref,
+                                                  high_b, high_a, high_cut_b, high_cut_a);
+        }
+        tone_bench_sink += out[b & ((TONE_BENCH_LEN * 2) - 1)];
+    }
+    t_old = plat_get_ticks() - start;
+
+    printf("tone     %6.1f ns/frame, old %6.1f ns/frame, error %7.1f dB\n",
+           ((double) t_new * 1000000.0) / (double) (TONE_BENCH_BLOCKS * TONE_BENCH_LEN),
+           ((double) t_old * 1000000.0) / (double) (TONE_BENCH_BLOCKS * TONE_BENCH_LEN),
+           tone_bench_db(err));
+
+    free(treble);
+    free(bass);
+    free(tone);
+    free(out);
+    free(buffer);
+}
+
+/* Time the output filters and the bass and treble controls against the
+   double precision per sample filters they replaced, over stereo white
+   noise at full scale, and give the largest difference from them relative
+   to full scale. The controls are compared at all 256 settings. */
+void
+tone_benchmark(void)
+{
+    tone_bench_fir();
+    tone_bench_tone();
+}
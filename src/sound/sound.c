@@ -81,6 +81,23 @@ static uint64_t   music_poll_latch;
 static pc_timer_t wavetable_poll_timer;
 static uint64_t   wavetable_poll_latch;
 
+/* Jobs queued for the sound render thread. A job is queued at most once
+   before its owner waits for it, so a pending flag per job is enough. */
+#define SOUND_RENDER_JOBS 16
+
+struct sound_render_job_t {
+    void (*render)(void *priv);
+    void    *priv;
+    event_t *done;
+    int      pending;
+};
+
+static thread_t           *sound_render_thread_h;
+static event_t            *sound_render_event;
+static mutex_t            *sound_render_mutex;
+static sound_render_job_t *sound_render_jobs[SOUND_RENDER_JOBS];
+static volatile int        sound_render_on = 0;
+
 static int16_t      cd_buffer[CDROM_NUM][CD_BUFLEN * 2];
 static float        cd_out_buffer[CD_BUFLEN * 2];
 static int16_t      cd_out_buffer_int16[CD_BUFLEN * 2];
@@ -696,7 +713,9 @@ sound_reset(void)
     midi_out_device_init();
     midi_in_device_init();
 
-    inital();
+    /* Headless runs produce no audio output at all. */
+    if (!run_headless)
+        inital();
 
     timer_add(&sound_poll_timer, sound_poll, NULL, 1);
 
@@ -786,3 +805,128 @@ sound_cd_thread_reset(void)
 
     cd_thread_enable = available_cdrom_drives ? 1 : 0;
 }
+
+static void
+sound_render_thread(UNUSED(void *param))
+{
+    sound_render_job_t *job;
+
+    while (sound_render_on) {
+        thread_wait_event(sound_render_event, -1);
+        thread_reset_event(sound_render_event);
+
+        do {
+            job = NULL;
+
+            thread_wait_mutex(sound_render_mutex);
+            for (int i = 0; i < SOUND_RENDER_JOBS; i++) {
+                if ((sound_render_jobs[i] != NULL) && sound_render_jobs[i]->pending) {
+                    job          = sound_render_jobs[i];
+                    job->pending = 0;
+                    break;
+                }
+            }
+            thread_release_mutex(sound_render_mutex);
+
+            if (job != NULL) {
+                job->render(job->priv);
+                thread_set_event(job->done);
+            }
+        } while (job != NULL);
+    }
+}
+
+/* Register a job to be run on the sound render thread, starting the thread
+   if it is not running yet. Returns NULL if no more jobs can be added, in
+   which case the caller should do the work itself. */
+sound_render_job_t *
+sound_render_job_add(void (*render)(void *priv), void *priv)
+{
+    sound_render_job_t *job = NULL;
+
+    if (!sound_render_on) {
+        sound_render_event    = thread_create_event();
+        sound_render_mutex    = thread_create_mutex();
+        sound_render_on       = 1;
+        sound_render_thread_h = thread_create(sound_render_thread, NULL);
+    }
+
+    thread_wait_mutex(sound_render_mutex);
+    for (int i = 0; i < SOUND_RENDER_JOBS; i++) {
+        if (sound_render_jobs[i] == NULL) {
+            job         = (sound_render_job_t *) calloc(1, sizeof(sound_render_job_t));
+            job->render = render;
+            job->priv   = priv;
+            job->done   = thread_create_event();
+            /* Nothing is outstanding yet, so the first wait must not block. */
+            thread_set_event(job->done);
+            sound_render_jobs[i] = job;
+            break;
+        }
+    }
+    thread_release_mutex(sound_render_mutex);
+
+    if (job == NULL)
+        sound_log("Sound render thread: no free job slots\n");
+
+    return job;
+}
+
+void
+sound_render_job_submit(sound_render_job_t *job)
+{
+    thread_reset_event(job->done);
+
+    thread_wait_mutex(sound_render_mutex);
+    job->pending = 1;
+    thread_release_mutex(sound_render_mutex);
+
+    thread_set_event(sound_render_event);
+}
+
+/* Wait for the last submission of the job to be rendered. */
+void
+sound_render_job_wait(sound_render_job_t *job)
+{
+    thread_wait_event(job->done, -1);
+}
+
+void
+sound_render_job_close(sound_render_job_t *job)
+{
+    if (job == NULL)
+        return;
+
+    sound_render_job_wait(job);
+
+    thread_wait_mutex(sound_render_mutex);
+    for (int i = 0; i < SOUND_RENDER_JOBS; i++) {
+        if (sound_render_jobs[i] == job)
+            sound_render_jobs[i] = NULL;
+    }
+    thread_release_mutex(sound_render_mutex);
+
+    thread_destroy_event(job->done);
+    free(job);
+}
+
+void
+sound_render_thread_end(void)
+{
+    if (sound_render_on) {
+        sound_render_on = 0;
+
+        sound_log("Waiting for sound render thread to terminate...\n");
+        thread_set_event(sound_render_event);
+        thread_wait(sound_render_thread_h);
+        sound_log("Sound render thread terminated...\n");
+
+        sound_render_thread_h = NULL;
+
+        thread_destroy_event(sound_render_event);
+        sound_render_event = NULL;
+
+        thread_close_mutex(sound_render_mutex);
+        sound_render_mutex = NULL;
+    }
+}
@@ -95,14 +95,11 @@ thread_wait_event(event_t *handle, int timeout)
     if (timeout < 0) {
         event->cond.wait(lock, [event] { return event->state; });
     } else {
-        auto           to = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout);
-        std::cv_status status;
+        auto to = std::chrono::system_clock::now() + std::chrono::milliseconds(timeout);
 
-        do {
-            status = event->cond.wait_until(lock, to);
-        } while ((status != std::cv_status::timeout) && !event->state);
-
-        if (status == std::cv_status::timeout) {
+        /* Check the state before waiting, so that an event set before this
+           call is not missed. */
+        if (!event->cond.wait_until(lock, to, [event] { return event->state; })) {
             return 1;
         }
     }
@@ -1,87 +1,328 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include <wchar.h>
 #include <86box/86box.h>
 #include <86box/timer.h>
+#include <86box/plat.h>
 
 uint64_t TIMER_USEC;
 uint32_t timer_target;
 
-/*Enabled timers are stored in a linked list, with the first timer to expire at
-  the head.*/
-pc_timer_t *timer_head = NULL;
+/*Enabled timers are kept in one of two ways, depending on how many there are.
+
+  With few timers, they are kept in a sorted doubly linked list, with the first
+  timer to expire at timer_head. Most of the work of the timers is done by a
+  few short period timers that re-arm themselves from their callbacks and land
+  a few places from the head of the list, and for them a short walk of the
+  list is as cheap as it gets.
+
+  With many timers, that walk gets long, so they are kept in a 4-ary min-heap
+  instead, with the first timer to expire at timer_heap[0]. The heap holds a
+  copy of each timer's timestamp, so it can be walked without touching the
+  timers themselves, and each timer holds its position in it (plus one) in
+  heap_pos, so it can be removed without a search. While a timer callback
+  runs, the root of the heap is left empty, as the callback will usually
+  re-arm its own timer; the root is then filled with that timer in a single
+  sift down.
+
+  The timers are moved to the heap when a timer is enabled with TIMER_HEAP_ON
+  already enabled, and back to the list by timer_process() once fewer than
+  TIMER_HEAP_OFF are left; the gap between the two keeps a number of timers
+  close to either from moving them back and forth.
+
+  Timers that expire at the same time are run most recently enabled first, in
+  the list by being inserted in front of the timers they are equal to, and in
+  the heap by the sequence number given to each timer as it goes in.*/
+#define TIMER_HEAP_ON  40
+#define TIMER_HEAP_OFF 24
+
+typedef struct timer_heap_t {
+    uint64_t    ts;
+    uint64_t    seq;
+    pc_timer_t *timer;
+} timer_heap_t;
+
+static pc_timer_t   *timer_head       = NULL;
+static int           timer_count      = 0;
+static int           timer_use_heap   = 0;
+static timer_heap_t *timer_heap       = NULL;
+static int           timer_heap_size  = 0;
+static int           timer_heap_alloc = 0;
+static int           timer_heap_hole  = 0;
+static uint64_t      timer_seq        = 0;
 
 /* Are we initialized? */
 int timer_inited = 0;
 
 static void timer_advance_ex(pc_timer_t *timer, int start);
 
-void
-timer_enable(pc_timer_t *timer)
+/*True if timer a is to run before timer b*/
+static __inline int
+timer_heap_less(const timer_heap_t *a, const timer_heap_t *b)
 {
-    pc_timer_t *timer_node = timer_head;
-    int ret = 0;
+    int64_t diff = (int64_t) (a->ts - b->ts);
 
-    if (!timer_inited || (timer == NULL))
+    if (diff)
+        return diff < 0;
+
+    return a->seq > b->seq;
+}
+
+static __inline void
+timer_heap_set(int pos, const timer_heap_t *entry)
+{
+    timer_heap[pos]        = *entry;
+    entry->timer->heap_pos = pos + 1;
+}
+
+static void
+timer_heap_sift_up(int pos)
+{
+    timer_heap_t entry = timer_heap[pos];
+
+    while (pos > 0) {
+        int parent = (pos - 1) >> 2;
+
+        if (!timer_heap_less(&entry, &timer_heap[parent]))
+            break;
+
+        timer_heap_set(pos, &timer_heap[parent]);
+        pos = parent;
+    }
+
+    timer_heap_set(pos, &entry);
+}
+
+static void
+timer_heap_sift_down(int pos)
+{
+    timer_heap_t entry = timer_heap[pos];
+
+    while (1) {
+        int first = (pos << 2) + 1;
+        int last  = first + 4;
+        int child = first;
+
+        if (first >= timer_heap_size)
+            break;
+        if (last > timer_heap_size)
+            last = timer_heap_size;
+        for (int c = first + 1; c < last; c++) {
+            if (timer_heap_less(&timer_heap[c], &timer_heap[child]))
+                child = c;
+        }
+        if (!timer_heap_less(&timer_heap[child], &entry))
+            break;
+
+        timer_heap_set(pos, &timer_heap[child]);
+        pos = child;
+    }
+
+    timer_heap_set(pos, &entry);
+}
+
+/*Fill the empty root left by timer_process() with the last timer in the heap*/
+static void
+timer_heap_close_hole(void)
+{
+    timer_heap_hole = 0;
+    timer_heap_size--;
+
+    if (timer_heap_size) {
+        timer_heap[0] = timer_heap[timer_heap_size];
+        timer_heap_sift_down(0);
+    }
+}
+
+static void
+timer_heap_insert(pc_timer_t *timer)
+{
+    int pos;
+
+    if (timer_heap_size == timer_heap_alloc) {
+        timer_heap_alloc = timer_heap_alloc ? (timer_heap_alloc << 1) : 64;
+        timer_heap       = (timer_heap_t *) realloc(timer_heap, timer_heap_alloc * sizeof(timer_heap_t));
+        if (timer_heap == NULL)
+            fatal("timer_enable - out of memory\n");
+    }
+
+    if (timer_heap_hole) {
+        timer_heap_hole = 0;
+        pos             = 0;
+    } else
+        pos = timer_heap_size++;
+
+    timer_heap[pos].ts    = timer->ts.ts64;
+    timer_heap[pos].seq   = ++timer_seq;
+    timer_heap[pos].timer = timer;
+    if (pos)
+        timer_heap_sift_up(pos);
+    else
+        timer_heap_sift_down(pos);
+}
+
+static void
+timer_heap_remove(pc_timer_t *timer)
+{
+    int pos;
+
+    if (timer_heap_hole)
+        timer_heap_close_hole();
+
+    pos = timer->heap_pos - 1;
+
+    timer->heap_pos = 0;
+    timer_heap_size--;
+
+    if (pos == timer_heap_size)
         return;
 
-    if (timer->flags & TIMER_ENABLED)
-        timer_disable(timer);
+    timer_heap_set(pos, &timer_heap[timer_heap_size]);
+    if ((pos > 0) && timer_heap_less(&timer_heap[pos], &timer_heap[(pos - 1) >> 2]))
+        timer_heap_sift_up(pos);
+    else
+        timer_heap_sift_down(pos);
+}
 
-    if (timer->next || timer->prev)
-        fatal("timer_enable - timer->next\n");
+static void
+timer_list_insert(pc_timer_t *timer)
+{
+    pc_timer_t *timer_node = timer_head;
+    pc_timer_t *prev;
 
     /*List currently empty - add to head*/
     if (!timer_head) {
         timer_head  = timer;
         timer->next = timer->prev = NULL;
-        timer_target              = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (TIMER_LESS_THAN(timer, timer_head)) {
+        return;
+    }
+
+    if (TIMER_LESS_THAN(timer, timer_head)) {
         timer->next      = timer_head;
         timer->prev      = NULL;
         timer_head->prev = timer;
         timer_head       = timer;
-        timer_target     = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (!timer_head->next) {
-        timer_head->next = timer;
-        timer->prev      = timer_head;
-        ret = 1;
-    }
-
-    if (ret == 0) {
-        pc_timer_t *prev = timer_head;
-        timer_node       = timer_head->next;
-
-        while (1) {
-            /*Timer expires before timer_node. Add to list in front of timer_node*/
-            if (TIMER_LESS_THAN(timer, timer_node)) {
-                timer->next      = timer_node;
-                timer->prev      = prev;
-                timer_node->prev = timer;
-                prev->next       = timer;
-                ret = 1;
-                break;
-            }
-
-            /*timer_node is last in the list. Add timer to end of list*/
-            if (!timer_node->next) {
-                timer_node->next = timer;
-                timer->prev      = timer_node;
-                ret = 1;
-                break;
-            }
+        return;
+    }
 
-            prev       = timer_node;
-            timer_node = timer_node->next;
+    prev       = timer_head;
+    timer_node = timer_head->next;
+
+    while (timer_node) {
+        /*Timer expires before timer_node. Add to list in front of timer_node*/
+        if (TIMER_LESS_THAN(timer, timer_node)) {
+            timer->next      = timer_node;
+            timer->prev      = prev;
+            timer_node->prev = timer;
+            prev->next       = timer;
+            return;
         }
+
+        prev       = timer_node;
+        timer_node = timer_node->next;
     }
 
-    /* Do not mark it as enabled if it has failed every single condition. */
-    if (ret == 1)
-        timer->flags |= TIMER_ENABLED;
+    /*prev is last in the list. Add timer to end of list*/
+    prev->next  = timer;
+    timer->prev = prev;
+    timer->next = NULL;
+}
+
+static void
+timer_list_remove(pc_timer_t *timer)
+{
+    if (timer->prev)
+        timer->prev->next = timer->next;
+    else
+        timer_head = timer->next;
+    if (timer->next)
+        timer->next->prev = timer->prev;
+    timer->prev = timer->next = NULL;
+}
+
+/*Move every enabled timer from the list to the heap. The list is walked from
+  its tail, so that of the timers that expire at the same time, the one nearest
+  the head gets the latest sequence number and still runs first.*/
+static void
+timer_to_heap(void)
+{
+    pc_timer_t *timer = timer_head;
+
+    while (timer && timer->next)
+        timer = timer->next;
+
+    while (timer) {
+        pc_timer_t *prev = timer->prev;
+
+        timer->prev = timer->next = NULL;
+        timer_heap_insert(timer);
+        timer = prev;
+    }
+
+    timer_head     = NULL;
+    timer_use_heap = 1;
+}
+
+/*Move every enabled timer from the heap to the list, in the order they are to
+  run*/
+static void
+timer_to_list(void)
+{
+    pc_timer_t *tail = NULL;
+
+    if (timer_heap_hole)
+        timer_heap_close_hole();
+
+    while (timer_heap_size) {
+        pc_timer_t *timer = timer_heap[0].timer;
+
+        timer_heap_remove(timer);
+
+        timer->prev = tail;
+        timer->next = NULL;
+        if (tail)
+            tail->next = timer;
+        else
+            timer_head = timer;
+        tail = timer;
+    }
+
+    timer_use_heap = 0;
+}
+
+void
+timer_enable(pc_timer_t *timer)
+{
+    if (!timer_inited || (timer == NULL))
+        return;
+
+    if (timer->flags & TIMER_ENABLED)
+        timer_disable(timer);
+
+    if (timer->next || timer->prev || timer->heap_pos)
+        fatal("timer_enable - timer->next\n");
+
+    if (!timer_use_heap && (timer_count >= TIMER_HEAP_ON))
+        timer_to_heap();
+
+    if (timer_use_heap) {
+        timer_heap_insert(timer);
+
+        if (timer->heap_pos == 1)
+            timer_target = timer->ts.ts32.integer;
+    } else {
+        timer_list_insert(timer);
+
+        if (timer == timer_head)
+            timer_target = timer->ts.ts32.integer;
+    }
+
+    timer_count++;
+
+    timer->flags |= TIMER_ENABLED;
 }
 
 void
@@ -90,19 +331,21 @@ timer_disable(pc_timer_t *timer)
     if (!timer_inited || (timer == NULL) || !(timer->flags & TIMER_ENABLED))
         return;
 
-    if (!timer->next && !timer->prev && timer != timer_head)
+    if (timer_use_heap) {
+        if (!timer->heap_pos || (timer->heap_pos > timer_heap_size) || (timer_heap[timer->heap_pos - 1].timer != timer))
+            fatal("timer_disable - !timer->heap_pos\n");
+    } else if (!timer->next && !timer->prev && (timer != timer_head))
         fatal("timer_disable - !timer->next\n");
 
     timer->flags &= ~TIMER_ENABLED;
     timer->in_callback = 0;
 
-    if (timer->prev)
-        timer->prev->next = timer->next;
+    if (timer_use_heap)
+        timer_heap_remove(timer);
     else
-        timer_head = timer->next;
-    if (timer->next)
-        timer->next->prev = timer->prev;
-    timer->prev = timer->next = NULL;
+        timer_list_remove(timer);
+
+    timer_count--;
 }
 
 void
@@ -110,20 +353,33 @@ timer_process(void)
 {
     pc_timer_t *timer;
 
-    if (!timer_head)
-        return;
-
     while (1) {
-        timer = timer_head;
+        if (timer_use_heap) {
+            if (timer_heap_hole)
+                timer_heap_close_hole();
 
-        if (!TIMER_LESS_THAN_VAL(timer, (uint32_t) tsc))
-            break;
+            if (!timer_heap_size || !TIMER_VAL_LESS_THAN_VAL((uint32_t) (timer_heap[0].ts >> 32), (uint32_t) tsc))
+                break;
 
-        timer_head = timer->next;
-        if (timer_head)
-            timer_head->prev = NULL;
+            timer = timer_heap[0].timer;
 
-        timer->next = timer->prev = NULL;
+            /* Leave the root empty for the callback to re-arm into. */
+            timer_heap_hole = 1;
+            timer->heap_pos = 0;
+        } else {
+            timer = timer_head;
+
+            if (!timer || !TIMER_LESS_THAN_VAL(timer, (uint32_t) tsc))
+                break;
+
+            timer_head = timer->next;
+            if (timer_head)
+                timer_head->prev = NULL;
+
+            timer->next = timer->prev = NULL;
+        }
+
+        timer_count--;
         timer->flags &= ~TIMER_ENABLED;
 
         if (timer->flags & TIMER_SPLIT)
@@ -139,7 +395,36 @@ timer_process(void)
         }
     }
 
-    timer_target = timer_head->ts.ts32.integer;
+    if (timer_use_heap && (timer_count < TIMER_HEAP_OFF))
+        timer_to_list();
+
+    if (timer_use_heap && timer_heap_size)
+        timer_target = timer_heap[0].timer->ts.ts32.integer;
+    else if (!timer_use_heap && timer_head)
+        timer_target = timer_head->ts.ts32.integer;
+}
+
+/*Move every enabled timer by delay, in 32:32 format, such as when the TSC
+  is changed under them. All the timers move together, so their order
+  holds.*/
+void
+timer_shift(uint64_t delay)
+{
+    if (timer_heap_hole)
+        timer_heap_close_hole();
+
+    for (pc_timer_t *timer = timer_head; timer != NULL; timer = timer->next)
+        timer->ts.ts64 += delay;
+
+    for (int i = 0; i < timer_heap_size; i++) {
+        timer_heap[i].ts += delay;
+        timer_heap[i].timer->ts.ts64 += delay;
+    }
+
+    if (timer_use_heap && timer_heap_size)
+        timer_target = timer_heap[0].timer->ts.ts32.integer;
+    else if (!timer_use_heap && timer_head)
+        timer_target = timer_head->ts.ts32.integer;
 }
 
 void
@@ -148,16 +433,26 @@ timer_close(void)
     pc_timer_t *t = timer_head;
     pc_timer_t *r;
 
-    /* Set all timers' prev and next to NULL so it is assured that
-       timers that are not in malloc'd structs don't keep pointing
-       to timers that may be in malloc'd structs. */
+    /* Set all timers' prev and next to NULL and clear their heap positions,
+       so it is assured that timers that are not in malloc'd structs don't
+       keep pointing to timers that may be in malloc'd structs, or look
+       enabled to a heap that no longer holds them. */
     while (t != NULL) {
         r       = t;
+        t       = r->next;
         r->prev = r->next = NULL;
-        t                 = r->next;
     }
-
-    timer_head = NULL;
+    for (int i = timer_heap_hole; i < timer_heap_size; i++)
+        timer_heap[i].timer->heap_pos = 0;
+
+    free(timer_heap);
+    timer_head       = NULL;
+    timer_count      = 0;
+    timer_use_heap   = 0;
+    timer_heap       = NULL;
+    timer_heap_size  = 0;
+    timer_heap_alloc = 0;
+    timer_heap_hole  = 0;
 
     timer_inited = 0;
 }
@@ -181,6 +476,7 @@ timer_add(pc_timer_t *timer, void (*callback)(void *priv), void *priv, int start
     timer->priv        = priv;
     timer->flags       = 0;
     timer->prev        = timer->next = NULL;
+    timer->heap_pos    = 0;
     if (start_timer)
         timer_set_delay_u64(timer, 0);
 }
@@ -253,3 +549,126 @@ timer_on_auto(pc_timer_t *timer, double period)
     else
         timer_stop(timer);
 }
+
+/* The timer benchmark starts here. */
+#define TIMER_BENCH_PERIODIC 0
+#define TIMER_BENCH_RANDOM   1
+#define TIMER_BENCH_CHURN    2
+
+#define TIMER_BENCH_STEPS    250000
+
+typedef struct timer_bench_t {
+    pc_timer_t timer;
+    uint64_t   period;
+    int        id;
+} timer_bench_t;
+
+static uint32_t timer_bench_seed;
+static uint32_t timer_bench_hash;
+static uint64_t timer_bench_count;
+static int      timer_bench_mode;
+
+static uint32_t
+timer_bench_rand(void)
+{
+    timer_bench_seed = (timer_bench_seed * 1103515245) + 12345;
+
+    return timer_bench_seed >> 16;
+}
+
+/*A period of 0.25 to 1250 cycles, in 32:32 format*/
+static uint64_t
+timer_bench_period(void)
+{
+    return ((uint64_t) (1 + (timer_bench_rand() % 5000))) << 30;
+}
+
+static void
+timer_bench_callback(void *priv)
+{
+    timer_bench_t *dev = (timer_bench_t *) priv;
+
+    timer_bench_count++;
+    timer_bench_hash = (timer_bench_hash * 31) + dev->id;
+
+    if (timer_bench_mode == TIMER_BENCH_RANDOM)
+        timer_advance_u64(&dev->timer, timer_bench_period());
+    else
+        timer_advance_u64(&dev->timer, dev->period);
+}
+
+static void
+timer_bench_run(int mode, int num)
+{
+    static const char *names[] = { "periodic", "random", "churn" };
+    timer_bench_t     *devs    = (timer_bench_t *) calloc(num, sizeof(timer_bench_t));
+    uint64_t           ops;
+    uint32_t           start;
+    uint32_t           elapsed;
+
+    if (devs == NULL)
+        fatal("timer_bench_run - out of memory\n");
+
+    timer_init();
+    timer_bench_seed  = 1;
+    timer_bench_hash  = 0;
+    timer_bench_count = 0;
+    timer_bench_mode  = mode;
+
+    for (int i = 0; i < num; i++) {
+        devs[i].period = timer_bench_period();
+        devs[i].id     = i;
+        timer_add(&devs[i].timer, timer_bench_callback, &devs[i], 1);
+    }
+
+    start = plat_get_ticks();
+    for (int i = 0; i < TIMER_BENCH_STEPS; i++) {
+        timer_bench_t *dev = &devs[timer_bench_rand() % num];
+
+        if (mode == TIMER_BENCH_CHURN) {
+            /* Re-arm without ever letting a timer run, for the cost of
+               enabling and disabling alone. */
+            timer_disable(&dev->timer);
+            timer_set_delay_u64(&dev->timer, TIMER_USEC + timer_bench_period());
+            continue;
+        }
+
+        /* Run the timers as the CPU would, then re-arm one of them as a
+           device would on a register write. */
+        tsc += 50;
+        if (TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) tsc))
+            timer_process();
+
+        timer_disable(&dev->timer);
+        timer_set_delay_u64(&dev->timer, dev->period);
+    }
+    elapsed = plat_get_ticks() - start;
+
+    timer_close();
+    free(devs);
+
+    ops = timer_bench_count + (TIMER_BENCH_STEPS * 2);
+    printf("%-8s %3i timers: %5u ms, %10" PRIu64 " callbacks, %6.1f ns/op, order %08X\n",
+           names[mode], num, elapsed, timer_bench_count,
+           ((double) elapsed * 1000000.0) / (double) ops, timer_bench_hash);
+}
+
+/*Time enabling, disabling and processing timers at typical timer counts. The
+  timers run at 100 MHz, with periods of 0.25 to 1250 cycles, and one of them
+  is re-armed by hand every 50 cycles. The callback order hash must not change
+  between timer implementations.*/
+void
+timer_benchmark(void)
+{
+    static const int nums[] = { 8, 32, 64, 256 };
+    uint64_t         old_usec = TIMER_USEC;
+
+    TIMER_USEC = 100ULL << 32;
+
+    for (int mode = TIMER_BENCH_PERIODIC; mode <= TIMER_BENCH_CHURN; mode++) {
+        for (int i = 0; i < (int) (sizeof(nums) / sizeof(nums[0])); i++)
+            timer_bench_run(mode, nums[i]);
+    }
+
+    TIMER_USEC = old_usec;
+}
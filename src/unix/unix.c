@@ -1,6 +1,7 @@
 #ifdef __linux__
 #    define _FILE_OFFSET_BITS   64
 #    define _LARGEFILE64_SOURCE 1
+#    define _GNU_SOURCE         1
 #endif
 #include <SDL.h>
 #include <stdlib.h>
@@ -13,6 +14,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 #include <inttypes.h>
@@ -44,6 +46,8 @@
 #include <86box/video.h>
 #include <86box/ui.h>
 #include <86box/gdbstub.h>
+#include <86box/hdd.h>
+#include <86box/plat_unused.h>
 
 #define __USE_GNU 1 /* shouldn't be done, yet it is */
 #include <pthread.h>
@@ -417,6 +421,41 @@ plat_munmap(void *ptr, size_t size)
     munmap(ptr, size);
 }
 
+void *
+plat_mmap_file(FILE *fp, uint64_t size, int writable)
+{
+    void *ret;
+
+    if ((size == 0) || (size > SIZE_MAX))
+        return NULL;
+
+    fflush(fp);
+    ret = mmap(0, (size_t) size, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fileno(fp), 0);
+    return (ret == MAP_FAILED) ? NULL : ret;
+}
+
+void
+plat_munmap_file(void *ptr, uint64_t size)
+{
+    munmap(ptr, (size_t) size);
+}
+
+void
+plat_msync_file(void *ptr, uint64_t size, int wait)
+{
+    msync(ptr, (size_t) size, wait ? MS_SYNC : MS_ASYNC);
+}
+
+int
+plat_file_punch_hole(FILE *fp, uint64_t offset, uint64_t size)
+{
+#if defined __linux__ && defined FALLOC_FL_PUNCH_HOLE
+    return fallocate(fileno(fp), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t) offset, (off_t) size);
+#else
+    return -1;
+#endif
+}
+
 uint64_t
 plat_timer_read(void)
 {
@@ -549,6 +588,12 @@ main_thread(void *param)
 #endif
             drawits += (new_time - old_time);
         old_time = new_time;
+
+        /* Headless runs are not paced to the wall clock at all, guest time
+           only advances with the emulated cycles in each slice. */
+        if (run_headless)
+            drawits = 10;
+
         if (drawits > 0 && !dopause) {
             /* Yes, so do one frame now. */
             drawits -= 10;
@@ -582,6 +627,13 @@ main_thread(void *param)
 
 thread_t *thMain = NULL;
 
+/* Nothing is ever shown in headless mode, so hand the buffer straight back. */
+static void
+headless_blit(UNUSED(int x), UNUSED(int y), UNUSED(int w), UNUSED(int h), int monitor_index)
+{
+    video_blit_complete_monitor(monitor_index);
+}
+
 void
 do_start(void)
 {
@@ -962,6 +1014,8 @@ monitor_thread(void *param)
                         "zipeject <id> - eject ZIP image from ZIP drive <id>.\n"
                         "carteject <id> - eject cartridge from drive <id>.\n"
                         "moeject <id> - eject image from MO drive <id>.\n\n"
+                        "hddcommit <id> - write the overlay of hard disk <id> back into its image.\n"
+                        "hdddiscard <id> - throw away the overlay of hard disk <id>.\n\n"
                         "hardreset - hard reset the emulated system.\n"
                         "pause - pause the the emulated system.\n"
                         "fullscreen - toggle fullscreen.\n"
@@ -1066,6 +1120,10 @@ monitor_thread(void *param)
                     cartridge_eject(atoi(xargv[1]));
                 } else if (strncasecmp(xargv[0], "zipeject", 8) == 0 && cmdargc >= 2) {
                     zip_eject(atoi(xargv[1]));
+                } else if (strncasecmp(xargv[0], "hddcommit", 9) == 0 && cmdargc >= 2) {
+                    hdd_image_overlay_request(atoi(xargv[1]), HDD_OVERLAY_COMMIT);
+                } else if (strncasecmp(xargv[0], "hdddiscard", 10) == 0 && cmdargc >= 2) {
+                    hdd_image_overlay_request(atoi(xargv[1]), HDD_OVERLAY_DISCARD);
                 } else if (strncasecmp(xargv[0], "fddload", 7) == 0 && cmdargc >= 4) {
                     uint8_t id;
                     uint8_t wp;
@@ -1200,9 +1258,14 @@ main(int argc, char **argv)
     } else
         fprintf(stderr, "libedit not found, line editing will be limited.\n");
     mousemutex = SDL_CreateMutex();
-    sdl_initho();
+    if (run_headless) {
+        /* Still wanted so that SIGINT/SIGTERM arrive as SDL_QUIT. */
+        SDL_InitSubSystem(SDL_INIT_EVENTS);
+        video_setblit(headless_blit);
+    } else
+        sdl_initho();
 
-    if (start_in_fullscreen) {
+    if (start_in_fullscreen && !run_headless) {
         video_fullscreen = 1;
         sdl_set_fs(1);
     }
@@ -1348,6 +1411,10 @@ main(int argc, char **argv)
             do_stop();
             break;
         }
+        /* Without a window there are no events to wait for; do not take
+           a host core away from the emulation thread. */
+        if (run_headless)
+            SDL_Delay(10);
     }
     printf("\n");
     SDL_DestroyMutex(blitmtx);
@@ -146,13 +146,20 @@ sdl_stretch(int *w, int *h, int *x, int *y)
 void
 sdl_blit_shim(int x, int y, int w, int h, int monitor_index)
 {
+    int dirty_y;
+    int dirty_h;
+
     params.x = x;
     params.y = y;
     params.w = w;
     params.h = h;
 
+    /* pixeldata still holds the previous frame, only copy what changed. */
+    video_blit_dirty_rows_monitor(&dirty_y, &dirty_h, monitor_index);
+    dirty_y -= y;
+
     if (!(!sdl_enabled || (x < 0) || (y < 0) || (w <= 0) || (h <= 0) || (w > 2048) || (h > 2048) || (buffer32 == NULL) || (sdl_render == NULL) || (sdl_tex == NULL)) || (monitor_index >= 1))
-        for (int row = 0; row < h; ++row)
+        for (int row = dirty_y; row < (dirty_y + dirty_h); ++row)
             video_copy(&(((uint8_t *) pixeldata)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
 
     if (monitors[monitor_index].mon_screenshots)
@@ -24,6 +24,8 @@
 #include <86box/device.h>
 #include <86box/mem.h>
 #include <86box/agpgart.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
 #include <86box/plat_unused.h>
 
 #ifdef ENABLE_AGPGART_LOG
@@ -146,6 +148,35 @@ agpgart_init(UNUSED(const device_t *info))
     return dev;
 }
 
+static void
+agpgart_save(void *priv, snapshot_t *s)
+{
+    const agpgart_t *dev = (agpgart_t *) priv;
+
+    snapshot_write_var(s, dev->aperture_enable);
+    snapshot_write_var(s, dev->aperture_base);
+    snapshot_write_var(s, dev->aperture_size);
+    snapshot_write_var(s, dev->gart_base);
+}
+
+static void
+agpgart_load(void *priv, snapshot_t *s)
+{
+    agpgart_t *dev = (agpgart_t *) priv;
+    int        enable;
+    uint32_t   base;
+    uint32_t   size;
+    uint32_t   gart_base;
+
+    snapshot_read_var(s, enable);
+    snapshot_read_var(s, base);
+    snapshot_read_var(s, size);
+    snapshot_read_var(s, gart_base);
+
+    agpgart_set_aperture(dev, base, size, enable);
+    agpgart_set_gart(dev, gart_base);
+}
+
 static void
 agpgart_close(void *priv)
 {
@@ -170,5 +201,7 @@ const device_t agpgart_device = {
     { .available = NULL },
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save          = agpgart_save,
+    .load          = agpgart_load
 };
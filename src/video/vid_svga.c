@@ -21,6 +21,7 @@
  */
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -44,6 +45,7 @@
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
 #include <86box/vid_xga_device.h>
+#include <86box/snapshot.h>
 
 void svga_doblit(int wx, int wy, svga_t *svga);
 void svga_poll(void *priv);
@@ -974,17 +976,37 @@ svga_recalctimings(svga_t *svga)
     }
 }
 
+/* Note that a row of the target buffer has been written to this frame, so
+   that svga_doblit() can tell the blitter which rows actually changed. */
+static void
+svga_mark_dirty(svga_t *svga, int line)
+{
+    if (line < svga->dirty_first)
+        svga->dirty_first = line;
+    if (line > svga->dirty_last)
+        svga->dirty_last = line;
+}
+
 static void
 svga_do_render(svga_t *svga)
 {
+    int firstline_draw = svga->firstline_draw;
+    int lastline_draw  = svga->lastline_draw;
+
     /* Always render a blank screen and nothing else while in DPMS mode. */
     if (svga->dpms) {
         svga_render_blank(svga);
+        if ((svga->firstline_draw != firstline_draw) || (svga->lastline_draw != lastline_draw))
+            svga_mark_dirty(svga, svga->displine + svga->y_add);
         return;
     }
 
     if (!svga->override) {
         svga->render(svga);
+        /* The renderers only update firstline_draw/lastline_draw when they
+           actually redraw the line. */
+        if ((svga->firstline_draw != firstline_draw) || (svga->lastline_draw != lastline_draw))
+            svga_mark_dirty(svga, svga->displine + svga->y_add);
 
         svga->x_add = (svga->monitor->mon_overscan_x >> 1);
         svga_render_overscan_left(svga);
@@ -993,24 +1015,30 @@ svga_do_render(svga_t *svga)
     }
 
     if (svga->overlay_on) {
-        if (!svga->override && svga->overlay_draw)
+        if (!svga->override && svga->overlay_draw) {
             svga->overlay_draw(svga, svga->displine + svga->y_add);
+            svga_mark_dirty(svga, svga->displine + svga->y_add);
+        }
         svga->overlay_on--;
         if (svga->overlay_on && svga->interlace)
             svga->overlay_on--;
     }
 
     if (svga->dac_hwcursor_on) {
-        if (!svga->override && svga->dac_hwcursor_draw)
+        if (!svga->override && svga->dac_hwcursor_draw) {
             svga->dac_hwcursor_draw(svga, (svga->displine + svga->y_add + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y)) & 2047);
+            svga_mark_dirty(svga, (svga->displine + svga->y_add + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y)) & 2047);
+        }
         svga->dac_hwcursor_on--;
         if (svga->dac_hwcursor_on && svga->interlace)
             svga->dac_hwcursor_on--;
     }
 
     if (svga->hwcursor_on) {
-        if (!svga->override && svga->hwcursor_draw)
+        if (!svga->override && svga->hwcursor_draw) {
             svga->hwcursor_draw(svga, (svga->displine + svga->y_add + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y)) & 2047);
+            svga_mark_dirty(svga, (svga->displine + svga->y_add + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y)) & 2047);
+        }
         svga->hwcursor_on--;
         if (svga->hwcursor_on && svga->interlace)
             svga->hwcursor_on--;
@@ -1218,6 +1246,7 @@ svga_poll(void *priv)
             wx = x;
 
             if (!svga->override) {
+                svga->dirty_valid = 1;
                 if (svga->vertical_linedbl) {
                     wy = (svga->lastline - svga->firstline) << 1;
                     svga_doblit(wx, wy, svga);
@@ -1233,6 +1262,10 @@ svga_poll(void *priv)
             svga->firstline_draw = 2000;
             svga->lastline_draw  = 0;
 
+            svga->dirty_valid = 0;
+            svga->dirty_first = 2048;
+            svga->dirty_last  = -1;
+
             svga->oddeven ^= 1;
 
             svga->monitor->mon_changeframecount = svga->interlace ? 3 : 2;
@@ -1401,6 +1434,72 @@ svga_close(svga_t *svga)
     svga_pri = NULL;
 }
 
+/* Save the state of the VGA core, for the snapshot callbacks of the cards
+   built on it. The callbacks and the RAMDAC, clock and 8514/A pointers are
+   set up by the card at init, so only the registers, the raster and the
+   video memory are saved; the cards save their own extended state. */
+void
+svga_save(svga_t *svga, snapshot_t *s)
+{
+    snapshot_write_var(s, svga->vram_max);
+    snapshot_write_var(s, svga->mapping.base);
+    snapshot_write_var(s, svga->mapping.size);
+    snapshot_write_var(s, svga->mapping.enable);
+
+    snapshot_write(s, &svga->fast, offsetof(svga_t, map8) - offsetof(svga_t, fast));
+    snapshot_write_var(s, svga->pallook);
+    snapshot_write_var(s, svga->vgapal);
+    snapshot_write_var(s, svga->dispontime);
+    snapshot_write_var(s, svga->dispofftime);
+    snapshot_write_var(s, svga->latch);
+    snapshot_write_timer(s, &svga->timer);
+    snapshot_write(s, &svga->hwcursor, offsetof(svga_t, render) - offsetof(svga_t, hwcursor));
+    snapshot_write(s, svga->crtc, offsetof(svga_t, vram) - offsetof(svga_t, crtc));
+    snapshot_write(s, &svga->crtcreg, offsetof(svga_t, remap_func) - offsetof(svga_t, crtcreg));
+    snapshot_write(s, svga->vram, svga->vram_max);
+}
+
+void
+svga_load(svga_t *svga, snapshot_t *s)
+{
+    uint32_t vram_max;
+    uint32_t base;
+    uint32_t size;
+    int      enable;
+
+    snapshot_read_var(s, vram_max);
+    if (vram_max != svga->vram_max) {
+        pclog("SVGA: snapshot has %u bytes of video memory, this card has %u\n", vram_max, svga->vram_max);
+        snapshot_set_error(s);
+        return;
+    }
+
+    snapshot_read_var(s, base);
+    snapshot_read_var(s, size);
+    snapshot_read_var(s, enable);
+
+    snapshot_read(s, &svga->fast, offsetof(svga_t, map8) - offsetof(svga_t, fast));
+    snapshot_read_var(s, svga->pallook);
+    snapshot_read_var(s, svga->vgapal);
+    snapshot_read_var(s, svga->dispontime);
+    snapshot_read_var(s, svga->dispofftime);
+    snapshot_read_var(s, svga->latch);
+    snapshot_read_timer(s, &svga->timer);
+    snapshot_read(s, &svga->hwcursor, offsetof(svga_t, render) - offsetof(svga_t, hwcursor));
+    snapshot_read(s, svga->crtc, offsetof(svga_t, vram) - offsetof(svga_t, crtc));
+    snapshot_read(s, &svga->crtcreg, offsetof(svga_t, remap_func) - offsetof(svga_t, crtcreg));
+    snapshot_read(s, svga->vram, svga->vram_max);
+
+    if (enable)
+        mem_mapping_set_addr(&svga->mapping, base, size);
+    else
+        mem_mapping_disable(&svga->mapping);
+
+    memset(svga->changedvram, 0xff, svga->vram_max >> 12);
+    svga_recalctimings(svga);
+    svga->fullchange = changeframecount;
+}
+
 static uint32_t
 svga_decode_addr(svga_t *svga, uint32_t addr, int write)
 {
@@ -1827,6 +1926,10 @@ svga_doblit(int wx, int wy, svga_t *svga)
     int       j;
     int       xs_temp;
     int       ys_temp;
+    int       dirty_y;
+    int       dirty_h;
+    int       full   = !svga->dirty_valid;
+    uint32_t  border = svga->dpms ? 0 : svga->overscan_color;
 
     y_add   = enable_overscan ? svga->monitor->mon_overscan_y : 0;
     x_add   = enable_overscan ? svga->monitor->mon_overscan_x : 0;
@@ -1857,6 +1960,8 @@ svga_doblit(int wx, int wy, svga_t *svga)
 
     if ((svga->crtc[0x17] & 0x80) && ((xs_temp != svga->monitor->mon_xsize) || (ys_temp != svga->monitor->mon_ysize) || video_force_resize_get_monitor(svga->monitor_index))) {
         /* Screen res has changed.. fix up, and let them know. */
+        full = 1;
+
         svga->monitor->mon_xsize = xs_temp;
         svga->monitor->mon_ysize = ys_temp;
 
@@ -1895,7 +2000,21 @@ svga_doblit(int wx, int wy, svga_t *svga)
         }
     }
 
-    video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
+    /* Only the rows the renderers wrote to need to be blitted, unless the
+       overscan around them changed, or this is not a regular end of frame. */
+    if (full || (border != svga->dirty_border) || (svga->y_add != svga->dirty_y_add) || (svga->scrollcache != svga->dirty_scrollcache)) {
+        dirty_y = y_start;
+        dirty_h = svga->monitor->mon_ysize + y_add;
+    } else {
+        dirty_y = svga->dirty_first;
+        dirty_h = svga->dirty_last - svga->dirty_first + 1;
+    }
+
+    svga->dirty_border      = border;
+    svga->dirty_y_add       = svga->y_add;
+    svga->dirty_scrollcache = svga->scrollcache;
+
+    video_blit_memtoscreen_dirty_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, dirty_y, dirty_h, svga->monitor_index);
 
     if (svga->vertical_linedbl)
         svga->vertical_linedbl >>= 1;
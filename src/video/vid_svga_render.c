@@ -30,6 +30,14 @@
 #include <86box/vid_svga_render.h>
 #include <86box/vid_svga_render_remap.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#    include <emmintrin.h>
+#    define SVGA_RENDER_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#    include <arm_neon.h>
+#    define SVGA_RENDER_NEON
+#endif
+
 uint32_t
 svga_lookup_lut_ram(svga_t* svga, uint32_t val)
 {
@@ -44,6 +52,142 @@ svga_lookup_lut_ram(svga_t* svga, uint32_t val)
 
 #define lookup_lut(val) svga_lookup_lut_ram(svga, val)
 
+/* Line kernels for the high resolution direct color renderers, used when
+   neither address remapping nor the RAMDAC LUT are in use. SSE2 and NEON are
+   only used where they are part of the target's baseline instruction set, so
+   no run-time selection is needed; the scalar loops are kept for everything
+   else and as the reference. Results match video_15to32[], video_16to32[]
+   and lookup_lut() exactly.
+
+   5 and 6-bit components are expanded as (c * 255) / 31 and (c * 255) / 63,
+   which is what calc_15to32() and calc_16to32() produce, using:
+     (c * 255) / 31 == (c * 1053) >> 7
+     (c * 255) / 63 == (c << 2) + ((c * 49) >> 10) */
+
+/* Pointer to len bytes of VRAM starting at svga->ma, if they do not wrap
+   around the display mask. */
+static uint8_t *
+svga_render_run(svga_t *svga, uint32_t len)
+{
+    uint32_t addr = svga->ma & svga->vram_display_mask;
+
+    if ((svga->vram_display_mask & (svga->vram_display_mask + 1)) || ((addr + len - 1) > svga->vram_display_mask))
+        return NULL;
+
+    return &svga->vram[addr];
+}
+
+static void
+svga_render_line_16to32(uint32_t *p, const uint8_t *src, int count, int bpp)
+{
+    const uint32_t *table = (bpp == 15) ? video_15to32 : video_16to32;
+    int             x     = 0;
+
+#if defined(SVGA_RENDER_SSE2)
+    const __m128i mask5 = _mm_set1_epi16(0x1f);
+    const __m128i mask6 = _mm_set1_epi16(0x3f);
+    const __m128i mul5  = _mm_set1_epi16(1053);
+    const __m128i mul6  = _mm_set1_epi16(49);
+
+    for (; (x + 8) <= count; x += 8) {
+        __m128i dat = _mm_loadu_si128((const __m128i *) &src[x << 1]);
+        __m128i b   = _mm_and_si128(dat, mask5);
+        __m128i g;
+        __m128i r;
+
+        if (bpp == 15) {
+            g = _mm_and_si128(_mm_srli_epi16(dat, 5), mask5);
+            r = _mm_and_si128(_mm_srli_epi16(dat, 10), mask5);
+            g = _mm_srli_epi16(_mm_mullo_epi16(g, mul5), 7);
+        } else {
+            g = _mm_and_si128(_mm_srli_epi16(dat, 5), mask6);
+            r = _mm_srli_epi16(dat, 11);
+            g = _mm_add_epi16(_mm_slli_epi16(g, 2), _mm_srli_epi16(_mm_mullo_epi16(g, mul6), 10));
+        }
+        b = _mm_srli_epi16(_mm_mullo_epi16(b, mul5), 7);
+        r = _mm_srli_epi16(_mm_mullo_epi16(r, mul5), 7);
+
+        b = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        _mm_storeu_si128((__m128i *) &p[x], _mm_unpacklo_epi16(b, r));
+        _mm_storeu_si128((__m128i *) &p[x + 4], _mm_unpackhi_epi16(b, r));
+    }
+#elif defined(SVGA_RENDER_NEON)
+    const uint16x8_t mask5 = vdupq_n_u16(0x1f);
+    const uint16x8_t mask6 = vdupq_n_u16(0x3f);
+
+    for (; (x + 8) <= count; x += 8) {
+        uint16x8_t   dat = vreinterpretq_u16_u8(vld1q_u8(&src[x << 1]));
+        uint16x8_t   b   = vandq_u16(dat, mask5);
+        uint16x8_t   g;
+        uint16x8_t   r;
+        uint16x8x2_t out;
+
+        if (bpp == 15) {
+            g = vandq_u16(vshrq_n_u16(dat, 5), mask5);
+            r = vandq_u16(vshrq_n_u16(dat, 10), mask5);
+            g = vshrq_n_u16(vmulq_n_u16(g, 1053), 7);
+        } else {
+            g = vandq_u16(vshrq_n_u16(dat, 5), mask6);
+            r = vshrq_n_u16(dat, 11);
+            g = vaddq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(vmulq_n_u16(g, 49), 10));
+        }
+        b = vshrq_n_u16(vmulq_n_u16(b, 1053), 7);
+        r = vshrq_n_u16(vmulq_n_u16(r, 1053), 7);
+
+        out = vzipq_u16(vorrq_u16(b, vshlq_n_u16(g, 8)), r);
+        vst1q_u32(&p[x], vreinterpretq_u32_u16(out.val[0]));
+        vst1q_u32(&p[x + 4], vreinterpretq_u32_u16(out.val[1]));
+    }
+#endif
+
+    for (; x < count; x++)
+        p[x] = table[*(const uint16_t *) &src[x << 1]];
+}
+
+static void
+svga_render_line_24to32(uint32_t *p, const uint8_t *src, int count)
+{
+    int x = 0;
+
+#if defined(SVGA_RENDER_NEON)
+    for (; (x + 16) <= count; x += 16) {
+        uint8x16x3_t dat = vld3q_u8(&src[x * 3]);
+        uint8x16x4_t out;
+
+        out.val[0] = dat.val[0];
+        out.val[1] = dat.val[1];
+        out.val[2] = dat.val[2];
+        out.val[3] = vdupq_n_u8(0);
+        vst4q_u8((uint8_t *) &p[x], out);
+    }
+#endif
+
+    /* SSE2 has no byte shuffle, so 24 bpp stays scalar there. */
+    for (; x < count; x++)
+        p[x] = src[x * 3] | (src[(x * 3) + 1] << 8) | (src[(x * 3) + 2] << 16);
+}
+
+static void
+svga_render_line_32to32(uint32_t *p, const uint8_t *src, int count)
+{
+    int x = 0;
+
+#if defined(SVGA_RENDER_SSE2)
+    const __m128i mask = _mm_set1_epi32(0x00ffffff);
+
+    for (; (x + 4) <= count; x += 4)
+        _mm_storeu_si128((__m128i *) &p[x], _mm_and_si128(_mm_loadu_si128((const __m128i *) &src[x << 2]), mask));
+#elif defined(SVGA_RENDER_NEON)
+    const uint32x4_t mask = vdupq_n_u32(0x00ffffff);
+
+    for (; (x + 4) <= count; x += 4)
+        vst1q_u32(&p[x], vandq_u32(vreinterpretq_u32_u8(vld1q_u8(&src[x << 2])), mask));
+#endif
+
+    for (; x < count; x++)
+        p[x] = *(const uint32_t *) &src[x << 2] & 0xffffff;
+}
+
 void
 svga_render_null(svga_t *svga)
 {
@@ -1136,6 +1280,8 @@ svga_render_15bpp_highres(svga_t *svga)
     uint32_t  dat;
     uint32_t  changed_addr;
     uint32_t  addr;
+    int       count;
+    uint8_t  *src;
 
     if ((svga->displine + svga->y_add) < 0)
         return;
@@ -1179,24 +1325,32 @@ svga_render_15bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                count = ((svga->hdisp + svga->scrollcache) & ~7) + 8;
+                src   = (svga->conv_16to32 == svga_conv_16to32) ? svga_render_run(svga, count << 1) : NULL;
 
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                if (src) {
+                    svga_render_line_16to32(p, src, count, 15);
+                    svga->ma += count << 1;
+                } else {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 15);
+                    }
+                    svga->ma += x << 1;
                 }
-                svga->ma += x << 1;
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 2) {
                     addr = svga->remap_func(svga, svga->ma);
@@ -1368,6 +1522,8 @@ svga_render_16bpp_highres(svga_t *svga)
     uint32_t  dat;
     uint32_t  changed_addr;
     uint32_t  addr;
+    int       count;
+    uint8_t  *src;
 
     if ((svga->displine + svga->y_add) < 0)
         return;
@@ -1411,24 +1567,32 @@ svga_render_16bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
-
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                count = ((svga->hdisp + svga->scrollcache) & ~7) + 8;
+                src   = (svga->conv_16to32 == svga_conv_16to32) ? svga_render_run(svga, count << 1) : NULL;
 
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
-                    *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
-                    *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                if (src) {
+                    svga_render_line_16to32(p, src, count, 16);
+                    svga->ma += count << 1;
+                } else {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 4) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 8) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 1) + 12) & svga->vram_display_mask]);
+                        *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
+                        *p++ = svga->conv_16to32(svga, dat >> 16, 16);
+                    }
+                    svga->ma += x << 1;
                 }
-                svga->ma += x << 1;
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 2) {
                     addr = svga->remap_func(svga, svga->ma);
@@ -1532,6 +1696,8 @@ svga_render_24bpp_highres(svga_t *svga)
     uint32_t  dat1;
     uint32_t  dat2;
     uint32_t  dat;
+    int       count;
+    uint8_t  *src;
 
     if ((svga->displine + svga->y_add) < 0)
         return;
@@ -1572,17 +1738,25 @@ svga_render_24bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
-                    dat0 = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
-                    dat1 = *(uint32_t *) (&svga->vram[(svga->ma + 4) & svga->vram_display_mask]);
-                    dat2 = *(uint32_t *) (&svga->vram[(svga->ma + 8) & svga->vram_display_mask]);
+                count = ((svga->hdisp + svga->scrollcache) & ~3) + 4;
+                src   = !svga->lut_map ? svga_render_run(svga, count * 3) : NULL;
 
-                    *p++ = lookup_lut(dat0 & 0xffffff);
-                    *p++ = lookup_lut((dat0 >> 24) | ((dat1 & 0xffff) << 8));
-                    *p++ = lookup_lut((dat1 >> 16) | ((dat2 & 0xff) << 16));
-                    *p++ = lookup_lut(dat2 >> 8);
+                if (src) {
+                    svga_render_line_24to32(p, src, count);
+                    svga->ma += count * 3;
+                } else {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
+                        dat0 = *(uint32_t *) (&svga->vram[svga->ma & svga->vram_display_mask]);
+                        dat1 = *(uint32_t *) (&svga->vram[(svga->ma + 4) & svga->vram_display_mask]);
+                        dat2 = *(uint32_t *) (&svga->vram[(svga->ma + 8) & svga->vram_display_mask]);
 
-                    svga->ma += 12;
+                        *p++ = lookup_lut(dat0 & 0xffffff);
+                        *p++ = lookup_lut((dat0 >> 24) | ((dat1 & 0xffff) << 8));
+                        *p++ = lookup_lut((dat1 >> 16) | ((dat2 & 0xff) << 16));
+                        *p++ = lookup_lut(dat2 >> 8);
+
+                        svga->ma += 12;
+                    }
                 }
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
@@ -1670,6 +1844,8 @@ svga_render_32bpp_highres(svga_t *svga)
     uint32_t  dat;
     uint32_t  changed_addr;
     uint32_t  addr;
+    int       count;
+    uint8_t  *src;
 
     if ((svga->displine + svga->y_add) < 0)
         return;
@@ -1700,11 +1876,19 @@ svga_render_32bpp_highres(svga_t *svga)
             svga->lastline_draw = svga->displine;
 
             if (!svga->remap_required) {
-                for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
-                    dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 2)) & svga->vram_display_mask]);
-                    *p++ = lookup_lut(dat & 0xffffff);
+                count = svga->hdisp + svga->scrollcache + 1;
+                src   = !svga->lut_map ? svga_render_run(svga, count << 2) : NULL;
+
+                if (src) {
+                    svga_render_line_32to32(p, src, count);
+                    svga->ma += count << 2;
+                } else {
+                    for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
+                        dat  = *(uint32_t *) (&svga->vram[(svga->ma + (x << 2)) & svga->vram_display_mask]);
+                        *p++ = lookup_lut(dat & 0xffffff);
+                    }
+                    svga->ma += (x * 4);
                 }
-                svga->ma += (x * 4);
             } else {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
                     addr = svga->remap_func(svga, svga->ma);
@@ -30,6 +30,7 @@
 #include <86box/video.h>
 #include <86box/vid_svga.h>
 #include <86box/vid_vga.h>
+#include <86box/snapshot.h>
 
 static video_timings_t timing_ps1_svga_isa = { .type = VIDEO_ISA, .write_b = 6, .write_w = 8, .write_l = 16, .read_b = 6, .read_w = 8, .read_l = 16 };
 static video_timings_t timing_ps1_svga_mca = { .type = VIDEO_MCA, .write_b = 6, .write_w = 8, .write_l = 16, .read_b = 6, .read_w = 8, .read_l = 16 };
@@ -169,6 +170,22 @@ vga_close(void *priv)
     free(vga);
 }
 
+static void
+vga_save(void *priv, snapshot_t *s)
+{
+    vga_t *vga = (vga_t *) priv;
+
+    svga_save(&vga->svga, s);
+}
+
+static void
+vga_load(void *priv, snapshot_t *s)
+{
+    vga_t *vga = (vga_t *) priv;
+
+    svga_load(&vga->svga, s);
+}
+
 void
 vga_speed_changed(void *priv)
 {
@@ -196,7 +213,9 @@ const device_t vga_device = {
     { .available = vga_available },
     .speed_changed = vga_speed_changed,
     .force_redraw  = vga_force_redraw,
-    .config        = NULL
+    .config        = NULL,
+    .save          = vga_save,
+    .load          = vga_load
 };
 
 const device_t ps1vga_device = {
@@ -210,7 +229,9 @@ const device_t ps1vga_device = {
     { .available = vga_available },
     .speed_changed = vga_speed_changed,
     .force_redraw  = vga_force_redraw,
-    .config        = NULL
+    .config        = NULL,
+    .save          = vga_save,
+    .load          = vga_load
 };
 
 const device_t ps1vga_mca_device = {
@@ -224,5 +245,7 @@ const device_t ps1vga_mca_device = {
     { .available = vga_available },
     .speed_changed = vga_speed_changed,
     .force_redraw  = vga_force_redraw,
-    .config        = NULL
+    .config        = NULL,
+    .save          = vga_save,
+    .load          = vga_load
 };
@@ -1084,7 +1084,7 @@ banshee_status(banshee_t *banshee)
     int           fifo_entries = FIFO_ENTRIES;
     int           swap_count   = voodoo->swap_count;
     int           written      = voodoo->cmd_written + voodoo->cmd_written_fifo;
-    int           busy         = (written - voodoo->cmd_read) || (voodoo->cmdfifo_depth_rd != voodoo->cmdfifo_depth_wr) || voodoo->render_voodoo_busy[0] || voodoo->render_voodoo_busy[1] || voodoo->render_voodoo_busy[2] || voodoo->render_voodoo_busy[3] || voodoo->voodoo_busy;
+    int           busy         = (written - voodoo->cmd_read) || (voodoo->cmdfifo_depth_rd != voodoo->cmdfifo_depth_wr) || voodoo->params_pending || voodoo->voodoo_busy;
     uint32_t      ret          = 0;
 
     if (fifo_entries < 0x20)
@@ -3084,12 +3084,43 @@ static const device_config_t banshee_sgram_config[] = {
                 .description = "4",
                 .value = 4
             },
+            {
+                .description = "8",
+                .value = 8
+            },
+            {
+                .description = "16",
+                .value = 16
+            },
             {
                 .description = ""
             }
         },
         .default_int = 2
     },
+    {
+        .name = "texture_cache",
+        .description = "Texture cache entries",
+        .type = CONFIG_SELECTION,
+        .selection = {
+            {
+                .description = "64",
+                .value = 64
+            },
+            {
+                .description = "256",
+                .value = 256
+            },
+            {
+                .description = "1024",
+                .value = 1024
+            },
+            {
+                .description = ""
+            }
+        },
+        .default_int = 256
+    },
 #ifndef NO_CODEGEN
     {
         .name = "recompiler",
@@ -3139,12 +3170,43 @@ static const device_config_t banshee_sgram_16mbonly_config[] = {
                 .description = "4",
                 .value = 4
             },
+            {
+                .description = "8",
+                .value = 8
+            },
+            {
+                .description = "16",
+                .value = 16
+            },
             {
                 .description = ""
             }
         },
         .default_int = 2
     },
+    {
+        .name = "texture_cache",
+        .description = "Texture cache entries",
+        .type = CONFIG_SELECTION,
+        .selection = {
+            {
+                .description = "64",
+                .value = 64
+            },
+            {
+                .description = "256",
+                .value = 256
+            },
+            {
+                .description = "1024",
+                .value = 1024
+            },
+            {
+                .description = ""
+            }
+        },
+        .default_int = 256
+    },
 #ifndef NO_CODEGEN
     {
         .name = "recompiler",
@@ -3194,12 +3256,43 @@ static const device_config_t banshee_sdram_config[] = {
                 .description = "4",
                 .value = 4
             },
+            {
+                .description = "8",
+                .value = 8
+            },
+            {
+                .description = "16",
+                .value = 16
+            },
             {
                 .description = ""
             }
         },
         .default_int = 2
     },
+    {
+        .name = "texture_cache",
+        .description = "Texture cache entries",
+        .type = CONFIG_SELECTION,
+        .selection = {
+            {
+                .description = "64",
+                .value = 64
+            },
+            {
+                .description = "256",
+                .value = 256
+            },
+            {
+                .description = "1024",
+                .value = 1024
+            },
+            {
+                .description = ""
+            }
+        },
+        .default_int = 256
+    },
 #ifndef NO_CODEGEN
     {
         .name = "recompiler",
@@ -665,7 +665,7 @@ int voodoo_recomp = 0;
 #endif
 
 static void
-voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int ystart, int yend, int odd_even)
+voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int ystart, int yend, int thread, int bin)
 {
 #if 0
     int rgb_sel                 = params->fbzColorPath & 3;
@@ -713,8 +713,8 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
     //        voodoo_render_log("voodoo_triangle : bottom-half %X %X %X %X %X %i  %i %i %i\n", xstart, xend, dx1, dx2, dx2 * 36, xdir,  y, yend, ydir);
 
     for (uint8_t c = 0; c <= LOD_MAX; c++) {
-        state->tex[0][c] = &voodoo->texture_cache[0][params->tex_entry[0]].data[texture_offset[c]];
-        state->tex[1][c] = &voodoo->texture_cache[1][params->tex_entry[1]].data[texture_offset[c]];
+        state->tex[0][c] = voodoo_texture_data(&voodoo->texture_cache[0][params->tex_entry[0]], c);
+        state->tex[1][c] = voodoo_texture_data(&voodoo->texture_cache[1][params->tex_entry[1]], c);
     }
 
     state->tformat = params->tformat[0];
@@ -786,7 +786,7 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
     }
 #ifndef NO_CODEGEN
     if (voodoo->use_recompiler)
-        voodoo_draw = voodoo_get_block(voodoo, params, state, odd_even);
+        voodoo_draw = voodoo_get_block(voodoo, params, state, thread);
     else
         voodoo_draw = NULL;
 #endif
@@ -830,13 +830,8 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
         else
             real_y >>= 4;
 
-        if (SLI_ENABLED) {
-            if (((real_y >> 1) & voodoo->odd_even_mask) != odd_even)
-                goto next_line;
-        } else {
-            if ((real_y & voodoo->odd_even_mask) != odd_even)
-                goto next_line;
-        }
+        if (VOODOO_BIN(voodoo, SLI_ENABLED ? (real_y >> 1) : real_y) != bin)
+            goto next_line;
 
         start_x = x;
 
@@ -945,8 +940,8 @@ voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *
                 int x_tiled = (x & 63) | ((x >> 6) * 128 * 32 / 2);
                 start_x     = x;
                 state->x    = x;
-                voodoo->pixel_count[odd_even]++;
-                voodoo->texel_count[odd_even] += texels;
+                voodoo->pixel_count[thread]++;
+                voodoo->texel_count[thread] += texels;
                 voodoo->fbiPixelsIn++;
 
                 voodoo_render_log("  X=%03i T=%08x\n", x, state->tmu0_t);
@@ -1347,8 +1342,8 @@ skip_pixel:
                 x += state->xdir;
             } while (start_x != x2);
 
-        voodoo->pixel_count[odd_even] += state->pixel_count;
-        voodoo->texel_count[odd_even] += state->texel_count;
+        voodoo->pixel_count[thread] += state->pixel_count;
+        voodoo->texel_count[thread] += state->texel_count;
         voodoo->fbiPixelsIn += state->pixel_count;
 
         if (voodoo->params.draw_offset == voodoo->params.front_offset && (real_y >> 1) < 2048)
@@ -1386,13 +1381,10 @@ next_line:
         state->xstart += state->dx1;
         state->xend += state->dx2;
     }
-
-    voodoo->texture_cache[0][params->tex_entry[0]].refcount_r[odd_even]++;
-    voodoo->texture_cache[1][params->tex_entry[1]].refcount_r[odd_even]++;
 }
 
-void
-voodoo_triangle(voodoo_t *voodoo, voodoo_params_t *params, int odd_even)
+static void
+voodoo_triangle(voodoo_t *voodoo, voodoo_params_t *params, int thread, int bin)
 {
     voodoo_state_t state = { 0 };
     int            vertexAy_adjusted;
@@ -1408,8 +1400,6 @@ voodoo_triangle(voodoo_t *voodoo, voodoo_params_t *params, int odd_even)
 
     state.dx1 = state.dx2 = 0;
 
-    voodoo->tri_count++;
-
     dx = 8 - (params->vertexAx & 0xf);
     if ((params->vertexAx & 0xf) > 8)
         dx += 16;
@@ -1417,7 +1407,7 @@ voodoo_triangle(voodoo_t *voodoo, voodoo_params_t *params, int odd_even)
     if ((params->vertexAy & 0xf) > 8)
         dy += 16;
 
-    /*        voodoo_render_log("voodoo_triangle %i %i %i : vA %f, %f  vB %f, %f  vC %f, %f f %i,%i %08x %08x %08x,%08x tex=%i,%i fogMode=%08x\n", odd_even, voodoo->params_read_idx[odd_even], voodoo->params_read_idx[odd_even] & PARAM_MASK, (float)params->vertexAx / 16.0, (float)params->vertexAy / 16.0,
+    /*        voodoo_render_log("voodoo_triangle %i %i : vA %f, %f  vB %f, %f  vC %f, %f f %i,%i %08x %08x %08x,%08x tex=%i,%i fogMode=%08x\n", thread, bin, (float)params->vertexAx / 16.0, (float)params->vertexAy / 16.0,
                                                                          (float)params->vertexBx / 16.0, (float)params->vertexBy / 16.0,
                                                                          (float)params->vertexCx / 16.0, (float)params->vertexCy / 16.0,
                                                                          (params->fbzColorPath & FBZCP_TEXTURE_ENABLED) ? params->tformat[0] : 0,
@@ -1451,8 +1441,6 @@ voodoo_triangle(voodoo_t *voodoo, voodoo_params_t *params, int odd_even)
         state.base_w += (dx * params->dWdX + dy * params->dWdY) >> 4;
     }
 
-    tris++;
-
     state.vertexAy = params->vertexAy & ~0xffff0000;
     if (state.vertexAy & 0x8000)
         state.vertexAy |= 0xffff0000;
@@ -1536,82 +1524,202 @@ voodoo_triangle(voodoo_t *voodoo, voodoo_params_t *params, int odd_even)
         lodbias |= ~0x3f;
     state.tmu[1].lod = LOD + (lodbias << 6);
 
-    voodoo_half_triangle(voodoo, params, &state, vertexAy_adjusted, vertexCy_adjusted, odd_even);
+    voodoo_half_triangle(voodoo, params, &state, vertexAy_adjusted, vertexCy_adjusted, thread, bin);
+}
+
+/*Work out which bins the lines of a triangle fall in. This follows the
+  clipping and Y origin handling in voodoo_half_triangle(), but ignores the
+  SLI line skip, so may take in one line too many.*/
+static uint64_t
+voodoo_bin_mask(voodoo_t *voodoo, const voodoo_params_t *params)
+{
+    int      y_origin = (voodoo->type >= VOODOO_BANSHEE) ? voodoo->y_origin_swap : (voodoo->v_disp - 1);
+    int      ystart   = ((int16_t) params->vertexAy + 7) >> 4;
+    int      yend     = ((int16_t) params->vertexCy + 7) >> 4;
+    int      bin_start;
+    int      bin_end;
+    uint64_t mask = 0;
+
+    if (voodoo->render_bins == 1)
+        return 1;
+
+    if (params->fbzMode & 1) {
+        if (ystart < params->clipLowY)
+            ystart = params->clipLowY;
+        if (yend > params->clipHighY)
+            yend = params->clipHighY;
+    }
+
+    /*Triangles that draw nothing still go through a bin, so that their
+      textures are released in order*/
+    if (ystart >= yend)
+        return 1;
+
+    if (params->fbzMode & (1 << 17)) {
+        int temp = y_origin - (yend - 1);
+
+        yend   = y_origin - ystart;
+        ystart = temp;
+    } else
+        yend--;
+
+    if (SLI_ENABLED) {
+        ystart >>= 1;
+        yend >>= 1;
+    }
+
+    bin_start = ystart >> VOODOO_BIN_SHIFT;
+    bin_end   = yend >> VOODOO_BIN_SHIFT;
+    if ((bin_end - bin_start) >= (voodoo->render_bins - 1))
+        return ~0ULL >> (64 - voodoo->render_bins);
+
+    for (int c = bin_start; c <= bin_end; c++)
+        mask |= 1ULL << (c & (voodoo->render_bins - 1));
+
+    return mask;
 }
 
 static void
-render_thread(void *param, int odd_even)
+voodoo_retire_triangle(voodoo_t *voodoo, int idx, const int *tex_entry)
 {
-    voodoo_t *voodoo = (voodoo_t *) param;
+    voodoo->texture_cache[0][tex_entry[0]].refcount_r++;
+    voodoo->texture_cache[1][tex_entry[1]].refcount_r++;
 
-    while (voodoo->render_thread_run[odd_even]) {
-        thread_set_event(voodoo->render_not_full_event[odd_even]);
-        thread_wait_event(voodoo->wake_render_thread[odd_even], -1);
-        thread_reset_event(voodoo->wake_render_thread[odd_even]);
-        voodoo->render_voodoo_busy[odd_even] = 1;
+    /*voodoo_queue_triangle() may be waiting for this entry, and
+      voodoo_wait_for_render_thread_idle() for the last one*/
+    if ((--voodoo->params_pending == 0) || (idx == (voodoo->params_write_idx & PARAM_MASK)))
+        thread_set_event(voodoo->render_not_full_event);
+}
 
-        while (!PARAM_EMPTY(odd_even)) {
-            uint64_t         start_time = plat_timer_read();
-            uint64_t         end_time;
-            voodoo_params_t *params = &voodoo->params_buffer[voodoo->params_read_idx[odd_even] & PARAM_MASK];
+/*Draw all of the triangles queued in a bin, unless another thread is already
+  drawing it. Returns 1 if the bin was claimed.*/
+static int
+voodoo_render_bin(voodoo_t *voodoo, int thread, int bin_nr)
+{
+    voodoo_bin_t *bin      = &voodoo->bins[bin_nr];
+    int           expected = 0;
+    uint64_t      start_time;
 
-            voodoo_triangle(voodoo, params, odd_even);
+    if (BIN_EMPTY(bin_nr) || !atomic_compare_exchange_strong(&bin->claimed, &expected, 1))
+        return 0;
 
-            voodoo->params_read_idx[odd_even]++;
+    start_time = plat_timer_read();
 
-            if (PARAM_ENTRIES(odd_even) > (PARAM_SIZE - 10))
-                thread_set_event(voodoo->render_not_full_event[odd_even]);
+    while (!BIN_EMPTY(bin_nr)) {
+        int              idx    = bin->params[bin->read_idx & PARAM_MASK];
+        voodoo_params_t *params = &voodoo->params_buffer[idx];
+        int              tex_entry[2];
 
-            end_time = plat_timer_read();
-            voodoo->render_time[odd_even] += end_time - start_time;
-        }
+        /*The entry may be reused as soon as the last bin is done with it*/
+        tex_entry[0] = params->tex_entry[0];
+        tex_entry[1] = params->tex_entry[1];
+
+        voodoo_triangle(voodoo, params, thread, bin_nr);
+
+        bin->read_idx++;
 
-        voodoo->render_voodoo_busy[odd_even] = 0;
+        if (atomic_fetch_sub(&voodoo->params_bins_left[idx], 1) == 1)
+            voodoo_retire_triangle(voodoo, idx, tex_entry);
     }
+
+    bin->claimed = 0;
+
+    voodoo->render_time[thread] += plat_timer_read() - start_time;
+
+    return 1;
 }
 
-void
-voodoo_render_thread_1(void *param)
+static int
+voodoo_render_bins_waiting(voodoo_t *voodoo)
 {
-    render_thread(param, 0);
+    for (int c = 0; c < voodoo->render_bins; c++) {
+        if (!BIN_EMPTY(c) && !voodoo->bins[c].claimed)
+            return 1;
+    }
+
+    return 0;
 }
-void
-voodoo_render_thread_2(void *param)
+
+static void
+voodoo_render_thread(void *param)
 {
-    render_thread(param, 1);
+    voodoo_render_thread_t *data   = (voodoo_render_thread_t *) param;
+    voodoo_t               *voodoo = data->voodoo;
+    int                     thread = data->index;
+    /*Each thread starts looking for work at a different bin, so threads
+      tend to stay on the same part of the screen, and only take bins from
+      elsewhere once their own are done*/
+    int first = (thread * voodoo->render_bins) / voodoo->render_threads;
+
+    while (voodoo->render_thread_run[thread]) {
+        thread_wait_event(voodoo->wake_render_thread[thread], -1);
+        thread_reset_event(voodoo->wake_render_thread[thread]);
+        voodoo->render_voodoo_busy[thread] = 1;
+
+        while (1) {
+            int claimed = 0;
+
+            for (int c = 0; c < voodoo->render_bins; c++)
+                claimed |= voodoo_render_bin(voodoo, thread, (first + c) & (voodoo->render_bins - 1));
+
+            if (claimed)
+                continue;
+
+            /*voodoo_queue_triangle() doesn't wake busy threads, so check
+              again once idle in case a triangle was queued in between*/
+            voodoo->render_voodoo_busy[thread] = 0;
+            if (!voodoo_render_bins_waiting(voodoo))
+                break;
+            voodoo->render_voodoo_busy[thread] = 1;
+        }
+    }
 }
+
 void
-voodoo_render_thread_3(void *param)
+voodoo_render_threads_init(voodoo_t *voodoo)
 {
-    render_thread(param, 2);
+    if (voodoo->render_threads < 1)
+        voodoo->render_threads = 1;
+    else if (voodoo->render_threads > VOODOO_RENDER_THREADS_MAX)
+        voodoo->render_threads = VOODOO_RENDER_THREADS_MAX;
+
+    voodoo->render_bins           = (voodoo->render_threads > 1) ? VOODOO_BINS : 1;
+    voodoo->render_not_full_event = thread_create_event();
+
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        voodoo->render_thread_data[c].voodoo = voodoo;
+        voodoo->render_thread_data[c].index  = c;
+        voodoo->wake_render_thread[c]        = thread_create_event();
+        voodoo->render_thread_run[c]         = 1;
+        voodoo->render_thread[c]             = thread_create(voodoo_render_thread, &voodoo->render_thread_data[c]);
+    }
 }
+
 void
-voodoo_render_thread_4(void *param)
+voodoo_render_threads_close(voodoo_t *voodoo)
 {
-    render_thread(param, 3);
+    for (int c = 0; c < voodoo->render_threads; c++) {
+        voodoo->render_thread_run[c] = 0;
+        thread_set_event(voodoo->wake_render_thread[c]);
+        thread_wait(voodoo->render_thread[c]);
+        thread_destroy_event(voodoo->wake_render_thread[c]);
+    }
+
+    thread_destroy_event(voodoo->render_not_full_event);
 }
 
 void
 voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 {
-    voodoo_params_t *params_new = &voodoo->params_buffer[voodoo->params_write_idx & PARAM_MASK];
-
-    while (PARAM_FULL(0) || (voodoo->render_threads >= 2 && PARAM_FULL(1)) || (voodoo->render_threads == 4 && (PARAM_FULL(2) || PARAM_FULL(3)))) {
-        thread_reset_event(voodoo->render_not_full_event[0]);
-        if (voodoo->render_threads >= 2)
-            thread_reset_event(voodoo->render_not_full_event[1]);
-        if (voodoo->render_threads == 4) {
-            thread_reset_event(voodoo->render_not_full_event[2]);
-            thread_reset_event(voodoo->render_not_full_event[3]);
-        }
-        if (PARAM_FULL(0))
-            thread_wait_event(voodoo->render_not_full_event[0], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads >= 2 && PARAM_FULL(1))
-            thread_wait_event(voodoo->render_not_full_event[1], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads == 4 && PARAM_FULL(2))
-            thread_wait_event(voodoo->render_not_full_event[2], -1); /*Wait for room in ringbuffer*/
-        if (voodoo->render_threads == 4 && PARAM_FULL(3))
-            thread_wait_event(voodoo->render_not_full_event[3], -1); /*Wait for room in ringbuffer*/
+    int              idx        = voodoo->params_write_idx & PARAM_MASK;
+    voodoo_params_t *params_new = &voodoo->params_buffer[idx];
+    uint64_t         mask;
+    int              bins = 0;
+
+    while (PARAM_FULL) {
+        thread_reset_event(voodoo->render_not_full_event);
+        if (PARAM_FULL)
+            thread_wait_event(voodoo->render_not_full_event, -1); /*Wait for room in ringbuffer*/
     }
 
     voodoo_use_texture(voodoo, params, 0);
@@ -1620,8 +1728,34 @@ voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 
     memcpy(params_new, params, sizeof(voodoo_params_t));
 
+    mask = voodoo_bin_mask(voodoo, params_new);
+    for (int c = 0; c < voodoo->render_bins; c++) {
+        if (mask & (1ULL << c))
+            bins++;
+    }
+
+    voodoo->params_bins_left[idx] = bins;
+    voodoo->params_pending++;
     voodoo->params_write_idx++;
 
-    if (PARAM_ENTRIES(0) < 4 || (voodoo->render_threads >= 2 && PARAM_ENTRIES(1) < 4) || (voodoo->render_threads == 4 && (PARAM_ENTRIES(2) < 4 || PARAM_ENTRIES(3) < 4)))
-        voodoo_wake_render_thread(voodoo);
+    voodoo->tri_count++;
+    tris++;
+
+    for (int c = 0; c < voodoo->render_bins; c++) {
+        if (mask & (1ULL << c)) {
+            voodoo_bin_t *bin = &voodoo->bins[c];
+
+            bin->params[bin->write_idx & PARAM_MASK] = idx;
+            bin->write_idx++;
+        }
+    }
+
+    /*Busy threads pick up new work themselves, so only wake as many idle
+      threads as there are bins to draw*/
+    for (int c = 0; (c < voodoo->render_threads) && (bins > 0); c++) {
+        if (!voodoo->render_voodoo_busy[c]) {
+            thread_set_event(voodoo->wake_render_thread[c]);
+            bins--;
+        }
+    }
 }
@@ -239,15 +239,115 @@ voodoo_recalc_tex3(voodoo_t *voodoo, int tmu)
 
 #define makergba(r, g, b, a) ((b) | ((g) << 8) | ((r) << 16) | ((a) << 24))
 
+/*Decoded textures are allocated this many texels larger than they need to be,
+  as bilinear filtering may read one texel and one row past the end*/
+#define TEX_DATA_PAD (256 + 2)
+
+static int
+voodoo_texture_hash(const voodoo_t *voodoo, uint32_t base, uint32_t tLOD, uint32_t palette_checksum)
+{
+    uint32_t hash = base ^ (tLOD * 0x9e3779b1) ^ (palette_checksum * 0x85ebca6b);
+
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6d;
+    hash ^= hash >> 13;
+
+    /*There are twice as many hash chains as cache entries*/
+    return hash & ((voodoo->texture_cache_size << 1) - 1);
+}
+
+static void
+voodoo_texture_hash_remove(voodoo_t *voodoo, int tmu, int c)
+{
+    texture_t *texture = &voodoo->texture_cache[tmu][c];
+    int       *entry   = &voodoo->texture_hash[tmu][voodoo_texture_hash(voodoo, texture->base, texture->tLOD, texture->palette_checksum)];
+
+    while (*entry != -1) {
+        if (*entry == c) {
+            *entry = texture->hash_next;
+            break;
+        }
+        entry = &voodoo->texture_cache[tmu][*entry].hash_next;
+    }
+}
+
+/*Get the range of texture memory that a texture was decoded from, as an offset
+  and length into texture memory. The range may wrap past the end of texture
+  memory.*/
+static uint32_t
+voodoo_texture_range(const voodoo_t *voodoo, const texture_t *texture, int d, uint32_t *start)
+{
+    *start = texture->addr_start[d] & voodoo->texture_mask;
+
+    return (texture->addr_end[d] - texture->addr_start[d]) & voodoo->texture_mask;
+}
+
+/*Add or remove a texture from the counts of cached textures in each page of
+  texture memory, which texture writes check before flushing the cache*/
+static void
+voodoo_texture_mark_present(voodoo_t *voodoo, int tmu, const texture_t *texture, int delta)
+{
+    uint32_t page_mask = voodoo->texture_mask >> TEX_DIRTY_SHIFT;
+
+    for (uint8_t d = 0; d < 4; d++) {
+        uint32_t start;
+        uint32_t len;
+        uint32_t pages;
+
+        if (texture->addr_end[d] == 0)
+            continue;
+
+        len = voodoo_texture_range(voodoo, texture, d, &start);
+        if (!len)
+            continue;
+
+        pages = ((start & ((1 << TEX_DIRTY_SHIFT) - 1)) + len - 1) >> TEX_DIRTY_SHIFT;
+        for (uint32_t page = 0; page <= pages; page++)
+            voodoo->texture_present[tmu][((start >> TEX_DIRTY_SHIFT) + page) & page_mask] += delta;
+    }
+}
+
+/*Pick the least recently used texture that no queued triangle is using,
+  preferring empty entries*/
+static int
+voodoo_texture_find_free(voodoo_t *voodoo, int tmu)
+{
+    while (1) {
+        int      c_free = -1;
+        uint32_t oldest = 0;
+
+        for (int c = 0; c < voodoo->texture_cache_size; c++) {
+            const texture_t *texture = &voodoo->texture_cache[tmu][c];
+            uint32_t         age     = voodoo->texture_lru - texture->lru;
+
+            if (texture->refcount != texture->refcount_r)
+                continue;
+            if (texture->base == -1)
+                return c;
+            if ((c_free == -1) || (age > oldest)) {
+                c_free = c;
+                oldest = age;
+            }
+        }
+        if (c_free != -1)
+            return c_free;
+
+        voodoo_wait_for_render_thread_idle(voodoo);
+    }
+}
+
 void
 voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
 {
-    int      c;
-    int      lod_min;
-    int      lod_max;
-    uint32_t addr = 0;
-    uint32_t addr_end;
-    uint32_t palette_checksum;
+    texture_t *texture;
+    int        c;
+    int        lod_min;
+    int        lod_max;
+    int        hash;
+    int        size;
+    uint32_t   addr = 0;
+    uint32_t   tLOD = params->tLOD[tmu] & 0xf00fff;
+    uint32_t   palette_checksum;
 
     lod_min = (params->tLOD[tmu] >> 2) & 15;
     lod_max = (params->tLOD[tmu] >> 8) & 15;
@@ -271,36 +371,42 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     else
         addr = params->texBaseAddr[tmu];
 
+    voodoo->texture_lru++;
+
     /*Try to find texture in cache*/
-    for (c = 0; c < TEX_CACHE_MAX; c++) {
-        if (voodoo->texture_cache[tmu][c].base == addr && voodoo->texture_cache[tmu][c].tLOD == (params->tLOD[tmu] & 0xf00fff) && voodoo->texture_cache[tmu][c].palette_checksum == palette_checksum) {
+    hash = voodoo_texture_hash(voodoo, addr, tLOD, palette_checksum);
+    for (c = voodoo->texture_hash[tmu][hash]; c != -1; c = voodoo->texture_cache[tmu][c].hash_next) {
+        texture = &voodoo->texture_cache[tmu][c];
+
+        if (texture->base == addr && texture->tLOD == tLOD && texture->palette_checksum == palette_checksum) {
             params->tex_entry[tmu] = c;
-            voodoo->texture_cache[tmu][c].refcount++;
+            texture->refcount++;
+            texture->lru = voodoo->texture_lru;
+            voodoo->texture_hits++;
             return;
         }
     }
 
-    /*Texture not found, search for unused texture*/
-    do {
-        for (c = 0; c < TEX_CACHE_MAX; c++) {
-            voodoo->texture_last_removed++;
-            voodoo->texture_last_removed &= (TEX_CACHE_MAX - 1);
-            if (voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[0] && (voodoo->render_threads == 1 || voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[1]))
-                break;
-        }
-        if (c == TEX_CACHE_MAX)
-            voodoo_wait_for_render_thread_idle(voodoo);
-    } while (c == TEX_CACHE_MAX);
-    if (c == TEX_CACHE_MAX)
-        fatal("Texture cache full!\n");
+    /*Texture not found, replace the least recently used one*/
+    voodoo->texture_misses++;
+    if (!(voodoo->texture_misses & 0xfff))
+        voodoo_texture_log("Texture cache: %u hits, %u misses, %u evictions\n", voodoo->texture_hits, voodoo->texture_misses, voodoo->texture_evictions);
 
-    c = voodoo->texture_last_removed;
+    c       = voodoo_texture_find_free(voodoo, tmu);
+    texture = &voodoo->texture_cache[tmu][c];
 
-    if ((voodoo->params.tLOD[tmu] & LOD_SPLIT) && (voodoo->params.tLOD[tmu] & LOD_ODD) && (voodoo->params.tLOD[tmu] & LOD_TMULTIBASEADDR))
-        voodoo->texture_cache[tmu][c].base = params->texBaseAddr1[tmu];
-    else
-        voodoo->texture_cache[tmu][c].base = params->texBaseAddr[tmu];
-    voodoo->texture_cache[tmu][c].tLOD = params->tLOD[tmu] & 0xf00fff;
+    if (texture->base != -1) {
+        voodoo_texture_hash_remove(voodoo, tmu, c);
+        voodoo_texture_mark_present(voodoo, tmu, texture, -1);
+    }
+
+    texture->base             = addr;
+    texture->tLOD             = tLOD;
+    texture->palette_checksum = palette_checksum;
+    texture->lru              = voodoo->texture_lru;
+    texture->hash_next        = voodoo->texture_hash[tmu][hash];
+
+    voodoo->texture_hash[tmu][hash] = c;
 
     lod_min = (params->tLOD[tmu] >> 2) & 15;
     lod_max = (params->tLOD[tmu] >> 8) & 15;
@@ -309,8 +415,26 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
 #endif
     lod_min = MIN(lod_min, 8);
     lod_max = MIN(lod_max, 8);
+
+    /*Only allocate room for the LODs in use. Levels may be larger than their
+      slot in texture_offset[], so size each one by its rows.*/
+    size = 0;
     for (int lod = lod_min; lod <= lod_max; lod++) {
-        uint32_t     *base     = &voodoo->texture_cache[tmu][c].data[texture_offset[lod]];
+        int shift    = MAX(8 - params->tex_lod[tmu][lod], params->tex_shift[tmu][lod]);
+        int lod_size = texture_offset[lod] - texture_offset[lod_min] + ((voodoo->params.tex_h_mask[tmu][lod] + 1) << shift);
+
+        size = MAX(size, lod_size);
+    }
+    size += TEX_DATA_PAD;
+    if (size > texture->data_size) {
+        free(texture->data);
+        texture->data      = malloc(size * sizeof(uint32_t));
+        texture->data_size = size;
+    }
+    texture->data_lod = lod_min;
+
+    for (int lod = lod_min; lod <= lod_max; lod++) {
+        uint32_t     *base     = voodoo_texture_data(texture, lod);
         uint32_t      tex_addr = params->tex_base[tmu][lod] & voodoo->texture_mask;
         int           x;
         int           y;
@@ -507,11 +631,6 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
 
     voodoo->texture_cache[tmu][c].is16 = voodoo->params.tformat[tmu] & 8;
 
-    if (params->tformat[tmu] == TEX_PAL8 || params->tformat[tmu] == TEX_APAL8 || params->tformat[tmu] == TEX_APAL88)
-        voodoo->texture_cache[tmu][c].palette_checksum = palette_checksum;
-    else
-        voodoo->texture_cache[tmu][c].palette_checksum = 0;
-
     if (lod_min == 0) {
         voodoo->texture_cache[tmu][c].addr_start[0] = voodoo->params.tex_base[tmu][0];
         voodoo->texture_cache[tmu][c].addr_end[0]   = voodoo->params.tex_end[tmu][0];
@@ -536,55 +655,51 @@ voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
     } else
         voodoo->texture_cache[tmu][c].addr_start[3] = voodoo->texture_cache[tmu][c].addr_end[3] = 0;
 
-    for (uint8_t d = 0; d < 4; d++) {
-        addr     = voodoo->texture_cache[tmu][c].addr_start[d];
-        addr_end = voodoo->texture_cache[tmu][c].addr_end[d];
-
-        if (addr_end != 0) {
-            for (; addr <= addr_end; addr += (1 << TEX_DIRTY_SHIFT))
-                voodoo->texture_present[tmu][(addr & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-        }
-    }
+    voodoo_texture_mark_present(voodoo, tmu, texture, 1);
 
     params->tex_entry[tmu] = c;
-    voodoo->texture_cache[tmu][c].refcount++;
+    texture->refcount++;
 }
 
+/*Evict the textures decoded from a dword of texture memory that has been
+  written to. Only the textures that overlap the write are evicted, rather
+  than everything sharing a page with it.*/
 void
 flush_texture_cache(voodoo_t *voodoo, uint32_t dirty_addr, int tmu)
 {
     int wait_for_idle = 0;
 
-    memset(voodoo->texture_present[tmu], 0, sizeof(voodoo->texture_present[0]));
 #if 0
-    voodoo_texture_log("Evict %08x %i\n", dirty_addr, sizeof(voodoo->texture_present));
+    voodoo_texture_log("Evict %08x\n", dirty_addr);
 #endif
-    for (uint8_t c = 0; c < TEX_CACHE_MAX; c++) {
-        if (voodoo->texture_cache[tmu][c].base != -1) {
-            for (uint8_t d = 0; d < 4; d++) {
-                int addr_start = voodoo->texture_cache[tmu][c].addr_start[d];
-                int addr_end   = voodoo->texture_cache[tmu][c].addr_end[d];
-
-                if (addr_end != 0) {
-                    int addr_start_masked = addr_start & voodoo->texture_mask & ~0x3ff;
-                    int addr_end_masked   = ((addr_end & voodoo->texture_mask) + 0x3ff) & ~0x3ff;
-
-                    if (addr_end_masked < addr_start_masked)
-                        addr_end_masked = voodoo->texture_mask + 1;
-                    if (dirty_addr >= addr_start_masked && dirty_addr < addr_end_masked) {
+    for (int c = 0; c < voodoo->texture_cache_size; c++) {
+        texture_t *texture = &voodoo->texture_cache[tmu][c];
+
+        if (texture->base == -1)
+            continue;
+
+        for (uint8_t d = 0; d < 4; d++) {
+            uint32_t start;
+            uint32_t len;
+
+            if (texture->addr_end[d] == 0)
+                continue;
+
+            /*The dword overlaps the range if its last byte is less than
+              len + 3 bytes past the start, wrapping at the end of memory*/
+            len = voodoo_texture_range(voodoo, texture, d, &start);
+            if (len && (((dirty_addr + 3 - start) & voodoo->texture_mask) < (len + 3))) {
 #if 0
-                        voodoo_texture_log("  Evict texture %i %08x\n", c, voodoo->texture_cache[tmu][c].base);
+                voodoo_texture_log("  Evict texture %i %08x\n", c, texture->base);
 #endif
+                if (texture->refcount != texture->refcount_r)
+                    wait_for_idle = 1;
 
-                        if (voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[0] || (voodoo->render_threads == 2 && voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[1]))
-                            wait_for_idle = 1;
-
-                        voodoo->texture_cache[tmu][c].base = -1;
-                    } else {
-                        for (; addr_start <= addr_end; addr_start += (1 << TEX_DIRTY_SHIFT))
-                            voodoo->texture_present[tmu][(addr_start & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-                    }
-                }
+                voodoo_texture_hash_remove(voodoo, tmu, c);
+                voodoo_texture_mark_present(voodoo, tmu, texture, -1);
+                texture->base = -1;
+                voodoo->texture_evictions++;
+                break;
             }
         }
     }
@@ -592,6 +707,37 @@ flush_texture_cache(voodoo_t *voodoo, uint32_t dirty_addr, int tmu)
         voodoo_wait_for_render_thread_idle(voodoo);
 }
 
+void
+voodoo_texture_cache_init(voodoo_t *voodoo)
+{
+    int size = voodoo->texture_cache_size;
+
+    /*The size must be a power of two, for the hash*/
+    if ((size < TEX_CACHE_MIN) || (size > TEX_CACHE_MAX) || (size & (size - 1)))
+        voodoo->texture_cache_size = size = 256;
+
+    for (uint8_t tmu = 0; tmu < 2; tmu++) {
+        voodoo->texture_cache[tmu] = calloc(size, sizeof(texture_t));
+        voodoo->texture_hash[tmu]  = malloc((size << 1) * sizeof(int));
+
+        for (int c = 0; c < size; c++)
+            voodoo->texture_cache[tmu][c].base = -1; /*invalid*/
+        for (int c = 0; c < (size << 1); c++)
+            voodoo->texture_hash[tmu][c] = -1;
+    }
+}
+
+void
+voodoo_texture_cache_close(voodoo_t *voodoo)
+{
+    for (uint8_t tmu = 0; tmu < 2; tmu++) {
+        for (int c = 0; c < voodoo->texture_cache_size; c++)
+            free(voodoo->texture_cache[tmu][c].data);
+        free(voodoo->texture_cache[tmu]);
+        free(voodoo->texture_hash[tmu]);
+    }
+}
+
 void
 voodoo_tex_writel(uint32_t addr, uint32_t val, void *priv)
 {
@@ -236,6 +236,9 @@ const uint32_t shade[5][256] = {
 
 typedef struct blit_data_struct {
     int x, y, w, h;
+    int dirty_y, dirty_h;
+    int last_x, last_y, last_w, last_h;
+    int held;
     int busy;
     int buffer_in_use;
     int thread_run;
@@ -273,6 +276,14 @@ void
 video_setblit(void (*blit)(int, int, int, int, int))
 {
     blit_func = blit;
+
+    /* Make sure the new blitter gets a full frame to start with. */
+    for (uint8_t i = 0; i < MONITORS_NUM; i++) {
+        if (monitors[i].mon_blit_data_ptr) {
+            monitors[i].mon_blit_data_ptr->last_w = 0;
+            monitors[i].mon_blit_data_ptr->held   = 0;
+        }
+    }
 }
 
 void
@@ -460,27 +471,82 @@ blit_thread(void *param)
     }
 }
 
+/* Blit the given area, of which only rows dirty_y to dirty_y + dirty_h - 1
+   have changed since the previous blit. If the area is not the same as last
+   time, all of it is treated as changed. If nothing has changed, the blit is
+   skipped entirely, unless a screenshot is pending or the blit function is
+   still holding back rows from an earlier call. */
 void
-video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+video_blit_memtoscreen_dirty_monitor(int x, int y, int w, int h, int dirty_y, int dirty_h, int monitor_index)
 {
+    blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+
     MTR_BEGIN("video", "video_blit_memtoscreen");
 
     if ((w <= 0) || (h <= 0))
         return;
 
+    if ((x != blit_data_ptr->last_x) || (y != blit_data_ptr->last_y) || (w != blit_data_ptr->last_w) || (h != blit_data_ptr->last_h)) {
+        dirty_y = y;
+        dirty_h = h;
+    } else {
+        if (dirty_y < y) {
+            dirty_h -= (y - dirty_y);
+            dirty_y = y;
+        }
+        if ((dirty_y + dirty_h) > (y + h))
+            dirty_h = y + h - dirty_y;
+        if (dirty_h < 0)
+            dirty_h = 0;
+    }
+
+    if (!dirty_h && !blit_data_ptr->held && !monitors[monitor_index].mon_screenshots) {
+        MTR_END("video", "video_blit_memtoscreen");
+        return;
+    }
+
     video_wait_for_blit_monitor(monitor_index);
 
-    monitors[monitor_index].mon_blit_data_ptr->busy          = 1;
-    monitors[monitor_index].mon_blit_data_ptr->buffer_in_use = 1;
-    monitors[monitor_index].mon_blit_data_ptr->x             = x;
-    monitors[monitor_index].mon_blit_data_ptr->y             = y;
-    monitors[monitor_index].mon_blit_data_ptr->w             = w;
-    monitors[monitor_index].mon_blit_data_ptr->h             = h;
+    blit_data_ptr->busy          = 1;
+    blit_data_ptr->buffer_in_use = 1;
+    blit_data_ptr->x             = blit_data_ptr->last_x = x;
+    blit_data_ptr->y             = blit_data_ptr->last_y = y;
+    blit_data_ptr->w             = blit_data_ptr->last_w = w;
+    blit_data_ptr->h             = blit_data_ptr->last_h = h;
+    blit_data_ptr->dirty_y       = dirty_y;
+    blit_data_ptr->dirty_h       = dirty_h;
 
-    thread_set_event(monitors[monitor_index].mon_blit_data_ptr->wake_blit_thread);
+    thread_set_event(blit_data_ptr->wake_blit_thread);
     MTR_END("video", "video_blit_memtoscreen");
 }
 
+void
+video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+{
+    video_blit_memtoscreen_dirty_monitor(x, y, w, h, y, h, monitor_index);
+}
+
+/* Rows of the area being blitted that changed since the previous blit. Only
+   valid from within the blit function; anything outside these rows is the
+   same as what was passed to the previous call. */
+void
+video_blit_dirty_rows_monitor(int *y, int *h, int monitor_index)
+{
+    const blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+
+    *y = blit_data_ptr->dirty_y;
+    *h = blit_data_ptr->dirty_h;
+}
+
+/* Called from within the blit function when it did not show all the rows it
+   was given, so that it keeps getting called while the image stays the same
+   until it has caught up. */
+void
+video_blit_set_held_monitor(int held, int monitor_index)
+{
+    monitors[monitor_index].mon_blit_data_ptr->held = held;
+}
+
 uint8_t
 pixels8(uint32_t *pixels)
 {
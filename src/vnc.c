@@ -37,6 +37,14 @@
 #define VNC_MIN_Y 200
 #define VNC_MAX_Y 2048
 
+/* Changes are found and sent in tiles of this size. */
+#define VNC_TILE_W 64
+#define VNC_TILE_H 16
+
+/* Bounds, in ms, of the time between two updates to the clients. */
+#define VNC_INTERVAL_MIN 10
+#define VNC_INTERVAL_MAX 100
+
 static rfbScreenInfoPtr rfb = NULL;
 static int              clients;
 static int              updatingSize;
@@ -45,6 +53,12 @@ static int              allowedY;
 static int              ptr_x;
 static int              ptr_y;
 static int              ptr_but;
+static int              last_x;
+static int              last_w;
+static int              pending_y1;
+static int              pending_y2;
+static uint32_t         last_update;
+static uint32_t         update_interval;
 
 #ifdef ENABLE_VNC_LOG
 int vnc_do_log = ENABLE_VNC_LOG;
@@ -175,24 +189,137 @@ vnc_display(rfbClientPtr cl)
     }
 }
 
+/* Copy the rows of a tile that differ from the frame buffer, which still
+   holds what the clients were last sent; returns whether any did. */
+static int
+vnc_update_tile(int x, int y, int fb_x, int fb_y, int w, int h)
+{
+    uint32_t *fb      = &(((uint32_t *) rfb->frameBuffer)[fb_y * VNC_MAX_X + fb_x]);
+    int       changed = 0;
+
+    for (int row = 0; row < h; ++row) {
+        const uint32_t *src = &(buffer32->line[y + row][x]);
+
+        if (memcmp(fb, src, w * sizeof(uint32_t))) {
+            video_copy(fb, src, w * sizeof(uint32_t));
+            changed = 1;
+        }
+        fb += VNC_MAX_X;
+    }
+
+    return changed;
+}
+
+static void
+vnc_mark_tiles(sraRegionPtr region, int x1, int y1, int x2, int y2)
+{
+    sraRegionPtr rect;
+
+    x2 = MIN(x2, allowedX);
+    y2 = MIN(y2, allowedY);
+    if ((x1 >= x2) || (y1 >= y2))
+        return;
+
+    rect = sraRgnCreateRect(x1, y1, x2, y2);
+    sraRgnOr(region, rect);
+    sraRgnDestroy(rect);
+}
+
 static void
 vnc_blit(int x, int y, int w, int h, int monitor_index)
 {
+    sraRegionPtr region;
+    uint32_t     now;
+    int          dirty_y;
+    int          dirty_h;
+    int          top;
+    int          bottom;
+    int          changed;
+    int          tiles;
+
     if (monitor_index || (x < 0) || (y < 0) || (w < VNC_MIN_X) || (h < VNC_MIN_Y) || (w > VNC_MAX_X) || (h > VNC_MAX_Y) || (buffer32 == NULL)) {
         video_blit_complete_monitor(monitor_index);
         return;
     }
 
-    for (int row = 0; row < h; ++row)
-        video_copy(&(((uint8_t *) rfb->frameBuffer)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+    video_blit_dirty_rows_monitor(&dirty_y, &dirty_h, monitor_index);
+
+    /* The frame buffer no longer lines up with the image if it moved
+       horizontally, so look at all of it. */
+    if ((x != last_x) || (w != last_w)) {
+        last_x  = x;
+        last_w  = w;
+        dirty_y = y;
+        dirty_h = h;
+    }
+
+    /* Rows held back by the frame rate cap are still in buffer32, so they
+       just need merging with those that changed since. */
+    if (dirty_h) {
+        if (pending_y2 > pending_y1) {
+            pending_y1 = MIN(pending_y1, dirty_y);
+            pending_y2 = MAX(pending_y2, dirty_y + dirty_h);
+        } else {
+            pending_y1 = dirty_y;
+            pending_y2 = dirty_y + dirty_h;
+        }
+    }
+
+    /* Keep video.c calling in while rows are held back, even if the screen
+       stops changing, so that they still get sent once the interval is up. */
+    now = plat_get_ticks();
+    if (!screenshots && ((pending_y2 <= pending_y1) || ((now - last_update) < update_interval))) {
+        video_blit_set_held_monitor(pending_y2 > pending_y1, monitor_index);
+        video_blit_complete_monitor(monitor_index);
+        return;
+    }
+    last_update = now;
+
+    top        = MAX(pending_y1, y) - y;
+    bottom     = MIN(pending_y2, y + h) - y;
+    pending_y1 = pending_y2 = 0;
+    video_blit_set_held_monitor(0, monitor_index);
+
+    region  = sraRgnCreate();
+    changed = 0;
+    for (int ty = top - (top % VNC_TILE_H); ty < bottom; ty += VNC_TILE_H) {
+        int y1  = MAX(ty, top);
+        int y2  = MIN(ty + VNC_TILE_H, bottom);
+        int run = -1;
+
+        /* Send runs of changed tiles on a row as a single rectangle. */
+        for (int tx = 0; tx < w; tx += VNC_TILE_W) {
+            if (vnc_update_tile(x + tx, y + y1, tx, y1, MIN(VNC_TILE_W, w - tx), y2 - y1)) {
+                changed++;
+                if (run < 0)
+                    run = tx;
+            } else if (run >= 0) {
+                vnc_mark_tiles(region, run, y1, tx, y2);
+                run = -1;
+            }
+        }
+        if (run >= 0)
+            vnc_mark_tiles(region, run, y1, w, y2);
+    }
 
     if (screenshots)
         video_screenshot((uint32_t *) rfb->frameBuffer, 0, 0, VNC_MAX_X);
 
     video_blit_complete_monitor(monitor_index);
 
-    if (!updatingSize)
-        rfbMarkRectAsModified(rfb, 0, 0, allowedX, allowedY);
+    if (!updatingSize && !sraRgnEmpty(region))
+        rfbMarkRegionAsModified(rfb, region);
+    sraRgnDestroy(region);
+
+    /* Back off while most of the screen keeps changing (video, scrolling),
+       and go back to a quick rate once it settles. */
+    tiles = ((w + VNC_TILE_W - 1) / VNC_TILE_W) * ((h + VNC_TILE_H - 1) / VNC_TILE_H);
+    if ((changed * 4) >= tiles)
+        update_interval = MIN(update_interval * 2, VNC_INTERVAL_MAX);
+    else if ((changed * 16) < tiles)
+        update_interval = MAX(update_interval / 2, VNC_INTERVAL_MIN);
+
+    vnc_log("VNC: %i of %i tiles changed, next update in %u ms\n", changed, tiles, update_interval);
 }
 
 /* Initialize VNC for operation. */
@@ -222,6 +349,13 @@ vnc_init(UNUSED(void *arg))
         allowedX     = scrnsz_x;
         allowedY     = scrnsz_y;
 
+        last_x          = -1;
+        last_w          = -1;
+        pending_y1      = 0;
+        pending_y2      = 0;
+        last_update     = 0;
+        update_interval = VNC_INTERVAL_MIN;
+
         rfb              = rfbGetScreen(0, NULL, VNC_MAX_X, VNC_MAX_Y, 8, 3, 4);
         rfb->desktopName = title;
         rfb->frameBuffer = (char *) malloc(VNC_MAX_X * VNC_MAX_Y * 4);